@@ -0,0 +1,404 @@
+#include "action_journal.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+
+namespace app
+{
+
+namespace
+{
+constexpr std::string_view segment_suffix = ".journal.";
+
+void ThrowSystemError(const char* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+void WriteAll(int fd, std::string_view data)
+{
+    while(!data.empty())
+    {
+        const ssize_t result = ::write(fd, data.data(), data.size());
+        if(result < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            ThrowSystemError("Can't write journal segment");
+        }
+        data.remove_prefix(static_cast<size_t>(result));
+    }
+}
+
+std::filesystem::path SegmentPath(const std::filesystem::path& state_file_path, uint64_t first_lsn)
+{
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(first_lsn));
+    std::filesystem::path path(state_file_path);
+    path += segment_suffix;
+    path += name;
+    return path;
+}
+
+// Сегменты журнала рядом с файлом состояния, упорядоченные по первому lsn
+std::vector<std::pair<uint64_t, std::filesystem::path>> ListSegments(const std::filesystem::path& state_file_path)
+{
+    std::vector<std::pair<uint64_t, std::filesystem::path>> segments;
+    const std::string prefix = state_file_path.filename().string() + std::string(segment_suffix);
+    std::error_code ec;
+    for(const auto& entry : std::filesystem::directory_iterator(state_file_path.parent_path(), ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if(!name.starts_with(prefix))
+        {
+            continue;
+        }
+        std::string_view lsn_str = std::string_view(name).substr(prefix.size());
+        uint64_t first_lsn = 0;
+        auto [ptr, parse_ec] = std::from_chars(lsn_str.data(), lsn_str.data() + lsn_str.size(), first_lsn, 16);
+        if(parse_ec == std::errc{} && ptr == lsn_str.data() + lsn_str.size())
+        {
+            segments.emplace_back(first_lsn, entry.path());
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+std::string ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("Can't open journal segment " + path.string());
+    }
+    std::string data;
+    data.resize(static_cast<size_t>(std::filesystem::file_size(path)));
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    data.resize(static_cast<size_t>(file.gcount()));
+    return data;
+}
+} // namespace
+
+uint64_t ActionJournal::Replay(const std::filesystem::path& state_file_path, uint64_t after_lsn, const EntryHandler& handler)
+{
+    uint64_t last_lsn = after_lsn;
+    for(const auto& [first_lsn, path] : ListSegments(state_file_path))
+    {
+        if(first_lsn > last_lsn + 1)
+        {
+            // Разрыв нумерации: записи за ним нельзя применять к текущему состоянию
+            break;
+        }
+        const std::string data = ReadFile(path);
+        std::optional<serialization::JournalReader> reader;
+        try
+        {
+            reader.emplace(data);
+        }
+        catch(const serialization::SnapshotError&)
+        {
+            // Сегмент создан, но заголовок не успел записаться
+            continue;
+        }
+        while(auto entry = reader->Next())
+        {
+            if(entry->lsn <= last_lsn)
+            {
+                continue;
+            }
+            if(entry->lsn != last_lsn + 1)
+            {
+                return last_lsn;
+            }
+            last_lsn = entry->lsn;
+            handler(std::move(*entry));
+        }
+        // Недописанный хвост сегмента - обычное следствие аварийной остановки:
+        // после неё запись продолжилась в следующем сегменте с того же номера
+    }
+    return last_lsn;
+}
+
+ActionJournal::ActionJournal(std::filesystem::path state_file_path, Config config, uint64_t next_lsn)
+    : state_file_path_(std::move(state_file_path))
+    , config_(config)
+    , last_lsn_(next_lsn - 1)
+    , durable_lsn_(next_lsn - 1)
+{
+    for(const auto& [first_lsn, path] : ListSegments(state_file_path_))
+    {
+        if(first_lsn < next_lsn)
+        {
+            segments_.push_back(first_lsn);
+        }
+        else
+        {
+            // Сегменты после разрыва нумерации при восстановлении не применялись
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    }
+    // Хвост предыдущего сегмента мог остаться недописанным, поэтому всегда начинаем новый
+    segment_first_lsn_ = next_lsn;
+    OpenSegment(next_lsn);
+    thread_ = std::jthread([this](std::stop_token stop) { Run(stop); });
+}
+
+ActionJournal::~ActionJournal()
+{
+    thread_.request_stop();
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+    CloseSegment();
+}
+
+uint64_t ActionJournal::Append(const serialization::JournalRecord& record)
+{
+    uint64_t lsn = 0;
+    {
+        std::lock_guard lock{mutex_};
+        lsn = last_lsn_.load(std::memory_order_relaxed) + 1;
+        serialization::EncodeJournalEntry(buffer_, lsn, record);
+        ++segment_records_;
+        ++buffered_records_;
+        last_lsn_.store(lsn, std::memory_order_release);
+    }
+    records_since_checkpoint_.fetch_add(1, std::memory_order_relaxed);
+    cond_var_.notify_one();
+    return lsn;
+}
+
+void ActionJournal::StartCheckpoint()
+{
+    records_since_checkpoint_.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard lock{mutex_};
+        if(segment_records_ == 0)
+        {
+            // Текущий сегмент пуст, новый не нужен
+            return;
+        }
+        rotations_.push_back(Rotation{.offset = buffer_.Size(), .first_lsn = last_lsn_.load(std::memory_order_relaxed) + 1});
+        segment_records_ = 0;
+    }
+    cond_var_.notify_one();
+}
+
+void ActionJournal::ReleaseUpTo(uint64_t lsn)
+{
+    std::vector<uint64_t> released;
+    {
+        std::lock_guard lock{mutex_};
+        // Сегмент не нужен, если следующий за ним начинается не позже lsn + 1
+        size_t count = 0;
+        while(count + 1 < segments_.size() && segments_[count + 1] <= lsn + 1)
+        {
+            ++count;
+        }
+        released.assign(segments_.begin(), segments_.begin() + count);
+        segments_.erase(segments_.begin(), segments_.begin() + count);
+    }
+    for(uint64_t first_lsn : released)
+    {
+        std::error_code ec;
+        std::filesystem::remove(SegmentPath(state_file_path_, first_lsn), ec);
+    }
+}
+
+void ActionJournal::Flush()
+{
+    std::unique_lock lock{mutex_};
+    const uint64_t target_lsn = last_lsn_.load(std::memory_order_relaxed);
+    // Ошибки попыток, начатых до вызова, не считаются: следующая попытка может удаться
+    const uint64_t first_attempt = write_attempts_ + 1;
+    is_flush_requested_ = true;
+    cond_var_.notify_one();
+    flushed_cond_var_.wait(lock, [this, target_lsn, first_attempt] {
+        return durable_lsn_.load(std::memory_order_acquire) >= target_lsn || failed_attempt_ >= first_attempt;
+    });
+    if(durable_lsn_.load(std::memory_order_acquire) < target_lsn)
+    {
+        throw std::runtime_error("Can't write action journal: " + last_error_);
+    }
+}
+
+void ActionJournal::Run(std::stop_token stop)
+{
+    while(true)
+    {
+        uint64_t attempt = 0;
+        {
+            std::unique_lock lock{mutex_};
+            const auto has_data = [this] {
+                return buffer_.Size() != 0 || !rotations_.empty() || !pending_.empty() || !pending_rotations_.empty();
+            };
+            cond_var_.wait(lock, stop, has_data);
+            if(!has_data())
+            {
+                // Остановка без незаписанных данных
+                return;
+            }
+            // Групповая фиксация: даём накопиться записям, пришедшим в течение окна
+            if(config_.commit_window.count() > 0 && !is_flush_requested_)
+            {
+                cond_var_.wait_for(lock, stop, config_.commit_window, [this] { return is_flush_requested_; });
+            }
+            // Новые записи дописываются к тем, что не удалось записать в прошлый раз
+            const size_t base = pending_.size();
+            pending_ += buffer_.Release();
+            buffer_ = serialization::BinaryWriter{};
+            for(Rotation rotation : rotations_)
+            {
+                rotation.offset += base;
+                pending_rotations_.push_back(rotation);
+            }
+            rotations_.clear();
+            pending_last_lsn_ = last_lsn_.load(std::memory_order_relaxed);
+            pending_records_ += buffered_records_;
+            buffered_records_ = 0;
+            is_flush_requested_ = false;
+            attempt = ++write_attempts_;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        try
+        {
+            WritePending();
+        }
+        catch(const std::exception& ex)
+        {
+            // Игра продолжается; записи остаются в pending_ и будут записаны следующей попыткой
+            failed_writes_.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::unique_lock lock{mutex_};
+                failed_attempt_ = attempt;
+                last_error_ = ex.what();
+                flushed_cond_var_.notify_all();
+                if(stop.stop_requested())
+                {
+                    // При остановке не ждём, пока диск снова станет доступен
+                    return;
+                }
+                cond_var_.wait_for(lock, stop, retry_delay, [] { return false; });
+            }
+            continue;
+        }
+        sync_duration_us_.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+        batch_size_.Record(pending_records_);
+        pending_records_ = 0;
+        SetDurableLsn(pending_last_lsn_);
+    }
+}
+
+void ActionJournal::WritePending()
+{
+    if(fd_ < 0)
+    {
+        // Прошлая попытка не смогла открыть сегмент
+        OpenSegment(segment_first_lsn_);
+    }
+    else if(::ftruncate(fd_, synced_size_) != 0)
+    {
+        // Отбрасываем недописанный хвост прошлой попытки
+        ThrowSystemError("Can't truncate journal segment");
+    }
+    while(!pending_rotations_.empty())
+    {
+        const Rotation rotation = pending_rotations_.front();
+        WriteAll(fd_, std::string_view(pending_).substr(0, rotation.offset));
+        if(::fdatasync(fd_) != 0)
+        {
+            ThrowSystemError("Can't sync journal segment");
+        }
+        CloseSegment();
+        // Записи до начала нового сегмента зафиксированы: при повторе они не пишутся снова
+        pending_.erase(0, rotation.offset);
+        pending_rotations_.erase(pending_rotations_.begin());
+        for(Rotation& next : pending_rotations_)
+        {
+            next.offset -= rotation.offset;
+        }
+        SetDurableLsn(rotation.first_lsn - 1);
+        segment_first_lsn_ = rotation.first_lsn;
+        OpenSegment(rotation.first_lsn);
+    }
+    WriteAll(fd_, pending_);
+    if(::fdatasync(fd_) != 0)
+    {
+        ThrowSystemError("Can't sync journal segment");
+    }
+    synced_size_ += static_cast<off_t>(pending_.size());
+    pending_.clear();
+}
+
+void ActionJournal::SetDurableLsn(uint64_t lsn)
+{
+    {
+        std::lock_guard lock{mutex_};
+        durable_lsn_.store(lsn, std::memory_order_release);
+    }
+    flushed_cond_var_.notify_all();
+}
+
+void ActionJournal::OpenSegment(uint64_t first_lsn)
+{
+    const std::filesystem::path path = SegmentPath(state_file_path_, first_lsn);
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        ThrowSystemError("Can't open journal segment");
+    }
+    const std::string header = serialization::EncodeJournalHeader(first_lsn);
+    try
+    {
+        WriteAll(fd, header);
+        if(::fsync(fd) != 0)
+        {
+            ThrowSystemError("Can't sync journal segment");
+        }
+    }
+    catch(...)
+    {
+        ::close(fd);
+        throw;
+    }
+    // Новый файл должен пережить сбой вместе с записью в каталоге
+    if(const int dir_fd = ::open(path.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); dir_fd >= 0)
+    {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    fd_ = fd;
+    synced_size_ = static_cast<off_t>(header.size());
+    std::lock_guard lock{mutex_};
+    // При повторной попытке сегмент уже учтён
+    if(segments_.empty() || segments_.back() != first_lsn)
+    {
+        segments_.push_back(first_lsn);
+    }
+}
+
+void ActionJournal::CloseSegment()
+{
+    if(fd_ >= 0)
+    {
+        ::fdatasync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+} // namespace app
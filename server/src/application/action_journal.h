@@ -0,0 +1,153 @@
+#pragma once
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../serialization/journal.h"
+#include "../metrics/histogram.h"
+
+namespace app {
+
+// Журнал действий игроков (вход, движение, такт), дописываемый в конец файла.
+// Записи добавляются на strand игры, а запись на диск и fsync выполняет отдельный поток:
+// всё, что накопилось за время предыдущего fsync и окна commit_window, фиксируется одним вызовом.
+// Журнал разбит на сегменты <state-file>.journal.<первый lsn>; при снятии контрольной точки
+// начинается новый сегмент, а сегменты, целиком вошедшие в записанный снимок, удаляются.
+// Группа, которую не удалось записать, не отбрасывается: недописанный хвост сегмента
+// обрезается, и запись повторяется вместе с новыми записями, пока не удастся.
+class ActionJournal {
+public:
+    struct Config {
+        // Сколько писатель ждёт новых записей перед fsync
+        std::chrono::milliseconds commit_window{2};
+        // Количество записей, после которого запрашивается новая контрольная точка (0 - не запрашивать)
+        uint64_t checkpoint_records = 100000;
+    };
+
+    using EntryHandler = std::function<void(serialization::JournalEntry&& entry)>;
+
+    // Передаёт handler записи всех сегментов с lsn больше after_lsn в порядке возрастания.
+    // Останавливается на недописанном хвосте или разрыве нумерации.
+    // Возвращает номер последней переданной записи (after_lsn, если таких нет)
+    static uint64_t Replay(const std::filesystem::path& state_file_path, uint64_t after_lsn, const EntryHandler& handler);
+
+    // Открывает новый сегмент, первая запись которого получит номер next_lsn
+    ActionJournal(std::filesystem::path state_file_path, Config config, uint64_t next_lsn);
+    ~ActionJournal();
+
+    ActionJournal(const ActionJournal&) = delete;
+    ActionJournal& operator=(const ActionJournal&) = delete;
+
+    // Добавляет запись в очередь на запись и возвращает её номер
+    uint64_t Append(const serialization::JournalRecord& record);
+
+    // Номер последней добавленной записи
+    uint64_t GetLastLsn() const noexcept {
+        return last_lsn_.load(std::memory_order_acquire);
+    }
+
+    // Номер последней записи, гарантированно сохранённой на диске
+    uint64_t GetDurableLsn() const noexcept {
+        return durable_lsn_.load(std::memory_order_acquire);
+    }
+
+    // Вызывается при снятии снимка: следующие записи пойдут в новый сегмент
+    void StartCheckpoint();
+
+    bool IsCheckpointDue() const noexcept {
+        return config_.checkpoint_records != 0
+            && records_since_checkpoint_.load(std::memory_order_relaxed) >= config_.checkpoint_records;
+    }
+
+    // Снимок, включающий записи до lsn, записан на диск: удаляет ставшие ненужными сегменты
+    void ReleaseUpTo(uint64_t lsn);
+
+    // Дожидается, пока все добавленные записи окажутся на диске.
+    // Бросает std::runtime_error, если попытка записи после вызова не удалась
+    void Flush();
+
+    const Config& GetConfig() const noexcept {
+        return config_;
+    }
+
+    // Количество записей, зафиксированных одним fsync
+    const metrics::Histogram& GetBatchSizeHistogram() const noexcept {
+        return batch_size_;
+    }
+
+    // Длительность записи и fsync одной группы, мкс
+    const metrics::Histogram& GetSyncDurationHistogram() const noexcept {
+        return sync_duration_us_;
+    }
+
+    uint64_t GetFailedWritesCount() const noexcept {
+        return failed_writes_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Rotation {
+        size_t offset;          // позиция в буфере, с которой начинается новый сегмент
+        uint64_t first_lsn;
+    };
+
+    // Пауза перед повторной записью после ошибки
+    static constexpr std::chrono::milliseconds retry_delay{100};
+
+    void Run(std::stop_token stop);
+    // Дописывает pending_ с переходами между сегментами. После ошибки можно вызвать снова:
+    // уже зафиксированные части не повторяются, хвост текущего сегмента обрезается
+    void WritePending();
+    void SetDurableLsn(uint64_t lsn);
+    void OpenSegment(uint64_t first_lsn);
+    void CloseSegment();
+
+    std::filesystem::path state_file_path_;
+    const Config config_;
+
+    std::mutex mutex_;
+    std::condition_variable_any cond_var_;
+    std::condition_variable flushed_cond_var_;
+    serialization::BinaryWriter buffer_;
+    std::vector<Rotation> rotations_;
+    uint64_t segment_records_ = 0;
+    uint64_t buffered_records_ = 0;
+    bool is_flush_requested_ = false;
+    // Номер попытки записи и последней неудачной из них - для Flush
+    uint64_t write_attempts_ = 0;
+    uint64_t failed_attempt_ = 0;
+    std::string last_error_;
+    // Первые lsn существующих сегментов по возрастанию
+    std::vector<uint64_t> segments_;
+
+    std::atomic<uint64_t> last_lsn_;
+    std::atomic<uint64_t> durable_lsn_;
+    std::atomic<uint64_t> records_since_checkpoint_{0};
+
+    // Используются только потоком записи (и конструктором до его запуска)
+    int fd_ = -1;
+    uint64_t segment_first_lsn_ = 0;
+    // Размер текущего сегмента после последнего успешного fdatasync
+    off_t synced_size_ = 0;
+    // Данные, ещё не записанные на диск, и переходы к новым сегментам внутри них
+    std::string pending_;
+    std::vector<Rotation> pending_rotations_;
+    uint64_t pending_last_lsn_ = 0;
+    uint64_t pending_records_ = 0;
+
+    metrics::Histogram batch_size_;
+    metrics::Histogram sync_duration_us_;
+    std::atomic<uint64_t> failed_writes_{0};
+
+    std::jthread thread_;
+};
+
+}  // namespace app
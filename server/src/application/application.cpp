@@ -1,9 +1,17 @@
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <variant>
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
 
 #include "application.h"
 #include "fstream"
 #include "../serialization/serialization.h"
+#include "../serialization/snapshot.h"
+#include "../tracing/span_recorder.h"
+#include "../logging/logger.h"
 
 
 
@@ -40,21 +48,24 @@ void Ticker::OnTick(sys::error_code ec) {
     }
 }
 
-Application::Application(model::Game& game, bool is_randomize_spawn_points, Strand& strand, database::Database& database)
+Application::Application(model::Game& game, bool is_randomize_spawn_points, Strand& strand,
+                         database::app::UnitOfWorkFactory& unit_of_work_factory, Executor db_executor)
 : game_(game)
 , is_randomize_spawn_points_(is_randomize_spawn_points)
 , strand_(strand)
-, database_(database)
+, unit_of_work_factory_(unit_of_work_factory)
+, db_executor_(std::move(db_executor))
 {
 
 }
 
-void Application::RecoverFromFile(std::string_view state_file_path)
+void Application::RecoverFromFile(std::string_view state_file_path, std::optional<ActionJournal::Config> journal_config)
 {
     path_to_state_file_ = std::filesystem::absolute(state_file_path);
+    uint64_t journal_lsn = 0;
     if(std::filesystem::exists(path_to_state_file_))
     {
-        RecoverState();
+        journal_lsn = RecoverState();
     }
     else
     {
@@ -66,6 +77,21 @@ void Application::RecoverFromFile(std::string_view state_file_path)
         }
     }
 
+    StateWriter::SavedHandler on_saved;
+    if(journal_config.has_value())
+    {
+        const uint64_t last_lsn = ReplayJournal(journal_lsn);
+        journal_ = std::make_unique<ActionJournal>(path_to_state_file_, *journal_config, last_lsn + 1);
+        on_saved = [journal = journal_.get()](const serialization::EncodedStateSnapshot& snapshot) {
+            journal->ReleaseUpTo(snapshot.journal_lsn);
+        };
+    }
+    state_writer_ = std::make_unique<StateWriter>(path_to_state_file_, std::move(on_saved));
+    // Результаты, не подтверждённые базой до остановки сервера, отправляются заново
+    pending_results_count_.store(pending_results_.size(), std::memory_order_relaxed);
+    net::post(strand_, [this] {
+        SubmitPendingResults();
+    });
 }
 
 void Application::TurnOnAutoTickingMode(std::chrono::milliseconds tick_value_ms) {
@@ -96,6 +122,18 @@ std::pair<Token, uint64_t> Application::JoinGame(model::Map::Id map_id, std::str
     //Is there with the same name
     auto [player, token] = players_.Add(user_name, *game_session_ptr);
     game_.GetGameSession(map_id)->AddDog(player.GetDog(), is_randomize_spawn_points_);
+    if(journal_ != nullptr)
+    {
+        auto dog = player.GetDog();
+        journal_->Append(serialization::JoinRecord{
+            .map_id = *map_id,
+            .user_name = std::move(user_name),
+            .token = *token,
+            .dog_id = dog->GetId(),
+            .x = dog->GetDogCoordinates().x_,
+            .y = dog->GetDogCoordinates().y_
+        });
+    }
     return {token, player.GetDog()->GetId()};
 }
 
@@ -103,6 +141,20 @@ std::shared_ptr<Player> Application::FindPlayerByToken(Token token) {
     return players_.FindByToken(token);
 }
 
+void Application::MoveAction(Token token, std::string_view move)
+{
+    auto player = players_.FindByToken(token);
+    if(player == nullptr)
+    {
+        return;
+    }
+    player->MoveAction(move, player->GetSession()->GetMap()->GetDogSpeed());
+    if(journal_ != nullptr)
+    {
+        journal_->Append(serialization::MoveRecord{.token = std::move(*token), .move = std::string(move)});
+    }
+}
+
 const std::deque<std::shared_ptr<Player>> Application::GetAllPlayersInSessionWithCurrentPlayer(Token current_player_token)
 {
     return players_.GetAllPlayersInSessionWithCurrentPlayer(current_player_token);
@@ -117,9 +169,50 @@ void Application::UpdateApplication(uint64_t delta_time_ms)
 {
     if(delta_time_ms > 0)
     {
-        game_.UpdateStateOfGame(delta_time_ms);
-        tick_signal_(std::chrono::milliseconds(delta_time_ms));
-        HandleLeavedPlayers();
+        const auto start_time = std::chrono::steady_clock::now();
+        tracing::ScopedSpan tick_span("tick", "tick");
+        model::TickProfiler& profiler = game_.GetTickProfiler();
+        model::TickPhaseTimes phase_times{};
+        model::TickPhaseTimes* profiled_times = profiler.IsEnabled() ? &phase_times : nullptr;
+        serialization::TickRecord tick{.delta_ms = delta_time_ms, .spawned = {}, .retired = {}};
+        {
+            model::ScopedPhaseTimer timer(profiled_times, model::TickPhase::kGameUpdate);
+            game_.UpdateStateOfGame(delta_time_ms, journal_ != nullptr ? &tick.spawned : nullptr);
+        }
+        {
+            model::ScopedPhaseTimer timer(profiled_times, model::TickPhase::kLeavedPlayers);
+            tick.retired = HandleLeavedPlayers();
+        }
+        // Такт попадает в журнал до обработчиков DoOnTick: снимок, снятый в них,
+        // уже учитывает этот такт, и при восстановлении такт не применяется повторно
+        if(journal_ != nullptr)
+        {
+            model::ScopedPhaseTimer timer(profiled_times, model::TickPhase::kJournal);
+            journal_->Append(tick);
+        }
+        pending_results_.insert(pending_results_.end(), std::make_move_iterator(tick.retired.begin()), std::make_move_iterator(tick.retired.end()));
+        ++tick_number_;
+        {
+            model::ScopedPhaseTimer timer(profiled_times, model::TickPhase::kTickListeners);
+            tick_signal_(std::chrono::milliseconds(delta_time_ms));
+        }
+        if(journal_ != nullptr && journal_->IsCheckpointDue())
+        {
+            model::ScopedPhaseTimer timer(profiled_times, model::TickPhase::kCheckpoint);
+            SaveStateInBackground();
+        }
+        SubmitPendingResults();
+
+        const auto population = game_.CountPopulation();
+        sessions_count_.store(population.sessions, std::memory_order_relaxed);
+        dogs_count_.store(population.dogs, std::memory_order_relaxed);
+        loots_count_.store(population.loots, std::memory_order_relaxed);
+        const auto tick_duration = std::chrono::steady_clock::now() - start_time;
+        tick_duration_us_.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(tick_duration).count()));
+        if(profiled_times != nullptr)
+        {
+            profiler.AddTick(phase_times, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(tick_duration).count()));
+        }
     }
 }
 
@@ -132,94 +225,286 @@ bool Application::IsTickerRunning() const noexcept {
     return is_ticker_running_;
 }
 
-void Application::SaveState()
+std::shared_ptr<const serialization::EncodedStateSnapshot> Application::CaptureState()
 {
-    if(path_to_state_file_ != "")
+    auto snapshot = std::make_shared<serialization::EncodedStateSnapshot>();
+    snapshot->captured_at = std::chrono::steady_clock::now();
+    if(journal_ != nullptr)
+    {
+        // Снимок становится контрольной точкой: после его записи сегменты с уже учтёнными записями удаляются
+        snapshot->journal_lsn = journal_->GetLastLsn();
+        journal_->StartCheckpoint();
+    }
+    for(const auto& map : game_.GetMaps())
     {
-        using namespace std::literals;
-        std::filesystem::path temp_file_path(path_to_state_file_.parent_path() / std::filesystem::path("temp.json"s));
-        std::ofstream temp_file(temp_file_path);
-        if(temp_file.is_open())
+        if(const model::GameSession* game_session = game_.FindGameSession(map.GetId()); game_session != nullptr)
         {
-            boost::json::object file_json;
-            SerializePlayers(file_json);
-            SerializeItems(file_json);
-            temp_file << boost::json::serialize(file_json);
-            temp_file.close();
-            std::filesystem::rename(temp_file_path, path_to_state_file_);
+            // Сессия кодируется сразу: это дешевле копирования собак и предметов
+            // (см. snapshot_capture в tests/bench/serialization_bench.cpp)
+            snapshot->sessions.push_back(serialization::EncodeSession(*map.GetId(), CaptureDogs(map.GetId()), game_session->GetLootsInSession()));
         }
     }
+    snapshot->pending_results = pending_results_;
+    capture_duration_us_.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - snapshot->captured_at).count()));
+    return snapshot;
 }
 
-void Application::SerializePlayers(boost::json::object& file_json)
+void Application::SaveState()
 {
-    boost::json::array players;
-    for(const auto& player : players_.GetAllPlayers())
+    if(journal_ != nullptr)
     {
-        
-        std::stringstream string_stream;
-        boost::archive::text_oarchive oa{string_stream};
-        serialization::DogRepr ser_dog((*player->GetDog()), *(players_.GetTokenByMapIdAndName(player->GetDog()->GetName(), *(player->GetSession()->GetMap()->GetId())).value()),  
-                                                    *(player->GetSession()->GetMap()->GetId()));
-        oa << ser_dog;
+        try
+        {
+            journal_->Flush();
+        }
+        catch(const std::exception& ex)
+        {
+            // Снимок ниже содержит всё состояние, в том числе незаписанные записи журнала
+            LogJson(boost::json::object{{"exception", ex.what()}}, "journal flush failed", LogLevel::kError);
+        }
+    }
+    if(state_writer_ != nullptr)
+    {
+        state_writer_->SaveNow(CaptureState());
+    }
+}
 
-        players.push_back(boost::json::string(string_stream.str()));
+void Application::SaveStateInBackground()
+{
+    if(state_writer_ != nullptr)
+    {
+        state_writer_->SaveInBackground(CaptureState());
     }
-    file_json.emplace("Players", players);
 }
 
-void Application::SerializeItems(boost::json::object& file_json)
+const StateWriter* Application::GetStateWriter() const noexcept
+{
+    return state_writer_.get();
+}
+
+const ActionJournal* Application::GetJournal() const noexcept
+{
+    return journal_.get();
+}
+
+void Application::CollectMetrics(metrics::PrometheusWriter& writer) const
 {
-    boost::json::array items_json;
-    for(auto map : game_.GetMaps())
+    using Type = metrics::PrometheusWriter::Type;
+    using namespace std::literals;
+
+    writer.WriteHeader("game_tick_duration_seconds"sv, Type::kHistogram, "Duration of a game tick"sv);
+    writer.WriteHistogram("game_tick_duration_seconds"sv, {}, tick_duration_us_.GetSnapshot(), 1e-6, metrics::kDurationBounds);
+    if(const auto report = game_.GetTickProfiler().GetReport(); report.ticks.calls != 0)
     {
-        if(model::GameSession* game_session = game_.GetGameSession(map.GetId()); game_session != nullptr)
+        writer.WriteHeader("game_tick_phase_seconds_total"sv, Type::kCounter, "Time spent in tick phases while the tick profiler was enabled"sv);
+        for(size_t i = 0; i < model::tick_phases_count; ++i)
         {
-            std::stringstream string_stream;
-            boost::archive::text_oarchive oa{string_stream};
-            oa << game_session->GetLootsInSession();
-            boost::json::object loots_in_map{
-                {"map_id",       *(map.GetId())},
-                {"loots_in_map", string_stream.str()}};
-
-            items_json.push_back(loots_in_map);
+            writer.WriteSample("game_tick_phase_seconds_total"sv, {{"phase"sv, model::GetTickPhaseName(static_cast<model::TickPhase>(i))}},
+                               static_cast<double>(report.phases[i].total_ns) * 1e-9);
         }
     }
-    file_json.emplace("Items", items_json);
+    writer.WriteHeader("game_sessions"sv, Type::kGauge, "Game sessions after the last tick"sv);
+    writer.WriteSample("game_sessions"sv, {}, sessions_count_.load(std::memory_order_relaxed));
+    writer.WriteHeader("game_dogs"sv, Type::kGauge, "Dogs in all sessions after the last tick"sv);
+    writer.WriteSample("game_dogs"sv, {}, dogs_count_.load(std::memory_order_relaxed));
+    writer.WriteHeader("game_loots"sv, Type::kGauge, "Loot items lying on maps after the last tick"sv);
+    writer.WriteSample("game_loots"sv, {}, loots_count_.load(std::memory_order_relaxed));
+
+    if(state_writer_ != nullptr)
+    {
+        writer.WriteHeader("state_capture_duration_seconds"sv, Type::kHistogram, "Time the game strand spends capturing a snapshot"sv);
+        writer.WriteHistogram("state_capture_duration_seconds"sv, {}, capture_duration_us_.GetSnapshot(), 1e-6, metrics::kDurationBounds);
+        writer.WriteHeader("state_save_duration_seconds"sv, Type::kHistogram, "Time to assemble and write a state snapshot file"sv);
+        writer.WriteHistogram("state_save_duration_seconds"sv, {}, state_writer_->GetSaveDurationHistogram().GetSnapshot(), 1e-6, metrics::kDurationBounds);
+        writer.WriteHeader("state_snapshot_age_seconds"sv, Type::kHistogram, "Snapshot age when it reached the disk"sv);
+        writer.WriteHistogram("state_snapshot_age_seconds"sv, {}, state_writer_->GetSnapshotAgeHistogram().GetSnapshot(), 1e-3, metrics::kDurationBounds);
+        writer.WriteHeader("state_snapshots_skipped_total"sv, Type::kCounter, "Snapshots replaced by newer ones before being written"sv);
+        writer.WriteSample("state_snapshots_skipped_total"sv, {}, state_writer_->GetSkippedCount());
+        writer.WriteHeader("state_save_failures_total"sv, Type::kCounter, "Background state saves that failed"sv);
+        writer.WriteSample("state_save_failures_total"sv, {}, state_writer_->GetFailedCount());
+    }
+
+    if(journal_ != nullptr)
+    {
+        writer.WriteHeader("journal_batch_records"sv, Type::kHistogram, "Journal records committed by one fsync"sv);
+        writer.WriteHistogram("journal_batch_records"sv, {}, journal_->GetBatchSizeHistogram().GetSnapshot(), 1.0, metrics::kSizeBounds);
+        writer.WriteHeader("journal_sync_duration_seconds"sv, Type::kHistogram, "Time to write and fsync a journal batch"sv);
+        writer.WriteHistogram("journal_sync_duration_seconds"sv, {}, journal_->GetSyncDurationHistogram().GetSnapshot(), 1e-6, metrics::kDurationBounds);
+        writer.WriteHeader("journal_failed_writes_total"sv, Type::kCounter, "Failed journal writes"sv);
+        writer.WriteSample("journal_failed_writes_total"sv, {}, journal_->GetFailedWritesCount());
+    }
+
+    writer.WriteHeader("retired_results_pending"sv, Type::kGauge, "Retired players results not yet confirmed by the database"sv);
+    writer.WriteSample("retired_results_pending"sv, {}, pending_results_count_.load(std::memory_order_relaxed));
+    writer.WriteHeader("retired_results_save_failures_total"sv, Type::kCounter, "Failed attempts to save retired players results"sv);
+    writer.WriteSample("retired_results_save_failures_total"sv, {}, results_save_failures_.load(std::memory_order_relaxed));
 }
 
-void Application::RecoverState()
+std::vector<serialization::SessionDog> Application::CaptureDogs(const model::Map::Id& map_id)
 {
-    using namespace std::literals;
-    std::ifstream json_file(path_to_state_file_);
-    if(!json_file.is_open())
+    const auto& players = players_.GetPlayersInSession(map_id);
+    std::vector<serialization::SessionDog> dogs;
+    dogs.reserve(players.size());
+    for(const auto& player : players)
     {
-        throw std::runtime_error("Can't open json state file");
+        const Token* token = players_.FindTokenByMapIdAndName(player->GetDog()->GetName(), *map_id);
+        dogs.push_back(serialization::SessionDog{.dog = player->GetDog().get(), .token = **token});
     }
-    std::string json_string = ""s;
-    std::string temp;
-    while(getline(json_file, temp)) {
-        json_string += temp;
+    return dogs;
+}
+
+uint64_t Application::RecoverState()
+{
+    std::ifstream state_file(path_to_state_file_, std::ios::binary);
+    if(!state_file.is_open())
+    {
+        throw std::runtime_error("Can't open state file");
     }
-    json_file.close();
-    boost::json::value parsed_json;
-    try
+    std::string data;
+    data.resize(static_cast<size_t>(std::filesystem::file_size(path_to_state_file_)));
+    state_file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    data.resize(static_cast<size_t>(state_file.gcount()));
+    state_file.close();
+
+    if(data.empty())
     {
-        if(!json_string.empty())
+        return 0;
+    }
+    if(serialization::IsBinarySnapshot(data))
+    {
+        auto snapshot = serialization::DecodeSnapshot(data);
+        RestoreSnapshot(std::move(snapshot.sessions));
+        pending_results_ = std::move(snapshot.pending_results);
+        return snapshot.journal_lsn;
+    }
+    // Файлы, сохранённые до перехода на двоичный формат
+    RecoverLegacyJsonState(data);
+    return 0;
+}
+
+void Application::RestoreSnapshot(std::vector<serialization::SessionSnapshot>&& sessions)
+{
+    uint64_t max_id_dog = 0;
+    for(auto& session : sessions)
+    {
+        model::Map::Id map_id{session.map_id};
+        if(game_.FindMap(map_id) == nullptr)
         {
-            parsed_json = boost::json::parse(json_string);
-            if(parsed_json.is_object())
+            throw std::runtime_error("State file refers to unknown map " + session.map_id);
+        }
+        for(const auto& ser_dog : session.dogs)
+        {
+            max_id_dog = std::max(max_id_dog, RestorePlayer(ser_dog));
+        }
+        GetOrCreateGameSession(map_id)->GetLootsInSession() = std::move(session.loots);
+    }
+    model::id_counter = max_id_dog + 1;
+}
+
+uint64_t Application::ReplayJournal(uint64_t after_lsn)
+{
+    // Повтор идёт через те же функции модели, что и исходные действия,
+    // но случайные значения и результаты выбывших берутся из записей.
+    // База данных не затрагивается: неподтверждённые результаты отправляются после восстановления
+    const uint64_t last_lsn = ActionJournal::Replay(path_to_state_file_, after_lsn, [this](serialization::JournalEntry&& entry) {
+        std::visit([this](const auto& record) {
+            using Record = std::decay_t<decltype(record)>;
+            if constexpr (std::is_same_v<Record, serialization::JoinRecord>)
+            {
+                ReplayJoin(record);
+            }
+            else if constexpr (std::is_same_v<Record, serialization::MoveRecord>)
+            {
+                ReplayMove(record);
+            }
+            else if constexpr (std::is_same_v<Record, serialization::TickRecord>)
+            {
+                ReplayTick(record);
+            }
+            else
             {
-                RestorePlayers(parsed_json.as_object().at("Players").as_array());
-                RestoreItems(parsed_json.as_object().at("Items").as_array());
+                ReplayResultsSaved(record);
             }
+        }, entry.record);
+    });
+    return last_lsn;
+}
 
-        }
+void Application::ReplayJoin(const serialization::JoinRecord& record)
+{
+    model::Map::Id map_id{record.map_id};
+    if(game_.FindMap(map_id) == nullptr)
+    {
+        throw std::runtime_error("Journal refers to unknown map " + record.map_id);
+    }
+    model::GameSession* game_session_ptr = GetOrCreateGameSession(map_id);
+    auto [player, token] = players_.Add(record.user_name, *game_session_ptr, record.token);
+    if(player.GetDog()->GetId() != record.dog_id)
+    {
+        player.SetId(record.dog_id);
+    }
+    game_session_ptr->AddDog(player.GetDog());
+    player.SetCoordinates(model::DogCoordinates(record.x, record.y));
+    model::id_counter = std::max(model::id_counter, record.dog_id + 1);
+}
+
+void Application::ReplayMove(const serialization::MoveRecord& record)
+{
+    if(auto player = players_.FindByToken(Token{record.token}); player != nullptr)
+    {
+        player->MoveAction(record.move, player->GetSession()->GetMap()->GetDogSpeed());
     }
-    catch(const std::exception& e)
+}
+
+void Application::ReplayTick(const serialization::TickRecord& record)
+{
+    game_.ReplayStateOfGame(record.delta_ms, record.spawned);
+    // Игроки выбывают так же, как в исходном такте, но результаты берутся из записи вместе с их id.
+    // В журналах версии 1 результатов нет: тогда они записывались в базу до журналирования такта
+    HandleLeavedPlayers();
+    pending_results_.insert(pending_results_.end(), record.retired.begin(), record.retired.end());
+}
+
+void Application::ReplayResultsSaved(const serialization::ResultsSavedRecord& record)
+{
+    ErasePendingResults(record.ids);
+}
+
+void Application::RecoverLegacyJsonState(const std::string& json_string)
+{
+    RestoreSnapshot(serialization::DecodeLegacyJsonState(json_string).sessions);
+}
+
+model::GameSession* Application::GetOrCreateGameSession(const model::Map::Id& map_id)
+{
+    if(game_.FindGameSession(map_id) == nullptr)
     {
-        throw;
+        game_.CreateGameSession(map_id);
     }
+    return game_.GetGameSession(map_id);
+}
+
+uint64_t Application::RestorePlayer(const serialization::DogRepr& ser_dog)
+{
+    auto[dog, dog_token, map_id] = ser_dog.Restore();
+    model::GameSession* game_session_ptr = GetOrCreateGameSession(model::Map::Id{map_id});
+    //Is there with the same name
+    auto [player, token] = players_.Add(dog.GetName(), *game_session_ptr, dog_token);
+    game_session_ptr->AddDog(player.GetDog());
+    player.SetId(dog.GetId());
+    player.SetCoordinates(dog.GetDogCoordinates());
+    player.SetDirection(dog.GetDogDirectionString());
+    player.SetScore(dog.GetScore());
+    for(const auto& loot_id : dog.GetDogsBag().GetAllIds())
+    {
+        player.AddIdOfTheLoot(loot_id);
+    }
+    auto restored_dog = player.GetDog();
+    restored_dog->SetDogSpeed(dog.GetDogSpeed());
+    restored_dog->SetGameTime(dog.GetGameTime_ms());
+    restored_dog->SetStandingTime(dog.GetStandingTime());
+    restored_dog->SetRetirement(dog.IsOnRetirement());
+    return dog.GetId();
 }
 
 uint64_t GetUint64_tFromJson(const boost::json::value& val)
@@ -235,74 +520,105 @@ uint64_t GetUint64_tFromJson(const boost::json::value& val)
 }
 
 
-void Application::RestorePlayers(const boost::json::array& players_json)
+std::vector<serialization::RetiredPlayerResult> Application::HandleLeavedPlayers()
 {
-    uint64_t max_id_dog = 0;
-    for(auto json_player : players_json)
-    {
-        std::stringstream string_stream;
-        string_stream.str(json_player.as_string().c_str());
-        boost::archive::text_iarchive ia{string_stream};
-        serialization::DogRepr ser_dog;
-        ia >> ser_dog;
-        auto[dog, dog_token, map_id] = ser_dog.Restore();
-        const model::GameSession* game_session_ptr = game_.FindGameSession(model::Map::Id{map_id});
-        if(game_session_ptr == nullptr)
-        {
-            game_session_ptr = game_.CreateGameSession(model::Map::Id{map_id});
-        }
-        //Is there with the same name
-        auto [player, token] = players_.Add(dog.GetName(), *game_session_ptr, dog_token);
-        game_.GetGameSession(model::Map::Id{map_id})->AddDog(player.GetDog());
-        if(dog.GetId() > max_id_dog)
-        {
-            max_id_dog = dog.GetId();
-        }
-        player.SetId(dog.GetId());
-        player.SetCoordinates(dog.GetDogCoordinates());
-        player.SetDirection(dog.GetDogDirectionString());
-        player.SetScore(dog.GetScore());
-        for(const auto& loot_id : dog.GetDogsBag().GetAllIds())
+    std::vector<serialization::RetiredPlayerResult> results;
+    for(const auto& map : game_.GetMaps())
+    {
+        model::GameSession* game_session_ptr = game_.GetGameSession(map.GetId());
+        if(game_session_ptr != nullptr)
         {
-            player.AddIdOfTheLoot(loot_id);
+            for(auto& player_info : players_.RemoveRetiredPlayersInSession(map.GetId(), game_session_ptr))
+            {
+                results.push_back(serialization::RetiredPlayerResult{
+                    .id = database::domain::Player::PlayerId::New().ToString(),
+                    .name = std::move(player_info.name_),
+                    .score = player_info.score_,
+                    .play_time_ms = player_info.total_active_time_ms_
+                });
+            }
         }
     }
-    model::id_counter = max_id_dog + 1;
+    return results;
 }
 
-void Application::RestoreItems(boost::json::array& file_json)
+void Application::SubmitPendingResults()
 {
-    for(auto& json_obj : file_json)
+    pending_results_count_.store(pending_results_.size(), std::memory_order_relaxed);
+    if(is_saving_results_ || pending_results_.empty())
     {
-        std::stringstream string_stream;
-        string_stream.str(json_obj.as_object().at("loots_in_map").as_string().c_str());
-        boost::archive::text_iarchive ia{string_stream};
-        model::LootsWrappler loots_wrappler;
-        ia >> loots_wrappler;
-        std::string map_id(json_obj.as_object().at("map_id").as_string().c_str());
-        game_.GetGameSession(model::Map::Id{map_id})->GetLootsInSession() = std::move(loots_wrappler);
+        return;
     }
+    is_saving_results_ = true;
+    // Запись идёт в пуле БД, такт базу не ждёт. Результат считается сохранённым,
+    // только когда его id вернулся на strand и подтверждение попало в журнал
+    net::post(db_executor_, [this, results = pending_results_, journal = journal_.get()] {
+        std::vector<std::string> saved_ids;
+        std::optional<std::string> error;
+        try
+        {
+            // В базу попадают только результаты тактов, уже записанных на диск. Иначе после
+            // сбоя игрок восстановился бы из журнала и выбыл заново с другим id
+            if(journal != nullptr)
+            {
+                journal->Flush();
+            }
+            database::app::UseCasesImpl use_cases(unit_of_work_factory_);
+            for(const auto& result : results)
+            {
+                use_cases.SavePlayer(database::domain::Player(database::domain::Player::PlayerId::FromString(result.id),
+                                                              result.name, result.score, result.play_time_ms));
+                saved_ids.push_back(result.id);
+            }
+        }
+        catch(const std::exception& ex)
+        {
+            error = ex.what();
+        }
+        net::dispatch(strand_, [this, saved_ids = std::move(saved_ids), error = std::move(error)]() mutable {
+            OnResultsSaved(std::move(saved_ids), std::move(error));
+        });
+    });
 }
 
-void Application::HandleLeavedPlayers()
+void Application::OnResultsSaved(std::vector<std::string> saved_ids, std::optional<std::string> error)
 {
-    for(auto map : game_.GetMaps())
+    if(!saved_ids.empty())
     {
-        model::GameSession* game_session_ptr = game_.GetGameSession(map.GetId());
-        if(game_session_ptr != nullptr)
+        ErasePendingResults(saved_ids);
+        if(journal_ != nullptr)
         {
-            auto retired_players = players_.RemoveRetiredPlayersInSession(map.GetId(), game_session_ptr);
-            if(!retired_players.empty())
+            journal_->Append(serialization::ResultsSavedRecord{.ids = std::move(saved_ids)});
+        }
+    }
+    if(error.has_value())
+    {
+        // Результаты остаются в очереди и отправляются повторно с растущей задержкой
+        results_save_failures_.fetch_add(1, std::memory_order_relaxed);
+        LogJson(boost::json::object{{"players", pending_results_.size()}, {"retry_in_ms", results_retry_delay_.count()}, {"exception", *error}},
+                "saving retired players failed", LogLevel::kError);
+        results_retry_timer_.expires_after(results_retry_delay_);
+        results_retry_delay_ = std::min(results_retry_delay_ * 2, max_results_retry_delay);
+        results_retry_timer_.async_wait([this](sys::error_code ec) {
+            if(!ec)
             {
-                database::app::UseCasesImpl use_cases(database_.GetUnitOfWorkImpl());
-                for(auto player_info : retired_players)
-                {
-                    use_cases.SavePlayer(database::domain::Player(database::domain::Player::PlayerId::New(), player_info.name_, player_info.score_, player_info.total_active_time_ms_));
-                }
+                is_saving_results_ = false;
+                SubmitPendingResults();
             }
-        }
-
+        });
+        return;
     }
+    results_retry_delay_ = min_results_retry_delay;
+    is_saving_results_ = false;
+    SubmitPendingResults();
+}
+
+void Application::ErasePendingResults(const std::vector<std::string>& ids)
+{
+    std::erase_if(pending_results_, [&ids](const serialization::RetiredPlayerResult& result) {
+        return std::find(ids.begin(), ids.end(), result.id) != ids.end();
+    });
+    pending_results_count_.store(pending_results_.size(), std::memory_order_relaxed);
 }
 
 }
\ No newline at end of file
@@ -10,19 +10,24 @@
 #include <list>
 #include <filesystem>
 #include <vector>
+#include <atomic>
 
 #include <boost/asio/strand.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/signals2.hpp>
-#include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
 #include "../game/game.h"
-#include "../database/database.h"
+#include "../database/unit_of_work.h"
 #include "../database/use_cases.h"
+#include "../serialization/snapshot.h"
+#include "../metrics/histogram.h"
+#include "../metrics/registry.h"
 
 #include "players.h"
+#include "state_writer.h"
+#include "action_journal.h"
 
 namespace app{
 
@@ -69,9 +74,14 @@ public:
     }
 
     using Strand = net::strand<net::io_context::executor_type>;
-    Application(model::Game& game, bool is_randomize_spawn_points, Strand& strand, database::Database& database);
-
-    void RecoverFromFile(std::string_view state_file_path);
+    using Executor = net::io_context::executor_type;
+    // db_executor - пул для блокирующих обращений к БД
+    Application(model::Game& game, bool is_randomize_spawn_points, Strand& strand,
+                database::app::UnitOfWorkFactory& unit_of_work_factory, Executor db_executor);
+
+    // Если задан journal_config, после загрузки снимка применяются записи журнала действий,
+    // а дальнейшие действия игроков записываются в журнал
+    void RecoverFromFile(std::string_view state_file_path, std::optional<ActionJournal::Config> journal_config = std::nullopt);
     void TurnOnAutoTickingMode(std::chrono::milliseconds tick_value_ms);
 
     const model::Map* FindMap(const model::Map::Id& id) const noexcept;
@@ -81,6 +91,8 @@ public:
 
     std::shared_ptr<Player> FindPlayerByToken(Token token);
 
+    void MoveAction(Token token, std::string_view move);
+
     const std::deque<std::shared_ptr<Player>> GetAllPlayersInSessionWithCurrentPlayer(Token current_player_token);
     const model::GameSession* GetGameSessionByPlayer(Token player_token);
 
@@ -89,15 +101,42 @@ public:
 
     bool IsTickerRunning() const noexcept;
 
+    // Число тактов с запуска сервера; меняется и читается на strand. К моменту
+    // вызова обработчиков DoOnTick уже учитывает текущий такт
+    uint64_t GetTickNumber() const noexcept
+    {
+        return tick_number_;
+    }
+
+    // Снимает состояние на strand и записывает его в текущем потоке
     void SaveState();
-    void RecoverState();
+    // Снимает состояние на strand и передаёт его на запись фоновому потоку
+    void SaveStateInBackground();
+    // Возвращает номер записи журнала, на которой был снят восстановленный снимок
+    uint64_t RecoverState();
+
+    const StateWriter* GetStateWriter() const noexcept;
+    const ActionJournal* GetJournal() const noexcept;
+
+    // Длительность такта, размер мира, запись состояния и журнала.
+    // Может вызываться из любого потока
+    void CollectMetrics(metrics::PrometheusWriter& writer) const;
 
     std::vector<database::domain::Player> GetPlayersStats(uint64_t offset, uint64_t limit)
     {
-        database::app::UseCasesImpl use_cases(database_.GetUnitOfWorkImpl());
+        database::app::UseCasesImpl use_cases(unit_of_work_factory_);
         return use_cases.GetPlayersStat(offset, limit);
     }
+
+    // Результаты выбывших игроков, ещё не подтверждённые базой. Может вызываться из любого потока
+    uint64_t GetPendingResultsCount() const noexcept
+    {
+        return pending_results_count_.load(std::memory_order_relaxed);
+    }
 private:
+    static constexpr std::chrono::milliseconds min_results_retry_delay{1000};
+    static constexpr std::chrono::milliseconds max_results_retry_delay{30000};
+
     model::Game& game_;
     Strand& strand_;
     Players players_;
@@ -105,17 +144,51 @@ private:
     bool is_ticker_running_ = false;
     bool is_randomize_spawn_points_ = false;
     std::filesystem::path path_to_state_file_;
+    // Журнал объявлен раньше: StateWriter обращается к нему после записи снимка
+    std::unique_ptr<ActionJournal> journal_;
+    std::unique_ptr<StateWriter> state_writer_;
     TickSignal tick_signal_;
-
-    database::Database& database_;
-
-    void SerializePlayers(boost::json::object& file_json);
-    void SerializeItems(boost::json::object& file_json);
-
-    void RestorePlayers(const boost::json::array& players_json);
-    void RestoreItems(boost::json::array& file_json);
-
-    void HandleLeavedPlayers();
+    uint64_t tick_number_ = 0;
+
+    // Длительность такта, мкс
+    metrics::Histogram tick_duration_us_;
+    // Время снятия снимка состояния на strand, мкс
+    metrics::Histogram capture_duration_us_;
+    // Обновляются в конце такта, читаются при сборе метрик
+    std::atomic<uint64_t> sessions_count_{0};
+    std::atomic<uint64_t> dogs_count_{0};
+    std::atomic<uint64_t> loots_count_{0};
+
+    database::app::UnitOfWorkFactory& unit_of_work_factory_;
+    Executor db_executor_;
+    // Результаты выбывших игроков, ещё не подтверждённые базой. Попадают в журнал
+    // с тактом и в снимок, поэтому переживают перезапуск и отправляются повторно
+    std::vector<serialization::RetiredPlayerResult> pending_results_;
+    bool is_saving_results_ = false;
+    net::steady_timer results_retry_timer_{strand_};
+    std::chrono::milliseconds results_retry_delay_ = min_results_retry_delay;
+    std::atomic<uint64_t> pending_results_count_{0};
+    std::atomic<uint64_t> results_save_failures_{0};
+
+    std::shared_ptr<const serialization::EncodedStateSnapshot> CaptureState();
+    std::vector<serialization::SessionDog> CaptureDogs(const model::Map::Id& map_id);
+
+    void RestoreSnapshot(std::vector<serialization::SessionSnapshot>&& sessions);
+    uint64_t ReplayJournal(uint64_t after_lsn);
+    void ReplayJoin(const serialization::JoinRecord& record);
+    void ReplayMove(const serialization::MoveRecord& record);
+    void ReplayTick(const serialization::TickRecord& record);
+    void ReplayResultsSaved(const serialization::ResultsSavedRecord& record);
+    void RecoverLegacyJsonState(const std::string& json_string);
+    model::GameSession* GetOrCreateGameSession(const model::Map::Id& map_id);
+    uint64_t RestorePlayer(const serialization::DogRepr& ser_dog);
+
+    // Удаляет выбывших игроков и возвращает их результаты с новыми id
+    std::vector<serialization::RetiredPlayerResult> HandleLeavedPlayers();
+    // Передаёт неподтверждённые результаты пулу БД, если запись ещё не идёт
+    void SubmitPendingResults();
+    void OnResultsSaved(std::vector<std::string> saved_ids, std::optional<std::string> error);
+    void ErasePendingResults(const std::vector<std::string>& ids);
 };
 
 }
\ No newline at end of file
@@ -88,16 +88,25 @@ std::shared_ptr<Player> PlayerTokens::FindPlayerByToken(Token token) {
     return nullptr;
 }
 
-std::optional<Token> PlayerTokens::GetTokenByMapIdAndName(std::string user_name, std::string map_id)
+std::optional<Token> PlayerTokens::GetTokenByMapIdAndName(const std::string& user_name, const std::string& map_id)
+{
+    if(const Token* token = FindTokenByMapIdAndName(user_name, map_id); token != nullptr)
+    {
+        return *token;
+    }
+    return std::nullopt;
+}
+
+const Token* PlayerTokens::FindTokenByMapIdAndName(const std::string& user_name, const std::string& map_id) const
 {
     if(auto it = map_id_user_name_to_token_.find(map_id); it != map_id_user_name_to_token_.end())
     {
-        if(it->second.find(user_name) != it->second.end())
+        if(auto it_token = it->second.find(user_name); it_token != it->second.end())
         {
-            return *it->second.at(user_name);
+            return it_token->second;
         }
     }
-    return std::nullopt;
+    return nullptr;
 }
 
 std::string GetTokenHexStringFromNumbers(uint64_t m_part, uint64_t l_part)
@@ -121,15 +130,16 @@ Token PlayerTokens::AddPlayer(Player& player, std::string map_id, std::string_vi
     if(token_str.empty())
     {
         *token = GetTokenHexStringFromNumbers(generator1_(), generator2_());
+        ResetGenerators();
     }
     else
     {
+        // Токен восстановлен из сохранённого состояния, генераторы не используются
         *token = std::string{token_str};
     }
     tokens_.push_back(token);
     token_to_player_.insert({tokens_.back(), std::make_shared<Player>(player)});
     map_id_user_name_to_token_[map_id].insert({player.GetDog()->GetName(), &tokens_.back()});
-    ResetGenerators();
     return token;
 }
 
@@ -201,11 +211,26 @@ std::list<std::shared_ptr<Player>>& Players::GetAllPlayers()
     return players_;
 }
 
-std::optional<Token> Players::GetTokenByMapIdAndName(std::string user_name, std::string map_id)
+const std::deque<std::shared_ptr<Player>>& Players::GetPlayersInSession(const model::Map::Id& map_id) const
+{
+    static const std::deque<std::shared_ptr<Player>> no_players;
+    if(auto it = session_to_players_.find(map_id); it != session_to_players_.end())
+    {
+        return it->second;
+    }
+    return no_players;
+}
+
+std::optional<Token> Players::GetTokenByMapIdAndName(const std::string& user_name, const std::string& map_id)
 {
     return players_tokens_.GetTokenByMapIdAndName(user_name, map_id);
 }
 
+const Token* Players::FindTokenByMapIdAndName(const std::string& user_name, const std::string& map_id) const
+{
+    return players_tokens_.FindTokenByMapIdAndName(user_name, map_id);
+}
+
 
 
 std::deque<PlayerInfo> Players::RemoveRetiredPlayersInSession(const model::Map::Id& map_id, model::GameSession* game_session_ptr)
@@ -52,7 +52,9 @@ class PlayerTokens
 {
 public:
     std::shared_ptr<Player> FindPlayerByToken(Token token);
-    std::optional<Token> GetTokenByMapIdAndName(std::string user_name, std::string map_id);
+    std::optional<Token> GetTokenByMapIdAndName(const std::string& user_name, const std::string& map_id);
+    // nullptr - игрока нет. Указатель действителен, пока игрок не удалён
+    const Token* FindTokenByMapIdAndName(const std::string& user_name, const std::string& map_id) const;
     Token AddPlayer(Player& player, std::string map_id, std::string_view token_str = "");
 
     void RemovePlayer(const std::string& user_name, const std::string& map_id);
@@ -88,7 +90,9 @@ public:
     std::shared_ptr<Player> FindByToken(Token token);
     std::deque<std::shared_ptr<Player>> GetAllPlayersInSessionWithCurrentPlayer(Token current_player_token);
     std::list<std::shared_ptr<Player>>& GetAllPlayers();
-    std::optional<Token> GetTokenByMapIdAndName(std::string user_name, std::string map_id);
+    const std::deque<std::shared_ptr<Player>>& GetPlayersInSession(const model::Map::Id& map_id) const;
+    std::optional<Token> GetTokenByMapIdAndName(const std::string& user_name, const std::string& map_id);
+    const Token* FindTokenByMapIdAndName(const std::string& user_name, const std::string& map_id) const;
     std::deque<PlayerInfo> RemoveRetiredPlayersInSession(const model::Map::Id& map_id, model::GameSession* game_session_ptr);
     std::optional<PlayerInfo> RemovePlayer(const model::Map::Id& map_id, std::string name);
 
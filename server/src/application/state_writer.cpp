@@ -0,0 +1,161 @@
+#include "state_writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+#include "../logging/logger.h"
+
+namespace app
+{
+
+namespace
+{
+void ThrowSystemError(const char* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+} // namespace
+
+StateWriter::StateWriter(std::filesystem::path state_file_path, SavedHandler on_saved)
+    : state_file_path_(std::move(state_file_path))
+    , on_saved_(std::move(on_saved))
+    , thread_([this](std::stop_token stop) { Run(stop); })
+{
+}
+
+StateWriter::~StateWriter()
+{
+    thread_.request_stop();
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void StateWriter::SaveInBackground(SnapshotPtr snapshot)
+{
+    {
+        std::lock_guard lock{mutex_};
+        if(pending_ != nullptr)
+        {
+            skipped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending_ = std::move(snapshot);
+    }
+    cond_var_.notify_one();
+}
+
+void StateWriter::SaveNow(const SnapshotPtr& snapshot)
+{
+    {
+        // Более старый снимок из очереди уже не нужен
+        std::lock_guard lock{mutex_};
+        if(pending_ != nullptr)
+        {
+            pending_.reset();
+            skipped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    Write(*snapshot);
+}
+
+void StateWriter::Run(std::stop_token stop)
+{
+    while(true)
+    {
+        SnapshotPtr snapshot;
+        {
+            std::unique_lock lock{mutex_};
+            cond_var_.wait(lock, stop, [this] { return pending_ != nullptr; });
+            if(pending_ == nullptr)
+            {
+                // Остановка без ожидающих снимков
+                return;
+            }
+            snapshot = std::move(pending_);
+        }
+        try
+        {
+            Write(*snapshot);
+        }
+        catch(const std::exception& ex)
+        {
+            // Ошибка записи не должна останавливать сервер: следующий снимок попробует снова
+            failed_.fetch_add(1, std::memory_order_relaxed);
+            LogJson(boost::json::object{{"path", state_file_path_.string()}, {"exception", ex.what()}}, "state save failed", LogLevel::kError);
+        }
+    }
+}
+
+void StateWriter::Write(const serialization::EncodedStateSnapshot& snapshot)
+{
+    using namespace std::chrono;
+    std::lock_guard lock{file_mutex_};
+    const auto start = steady_clock::now();
+    WriteFileAtomically(serialization::BuildSnapshot(snapshot));
+    const auto end = steady_clock::now();
+    save_duration_us_.Record(static_cast<uint64_t>(duration_cast<microseconds>(end - start).count()));
+    snapshot_age_ms_.Record(static_cast<uint64_t>(duration_cast<milliseconds>(end - snapshot.captured_at).count()));
+    if(on_saved_)
+    {
+        on_saved_(snapshot);
+    }
+}
+
+void StateWriter::WriteFileAtomically(const std::string& data)
+{
+    std::filesystem::path temp_file_path(state_file_path_);
+    temp_file_path += ".tmp";
+    const int fd = ::open(temp_file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        ThrowSystemError("Can't open temporary state file");
+    }
+    size_t written = 0;
+    while(written < data.size())
+    {
+        const ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+        if(result < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            ::close(fd);
+            ThrowSystemError("Can't write temporary state file");
+        }
+        written += static_cast<size_t>(result);
+    }
+    // Данные должны оказаться на диске до переименования, иначе после сбоя
+    // можно получить пустой файл состояния
+    if(::fsync(fd) != 0)
+    {
+        ::close(fd);
+        ThrowSystemError("Can't sync temporary state file");
+    }
+    ::close(fd);
+    std::filesystem::rename(temp_file_path, state_file_path_);
+    // Переименование становится надёжным только после fsync каталога: иначе после сбоя
+    // останется старый снимок, а сегменты журнала, вошедшие в новый, уже будут удалены
+    std::filesystem::path dir_path = state_file_path_.parent_path();
+    if(dir_path.empty())
+    {
+        dir_path = ".";
+    }
+    const int dir_fd = ::open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dir_fd < 0)
+    {
+        ThrowSystemError("Can't open state file directory");
+    }
+    const int sync_result = ::fsync(dir_fd);
+    ::close(dir_fd);
+    if(sync_result != 0)
+    {
+        ThrowSystemError("Can't sync state file directory");
+    }
+}
+
+} // namespace app
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../serialization/snapshot.h"
+#include "../metrics/histogram.h"
+
+namespace app {
+
+// Фоновая запись снимков состояния в файл.
+// Снимок снимается и кодируется по сессиям на strand игры, а сборка файла с подсчётом
+// контрольных сумм и запись через временный файл с переименованием выполняются
+// в отдельном потоке. Если предыдущий снимок ещё не записан, он заменяется более свежим.
+class StateWriter {
+public:
+    using SnapshotPtr = std::shared_ptr<const serialization::EncodedStateSnapshot>;
+    // Вызывается после того, как снимок оказался на диске
+    using SavedHandler = std::function<void(const serialization::EncodedStateSnapshot& snapshot)>;
+
+    explicit StateWriter(std::filesystem::path state_file_path, SavedHandler on_saved = {});
+    ~StateWriter();
+
+    StateWriter(const StateWriter&) = delete;
+    StateWriter& operator=(const StateWriter&) = delete;
+
+    // Ставит снимок в очередь на запись и сразу возвращает управление
+    void SaveInBackground(SnapshotPtr snapshot);
+
+    // Записывает снимок в текущем потоке, дождавшись окончания фоновой записи
+    void SaveNow(const SnapshotPtr& snapshot);
+
+    // Длительность сборки и записи файла, мкс
+    const metrics::Histogram& GetSaveDurationHistogram() const noexcept {
+        return save_duration_us_;
+    }
+
+    // Возраст снимка в момент, когда он оказался на диске, мс
+    const metrics::Histogram& GetSnapshotAgeHistogram() const noexcept {
+        return snapshot_age_ms_;
+    }
+
+    // Количество снимков, заменённых более свежими до записи
+    uint64_t GetSkippedCount() const noexcept {
+        return skipped_.load(std::memory_order_relaxed);
+    }
+
+    // Количество фоновых записей, завершившихся ошибкой
+    uint64_t GetFailedCount() const noexcept {
+        return failed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Run(std::stop_token stop);
+    void Write(const serialization::EncodedStateSnapshot& snapshot);
+    void WriteFileAtomically(const std::string& data);
+
+    std::filesystem::path state_file_path_;
+    SavedHandler on_saved_;
+
+    std::mutex mutex_;
+    std::condition_variable_any cond_var_;
+    SnapshotPtr pending_;
+
+    // Сериализует запись файла между фоновым потоком и SaveNow
+    std::mutex file_mutex_;
+
+    metrics::Histogram save_duration_us_;
+    metrics::Histogram snapshot_age_ms_;
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> failed_{0};
+
+    std::jthread thread_;
+};
+
+}  // namespace app
@@ -2,6 +2,8 @@
 #include <boost/program_options.hpp>
 #include <optional>
 #include <iostream>
+#include <string>
+#include <vector>
 
 namespace cl_pars {
 struct Args {
@@ -12,6 +14,38 @@ struct Args {
     std::string state_file_ = "";
     uint64_t save_state_period_ms_ = 0;
     bool with_save_state_period = true;
+    uint64_t db_pool_min_size_ = 1;
+    uint64_t db_pool_max_size_ = 0;  // 0 - по количеству рабочих потоков
+    uint64_t db_acquire_timeout_ms_ = 5000;
+    uint64_t db_idle_timeout_ms_ = 60000;
+    bool is_journal_enabled_ = false;
+    uint64_t journal_commit_window_ms_ = 2;
+    uint64_t journal_checkpoint_records_ = 100000;
+    std::string compile_config_;
+    std::string log_level_ = "info";
+    std::vector<std::string> log_sample_rates_;
+    uint64_t log_slow_threshold_ms_ = 100;
+    uint16_t admin_port_ = 0;   // 0 - административный порт не открывается
+    bool is_tick_profiler_enabled_ = false;
+    bool is_trace_enabled_ = false;
+    std::string trace_file_ = "trace.json";
+    bool is_server_timing_enabled_ = false;
+    uint64_t api_queue_max_depth_ = 0;      // 0 - без ограничения
+    uint64_t api_queue_max_wait_ms_ = 0;    // 0 - без ограничения
+    uint64_t retry_after_s_ = 1;
+    uint64_t static_cache_max_file_size_ = 8 * 1024 * 1024;    // 0 - кэш статических файлов выключен
+    bool is_static_watch_enabled_ = false;
+    std::vector<std::string> listen_ = {"tcp://0.0.0.0:8080"};
+    bool is_reuse_port_enabled_ = false;
+    uint64_t pending_accepts_ = 4;
+    uint64_t idle_timeout_s_ = 30;
+    uint64_t state_long_poll_timeout_ms_ = 25000;  // 0 - долгий опрос состояния выключен
+    std::string thread_topology_ = "shared";
+    unsigned net_threads_ = 0;  // 0 - по количеству процессоров
+    unsigned io_threads_ = 2;
+    std::string net_cpus_;      // пусто - без привязки к процессорам
+    std::string sim_cpus_;
+    std::string io_cpus_;
 };
 
 [[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
@@ -28,7 +62,39 @@ struct Args {
         ("www-root,w",              po::value(&args.www_root_)->value_name("dir"),                                  "Set path to static files")
         ("randomize-spawn-points",  po::value(&args.is_randomize_spawn_points_)->value_name("bool"),                "Set dog spawn mode(random/not random)")
         ("state-file",              po::value(&args.state_file_)->value_name("file"),                               "Set path to state file")
-        ("save-state-period",       po::value(&args.save_state_period_ms_)->value_name("milliseconds"s),            "Set save state period");
+        ("save-state-period",       po::value(&args.save_state_period_ms_)->value_name("milliseconds"s),            "Set save state period")
+        ("db-pool-min",             po::value(&args.db_pool_min_size_)->value_name("count"s),                       "Set minimum number of DB connections")
+        ("db-pool-max",             po::value(&args.db_pool_max_size_)->value_name("count"s),                       "Set maximum number of DB connections")
+        ("db-acquire-timeout",      po::value(&args.db_acquire_timeout_ms_)->value_name("milliseconds"s),           "Set timeout of waiting for a DB connection")
+        ("db-idle-timeout",         po::value(&args.db_idle_timeout_ms_)->value_name("milliseconds"s),              "Set idle time after which extra DB connections are closed")
+        ("journal",                 po::value(&args.is_journal_enabled_)->value_name("bool"),                       "Write action journal next to the state file")
+        ("journal-commit-window",   po::value(&args.journal_commit_window_ms_)->value_name("milliseconds"s),        "Set time to collect journal records before fsync")
+        ("journal-checkpoint-records", po::value(&args.journal_checkpoint_records_)->value_name("count"s),          "Save state after this many journal records (0 - only by save-state-period)")
+        ("compile-config",          po::value(&args.compile_config_)->value_name("file"),                           "Compile config-file into a binary map bundle and exit")
+        ("log-level",               po::value(&args.log_level_)->value_name("debug|info|warning|error"s),           "Set initial log level")
+        ("log-sample",              po::value(&args.log_sample_rates_)->multitoken()->value_name("route=N"s),       "Log only one of N requests to route (join, players, state, action, tick, maps, records, api, static)")
+        ("log-slow-threshold",      po::value(&args.log_slow_threshold_ms_)->value_name("milliseconds"s),           "Always log responses slower than this")
+        ("admin-port",              po::value(&args.admin_port_)->value_name("port"s),                              "Serve admin endpoints on 127.0.0.1:port")
+        ("tick-profiler",           po::value(&args.is_tick_profiler_enabled_)->value_name("bool"),                 "Measure tick phases from start (see /admin/tick-profile)")
+        ("trace",                   po::value(&args.is_trace_enabled_)->value_name("bool"),                         "Record request and tick spans from start (see /admin/trace)")
+        ("trace-file",              po::value(&args.trace_file_)->value_name("file"),                               "Write recorded spans to this file on SIGUSR1")
+        ("server-timing",           po::value(&args.is_server_timing_enabled_)->value_name("bool"),                 "Add Server-Timing header to all API responses (otherwise only to requests with X-Debug-Timing)")
+        ("api-queue-max-depth",     po::value(&args.api_queue_max_depth_)->value_name("count"s),                    "Reject players requests with 503 when this many API handlers wait for the game strand (0 - no limit)")
+        ("api-queue-max-wait",      po::value(&args.api_queue_max_wait_ms_)->value_name("milliseconds"s),           "Reject players requests with 503 when API handlers wait longer for the game strand (0 - no limit)")
+        ("retry-after",             po::value(&args.retry_after_s_)->value_name("seconds"s),                        "Retry-After value for rejected requests")
+        ("static-cache-max-file-size", po::value(&args.static_cache_max_file_size_)->value_name("bytes"s),           "Keep static files up to this size in memory (0 - always read from disk)")
+        ("static-watch",            po::value(&args.is_static_watch_enabled_)->value_name("bool"),                  "Reload static file cache when www-root changes (inotify)")
+        ("listen",                  po::value(&args.listen_)->composing()->value_name("tcp://host:port|unix://path"s), "Accept HTTP connections on this address; may be repeated")
+        ("reuse-port",              po::value(&args.is_reuse_port_enabled_)->value_name("bool"),                    "Open a SO_REUSEPORT acceptor per network thread; always on with per-core thread topology, ignored with shared")
+        ("pending-accepts",         po::value(&args.pending_accepts_)->value_name("count"s),                        "Keep this many accepts outstanding on each acceptor")
+        ("idle-timeout",            po::value(&args.idle_timeout_s_)->value_name("seconds"s),                       "Close connections that send no request or read no response for this long")
+        ("state-long-poll-timeout", po::value(&args.state_long_poll_timeout_ms_)->value_name("milliseconds"s),      "Longest wait of GET state?sinceTick=N for the next tick (0 - answer at once)")
+        ("thread-topology",         po::value(&args.thread_topology_)->value_name("shared|per-core"s),              "shared - one pool for network and game; per-core - io_context per network thread and a separate simulation thread")
+        ("net-threads",             po::value(&args.net_threads_)->value_name("count"s),                            "Set number of network threads (0 - by CPU count)")
+        ("io-threads",              po::value(&args.io_threads_)->value_name("count"s),                             "Set number of threads for blocking database calls")
+        ("net-cpus",                po::value(&args.net_cpus_)->value_name("list"s),                                "Pin network threads to CPUs, e.g. 0-3,6")
+        ("sim-cpus",                po::value(&args.sim_cpus_)->value_name("list"s),                                "Pin simulation thread to CPUs (per-core topology)")
+        ("io-cpus",                 po::value(&args.io_cpus_)->value_name("list"s),                                 "Pin database threads to CPUs");
     
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -42,7 +108,7 @@ struct Args {
         throw std::runtime_error("There is not path to config-file");
     }
 
-    if (!vm.contains("www-root")) {
+    if (!vm.contains("www-root") && args.compile_config_.empty()) {
         throw std::runtime_error("There is not path to static files");
     }
 
@@ -50,6 +116,22 @@ struct Args {
         args.with_save_state_period = false;
     }
 
+    if (args.is_journal_enabled_ && args.state_file_.empty()) {
+        throw std::runtime_error("Action journal requires state-file");
+    }
+
+    if (args.idle_timeout_s_ == 0) {
+        throw std::runtime_error("Idle timeout must be positive");
+    }
+
+    if (args.state_long_poll_timeout_ms_ >= args.idle_timeout_s_ * 1000) {
+        throw std::runtime_error("State long-poll timeout must be shorter than idle timeout");
+    }
+
+    if (args.thread_topology_ != "shared" && args.thread_topology_ != "per-core") {
+        throw std::runtime_error("Unknown thread topology " + args.thread_topology_);
+    }
+
     return args;
 }
 
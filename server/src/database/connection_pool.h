@@ -3,32 +3,73 @@
 #include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <cassert>
 
 #include <pqxx/pqxx>
 
+#include "../metrics/histogram.h"
+
 namespace database
 {
 
+// Пул соединений с минимальным и максимальным размером.
+// Захват и возврат соединения выполняются без блокировок (CAS по состоянию слота),
+// мьютекс используется только для ожидания, когда все соединения заняты.
+// Фоновый поток переподключает сломанные соединения и закрывает лишние простаивающие.
 class ConnectionPool {
     using PoolType = ConnectionPool;
     using ConnectionPtr = std::shared_ptr<pqxx::connection>;
+    using ConnectionFactory = std::function<ConnectionPtr()>;
+    using Clock = std::chrono::steady_clock;
 
   public:
+    struct Config {
+        size_t min_size = 1;
+        size_t max_size = 1;
+        std::chrono::milliseconds acquire_timeout{5000};
+        std::chrono::milliseconds idle_timeout{60000};
+        std::chrono::milliseconds maintenance_period{1000};
+    };
+
+    class AcquireTimeoutError : public std::runtime_error {
+      public:
+        using std::runtime_error::runtime_error;
+    };
+
     class ConnectionWrapper {
       public:
         ConnectionWrapper(
-            std::shared_ptr<pqxx::connection>&& conn, PoolType& pool
+            pqxx::connection& conn, size_t slot, PoolType& pool
         ) noexcept :
-            conn_{std::move(conn)},
+            conn_{&conn},
+            slot_{slot},
             pool_{&pool} {}
 
         ConnectionWrapper(const ConnectionWrapper&) = delete;
         ConnectionWrapper& operator=(const ConnectionWrapper&) = delete;
 
-        ConnectionWrapper(ConnectionWrapper&&) = default;
-        ConnectionWrapper& operator=(ConnectionWrapper&&) = default;
+        ConnectionWrapper(ConnectionWrapper&& other) noexcept
+            : conn_{std::exchange(other.conn_, nullptr)}
+            , slot_{other.slot_}
+            , pool_{other.pool_} {}
+
+        ConnectionWrapper& operator=(ConnectionWrapper&& other) noexcept {
+            if (this != &other) {
+                Release();
+                conn_ = std::exchange(other.conn_, nullptr);
+                slot_ = other.slot_;
+                pool_ = other.pool_;
+            }
+            return *this;
+        }
 
         pqxx::connection& operator*() const& noexcept {
             return *conn_;
@@ -36,59 +77,290 @@ class ConnectionPool {
         pqxx::connection& operator*() const&& = delete;
 
         pqxx::connection* operator->() const& noexcept {
-            return conn_.get();
+            return conn_;
         }
 
         ~ConnectionWrapper() {
+            Release();
+        }
+
+      private:
+        void Release() noexcept {
             if (conn_) {
-                pool_->ReturnConnection(std::move(conn_));
+                pool_->ReturnConnection(slot_);
+                conn_ = nullptr;
             }
         }
 
-      private:
-        std::shared_ptr<pqxx::connection> conn_;
+        pqxx::connection* conn_;
+        size_t slot_;
         PoolType* pool_;
     };
 
     // ConnectionFactory is a functional object returning
     // std::shared_ptr<pqxx::connection>
-    template <typename ConnectionFactory>
-    ConnectionPool(size_t capacity, ConnectionFactory&& connection_factory) {
-        pool_.reserve(capacity);
-        for (size_t i = 0; i < capacity; ++i) {
-            pool_.emplace_back(connection_factory());
+    template <typename Factory>
+    ConnectionPool(Config config, Factory&& connection_factory)
+        : config_{NormalizeConfig(config)}
+        , connection_factory_{std::forward<Factory>(connection_factory)}
+        , slots_{std::make_unique<Slot[]>(config_.max_size)} {
+        reconnect_queue_.reserve(config_.max_size);
+        for (size_t i = 0; i < config_.min_size; ++i) {
+            slots_[i].conn = connection_factory_();
+            slots_[i].last_used.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            slots_[i].state.store(SlotState::kIdle, std::memory_order_release);
         }
+        maintenance_thread_ = std::jthread([this](std::stop_token stop) {
+            MaintenanceLoop(stop);
+        });
+    }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    ~ConnectionPool() {
+        maintenance_thread_.request_stop();
+        maintenance_cond_var_.notify_all();
     }
 
     ConnectionWrapper GetConnection() {
+        // Быстрый путь: свободное соединение есть или пул может вырасти
+        if (auto conn = TryAcquire()) {
+            wait_time_us_.Record(0);
+            return std::move(*conn);
+        }
+
+        const auto start = Clock::now();
+        const auto deadline = start + config_.acquire_timeout;
         std::unique_lock lock{mutex_};
-        // Блокируем текущий поток и ждём, пока cond_var_ не получит уведомление
-        // и не освободится хотя бы одно соединение
-        cond_var_.wait(lock, [this] {
-            return used_connections_ < pool_.size();
-        });
-        // После выхода из цикла ожидания мьютекс остаётся захваченным
+        waiters_.fetch_add(1);
+        while (true) {
+            if (auto conn = TryAcquire()) {
+                waiters_.fetch_sub(1);
+                RecordWaitTime(start);
+                return std::move(*conn);
+            }
+            if (cond_var_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                if (auto conn = TryAcquire()) {
+                    waiters_.fetch_sub(1);
+                    RecordWaitTime(start);
+                    return std::move(*conn);
+                }
+                waiters_.fetch_sub(1);
+                RecordWaitTime(start);
+                throw AcquireTimeoutError("Timed out waiting for a database connection");
+            }
+        }
+    }
+
+    const Config& GetConfig() const noexcept {
+        return config_;
+    }
+
+    // Количество потоков, ожидающих соединение
+    size_t GetWaitersCount() const noexcept {
+        return waiters_.load(std::memory_order_relaxed);
+    }
 
-        return {std::move(pool_[used_connections_++]), *this};
+    // Количество открытых (или открываемых) соединений
+    size_t GetSize() const noexcept {
+        size_t size = 0;
+        for (size_t i = 0; i < config_.max_size; ++i) {
+            if (slots_[i].state.load(std::memory_order_relaxed) != SlotState::kEmpty) {
+                ++size;
+            }
+        }
+        return size;
+    }
+
+    // Время ожидания соединения в микросекундах
+    const metrics::Histogram& GetWaitTimeHistogram() const noexcept {
+        return wait_time_us_;
     }
 
   private:
-    void ReturnConnection(ConnectionPtr&& conn) {
-        // Возвращаем соединение обратно в пул
-        {
+    static constexpr std::chrono::milliseconds max_reconnect_delay{30000};
+
+    enum class SlotState : uint8_t {
+        kEmpty,     // соединения нет
+        kIdle,      // соединение открыто и свободно
+        kBusy,      // соединение выдано клиенту
+        kPending    // слот захвачен для открытия, переподключения или закрытия
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<SlotState> state{SlotState::kEmpty};
+        std::atomic<Clock::rep> last_used{0};
+        ConnectionPtr conn;
+    };
+
+    static Config NormalizeConfig(Config config) {
+        config.max_size = std::max<size_t>(1, config.max_size);
+        config.min_size = std::min(config.min_size, config.max_size);
+        return config;
+    }
+
+    static bool IsHealthy(const pqxx::connection& conn) noexcept {
+        return conn.is_open();
+    }
+
+    std::optional<ConnectionWrapper> TryAcquire() {
+        // Поиск всегда начинается с начала пула: горячие соединения переиспользуются,
+        // а хвост пула простаивает и закрывается фоновым потоком
+        for (size_t i = 0; i < config_.max_size; ++i) {
+            Slot& slot = slots_[i];
+            SlotState expected = SlotState::kIdle;
+            if (slot.state.compare_exchange_strong(expected, SlotState::kBusy)) {
+                if (IsHealthy(*slot.conn)) {
+                    return ConnectionWrapper{*slot.conn, i, *this};
+                }
+                ScheduleReconnect(i);
+            }
+        }
+        // Свободных соединений нет - пробуем открыть новое
+        for (size_t i = 0; i < config_.max_size; ++i) {
+            Slot& slot = slots_[i];
+            SlotState expected = SlotState::kEmpty;
+            if (slot.state.compare_exchange_strong(expected, SlotState::kPending, std::memory_order_acq_rel)) {
+                try {
+                    slot.conn = connection_factory_();
+                } catch (...) {
+                    slot.conn.reset();
+                    slot.state.store(SlotState::kEmpty);
+                    throw;
+                }
+                slot.state.store(SlotState::kBusy, std::memory_order_release);
+                return ConnectionWrapper{*slot.conn, i, *this};
+            }
+        }
+        return std::nullopt;
+    }
+
+    void ReturnConnection(size_t index) noexcept {
+        Slot& slot = slots_[index];
+        assert(slot.state.load() == SlotState::kBusy);
+        if (!IsHealthy(*slot.conn)) {
+            ScheduleReconnect(index);
+            return;
+        }
+        slot.last_used.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        // seq_cst в паре с waiters_: ожидающий поток либо увидит свободный слот,
+        // либо будет разбужен
+        slot.state.store(SlotState::kIdle);
+        NotifyWaiter();
+    }
+
+    void NotifyWaiter() {
+        if (waiters_.load() > 0) {
             std::lock_guard lock{mutex_};
-            assert(used_connections_ != 0);
-            pool_[--used_connections_] = std::move(conn);
+            cond_var_.notify_one();
+        }
+    }
+
+    void ScheduleReconnect(size_t index) noexcept {
+        slots_[index].state.store(SlotState::kPending, std::memory_order_release);
+        {
+            std::lock_guard lock{maintenance_mutex_};
+            reconnect_queue_.push_back(index);
         }
-        // Уведомляем один из ожидающих потоков об изменении состояния пула
-        cond_var_.notify_one();
+        maintenance_cond_var_.notify_one();
+    }
+
+    void RecordWaitTime(Clock::time_point start) noexcept {
+        const auto waited = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        wait_time_us_.Record(static_cast<uint64_t>(waited.count()));
     }
 
+    void MaintenanceLoop(std::stop_token stop) {
+        std::vector<size_t> to_reconnect;
+        // Слоты, которые не удалось переподключить. Они не входят в условие пробуждения,
+        // иначе при недоступной БД поток непрерывно вызывал бы connection_factory_
+        std::vector<size_t> failed;
+        auto retry_delay = config_.maintenance_period;
+        auto next_retry = Clock::now();
+        while (!stop.stop_requested()) {
+            {
+                std::unique_lock lock{maintenance_mutex_};
+                maintenance_cond_var_.wait_for(lock, stop, config_.maintenance_period, [this] {
+                    return !reconnect_queue_.empty();
+                });
+                to_reconnect.swap(reconnect_queue_);
+                reconnect_queue_.reserve(config_.max_size);
+            }
+            if (stop.stop_requested()) {
+                break;
+            }
+            if (!failed.empty() && Clock::now() >= next_retry) {
+                to_reconnect.insert(to_reconnect.end(), failed.begin(), failed.end());
+                failed.clear();
+            }
+            if (!to_reconnect.empty()) {
+                // Экспоненциальная задержка повторов, пока БД недоступна
+                if (Reconnect(to_reconnect, failed)) {
+                    retry_delay = std::min<std::chrono::milliseconds>(retry_delay * 2, max_reconnect_delay);
+                } else {
+                    retry_delay = config_.maintenance_period;
+                }
+                next_retry = Clock::now() + retry_delay;
+            }
+            ShrinkIdle();
+        }
+    }
+
+    // true - хотя бы одно переподключение не удалось, такие слоты добавлены в failed
+    bool Reconnect(std::vector<size_t>& to_reconnect, std::vector<size_t>& failed) {
+        const size_t failed_before = failed.size();
+        for (size_t index : to_reconnect) {
+            Slot& slot = slots_[index];
+            try {
+                slot.conn = connection_factory_();
+                slot.last_used.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                slot.state.store(SlotState::kIdle);
+                NotifyWaiter();
+            } catch (const std::exception&) {
+                slot.conn.reset();
+                failed.push_back(index);
+            }
+        }
+        to_reconnect.clear();
+        return failed.size() != failed_before;
+    }
+
+    void ShrinkIdle() {
+        size_t alive = GetSize();
+        const auto expire_before = (Clock::now() - config_.idle_timeout).time_since_epoch().count();
+        // Закрываем с хвоста, так как TryAcquire предпочитает начало пула
+        for (size_t i = config_.max_size; i-- > 0 && alive > config_.min_size;) {
+            Slot& slot = slots_[i];
+            if (slot.last_used.load(std::memory_order_relaxed) > expire_before) {
+                continue;
+            }
+            SlotState expected = SlotState::kIdle;
+            if (slot.state.compare_exchange_strong(expected, SlotState::kPending, std::memory_order_acq_rel)) {
+                slot.conn.reset();
+                slot.state.store(SlotState::kEmpty, std::memory_order_release);
+                --alive;
+            }
+        }
+    }
+
+    const Config config_;
+    ConnectionFactory connection_factory_;
+    std::unique_ptr<Slot[]> slots_;
+
     std::mutex mutex_;
     std::condition_variable cond_var_;
-    std::vector<ConnectionPtr> pool_;
-    size_t used_connections_ = 0;
+    std::atomic<size_t> waiters_{0};
+
+    std::mutex maintenance_mutex_;
+    std::condition_variable_any maintenance_cond_var_;
+    std::vector<size_t> reconnect_queue_;
+
+    metrics::Histogram wait_time_us_;
+
+    // Объявлен последним: поток останавливается до разрушения остальных полей
+    std::jthread maintenance_thread_;
 };
 
-    
-} // namespace database
\ No newline at end of file
+
+} // namespace database
@@ -2,10 +2,9 @@
 
 namespace database
 {
-    Database::Database(const char* db_url, unsigned num_threads)
+    Database::Database(const char* db_url, ConnectionPool::Config pool_config)
     : db_url_(db_url)
-    , num_threads_(num_threads)
-    , connection_pool_(num_threads, [db_url] {return std::make_shared<pqxx::connection>(db_url);})
+    , connection_pool_(pool_config, [db_url] {return std::make_shared<pqxx::connection>(db_url);})
     , unit_of_work_factory_(connection_pool_)
     {
         std::unique_ptr<ConnectionPool::ConnectionWrapper> conn = std::make_unique<ConnectionPool::ConnectionWrapper>(connection_pool_.GetConnection());
@@ -31,9 +30,9 @@ namespace database
         return db_url_;
     }
 
-    unsigned Database::GetNumThreads() const
+    const ConnectionPool::Config& Database::GetPoolConfig() const
     {
-        return num_threads_;
+        return connection_pool_.GetConfig();
     }
 
     database::postgres::UnitOfWorkFactoryImpl& Database::GetUnitOfWorkImpl()
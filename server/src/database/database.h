@@ -17,20 +17,19 @@ static const char* DB_ENV_NAME = "GAME_DB_URL";
 class Database {
 public:
     Database() = delete;
-    explicit Database(const char* db_url, unsigned num_threads);
+    explicit Database(const char* db_url, ConnectionPool::Config pool_config);
 
     ConnectionPool& GetConnectionPool();
 
     const char* GetDbUrl() const;
 
-    unsigned GetNumThreads() const;
+    const ConnectionPool::Config& GetPoolConfig() const;
 
     database::postgres::UnitOfWorkFactoryImpl& GetUnitOfWorkImpl();
 
 private:
     ConnectionPool connection_pool_;
     const char* db_url_;
-    const unsigned num_threads_;
     database::postgres::UnitOfWorkFactoryImpl unit_of_work_factory_;
 };
 
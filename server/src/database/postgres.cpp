@@ -10,7 +10,7 @@ namespace postgres
 void PlayerRepositoryImpl::Save(const domain::Player& player) 
 {
     w_.exec_params(
-            "INSERT INTO retired_players (id, name, score, play_time_ms) VALUES ($1, $2, $3, $4);"_zv,
+            "INSERT INTO retired_players (id, name, score, play_time_ms) VALUES ($1, $2, $3, $4) ON CONFLICT (id) DO NOTHING;"_zv,
                 player.GetId().ToString(), player.GetName(), player.GetScore(), player.GetTotalActiveTime());
 }
 
@@ -5,8 +5,6 @@
 #include "domain.h"
 #include "unit_of_work.h"
 
-#include <pqxx/pqxx>
-
 namespace database{
 namespace app{
 class UseCases {
@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include <unordered_set>
+#include <optional>
 
 namespace model {
 using namespace std::literals;
@@ -31,7 +32,7 @@ void GameSession::AddDog(std::shared_ptr<Dog> dog, bool is_random)
     {
         std::random_device rd;
         std::mt19937 gen(rd());
-        auto roads = map_->GetRoads();
+        const auto& roads = map_->GetRoads();
         std::uniform_int_distribution<> distr(0, roads.size()-1);
         int road_num = distr(gen);
         if(auto road = roads.at(road_num); road.IsHorizontal())
@@ -61,12 +62,28 @@ void GameSession::AddDog(std::shared_ptr<Dog> dog, bool is_random)
     dogs_.at(dog_id).get()->SetDogCoordinates(pos);
 }
 
-void GameSession::UpdateStateOfSession(uint64_t delta_time_ms, uint64_t retirement_time_ms)
+void GameSession::UpdateStateOfSession(uint64_t delta_time_ms, uint64_t retirement_time_ms, std::vector<LootSpawn>* spawned,
+                                       TickPhaseTimes* phase_times)
+{
+    {
+        ScopedPhaseTimer timer(phase_times, TickPhase::kLootGeneration);
+        loot_controller_.Update(std::chrono::milliseconds{delta_time_ms}, dogs_.size(), loots_, spawned);
+    }
+    UpdateDogsAndItems(delta_time_ms, retirement_time_ms, phase_times);
+}
+
+void GameSession::ReplayStateOfSession(uint64_t delta_time_ms, uint64_t retirement_time_ms, const std::vector<LootSpawn>& spawns)
+{
+    loot_controller_.Replay(std::chrono::milliseconds{delta_time_ms}, dogs_.size(), loots_, spawns);
+    UpdateDogsAndItems(delta_time_ms, retirement_time_ms);
+}
+
+void GameSession::UpdateDogsAndItems(uint64_t delta_time_ms, uint64_t retirement_time_ms, TickPhaseTimes* phase_times)
 {
-    loot_controller_.Update(std::chrono::milliseconds{delta_time_ms}, dogs_.size(), loots_);
-    
     std::vector<collision_detector::Gatherer> dogs_gatherers;
     dogs_gatherers.reserve(dogs_.size());
+    std::optional<ScopedPhaseTimer> timer;
+    timer.emplace(phase_times, TickPhase::kDogMotion);
     for(auto [id, dog] : dogs_)
     {
         bool is_speed_zero = false;
@@ -93,6 +110,7 @@ void GameSession::UpdateStateOfSession(uint64_t delta_time_ms, uint64_t retireme
         dogs_gatherers.push_back(gatherer);
     }
 
+    timer.emplace(phase_times, TickPhase::kItemsBuilding);
     std::vector<collision_detector::Item> items;
     auto all_loots = this->GetAllLoots();
     items.reserve(this->GetMap()->GetOffices().size() + this->GetLoots().size());
@@ -115,7 +133,9 @@ void GameSession::UpdateStateOfSession(uint64_t delta_time_ms, uint64_t retireme
         }
     }
 
+    timer.emplace(phase_times, TickPhase::kGatherEvents);
     auto collision_list = collision_detector::FindGatherEvents(collision_detector::ItemGathererProviderWrappler(items, dogs_gatherers), false);
+    timer.emplace(phase_times, TickPhase::kDelivery);
     if(!collision_list.empty())
     {
         for(size_t i = 0; i < collision_list.size(); ++i)
@@ -8,10 +8,13 @@
 #include <memory>
 #include <random>
 #include <deque>
+#include <algorithm>
+#include <utility>
 
 #include "../utils/tagged.h"
 #include "game_items.h"
 #include "motion.h"
+#include "tick_profiler.h"
 
 namespace model {
 
@@ -77,6 +80,11 @@ const Dog* GetDog(int id)
     }
 }
 
+size_t GetDogsCount() const noexcept
+{
+    return dogs_.size();
+}
+
 void RemoveDog(uint64_t id)
 {
     if(auto it = dogs_.find(id); it != dogs_.end())
@@ -85,14 +93,26 @@ void RemoveDog(uint64_t id)
     }
 }
 
-void UpdateStateOfSession(uint64_t delta_time_ms, uint64_t retirement_time_ms);
+// spawned (если задан) получает трофеи, появившиеся за такт; phase_times (если задан) - время этапов
+void UpdateStateOfSession(uint64_t delta_time_ms, uint64_t retirement_time_ms, std::vector<LootSpawn>* spawned = nullptr,
+                          TickPhaseTimes* phase_times = nullptr);
+
+// Повтор такта из журнала с заранее известными трофеями
+void ReplayStateOfSession(uint64_t delta_time_ms, uint64_t retirement_time_ms, const std::vector<LootSpawn>& spawns);
 
 LootsWrappler& GetLootsInSession()
 {
     return loots_;
 }
 
+const LootsWrappler& GetLootsInSession() const
+{
+    return loots_;
+}
+
 private:
+void UpdateDogsAndItems(uint64_t delta_time_ms, uint64_t retirement_time_ms, TickPhaseTimes* phase_times = nullptr);
+
 std::unordered_map<uint64_t, std::shared_ptr<Dog>> dogs_;
 std::unordered_map<uint64_t, Point> dog_id_to_position_;
 const Map* map_ = nullptr;
@@ -114,6 +134,8 @@ static const double default_retirement_time_s = 60;
 class Game {
 public:
     using Maps = std::vector<Map>;
+    // Трофеи, появившиеся за такт, по сессиям (сессии без новых трофеев не попадают)
+    using SpawnedLoots = std::vector<std::pair<Map::Id, std::vector<LootSpawn>>>;
 
     void SetPathToStaticFiles(std::string_view path_str_from_cur_dir)
     {
@@ -129,6 +151,12 @@ public:
 
     void AddMap(Map map);
 
+    void ReserveMaps(size_t count)
+    {
+        maps_.reserve(count);
+        map_id_to_index_.reserve(count);
+    }
+
     const Maps& GetMaps() const noexcept {
         return maps_;
     }
@@ -165,11 +193,55 @@ public:
         return nullptr;
     }
 
-    void UpdateStateOfGame(uint64_t delta_time_ms)
+    // Размер игрового мира для метрик
+    struct Population {
+        size_t sessions = 0;
+        size_t dogs = 0;
+        size_t loots = 0;
+    };
+
+    Population CountPopulation() const
+    {
+        Population population;
+        population.sessions = map_id_to_game_session_.size();
+        for(const auto& [id, game_session] : map_id_to_game_session_)
+        {
+            population.dogs += game_session->GetDogsCount();
+            population.loots += game_session->GetLootsInSession().GetSize();
+        }
+        return population;
+    }
+
+    void UpdateStateOfGame(uint64_t delta_time_ms, SpawnedLoots* spawned = nullptr)
     {
+        std::vector<LootSpawn> session_spawned;
+        const bool is_profiling = tick_profiler_.IsEnabled();
         for(auto& [id, game_session] : map_id_to_game_session_)
         {
-            game_session->UpdateStateOfSession(delta_time_ms, GetRetirementTimeMs());
+            session_spawned.clear();
+            TickPhaseTimes phase_times{};
+            game_session->UpdateStateOfSession(delta_time_ms, GetRetirementTimeMs(), spawned != nullptr ? &session_spawned : nullptr,
+                                               is_profiling ? &phase_times : nullptr);
+            if(is_profiling)
+            {
+                tick_profiler_.AddSession(*id, phase_times);
+            }
+            if(!session_spawned.empty())
+            {
+                spawned->emplace_back(id, session_spawned);
+            }
+        }
+    }
+
+    void ReplayStateOfGame(uint64_t delta_time_ms, const SpawnedLoots& spawned)
+    {
+        static const std::vector<LootSpawn> no_spawns;
+        for(auto& [id, game_session] : map_id_to_game_session_)
+        {
+            auto it = std::find_if(spawned.begin(), spawned.end(), [&id](const auto& session_spawned) {
+                return session_spawned.first == id;
+            });
+            game_session->ReplayStateOfSession(delta_time_ms, GetRetirementTimeMs(), it != spawned.end() ? it->second : no_spawns);
         }
     }
 
@@ -183,6 +255,11 @@ public:
         return loot_generator_config_;
     }
 
+    std::shared_ptr<const LootGeneratorConf> GetLootGeneratorConf() const
+    {
+        return loot_generator_config_;
+    }
+
     void SetRetirementTime(double time_s)
     {
         retirement_time_s_ = time_s;
@@ -198,6 +275,16 @@ public:
         return static_cast<uint64_t>(retirement_time_s_ * 1000.0);
     }
 
+    TickProfiler& GetTickProfiler() noexcept
+    {
+        return tick_profiler_;
+    }
+
+    const TickProfiler& GetTickProfiler() const noexcept
+    {
+        return tick_profiler_;
+    }
+
 
 private:
     using MapIdHasher = util::TaggedHasher<Map::Id>;
@@ -209,6 +296,7 @@ private:
     std::unordered_map<Map::Id, std::unique_ptr<GameSession>, MapIdHasher> map_id_to_game_session_;
     std::shared_ptr<LootGeneratorConf> loot_generator_config_ = std::make_shared<LootGeneratorConf>();
     double retirement_time_s_ = default_retirement_time_s;
+    TickProfiler tick_profiler_;
 };
 
 }  // namespace model
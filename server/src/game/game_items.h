@@ -9,6 +9,7 @@
 #include <deque>
 #include <queue>
 #include <memory>
+#include <span>
 #include <stdexcept>
 #include <utility>
 
@@ -70,20 +71,23 @@ public:
 
     Road(HorizontalTag, Point start, Coord end_x) noexcept
         : start_{start}
-        , end_{end_x, start.y} {
+        , end_{end_x, start.y}
+        , is_horizontal_{true} {
     }
 
     Road(VerticalTag, Point start, Coord end_y) noexcept
         : start_{start}
-        , end_{start.x, end_y} {
+        , end_{start.x, end_y}
+        , is_horizontal_{false} {
     }
 
+    // У дороги нулевой длины направление по концам не определить, поэтому оно хранится
     bool IsHorizontal() const noexcept {
-        return start_.y == end_.y;
+        return is_horizontal_;
     }
 
     bool IsVertical() const noexcept {
-        return start_.x == end_.x;
+        return !is_horizontal_;
     }
 
     Point GetStart() const noexcept {
@@ -111,6 +115,7 @@ public:
 private:
     Point start_;
     Point end_;
+    bool is_horizontal_;
 };
 
 class Building {
@@ -160,6 +165,8 @@ private:
     const double width_ = 0.5;
 };
 
+class LootsWrappler;
+
 class Loot
 {
 public:
@@ -170,6 +177,9 @@ public:
         , position_(position)
         {}
 
+    Loot(const Loot& other) = default;
+    Loot& operator=(const Loot& other) = default;
+
     Loot(Loot&& other)
     : position_(std::move(other.position_))
     , type_(std::move(other.type_))
@@ -217,6 +227,12 @@ private:
 
     template <typename Archive>
     friend void serialize(Archive& ar, model::Loot& loot, [[maybe_unused]] const unsigned version);
+
+    template <typename Writer>
+    friend void EncodeBinary(Writer& writer, const model::LootsWrappler& loots_wrappler);
+
+    template <typename Reader>
+    friend void DecodeBinary(Reader& reader, model::LootsWrappler& loots_wrappler);
 };
 
 class LootGeneratorConf{
@@ -269,30 +285,42 @@ public:
         {}
 
     explicit LootType(boost::json::value loot_type)
-    : loot_type_(loot_type)
+    : loot_type_(std::move(loot_type))
+    , value_(ParseValue(loot_type_))
     {}
 
-    boost::json::value GetLootType() const
+    const boost::json::value& GetLootType() const
     {
         return loot_type_;
     }
 
+    // Стоимость трофея разбирается один раз при загрузке: она нужна на каждом такте
     uint64_t GetValue() const
     {
-        boost::json::value val = loot_type_.as_object().at("value");
-        if(val.is_int64())
+        return value_;
+    }
+
+private:
+    static uint64_t ParseValue(const boost::json::value& loot_type)
+    {
+        const boost::json::value* val = loot_type.is_object() ? loot_type.as_object().if_contains("value") : nullptr;
+        if(val == nullptr)
+        {
+            return 0;
+        }
+        if(val->is_int64())
         {
-            return static_cast<uint64_t>(val.as_int64());
+            return static_cast<uint64_t>(val->as_int64());
         }
-        else if (val.is_uint64())
+        else if (val->is_uint64())
         {
-            return val.as_uint64();
+            return val->as_uint64();
         }
         return 0;
     }
 
-private:
     boost::json::value loot_type_;
+    uint64_t value_ = 0;
     int rotation_ = 0;
     double scale_ = 0.0;
     std::string name_ = "";
@@ -307,6 +335,18 @@ public:
 
 LootsWrappler() = default;
 
+// Копия используется для снимка состояния: указатели перестраиваются на собственные loots_
+LootsWrappler(const LootsWrappler& other)
+: loots_(other.loots_)
+, busy_loots_id_(other.busy_loots_id_)
+, freed_ids_(other.freed_ids_)
+{
+    for(size_t i = 0; i < loots_.size(); ++i)
+    {
+        loots_ptr_.push_back(other.loots_ptr_.at(i) != nullptr ? &loots_.at(i) : nullptr);
+    }
+}
+
 LootsWrappler(LootsWrappler&& other)
 :loots_(std::move(other.loots_))
 , loots_ptr_(std::move(other.loots_ptr_))
@@ -449,6 +489,12 @@ bool IsValidId(uint64_t id) const
 template <typename Archive>
 friend void serialize(Archive& ar, model::LootsWrappler& loots_wrappler, const unsigned version);
 
+template <typename Writer>
+friend void EncodeBinary(Writer& writer, const model::LootsWrappler& loots_wrappler);
+
+template <typename Reader>
+friend void DecodeBinary(Reader& reader, model::LootsWrappler& loots_wrappler);
+
 void MakeIndexFree(uint64_t id)
 {
     loots_ptr_.at(id) = nullptr;
@@ -464,6 +510,14 @@ public:
     using Buildings = std::vector<Building>;
     using Offices = std::vector<Office>;
 
+    // Элемент индекса дорог: координата, на которой лежит дорога, и её номер в GetRoads().
+    // Индекс упорядочен по координате, дороги с одной координатой идут подряд
+    struct RoadRef {
+        Coord coord;
+        uint32_t road;
+    };
+    using RoadIndex = std::vector<RoadRef>;
+
     Map(Id id, std::string name) noexcept
         : id_(std::move(id))
         , name_(std::move(name)) {
@@ -490,13 +544,58 @@ public:
     }
 
     void AddRoad(const Road& road) {
+        const auto road_num = static_cast<uint32_t>(roads_.size());
         roads_.emplace_back(road);
+        if(road.IsHorizontal()) {
+            InsertIntoIndex(horizontal_roads_, RoadRef{road.GetStart().y, road_num});
+        } else {
+            InsertIntoIndex(vertical_roads_, RoadRef{road.GetStart().x, road_num});
+        }
+    }
+
+    // Загрузка дорог вместе с заранее построенными индексами (из скомпилированного набора карт)
+    void SetRoads(Roads roads, RoadIndex horizontal_roads, RoadIndex vertical_roads) {
+        auto is_valid = [&roads](const RoadIndex& index, bool is_horizontal) {
+            return std::all_of(index.begin(), index.end(), [&roads, is_horizontal](const RoadRef& ref) {
+                       return ref.road < roads.size() && roads[ref.road].IsHorizontal() == is_horizontal;
+                   })
+                && std::is_sorted(index.begin(), index.end(), [](const RoadRef& lhs, const RoadRef& rhs) { return lhs.coord < rhs.coord; });
+        };
+        if(!is_valid(horizontal_roads, true) || !is_valid(vertical_roads, false)
+           || horizontal_roads.size() + vertical_roads.size() != roads.size()) {
+            throw std::invalid_argument("Invalid road index");
+        }
+        roads_ = std::move(roads);
+        horizontal_roads_ = std::move(horizontal_roads);
+        vertical_roads_ = std::move(vertical_roads);
+    }
+
+    const RoadIndex& GetHorizontalRoadIndex() const noexcept {
+        return horizontal_roads_;
+    }
+
+    const RoadIndex& GetVerticalRoadIndex() const noexcept {
+        return vertical_roads_;
+    }
+
+    // Горизонтальные дороги, лежащие на y
+    std::span<const RoadRef> FindHorizontalRoads(Coord y) const noexcept {
+        return FindInIndex(horizontal_roads_, y);
+    }
+
+    // Вертикальные дороги, лежащие на x
+    std::span<const RoadRef> FindVerticalRoads(Coord x) const noexcept {
+        return FindInIndex(vertical_roads_, x);
     }
 
     void AddBuilding(const Building& building) {
         buildings_.emplace_back(building);
     }
 
+    void SetBuildings(Buildings buildings) {
+        buildings_ = std::move(buildings);
+    }
+
     void AddOffice(Office office);
 
     void SetDogSpeed(double dog_speed)
@@ -532,9 +631,24 @@ public:
 private:
     using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
 
+    static bool CoordLess(const RoadRef& lhs, const RoadRef& rhs) noexcept {
+        return lhs.coord < rhs.coord;
+    }
+
+    static void InsertIntoIndex(RoadIndex& index, RoadRef ref) {
+        index.insert(std::upper_bound(index.begin(), index.end(), ref, CoordLess), ref);
+    }
+
+    static std::span<const RoadRef> FindInIndex(const RoadIndex& index, Coord coord) noexcept {
+        auto [first, last] = std::equal_range(index.begin(), index.end(), RoadRef{coord, 0}, CoordLess);
+        return {first, last};
+    }
+
     Id id_;
     std::string name_;
     Roads roads_;
+    RoadIndex horizontal_roads_;
+    RoadIndex vertical_roads_;
     Buildings buildings_;
 
     OfficeIdToIndex warehouse_id_to_index_;
@@ -546,7 +660,8 @@ private:
     uint64_t bag_capacity_ = 0;
 };
 
-static uint64_t id_counter = 0;
+// Общий для всех единиц трансляции счётчик id собак
+inline uint64_t id_counter = 0;
 
 struct DogCoordinates {
     DogCoordinates() = default;
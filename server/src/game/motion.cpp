@@ -14,8 +14,9 @@ void Motion::UpdateStateOfDog(uint64_t delta_time_ms, std::shared_ptr<Dog> dog)
     model::DogCoordinates dog_coordinates = dog->GetDogCoordinates();
     model::DogCoordinates finish_point = dog_coordinates;
     model::DogCoordinates prev_finish_point = finish_point;
-    auto it_horizontal_roads = horizontal_roads_.find(static_cast<int>(std::floor(dog_coordinates.y_ + half_of_grid)));
-    auto it_vertical_roads = vertical_roads_.find(static_cast<int>(std::floor(dog_coordinates.x_ + half_of_grid)));
+    const auto& roads = map_->GetRoads();
+    auto horizontal_roads = map_->FindHorizontalRoads(static_cast<int>(std::floor(dog_coordinates.y_ + half_of_grid)));
+    auto vertical_roads = map_->FindVerticalRoads(static_cast<int>(std::floor(dog_coordinates.x_ + half_of_grid)));
     model::DogCoordinates end_position(dog_coordinates.x_ + dog_speed.dx_ * (static_cast<double>(delta_time_ms) * ms_to_sec), 
                                         dog_coordinates.y_ + dog_speed.dy_ * (static_cast<double>(delta_time_ms) * ms_to_sec));
     bool is_point_calculated = false;
@@ -24,12 +25,13 @@ void Motion::UpdateStateOfDog(uint64_t delta_time_ms, std::shared_ptr<Dog> dog)
         std::optional<model::DogCoordinates> end_point_on_road = dog_coordinates;
         if(dog->GetDogDirection() == model::Direction::EAST || dog->GetDogDirection() == model::Direction::WEST)
         {
-            if(it_horizontal_roads != horizontal_roads_.end())
+            if(!horizontal_roads.empty())
             {
                 double max_distance = 0.0;
                 double distance_between_start_and_last_point = 0.0;
-                for(const auto* road : it_horizontal_roads->second)
+                for(const auto& road_ref : horizontal_roads)
                 {
+                    const Road* road = &roads[road_ref.road];
                     if(road->IsPointPartOfRoad(finish_point.x_, finish_point.y_))
                     {
                         finish_point = CalculateFurthestPointHorizontalRoad(road, end_position, end_point_on_road, max_distance, 
@@ -44,12 +46,13 @@ void Motion::UpdateStateOfDog(uint64_t delta_time_ms, std::shared_ptr<Dog> dog)
             }
         }
         else {
-            if(it_vertical_roads != vertical_roads_.end())
+            if(!vertical_roads.empty())
             {
                 double max_distance = 0.0;
                 double distance_between_start_and_last_point = 0.0;
-                for(const auto* road : it_vertical_roads->second)
+                for(const auto& road_ref : vertical_roads)
                 {
+                    const Road* road = &roads[road_ref.road];
                     if(road->IsPointPartOfRoad(finish_point.x_, finish_point.y_))
                     {
                         finish_point = CalculateFurthestPointVerticalRoad(road, end_position, end_point_on_road, max_distance, 
@@ -63,8 +66,8 @@ void Motion::UpdateStateOfDog(uint64_t delta_time_ms, std::shared_ptr<Dog> dog)
                 prev_finish_point = finish_point;
             }
         }
-        it_horizontal_roads = horizontal_roads_.find(static_cast<int>(std::floor(finish_point.y_ + 0.5)));
-        it_vertical_roads = vertical_roads_.find(static_cast<int>(std::floor(finish_point.x_ + 0.5)));
+        horizontal_roads = map_->FindHorizontalRoads(static_cast<int>(std::floor(finish_point.y_ + 0.5)));
+        vertical_roads = map_->FindVerticalRoads(static_cast<int>(std::floor(finish_point.x_ + 0.5)));
         if(std::abs(finish_point.x_ - end_position.x_) < EPSILON && std::abs(finish_point.y_ - end_position.y_) < EPSILON)
         {
             //целевая точка была достигнута
@@ -160,17 +163,33 @@ model::DogCoordinates Motion::CalculateFurthestPointOnOneVerticalRoad(std::share
 
 
 void LootControllerInSession::Update(std::chrono::milliseconds time_delta, unsigned looter_count, 
-            LootsWrappler& loots_to_update)
+            LootsWrappler& loots_to_update, std::vector<LootSpawn>* spawned)
 {
     unsigned current_number_of_loot = loots_to_update.GetSize();
     auto loot_count = loot_generator_.Generate(time_delta, current_number_of_loot, looter_count);
     for(unsigned i = 0; i < loot_count; ++i)
     {
         auto position = GetRandomPointOnTheMap();
-        loots_to_update.AddLoot(GetRandomType(0, map_->GetLootTypes().size()-1), position);
+        auto type = GetRandomType(0, map_->GetLootTypes().size()-1);
+        loots_to_update.AddLoot(type, position);
+        if(spawned != nullptr)
+        {
+            spawned->push_back(LootSpawn{.type = type, .position = position});
+        }
     } 
 }
 
+void LootControllerInSession::Replay(std::chrono::milliseconds time_delta, unsigned looter_count,
+            LootsWrappler& loots_to_update, const std::vector<LootSpawn>& spawns)
+{
+    //Генератор вызывается только чтобы его счётчик времени совпал с исходным запуском
+    loot_generator_.Generate(time_delta, loots_to_update.GetSize(), looter_count);
+    for(const auto& spawn : spawns)
+    {
+        loots_to_update.AddLoot(spawn.type, spawn.position);
+    }
+}
+
 std::mt19937_64& LootControllerInSession::GetRng() {
     static std::mt19937_64 gen(std::random_device{}());
     return gen;
@@ -179,7 +198,7 @@ std::mt19937_64& LootControllerInSession::GetRng() {
 DoublePoint LootControllerInSession::GetRandomPointOnTheMap()
 {
     DoublePoint pos;
-    auto roads = map_->GetRoads();
+    const auto& roads = map_->GetRoads();
     std::uniform_int_distribution<int> distr(0, roads.size()-1);
     int road_num = distr(GetRng());
     if(auto road = roads.at(road_num); road.IsHorizontal())
@@ -12,6 +12,7 @@
 #include <chrono>
 #include <random>
 #include <deque>
+#include <vector>
 
 namespace model {
 
@@ -24,13 +25,11 @@ public:
 explicit Motion(const Map* map)
 : map_(map)
 {
-    UpdateRoadMaps();
 }
 
 void SetMap(const Map* map)
 {
     map_ = map;
-    UpdateRoadMaps();
 }
 
 const Map* GetMap() const noexcept
@@ -41,26 +40,8 @@ const Map* GetMap() const noexcept
 void UpdateStateOfDog(uint64_t delta_time_ms, std::shared_ptr<Dog> dog);
 
 private:
+//Индекс дорог по координатам хранится в карте и общий для всех сессий
 const Map* map_ = nullptr;
-std::unordered_map<int, std::vector<const Road*>> horizontal_roads_;
-std::unordered_map<int, std::vector<const Road*>> vertical_roads_;
-
-void UpdateRoadMaps()
-{
-    horizontal_roads_.clear();
-    vertical_roads_.clear();
-    for(auto& road : map_->GetRoads())
-    {
-        if(road.IsHorizontal())
-        {
-            horizontal_roads_[road.GetStart().y].push_back(&road);
-        }
-        else
-        {
-            vertical_roads_[road.GetStart().x].push_back(&road);
-        }
-    }
-}
 
 double CalculateDistanceBetweenTwoPoints(model::DogCoordinates first_point, model::DogCoordinates end_point){
     return std::sqrt(std::pow((std::abs(first_point.x_ - end_point.x_)), 2) + std::pow((std::abs(first_point.y_ - end_point.y_)), 2)); 
@@ -80,6 +61,12 @@ model::DogCoordinates CalculateFurthestPointOnOneVerticalRoad(std::shared_ptr<Do
 
 };
 
+// Трофей, появившийся на карте за такт
+struct LootSpawn {
+    uint64_t type = 0;
+    DoublePoint position;
+};
+
 class LootControllerInSession
 {
 public:
@@ -87,8 +74,13 @@ public:
         : map_(map)
         , loot_generator_(std::chrono::milliseconds{static_cast<int64_t>(period * 1000)}, propability) {}
 
+    // spawned (если задан) получает сгенерированные трофеи
     void Update(std::chrono::milliseconds time_delta, unsigned looter_count, 
-                LootsWrappler& loots_to_update);
+                LootsWrappler& loots_to_update, std::vector<LootSpawn>* spawned = nullptr);
+
+    // Повтор такта из журнала: вместо случайных трофеев добавляются записанные
+    void Replay(std::chrono::milliseconds time_delta, unsigned looter_count,
+                LootsWrappler& loots_to_update, const std::vector<LootSpawn>& spawns);
 
 private:
     const Map* map_ = nullptr;
@@ -0,0 +1,75 @@
+#include "tick_profiler.h"
+
+#include <algorithm>
+
+namespace model {
+
+using namespace std::literals;
+
+std::string_view GetTickPhaseName(TickPhase phase) noexcept {
+    switch(phase) {
+    case TickPhase::kLootGeneration:  return "loot_generation"sv;
+    case TickPhase::kDogMotion:       return "dog_motion"sv;
+    case TickPhase::kItemsBuilding:   return "items_building"sv;
+    case TickPhase::kGatherEvents:    return "gather_events"sv;
+    case TickPhase::kDelivery:        return "delivery"sv;
+    case TickPhase::kGameUpdate:      return "game_update"sv;
+    case TickPhase::kJournal:         return "journal"sv;
+    case TickPhase::kTickListeners:   return "tick_listeners"sv;
+    case TickPhase::kLeavedPlayers:   return "leaved_players"sv;
+    case TickPhase::kCheckpoint:      return "checkpoint"sv;
+    case TickPhase::kCount:           break;
+    }
+    return "unknown"sv;
+}
+
+TickProfiler::TickProfiler(TickProfiler&& other) noexcept
+    : is_enabled_(other.is_enabled_.load(std::memory_order_relaxed)) {
+    std::lock_guard lock(other.mutex_);
+    ticks_ = other.ticks_;
+    phases_ = other.phases_;
+    sessions_ = std::move(other.sessions_);
+}
+
+void TickProfiler::AddSession(const std::string& session_id, const TickPhaseTimes& times) {
+    std::lock_guard lock(mutex_);
+    auto& session = sessions_[session_id];
+    for(size_t i = 0; i < tick_phases_count; ++i) {
+        if(times[i] != 0) {
+            session[i].Add(times[i]);
+            phases_[i].Add(times[i]);
+        }
+    }
+}
+
+void TickProfiler::AddTick(const TickPhaseTimes& times, uint64_t tick_ns) {
+    std::lock_guard lock(mutex_);
+    ticks_.Add(tick_ns);
+    for(size_t i = 0; i < tick_phases_count; ++i) {
+        if(times[i] != 0) {
+            phases_[i].Add(times[i]);
+        }
+    }
+}
+
+TickProfiler::Report TickProfiler::GetReport() const {
+    Report report;
+    report.is_enabled = IsEnabled();
+    std::lock_guard lock(mutex_);
+    report.ticks = ticks_;
+    report.phases = phases_;
+    report.sessions.assign(sessions_.begin(), sessions_.end());
+    std::sort(report.sessions.begin(), report.sessions.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    return report;
+}
+
+void TickProfiler::Reset() {
+    std::lock_guard lock(mutex_);
+    ticks_ = {};
+    phases_ = {};
+    sessions_.clear();
+}
+
+}  // namespace model
@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../tracing/span_recorder.h"
+
+namespace model {
+
+#ifdef GAME_TICK_PROFILER
+inline constexpr bool is_tick_profiler_compiled = true;
+#else
+inline constexpr bool is_tick_profiler_compiled = false;
+#endif
+
+// Этапы такта: первые выполняются для каждой игровой сессии, остальные - один раз за такт в приложении
+enum class TickPhase : uint8_t {
+    kLootGeneration,
+    kDogMotion,
+    kItemsBuilding,
+    kGatherEvents,
+    kDelivery,
+    kGameUpdate,
+    kJournal,
+    kTickListeners,
+    kLeavedPlayers,
+    kCheckpoint,
+    kCount
+};
+
+inline constexpr size_t tick_phases_count = static_cast<size_t>(TickPhase::kCount);
+
+std::string_view GetTickPhaseName(TickPhase phase) noexcept;
+
+// Время этапов одного такта (одной сессии), нс
+using TickPhaseTimes = std::array<uint64_t, tick_phases_count>;
+
+// Замеряет время этапа, если times задан (только с GAME_TICK_PROFILER),
+// и записывает участок в trace, если запись включена
+class ScopedPhaseTimer {
+public:
+    ScopedPhaseTimer(TickPhaseTimes* times, TickPhase phase) noexcept
+        : phase_(phase)
+        , is_traced_(tracing::IsEnabled()) {
+        if constexpr(is_tick_profiler_compiled) {
+            times_ = times;
+        }
+        if(times_ != nullptr || is_traced_) {
+            start_ns_ = tracing::SpanRecorder::NowNs();
+        }
+    }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+    ~ScopedPhaseTimer() {
+        if(times_ == nullptr && !is_traced_) {
+            return;
+        }
+        const uint64_t end_ns = tracing::SpanRecorder::NowNs();
+        if(times_ != nullptr) {
+            (*times_)[static_cast<size_t>(phase_)] += end_ns - start_ns_;
+        }
+        if(is_traced_) {
+            // Имена этапов - литералы, поэтому data() заканчивается нулём
+            tracing::SpanRecorder::Instance().Record("tick", GetTickPhaseName(phase_).data(), start_ns_, end_ns);
+        }
+    }
+
+private:
+    TickPhaseTimes* times_ = nullptr;
+    TickPhase phase_;
+    bool is_traced_;
+    uint64_t start_ns_ = 0;
+};
+
+// Накопленная статистика этапов такта: общая и по сессиям (по id карты).
+// Пишется из strand, читается из любого потока.
+class TickProfiler {
+public:
+    struct PhaseStats {
+        uint64_t calls = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+
+        void Add(uint64_t ns) noexcept {
+            ++calls;
+            total_ns += ns;
+            max_ns = std::max(max_ns, ns);
+        }
+    };
+
+    using PhaseStatsArray = std::array<PhaseStats, tick_phases_count>;
+
+    struct Report {
+        bool is_enabled = false;
+        PhaseStats ticks;
+        PhaseStatsArray phases;
+        std::vector<std::pair<std::string, PhaseStatsArray>> sessions;
+    };
+
+    TickProfiler() = default;
+    // Нужен, чтобы загрузчик мог вернуть Game по значению; такты в это время не идут
+    TickProfiler(TickProfiler&& other) noexcept;
+    TickProfiler& operator=(TickProfiler&&) = delete;
+
+    bool IsEnabled() const noexcept {
+        return is_tick_profiler_compiled && is_enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Без GAME_TICK_PROFILER включить нельзя
+    bool SetEnabled(bool is_enabled) noexcept {
+        is_enabled_.store(is_tick_profiler_compiled && is_enabled, std::memory_order_relaxed);
+        return IsEnabled();
+    }
+
+    // Этапы, выполненные (с ненулевым временем), учитываются в общей статистике и в статистике сессии
+    void AddSession(const std::string& session_id, const TickPhaseTimes& times);
+    void AddTick(const TickPhaseTimes& times, uint64_t tick_ns);
+
+    Report GetReport() const;
+    void Reset();
+
+private:
+    std::atomic<bool> is_enabled_{false};
+
+    mutable std::mutex mutex_;
+    PhaseStats ticks_;
+    PhaseStatsArray phases_;
+    std::unordered_map<std::string, PhaseStatsArray> sessions_;
+};
+
+}  // namespace model
@@ -12,7 +12,7 @@ namespace infrastructure
             {
                 if(time_since_previous_save_ >= save_period_)
                 {
-                    application_.SaveState();
+                    application_.SaveStateInBackground();
                     time_since_previous_save_ = 0ms;
                 }
                 else
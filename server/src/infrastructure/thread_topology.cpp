@@ -0,0 +1,139 @@
+#include "thread_topology.h"
+#include "../logging/logger.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace infrastructure
+{
+
+namespace {
+
+using namespace std::literals;
+
+unsigned ParseCpu(std::string_view str, std::string_view list) {
+    unsigned cpu = 0;
+    const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), cpu);
+    if(ec != std::errc{} || end != str.data() + str.size() || cpu >= CPU_SETSIZE) {
+        throw std::invalid_argument("Invalid CPU list: " + std::string(list));
+    }
+    return cpu;
+}
+
+void PinCurrentThread(const std::string& name, const CpuList& cpus, size_t index) {
+    if(cpus.empty()) {
+        return;
+    }
+    const unsigned cpu = cpus[index % cpus.size()];
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if(const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set); error != 0) {
+        // Недоступный процессор не мешает работе: поток остаётся без привязки
+        LogJson(boost::json::object{{"thread", name}, {"cpu", cpu}, {"code", error}}, "thread affinity failed"sv, LogLevel::kWarning);
+    }
+}
+
+// Имя видно в top -H и perf; обрезается до 15 символов
+void SetupWorkerThread(const std::string& name, const CpuList& cpus, size_t index) {
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    PinCurrentThread(name, cpus, index);
+}
+
+}  // namespace
+
+CpuList ParseCpuList(std::string_view str) {
+    CpuList cpus;
+    std::string_view rest = str;
+    while(!rest.empty()) {
+        const size_t comma = rest.find(',');
+        const std::string_view item = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? ""sv : rest.substr(comma + 1);
+        if(const size_t dash = item.find('-'); dash != std::string_view::npos) {
+            const unsigned first = ParseCpu(item.substr(0, dash), str);
+            const unsigned last = ParseCpu(item.substr(dash + 1), str);
+            if(first > last) {
+                throw std::invalid_argument("Invalid CPU list: " + std::string(str));
+            }
+            for(unsigned cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } else {
+            cpus.push_back(ParseCpu(item, str));
+        }
+    }
+    return cpus;
+}
+
+ThreadTopology::ThreadTopology(Config config)
+    : config_(std::move(config))
+    , io_context_(static_cast<int>(std::max(1u, config_.io_threads)))
+{
+    const unsigned net_threads = std::max(1u, config_.net_threads);
+    if(config_.mode == Mode::kPerCore) {
+        // Каждый io_context обслуживается одним потоком: планировщик asio не будит другие потоки
+        for(unsigned i = 0; i < net_threads; ++i) {
+            owned_net_contexts_.push_back(std::make_unique<net::io_context>(1));
+        }
+        sim_context_ = std::make_unique<net::io_context>(1);
+    } else {
+        owned_net_contexts_.push_back(std::make_unique<net::io_context>(static_cast<int>(net_threads)));
+    }
+    for(const auto& ioc : owned_net_contexts_) {
+        net_contexts_.push_back(ioc.get());
+        work_guards_.emplace_back(ioc->get_executor());
+    }
+    if(sim_context_) {
+        work_guards_.emplace_back(sim_context_->get_executor());
+    }
+    io_work_guard_.emplace(io_context_.get_executor());
+}
+
+void ThreadTopology::Run()
+{
+    const unsigned net_threads = std::max(1u, config_.net_threads);
+    std::vector<std::jthread> threads;
+    for(unsigned i = 1; i < net_threads; ++i) {
+        net::io_context& ioc = config_.mode == Mode::kPerCore ? *net_contexts_[i] : *net_contexts_.front();
+        threads.emplace_back([this, &ioc, i] {
+            SetupWorkerThread("net-" + std::to_string(i), config_.net_cpus, i);
+            ioc.run();
+        });
+    }
+    if(sim_context_) {
+        threads.emplace_back([this] {
+            SetupWorkerThread("sim", config_.sim_cpus, 0);
+            sim_context_->run();
+        });
+    }
+    for(unsigned i = 0; i < std::max(1u, config_.io_threads); ++i) {
+        threads.emplace_back([this, i] {
+            SetupWorkerThread("io-" + std::to_string(i), config_.io_cpus, i);
+            io_context_.run();
+        });
+    }
+    // Главный поток не переименовывается: по его имени процесс виден в ps
+    PinCurrentThread("net-0", config_.net_cpus, 0);
+    net_contexts_.front()->run();
+}
+
+void ThreadTopology::Stop()
+{
+    std::call_once(stop_flag_, [this] {
+        for(net::io_context* ioc : net_contexts_) {
+            ioc->stop();
+        }
+        if(sim_context_) {
+            sim_context_->stop();
+        }
+        io_work_guard_->reset();
+    });
+}
+
+} //namespace infrastructure
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace infrastructure
+{
+
+namespace net = boost::asio;
+
+// Номера процессоров для привязки потоков роли; пустой список - без привязки
+using CpuList = std::vector<unsigned>;
+
+// "0-3,6" -> {0, 1, 2, 3, 6}. Бросает std::invalid_argument
+CpuList ParseCpuList(std::string_view str);
+
+// Распределение потоков сервера по ролям.
+// kShared: сеть, такты и обработчики API выполняет общий пул потоков с одним io_context.
+// kPerCore: у каждого сетевого потока свой io_context, соединение живёт в одном потоке;
+// strand игры (такты и обработчики API) выполняется отдельным потоком симуляции.
+// В обоих режимах блокирующие обращения к БД (запросы records и запись результатов
+// выбывших игроков) выполняет отдельный пул.
+// Потоки роли привязываются к её процессорам по кругу
+class ThreadTopology
+{
+public:
+    enum class Mode {
+        kShared,
+        kPerCore
+    };
+
+    struct Config {
+        Mode mode = Mode::kShared;
+        unsigned net_threads = 1;
+        unsigned io_threads = 1;
+        CpuList net_cpus;
+        CpuList sim_cpus;       // в kShared не используется
+        CpuList io_cpus;
+    };
+
+    explicit ThreadTopology(Config config);
+
+    ThreadTopology(const ThreadTopology&) = delete;
+    ThreadTopology& operator=(const ThreadTopology&) = delete;
+
+    // По одному на сетевой поток, в kShared - один общий
+    const std::vector<net::io_context*>& GetNetContexts() const noexcept {
+        return net_contexts_;
+    }
+
+    // Такты и обработчики API; в kShared совпадает с сетевым
+    net::io_context& GetSimContext() noexcept {
+        return sim_context_ ? *sim_context_ : *net_contexts_.front();
+    }
+
+    net::io_context& GetIoContext() noexcept {
+        return io_context_;
+    }
+
+    // Запускает потоки всех ролей; текущий поток обслуживает первый сетевой io_context.
+    // Возвращает управление, когда после Stop завершатся все потоки
+    void Run();
+
+    // Сеть и симуляция останавливаются сразу, пул БД - после выполнения уже поставленных задач.
+    // Результаты, запись которых база не успела подтвердить, остаются в снимке и журнале
+    // и отправляются повторно после перезапуска. Может вызываться из любого потока
+    void Stop();
+
+private:
+    using WorkGuard = net::executor_work_guard<net::io_context::executor_type>;
+
+    const Config config_;
+    std::vector<std::unique_ptr<net::io_context>> owned_net_contexts_;
+    std::vector<net::io_context*> net_contexts_;
+    std::unique_ptr<net::io_context> sim_context_;
+    net::io_context io_context_;
+    // Без них io_context без ожидающих операций (например, симуляция без автотактов)
+    // сразу вернул бы управление из run()
+    std::vector<WorkGuard> work_guards_;
+    std::optional<WorkGuard> io_work_guard_;
+    std::once_flag stop_flag_;
+};
+
+} //namespace infrastructure
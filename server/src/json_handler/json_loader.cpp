@@ -1,5 +1,10 @@
 #include "json_loader.h"
+#include "map_bundle.h"
 #include <boost/json.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -8,6 +13,55 @@ namespace sys = boost::system;
 
 namespace json_loader {
 
+namespace {
+
+// Файл конфигурации, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            throw std::runtime_error("Can't open json file");
+        }
+        struct stat file_stat{};
+        if(::fstat(fd, &file_stat) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Can't stat json file");
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if(size_ > 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Can't map json file");
+            }
+            data_ = static_cast<const char*>(data);
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if(data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    std::string_view GetData() const noexcept {
+        return {data_, size_};
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+model::Game LoadGameFromJson(std::string_view json_string);
+
+} // namespace
+
 void AddRoadToTheGameMap(const boost::json::value& road, model::Map& game_map)
 {
     if(road.as_object().contains("x1"))
@@ -49,24 +103,24 @@ void AddMapToTheGame(const boost::json::value& map, model::Game& game, double de
 {
     model::Map game_map(model::Map::Id{std::string(map.as_object().at(literals::id).as_string().c_str())}, 
                                         std::string(map.as_object().at(literals::map_name).as_string().c_str()));
-    for(auto road : map.as_object().at("roads").as_array())
+    for(const auto& road : map.as_object().at("roads").as_array())
     {
         AddRoadToTheGameMap(road, game_map);
     }
 
-    for(auto building : map.as_object().at("buildings").as_array())
+    for(const auto& building : map.as_object().at("buildings").as_array())
     {
         AddBuildingToTheGameMap(building, game_map);
     }
 
-    for(auto office : map.as_object().at("offices").as_array())
+    for(const auto& office : map.as_object().at("offices").as_array())
     {
         AddOfficeToTheGameMap(office, game_map);
     }
 
-    if(auto array = map.as_object().at("lootTypes").as_array(); array.size() > 0)
+    if(const auto& array = map.as_object().at("lootTypes").as_array(); array.size() > 0)
     {
-        for(auto loot_type : array)
+        for(const auto& loot_type : array)
         {
             AddLootTypeToTheGameMap(loot_type, game_map);
         }
@@ -95,22 +149,37 @@ void AddMapToTheGame(const boost::json::value& map, model::Game& game, double de
         game_map.SetBagCapacity(default_bag_capacity);
     }
 
-    game.AddMap(game_map);
+    game.AddMap(std::move(game_map));
 }
 
 model::Game LoadGame(const std::filesystem::path& json_path) {
-    using namespace std::literals;
-    model::Game game;
-    std::ifstream json_file(json_path);
-    if(!json_file.is_open())
+    MappedFile file(json_path);
+    if(IsMapBundle(file.GetData()))
     {
-        throw std::runtime_error("Can't open json file");
+        return DecodeMapBundle(file.GetData());
     }
-    std::string json_string = ""s;
-    std::string temp;
-    while(getline(json_file, temp)) {
-        json_string += temp;
+    return LoadGameFromJson(file.GetData());
+}
+
+void CompileGame(const std::filesystem::path& json_path, const std::filesystem::path& bundle_path)
+{
+    const std::string bundle = EncodeMapBundle(LoadGame(json_path));
+    std::ofstream bundle_file(bundle_path, std::ios::binary | std::ios::trunc);
+    if(!bundle_file.is_open())
+    {
+        throw std::runtime_error("Can't open map bundle file");
     }
+    bundle_file.write(bundle.data(), static_cast<std::streamsize>(bundle.size()));
+    if(!bundle_file)
+    {
+        throw std::runtime_error("Can't write map bundle file");
+    }
+}
+
+namespace {
+
+model::Game LoadGameFromJson(std::string_view json_string) {
+    model::Game game;
     boost::json::value parsed_json;
     try
     {
@@ -122,7 +191,7 @@ model::Game LoadGame(const std::filesystem::path& json_path) {
         throw;
     }
     
-    auto array_of_maps = parsed_json.as_object().at("maps").as_array();
+    const auto& array_of_maps = parsed_json.as_object().at("maps").as_array();
     double default_speed = parsed_json.as_object().at("defaultDogSpeed").as_double();
     auto pointer_bag = parsed_json.as_object().if_contains("defaultBagCapacity");
     auto pointer_retirement_time = parsed_json.as_object().if_contains("dogRetirementTime");
@@ -138,7 +207,8 @@ model::Game LoadGame(const std::filesystem::path& json_path) {
             game.SetRetirementTime(time_s);
         }
     }
-    for(auto map : array_of_maps)
+    game.ReserveMaps(array_of_maps.size());
+    for(const auto& map : array_of_maps)
     {
         AddMapToTheGame(map, game, default_speed, default_bag_capacity);
     }
@@ -148,4 +218,6 @@ model::Game LoadGame(const std::filesystem::path& json_path) {
     return game;
 }
 
+} // namespace
+
 }// namespace json_loader
@@ -30,6 +30,10 @@ namespace literals {
 }
 
 
+// Загружает игру из JSON-конфигурации или из скомпилированного набора карт (определяется по содержимому)
 model::Game LoadGame(const std::filesystem::path& json_path);
 
+// Разбирает JSON-конфигурацию и записывает её в виде набора карт (см. map_bundle.h)
+void CompileGame(const std::filesystem::path& json_path, const std::filesystem::path& bundle_path);
+
 }  // namespace json_loader
@@ -0,0 +1,301 @@
+#include "map_bundle.h"
+
+#include <boost/json.hpp>
+
+#include "../serialization/snapshot.h"
+
+namespace json_loader {
+
+namespace {
+
+using namespace std::literals;
+using serialization::BinaryReader;
+using serialization::BinaryWriter;
+
+constexpr std::string_view bundle_magic = "GSMAPB\r\n"sv;
+constexpr uint32_t bundle_version = 3;
+// Минимальные размеры элементов, чтобы испорченный счётчик не приводил к огромному резервированию
+constexpr size_t min_road_size = sizeof(uint8_t) + 3 * sizeof(uint32_t);
+constexpr size_t min_road_ref_size = 2 * sizeof(uint32_t);
+constexpr size_t min_building_size = 4 * sizeof(uint32_t);
+constexpr size_t min_office_size = sizeof(uint64_t) + 4 * sizeof(uint32_t);
+constexpr size_t min_json_value_size = sizeof(uint8_t);
+constexpr size_t min_json_member_size = sizeof(uint64_t) + min_json_value_size;
+constexpr size_t min_loot_type_size = sizeof(uint8_t) + sizeof(uint64_t);
+// Описания трофеев неглубокие; ограничение защищает стек от испорченных данных
+constexpr size_t max_json_depth = 64;
+
+// Теги значений JSON в наборе карт
+enum class JsonTag : uint8_t {
+    kNull = 0,
+    kBool = 1,
+    kInt64 = 2,
+    kUint64 = 3,
+    kDouble = 4,
+    kString = 5,
+    kArray = 6,
+    kObject = 7
+};
+
+void WriteCoord(BinaryWriter& writer, model::Coord value) {
+    writer.WriteU32(static_cast<uint32_t>(value));
+}
+
+model::Coord ReadCoord(BinaryReader& reader) {
+    return static_cast<model::Coord>(reader.ReadU32());
+}
+
+void WriteJsonTag(BinaryWriter& writer, JsonTag tag) {
+    writer.WriteU8(static_cast<uint8_t>(tag));
+}
+
+void EncodeJson(BinaryWriter& writer, const boost::json::value& value) {
+    switch(value.kind()) {
+    case boost::json::kind::null:
+        WriteJsonTag(writer, JsonTag::kNull);
+        break;
+    case boost::json::kind::bool_:
+        WriteJsonTag(writer, JsonTag::kBool);
+        writer.WriteBool(value.get_bool());
+        break;
+    case boost::json::kind::int64:
+        WriteJsonTag(writer, JsonTag::kInt64);
+        writer.WriteU64(static_cast<uint64_t>(value.get_int64()));
+        break;
+    case boost::json::kind::uint64:
+        WriteJsonTag(writer, JsonTag::kUint64);
+        writer.WriteU64(value.get_uint64());
+        break;
+    case boost::json::kind::double_:
+        WriteJsonTag(writer, JsonTag::kDouble);
+        writer.WriteDouble(value.get_double());
+        break;
+    case boost::json::kind::string:
+        WriteJsonTag(writer, JsonTag::kString);
+        writer.WriteString(value.get_string());
+        break;
+    case boost::json::kind::array:
+        WriteJsonTag(writer, JsonTag::kArray);
+        writer.WriteU64(value.get_array().size());
+        for(const auto& item : value.get_array()) {
+            EncodeJson(writer, item);
+        }
+        break;
+    case boost::json::kind::object:
+        WriteJsonTag(writer, JsonTag::kObject);
+        writer.WriteU64(value.get_object().size());
+        for(const auto& member : value.get_object()) {
+            writer.WriteString(member.key());
+            EncodeJson(writer, member.value());
+        }
+        break;
+    }
+}
+
+boost::json::value DecodeJson(BinaryReader& reader, size_t depth = 0) {
+    if(depth > max_json_depth) {
+        throw serialization::SnapshotError("Loot type description is nested too deeply");
+    }
+    switch(static_cast<JsonTag>(reader.ReadU8())) {
+    case JsonTag::kNull:
+        return nullptr;
+    case JsonTag::kBool:
+        return reader.ReadBool();
+    case JsonTag::kInt64:
+        return static_cast<int64_t>(reader.ReadU64());
+    case JsonTag::kUint64:
+        return reader.ReadU64();
+    case JsonTag::kDouble:
+        return reader.ReadDouble();
+    case JsonTag::kString:
+        return boost::json::string(reader.ReadString());
+    case JsonTag::kArray: {
+        boost::json::array array;
+        const uint64_t size = reader.ReadCount(min_json_value_size);
+        array.reserve(size);
+        for(uint64_t i = 0; i < size; ++i) {
+            array.push_back(DecodeJson(reader, depth + 1));
+        }
+        return array;
+    }
+    case JsonTag::kObject: {
+        boost::json::object object;
+        const uint64_t size = reader.ReadCount(min_json_member_size);
+        object.reserve(size);
+        for(uint64_t i = 0; i < size; ++i) {
+            std::string key = reader.ReadString();
+            object[key] = DecodeJson(reader, depth + 1);
+        }
+        return object;
+    }
+    }
+    throw serialization::SnapshotError("Unknown JSON value tag in map bundle");
+}
+
+void EncodeRoadIndex(BinaryWriter& writer, const model::Map::RoadIndex& index) {
+    writer.WriteU64(index.size());
+    for(const auto& ref : index) {
+        WriteCoord(writer, ref.coord);
+        writer.WriteU32(ref.road);
+    }
+}
+
+model::Map::RoadIndex DecodeRoadIndex(BinaryReader& reader) {
+    model::Map::RoadIndex index(reader.ReadCount(min_road_ref_size));
+    for(auto& ref : index) {
+        ref.coord = ReadCoord(reader);
+        ref.road = reader.ReadU32();
+    }
+    return index;
+}
+
+void EncodeMap(BinaryWriter& writer, const model::Map& map) {
+    writer.WriteString(*map.GetId());
+    writer.WriteString(map.GetName());
+    writer.WriteDouble(map.GetDogSpeed());
+    writer.WriteU64(map.GetBagCapacity());
+
+    writer.WriteU64(map.GetRoads().size());
+    for(const auto& road : map.GetRoads()) {
+        writer.WriteBool(road.IsHorizontal());
+        WriteCoord(writer, road.GetStart().x);
+        WriteCoord(writer, road.GetStart().y);
+        WriteCoord(writer, road.IsHorizontal() ? road.GetEnd().x : road.GetEnd().y);
+    }
+    EncodeRoadIndex(writer, map.GetHorizontalRoadIndex());
+    EncodeRoadIndex(writer, map.GetVerticalRoadIndex());
+
+    writer.WriteU64(map.GetBuildings().size());
+    for(const auto& building : map.GetBuildings()) {
+        const auto& bounds = building.GetBounds();
+        WriteCoord(writer, bounds.position.x);
+        WriteCoord(writer, bounds.position.y);
+        WriteCoord(writer, bounds.size.width);
+        WriteCoord(writer, bounds.size.height);
+    }
+
+    writer.WriteU64(map.GetOffices().size());
+    for(const auto& office : map.GetOffices()) {
+        writer.WriteString(*office.GetId());
+        WriteCoord(writer, office.GetPosition().x);
+        WriteCoord(writer, office.GetPosition().y);
+        WriteCoord(writer, office.GetOffset().dx);
+        WriteCoord(writer, office.GetOffset().dy);
+    }
+
+    // Описание типа трофея отдаётся клиентам как есть, поэтому хранится деревом JSON
+    // в двоичном виде: при загрузке не нужен разбор текста
+    writer.WriteU64(map.GetLootTypes().size());
+    for(const auto& loot_type : map.GetLootTypes()) {
+        EncodeJson(writer, loot_type.GetLootType());
+    }
+}
+
+model::Map DecodeMap(BinaryReader& reader) {
+    model::Map::Id id{reader.ReadString()};
+    model::Map map(std::move(id), reader.ReadString());
+    map.SetDogSpeed(reader.ReadDouble());
+    map.SetBagCapacity(reader.ReadU64());
+
+    model::Map::Roads roads;
+    const uint64_t roads_count = reader.ReadCount(min_road_size);
+    roads.reserve(roads_count);
+    for(uint64_t i = 0; i < roads_count; ++i) {
+        const bool is_horizontal = reader.ReadBool();
+        const model::Point start{ReadCoord(reader), ReadCoord(reader)};
+        const model::Coord end = ReadCoord(reader);
+        if(is_horizontal) {
+            roads.emplace_back(model::Road::HORIZONTAL, start, end);
+        } else {
+            roads.emplace_back(model::Road::VERTICAL, start, end);
+        }
+    }
+    auto horizontal_roads = DecodeRoadIndex(reader);
+    auto vertical_roads = DecodeRoadIndex(reader);
+    try {
+        map.SetRoads(std::move(roads), std::move(horizontal_roads), std::move(vertical_roads));
+    } catch(const std::invalid_argument& e) {
+        throw serialization::SnapshotError(e.what());
+    }
+
+    model::Map::Buildings buildings;
+    const uint64_t buildings_count = reader.ReadCount(min_building_size);
+    buildings.reserve(buildings_count);
+    for(uint64_t i = 0; i < buildings_count; ++i) {
+        const model::Point position{ReadCoord(reader), ReadCoord(reader)};
+        const model::Size size{ReadCoord(reader), ReadCoord(reader)};
+        buildings.emplace_back(model::Rectangle{position, size});
+    }
+    map.SetBuildings(std::move(buildings));
+
+    const uint64_t offices_count = reader.ReadCount(min_office_size);
+    for(uint64_t i = 0; i < offices_count; ++i) {
+        model::Office::Id office_id{reader.ReadString()};
+        const model::Point position{ReadCoord(reader), ReadCoord(reader)};
+        const model::Offset offset{ReadCoord(reader), ReadCoord(reader)};
+        map.AddOffice(model::Office(std::move(office_id), position, offset));
+    }
+
+    const uint64_t loot_types_count = reader.ReadCount(min_loot_type_size);
+    for(uint64_t i = 0; i < loot_types_count; ++i) {
+        map.AddLootType(model::LootType(DecodeJson(reader)));
+    }
+    return map;
+}
+
+}  // namespace
+
+bool IsMapBundle(std::string_view data) noexcept {
+    return data.starts_with(bundle_magic);
+}
+
+std::string EncodeMapBundle(const model::Game& game) {
+    BinaryWriter writer;
+    writer.WriteBytes(bundle_magic);
+    writer.WriteU32(bundle_version);
+    const size_t crc_offset = writer.Size();
+    writer.WriteU32(0);
+    writer.WriteU64(game.GetMaps().size());
+    writer.WriteDouble(game.GetRetirementTime());
+    writer.WriteDouble(game.GetLootGeneratorConf()->GetPeriod());
+    writer.WriteDouble(game.GetLootGeneratorConf()->GetPropability());
+    for(const auto& map : game.GetMaps()) {
+        EncodeMap(writer, map);
+    }
+    const uint32_t crc = serialization::Crc32(std::string_view(writer.Data()).substr(crc_offset + sizeof(uint32_t)));
+    writer.PatchU32(crc_offset, crc);
+    return writer.Release();
+}
+
+model::Game DecodeMapBundle(std::string_view data) {
+    if(!IsMapBundle(data)) {
+        throw serialization::SnapshotError("Not a map bundle");
+    }
+    BinaryReader header_reader(data.substr(bundle_magic.size()));
+    if(const uint32_t version = header_reader.ReadU32(); version != bundle_version) {
+        throw serialization::SnapshotError("Unsupported map bundle version " + std::to_string(version));
+    }
+    const uint32_t crc = header_reader.ReadU32();
+    const std::string_view payload = data.substr(bundle_magic.size() + 2 * sizeof(uint32_t));
+    if(serialization::Crc32(payload) != crc) {
+        throw serialization::SnapshotError("Map bundle checksum mismatch");
+    }
+    BinaryReader reader(payload);
+    const uint64_t maps_count = reader.ReadCount(4 * sizeof(uint64_t));
+
+    model::Game game;
+    game.SetRetirementTime(reader.ReadDouble());
+    const double loot_period = reader.ReadDouble();
+    const double loot_probability = reader.ReadDouble();
+    game.SetLootGeneratorConf(loot_period, loot_probability);
+    game.ReserveMaps(maps_count);
+    for(uint64_t i = 0; i < maps_count; ++i) {
+        game.AddMap(DecodeMap(reader));
+    }
+    if(!reader.AtEnd()) {
+        throw serialization::SnapshotError("Unexpected data at the end of map bundle");
+    }
+    return game;
+}
+
+}  // namespace json_loader
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "../game/game.h"
+
+namespace json_loader {
+
+// Скомпилированный набор карт: содержимое конфигурации без JSON.
+//
+// Заголовок:  magic[8] | version:u32 | crc32:u32 (всех данных после него) | map_count:u64
+// Игра:       retirement_time:f64 | loot_period:f64 | loot_probability:f64
+// Карта:      id | name | dog_speed:f64 | bag_capacity:u64
+//             | roads | horizontal_index | vertical_index | buildings | offices | loot_types
+// Дорога:     is_horizontal:u8 | x0 | y0 | x1 или y1
+//
+// Дороги хранятся вместе с готовыми индексами по координатам, поэтому при загрузке
+// не нужно ни разбирать JSON, ни строить индексы заново.
+
+bool IsMapBundle(std::string_view data) noexcept;
+
+std::string EncodeMapBundle(const model::Game& game);
+
+// Бросает serialization::SnapshotError, если данные повреждены
+model::Game DecodeMapBundle(std::string_view data);
+
+}  // namespace json_loader
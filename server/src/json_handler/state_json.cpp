@@ -0,0 +1,55 @@
+#include "state_json.h"
+#include "json_loader.h"
+
+#include <boost/json.hpp>
+
+namespace json_loader {
+
+std::string SerializeState(const std::vector<const model::Dog*>& dogs, const model::LootsWrappler& loots) {
+    const auto& all_loots = loots.GetAllLoots();
+    boost::json::object players_json;
+    for(const model::Dog* dog : dogs)
+    {
+        auto pos = dog->GetDogCoordinates();
+        auto speed = dog->GetDogSpeed();
+        auto dir = dog->GetDogDirectionString();
+        boost::json::array loots_json_bag;
+        for(auto id : dog->GetDogsBag().GetAllIds())
+        {
+            boost::json::object loot{
+                {"id", id},
+                {"type", all_loots.at(id)->GetType()}
+            };
+            loots_json_bag.push_back(loot);
+        }
+
+        players_json[std::to_string(dog->GetId())] = boost::json::object{
+            {"pos", { pos.x_, pos.y_}},
+            {"speed", { speed.dx_, speed.dy_}},
+            {"dir", dir},
+            {"bag", loots_json_bag},
+            {"score", dog->GetScore()}
+        };
+    }
+    auto lost_loots = loots.GetLoots();
+    boost::json::object loots_json;
+    for(size_t i = 0; i < lost_loots.size(); ++i)
+    {
+        if(!loots.IsBusyLoot(i))
+        {
+            const auto& loot = lost_loots.at(i);
+            boost::json::object loot_json;
+            loot_json[literals::loot_type_type] = loot->GetType();
+            boost::json::array pos = {static_cast<double>(loot->GetPosition().x), static_cast<double>(loot->GetPosition().y)};
+            loot_json[literals::loot_pos] = pos;
+            loots_json[std::to_string(i)] = loot_json;
+        }
+    }
+    boost::json::object result_json{
+        {"players",     players_json},
+        {"lostObjects", loots_json}
+    };
+    return boost::json::serialize(result_json);
+}
+
+}  // namespace json_loader
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../game/game_items.h"
+
+namespace json_loader {
+
+// Тело ответа /api/v1/game/state: собаки игроков сессии и трофеи на карте
+std::string SerializeState(const std::vector<const model::Dog*>& dogs, const model::LootsWrappler& loots);
+
+}  // namespace json_loader
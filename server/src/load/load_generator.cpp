@@ -0,0 +1,346 @@
+#include "load_generator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/post.hpp>
+
+namespace load {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr auto io_timeout = 10s;
+// Пауза между входом всех игроков и началом расписания
+constexpr auto schedule_delay = 100ms;
+
+constexpr std::string_view join_target = "/api/v1/game/join"sv;
+constexpr std::string_view action_target = "/api/v1/game/player/action"sv;
+constexpr std::string_view state_target = "/api/v1/game/state"sv;
+constexpr std::string_view players_target = "/api/v1/game/players"sv;
+constexpr std::string_view records_target = "/api/v1/game/records"sv;
+
+constexpr std::array<std::string_view, 5> moves = {"L"sv, "R"sv, "U"sv, "D"sv, ""sv};
+
+double ToMs(uint64_t us) {
+    return static_cast<double>(us) / 1000.0;
+}
+
+}  // namespace
+
+std::string_view GetEndpointName(Endpoint endpoint) noexcept {
+    switch(endpoint) {
+    case Endpoint::kJoin:       return "join"sv;
+    case Endpoint::kAction:     return "action"sv;
+    case Endpoint::kState:      return "state"sv;
+    case Endpoint::kPlayers:    return "players"sv;
+    case Endpoint::kRecords:    return "records"sv;
+    case Endpoint::kCount:      break;
+    }
+    return "unknown"sv;
+}
+
+// Stats
+
+void Stats::Record(Endpoint endpoint, unsigned status, Clock::duration latency) noexcept {
+    auto& stats = endpoints_[static_cast<size_t>(endpoint)];
+    if(status == 0) {
+        stats.failures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if(status >= 200 && status < 300) {
+        stats.ok.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        stats.http_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    stats.latency_us.Record(static_cast<uint64_t>(
+        std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count())));
+}
+
+void Stats::Print(std::ostream& out, Clock::duration elapsed) const {
+    const double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 1e-9);
+    out << std::left << std::setw(10) << "endpoint" << std::right
+        << std::setw(10) << "requests" << std::setw(10) << "errors" << std::setw(10) << "failed"
+        << std::setw(10) << "req/s" << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+        << std::setw(10) << "p99 ms" << std::setw(10) << "p99.9 ms" << std::setw(10) << "max ms" << '\n';
+    out << std::fixed << std::setprecision(2);
+    for(size_t i = 0; i < endpoints_count; ++i) {
+        const auto& stats = endpoints_[i];
+        const auto snapshot = stats.latency_us.GetSnapshot();
+        const uint64_t failures = stats.failures.load(std::memory_order_relaxed);
+        if(snapshot.Count() == 0 && failures == 0) {
+            continue;
+        }
+        out << std::left << std::setw(10) << GetEndpointName(static_cast<Endpoint>(i)) << std::right
+            << std::setw(10) << snapshot.Count()
+            << std::setw(10) << stats.http_errors.load(std::memory_order_relaxed)
+            << std::setw(10) << failures
+            << std::setw(10) << static_cast<double>(snapshot.Count()) / seconds
+            << std::setw(10) << ToMs(snapshot.Quantile(0.5))
+            << std::setw(10) << ToMs(snapshot.Quantile(0.9))
+            << std::setw(10) << ToMs(snapshot.Quantile(0.99))
+            << std::setw(10) << ToMs(snapshot.Quantile(0.999))
+            << std::setw(10) << ToMs(snapshot.Max()) << '\n';
+    }
+}
+
+std::string Stats::ToJson(const Config& config, Clock::duration elapsed) const {
+    const double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 1e-9);
+    std::string out;
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  R"({"connections":%zu,"targetRate":%.3f,"durationSeconds":%.3f,"endpoints":{)",
+                  config.connections, config.rate, seconds);
+    out += buffer;
+    bool is_first = true;
+    for(size_t i = 0; i < endpoints_count; ++i) {
+        const auto& stats = endpoints_[i];
+        const auto snapshot = stats.latency_us.GetSnapshot();
+        const uint64_t failures = stats.failures.load(std::memory_order_relaxed);
+        if(snapshot.Count() == 0 && failures == 0) {
+            continue;
+        }
+        if(!is_first) {
+            out += ',';
+        }
+        is_first = false;
+        std::snprintf(buffer, sizeof(buffer),
+                      R"("%s":{"requests":%llu,"ok":%llu,"httpErrors":%llu,"failures":%llu,"throughput":%.3f,)"
+                      R"("p50Ms":%.3f,"p90Ms":%.3f,"p99Ms":%.3f,"p999Ms":%.3f,"maxMs":%.3f})",
+                      std::string(GetEndpointName(static_cast<Endpoint>(i))).c_str(),
+                      static_cast<unsigned long long>(snapshot.Count()),
+                      static_cast<unsigned long long>(stats.ok.load(std::memory_order_relaxed)),
+                      static_cast<unsigned long long>(stats.http_errors.load(std::memory_order_relaxed)),
+                      static_cast<unsigned long long>(failures),
+                      static_cast<double>(snapshot.Count()) / seconds,
+                      ToMs(snapshot.Quantile(0.5)), ToMs(snapshot.Quantile(0.9)), ToMs(snapshot.Quantile(0.99)),
+                      ToMs(snapshot.Quantile(0.999)), ToMs(snapshot.Max()));
+        out += buffer;
+    }
+    out += "}}\n";
+    return out;
+}
+
+ServerEndpoints ResolveServer(net::io_context& ioc, const Config& config) {
+    if(!config.unix_socket.empty()) {
+        return {net::local::stream_protocol::endpoint(config.unix_socket)};
+    }
+    tcp::resolver resolver(ioc);
+    ServerEndpoints endpoints;
+    for(const auto& entry : resolver.resolve(config.host, config.port)) {
+        endpoints.emplace_back(entry.endpoint());
+    }
+    return endpoints;
+}
+
+// Connection
+
+Connection::Connection(net::io_context& ioc, LoadRun& run, std::string map_id, size_t index)
+    : run_(run)
+    , stream_(net::make_strand(ioc))
+    , timer_(stream_.get_executor())
+    , map_id_(std::move(map_id))
+    , user_name_("load-" + std::to_string(index))
+    , random_(std::random_device{}() ^ index)
+    , mix_(run.GetMix()) {
+}
+
+void Connection::Start(const ServerEndpoints& endpoints) {
+    stream_.expires_after(io_timeout);
+    stream_.async_connect(endpoints, [self = shared_from_this()](beast::error_code ec, const net::generic::stream_protocol::endpoint&) {
+        self->OnConnect(ec);
+    });
+}
+
+void Connection::OnConnect(beast::error_code ec) {
+    if(ec) {
+        return Fail(Endpoint::kJoin);
+    }
+    if(run_.GetConfig().unix_socket.empty()) {
+        stream_.socket().set_option(tcp::no_delay(true));
+    }
+    SendJoin();
+}
+
+void Connection::SendJoin() {
+    request_ = {http::verb::post, join_target, 11};
+    request_.set(http::field::host, run_.GetConfig().host);
+    request_.set(http::field::content_type, "application/json"sv);
+    request_.body() = R"({"userName":")" + user_name_ + R"(","mapId":")" + map_id_ + R"("})";
+    request_.prepare_payload();
+    current_ = Endpoint::kJoin;
+    intended_send_ = Clock::now();
+
+    stream_.expires_after(io_timeout);
+    http::async_write(stream_, request_, [self = shared_from_this()](beast::error_code ec, size_t) {
+        if(ec) {
+            return self->Fail(Endpoint::kJoin);
+        }
+        self->response_ = {};
+        http::async_read(self->stream_, self->buffer_, self->response_, [self](beast::error_code ec, size_t) {
+            self->OnJoin(ec);
+        });
+    });
+}
+
+void Connection::OnJoin(beast::error_code ec) {
+    if(ec) {
+        return Fail(Endpoint::kJoin);
+    }
+    run_.GetStats().Record(Endpoint::kJoin, response_.result_int(), Clock::now() - intended_send_);
+    if(response_.result() != http::status::ok) {
+        Close();
+        is_ready_reported_ = true;
+        return run_.ReportReady();
+    }
+    try {
+        token_ = ParseAuthToken(response_.body());
+    } catch(const std::exception&) {
+        return Fail(Endpoint::kJoin);
+    }
+    run_.ReportJoined();
+    is_ready_reported_ = true;
+    run_.ReportReady();
+}
+
+void Connection::StartSchedule(Clock::time_point start, Clock::time_point end) {
+    if(token_.empty()) {
+        return;
+    }
+    const auto& config = run_.GetConfig();
+    // Каждое соединение отправляет rate / connections запросов в секунду со случайным сдвигом фазы
+    interval_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(config.connections) / config.rate));
+    std::uniform_int_distribution<Clock::rep> offset(0, std::max<Clock::rep>(interval_.count() - 1, 0));
+    intended_send_ = start + Clock::duration(offset(random_));
+    end_ = end;
+    ScheduleNext();
+}
+
+void Connection::ScheduleNext() {
+    if(intended_send_ >= end_) {
+        return Close();
+    }
+    // Если ответ задержался и момент уже прошёл, запрос уходит сразу, но задержка
+    // по-прежнему отсчитывается от запланированного момента
+    if(intended_send_ <= Clock::now()) {
+        return SendNext();
+    }
+    timer_.expires_at(intended_send_);
+    timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+        if(!ec) {
+            self->SendNext();
+        }
+    });
+}
+
+void Connection::SendNext() {
+    Send(static_cast<Endpoint>(mix_(random_)));
+}
+
+void Connection::Send(Endpoint endpoint) {
+    current_ = endpoint;
+    const auto& host = run_.GetConfig().host;
+    switch(endpoint) {
+    case Endpoint::kAction:
+        request_ = {http::verb::post, action_target, 11};
+        request_.set(http::field::content_type, "application/json"sv);
+        request_.body() = R"({"move":")" + std::string(moves[random_() % moves.size()]) + R"("})";
+        break;
+    case Endpoint::kState:
+        request_ = {http::verb::get, state_target, 11};
+        break;
+    case Endpoint::kPlayers:
+        request_ = {http::verb::get, players_target, 11};
+        break;
+    case Endpoint::kRecords:
+    default:
+        request_ = {http::verb::get, records_target, 11};
+        break;
+    }
+    request_.set(http::field::host, host);
+    if(endpoint != Endpoint::kRecords) {
+        request_.set(http::field::authorization, "Bearer " + token_);
+    }
+    request_.prepare_payload();
+
+    stream_.expires_after(io_timeout);
+    http::async_write(stream_, request_, [self = shared_from_this()](beast::error_code ec, size_t) {
+        if(ec) {
+            return self->Fail(self->current_);
+        }
+        self->response_ = {};
+        http::async_read(self->stream_, self->buffer_, self->response_, [self](beast::error_code ec, size_t) {
+            self->OnResponse(ec);
+        });
+    });
+}
+
+void Connection::OnResponse(beast::error_code ec) {
+    if(ec) {
+        return Fail(current_);
+    }
+    run_.GetStats().Record(current_, response_.result_int(), Clock::now() - intended_send_);
+    if(response_.need_eof()) {
+        // Сервер закрывает соединение: остаток расписания этого игрока не выполняется
+        return Close();
+    }
+    intended_send_ += interval_;
+    ScheduleNext();
+}
+
+void Connection::Fail(Endpoint endpoint) {
+    run_.GetStats().Record(endpoint, 0, {});
+    Close();
+    if(!is_ready_reported_) {
+        is_ready_reported_ = true;
+        run_.ReportReady();
+    }
+}
+
+void Connection::Close() {
+    timer_.cancel();
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+    stream_.socket().close(ec);
+}
+
+// LoadRun
+
+LoadRun::LoadRun(net::io_context& ioc, Config config)
+    : ioc_(ioc)
+    , config_(std::move(config))
+    , mix_(config_.mix.begin(), config_.mix.end()) {
+}
+
+void LoadRun::Start() {
+    const ServerEndpoints endpoints = ResolveServer(ioc_, config_);
+    not_ready_ = config_.connections;
+    connections_.reserve(config_.connections);
+    for(size_t i = 0; i < config_.connections; ++i) {
+        // Игроки распределяются по картам по кругу
+        auto connection = std::make_shared<Connection>(ioc_, *this, config_.maps[i % config_.maps.size()], i);
+        connections_.push_back(connection);
+        connection->Start(endpoints);
+    }
+}
+
+void LoadRun::ReportReady() {
+    if(not_ready_.fetch_sub(1) != 1) {
+        return;
+    }
+    const Clock::time_point start = Clock::now() + schedule_delay;
+    const Clock::time_point end = start + config_.duration;
+    start_time_ = start;
+    for(const auto& connection : connections_) {
+        net::post(ioc_, [connection, start, end] {
+            connection->StartSchedule(start, end);
+        });
+    }
+}
+
+}  // namespace load
@@ -0,0 +1,183 @@
+#pragma once
+//std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//boost
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include "../metrics/histogram.h"
+
+namespace load {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+// Соединение с сервером по TCP или через сокет AF_UNIX
+using Stream = beast::basic_stream<net::generic::stream_protocol>;
+using ServerEndpoints = std::vector<net::generic::stream_protocol::endpoint>;
+using Clock = std::chrono::steady_clock;
+
+enum class Endpoint : uint8_t {
+    kJoin,
+    kAction,
+    kState,
+    kPlayers,
+    kRecords,
+    kCount
+};
+
+inline constexpr size_t endpoints_count = static_cast<size_t>(Endpoint::kCount);
+
+std::string_view GetEndpointName(Endpoint endpoint) noexcept;
+
+struct Config {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    std::string unix_socket;                    // путь к сокету AF_UNIX; пусто - host:port по TCP
+    size_t connections = 100;
+    double rate = 1000.0;                       // запросов в секунду по всем соединениям
+    std::chrono::milliseconds duration{30000};
+    std::vector<std::string> maps;              // пусто - все карты сервера
+    // Доли запросов; join выполняется один раз на соединение и в смесь не входит
+    std::array<double, endpoints_count> mix{0.0, 40.0, 40.0, 15.0, 5.0};
+    unsigned threads = 1;
+    std::string json_report;                    // путь к отчёту в JSON
+};
+
+// Разбор ответов сервера (load_json.cpp)
+std::string ParseAuthToken(std::string_view join_response);
+std::vector<std::string> ParseMapIds(std::string_view maps_response);
+
+// Адреса сервера: сокет AF_UNIX или результат разрешения host:port
+ServerEndpoints ResolveServer(net::io_context& ioc, const Config& config);
+
+// Результаты по каждому типу запроса. Задержка считается от запланированного
+// момента отправки, а не от фактического, поэтому очередь на стороне клиента
+// не скрывает медленные ответы (coordinated omission)
+class Stats {
+public:
+    // status == 0 - сетевая ошибка
+    void Record(Endpoint endpoint, unsigned status, Clock::duration latency) noexcept;
+
+    void Print(std::ostream& out, Clock::duration elapsed) const;
+    std::string ToJson(const Config& config, Clock::duration elapsed) const;
+
+private:
+    struct EndpointStats {
+        metrics::Histogram latency_us;
+        std::atomic<uint64_t> ok{0};
+        std::atomic<uint64_t> http_errors{0};
+        std::atomic<uint64_t> failures{0};
+    };
+
+    std::array<EndpointStats, endpoints_count> endpoints_;
+};
+
+class LoadRun;
+
+// Одно keep-alive соединение с одним игроком. После входа в игру отправляет запросы
+// по открытому расписанию: n-й запрос запланирован на start + offset + n * interval
+// независимо от того, когда пришёл ответ на предыдущий.
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+    Connection(net::io_context& ioc, LoadRun& run, std::string map_id, size_t index);
+
+    void Start(const ServerEndpoints& endpoints);
+    // Вызывается, когда все соединения вошли в игру
+    void StartSchedule(Clock::time_point start, Clock::time_point end);
+
+private:
+    void OnConnect(beast::error_code ec);
+    void SendJoin();
+    void OnJoin(beast::error_code ec);
+    void ScheduleNext();
+    void SendNext();
+    void Send(Endpoint endpoint);
+    void OnResponse(beast::error_code ec);
+    void Fail(Endpoint endpoint);
+    void Close();
+
+    LoadRun& run_;
+    Stream stream_;
+    net::steady_timer timer_;
+    beast::flat_buffer buffer_;
+    http::request<http::string_body> request_;
+    http::response<http::string_body> response_;
+
+    std::string map_id_;
+    std::string user_name_;
+    std::string token_;
+    std::mt19937_64 random_;
+    std::discrete_distribution<size_t> mix_;
+
+    Endpoint current_ = Endpoint::kJoin;
+    Clock::time_point intended_send_;
+    Clock::time_point end_;
+    Clock::duration interval_{};
+    bool is_ready_reported_ = false;
+};
+
+// Общее состояние прогона: конфигурация, статистика и ожидание входа всех игроков
+class LoadRun {
+public:
+    LoadRun(net::io_context& ioc, Config config);
+
+    // Подключает соединения; возвращает управление сразу, работа идёт в ioc
+    void Start();
+
+    const Config& GetConfig() const noexcept {
+        return config_;
+    }
+
+    Stats& GetStats() noexcept {
+        return stats_;
+    }
+
+    const std::discrete_distribution<size_t>& GetMix() const noexcept {
+        return mix_;
+    }
+
+    // Соединение вошло в игру или не смогло подключиться; последнее запускает расписание у всех
+    void ReportReady();
+
+    // Момент начала расписания; до входа всех игроков - time_point{}
+    Clock::time_point GetStartTime() const noexcept {
+        return start_time_.load();
+    }
+
+    uint64_t GetJoinedCount() const noexcept {
+        return joined_.load(std::memory_order_relaxed);
+    }
+
+    void ReportJoined() noexcept {
+        joined_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    net::io_context& ioc_;
+    Config config_;
+    Stats stats_;
+    std::discrete_distribution<size_t> mix_;
+    std::vector<std::shared_ptr<Connection>> connections_;
+    std::atomic<size_t> not_ready_{0};
+    std::atomic<uint64_t> joined_{0};
+    std::atomic<Clock::time_point> start_time_{Clock::time_point{}};
+};
+
+}  // namespace load
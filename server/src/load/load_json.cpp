@@ -0,0 +1,30 @@
+#include "load_generator.h"
+
+#include <stdexcept>
+
+#include <boost/json.hpp>
+
+namespace load {
+
+namespace json = boost::json;
+
+std::string ParseAuthToken(std::string_view join_response) {
+    const json::value value = json::parse(json::string_view{join_response.data(), join_response.size()});
+    const auto& token = value.as_object().at("authToken").as_string();
+    if(token.empty()) {
+        throw std::runtime_error("Empty auth token in join response");
+    }
+    return {token.data(), token.size()};
+}
+
+std::vector<std::string> ParseMapIds(std::string_view maps_response) {
+    const json::value value = json::parse(json::string_view{maps_response.data(), maps_response.size()});
+    std::vector<std::string> ids;
+    for(const auto& map : value.as_array()) {
+        const auto& id = map.as_object().at("id").as_string();
+        ids.emplace_back(id.data(), id.size());
+    }
+    return ids;
+}
+
+}  // namespace load
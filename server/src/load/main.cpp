@@ -0,0 +1,159 @@
+// Генератор нагрузки на игровой сервер: держит заданное число keep-alive соединений
+// и отправляет запросы по открытому расписанию с заданной суммарной частотой
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <thread>
+
+#include <boost/program_options.hpp>
+
+#include "load_generator.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Args {
+    load::Config config;
+    uint64_t duration_s = 30;
+    std::string mix = "action=40,state=40,players=15,records=5";
+};
+
+// "action=40,state=40" -> доли по типам запросов; неуказанные получают 0
+std::array<double, load::endpoints_count> ParseMix(std::string_view mix) {
+    std::array<double, load::endpoints_count> shares{};
+    while(!mix.empty()) {
+        const size_t comma = mix.find(',');
+        const std::string_view item = mix.substr(0, comma);
+        mix = comma == std::string_view::npos ? std::string_view{} : mix.substr(comma + 1);
+
+        const size_t eq = item.find('=');
+        if(eq == std::string_view::npos) {
+            throw std::invalid_argument("Wrong mix item: " + std::string(item));
+        }
+        const std::string_view name = item.substr(0, eq);
+        size_t i = 0;
+        while(i < load::endpoints_count && load::GetEndpointName(static_cast<load::Endpoint>(i)) != name) {
+            ++i;
+        }
+        if(i == load::endpoints_count || static_cast<load::Endpoint>(i) == load::Endpoint::kJoin) {
+            throw std::invalid_argument("Unknown endpoint in mix: " + std::string(name));
+        }
+        shares[i] = std::stod(std::string(item.substr(eq + 1)));
+        if(shares[i] < 0) {
+            throw std::invalid_argument("Negative share in mix: " + std::string(item));
+        }
+    }
+    if(std::all_of(shares.begin(), shares.end(), [](double share) { return share == 0; })) {
+        throw std::invalid_argument("Empty request mix");
+    }
+    return shares;
+}
+
+[[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
+    namespace po = boost::program_options;
+    Args args;
+    auto& config = args.config;
+    po::options_description desc{"All options"s};
+    desc.add_options()
+        ("help,h", "Show help")
+        ("host",            po::value(&config.host)->value_name("host"s),                   "Server host")
+        ("port",            po::value(&config.port)->value_name("port"s),                   "Server port")
+        ("unix-socket",     po::value(&config.unix_socket)->value_name("path"s),            "Connect through this AF_UNIX socket instead of host:port (host is still sent in Host header)")
+        ("connections",     po::value(&config.connections)->value_name("count"s),           "Number of players (one keep-alive connection each)")
+        ("rate",            po::value(&config.rate)->value_name("rps"s),                    "Total request rate over all connections")
+        ("duration",        po::value(&args.duration_s)->value_name("seconds"s),            "Measurement duration")
+        ("map",             po::value(&config.maps)->multitoken()->value_name("id"s),       "Maps to join (default - all maps of the server)")
+        ("mix",             po::value(&args.mix)->value_name("endpoint=share,..."s),        "Request mix (action, state, players, records)")
+        ("threads",         po::value(&config.threads)->value_name("count"s),               "Number of client threads")
+        ("json-report",     po::value(&config.json_report)->value_name("file"s),            "Write results as JSON");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if(vm.contains("help")) {
+        std::cout << desc;
+        return std::nullopt;
+    }
+    if(config.connections == 0 || config.rate <= 0) {
+        throw std::invalid_argument("Connections and rate must be positive");
+    }
+    config.duration = std::chrono::seconds(args.duration_s);
+    config.mix = ParseMix(args.mix);
+    config.threads = std::max(1u, config.threads);
+    return args;
+}
+
+std::vector<std::string> FetchMapIds(const load::Config& config) {
+    namespace http = load::http;
+    load::net::io_context ioc;
+    load::Stream stream(ioc);
+    stream.connect(load::ResolveServer(ioc, config));
+
+    http::request<http::empty_body> request{http::verb::get, "/api/v1/maps"sv, 11};
+    request.set(http::field::host, config.host);
+    http::write(stream, request);
+
+    load::beast::flat_buffer buffer;
+    http::response<http::string_body> response;
+    http::read(stream, buffer, response);
+    if(response.result() != http::status::ok) {
+        throw std::runtime_error("Failed to get maps: HTTP "s + std::to_string(response.result_int()));
+    }
+    load::beast::error_code ec;
+    stream.socket().shutdown(load::tcp::socket::shutdown_both, ec);
+    return load::ParseMapIds(response.body());
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        auto args = ParseCommandLine(argc, argv);
+        if(!args) {
+            return EXIT_SUCCESS;
+        }
+        auto& config = args->config;
+        if(config.maps.empty()) {
+            config.maps = FetchMapIds(config);
+            if(config.maps.empty()) {
+                throw std::runtime_error("Server has no maps");
+            }
+        }
+
+        load::net::io_context ioc(static_cast<int>(config.threads));
+        load::LoadRun run(ioc, config);
+        std::cout << "Joining " << config.connections << " players to " << config.maps.size() << " map(s)..." << std::endl;
+        run.Start();
+
+        std::vector<std::jthread> workers;
+        workers.reserve(config.threads - 1);
+        for(unsigned i = 1; i < config.threads; ++i) {
+            workers.emplace_back([&ioc] { ioc.run(); });
+        }
+        ioc.run();
+        for(auto& worker : workers) {
+            worker.join();
+        }
+
+        const auto start = run.GetStartTime();
+        const auto elapsed = start == load::Clock::time_point{} ? load::Clock::duration{} : load::Clock::now() - start;
+        std::cout << "Joined " << run.GetJoinedCount() << " of " << config.connections << " players, "
+                  << config.rate << " req/s target\n";
+        run.GetStats().Print(std::cout, elapsed);
+
+        if(!config.json_report.empty()) {
+            std::ofstream out(config.json_report);
+            if(!out) {
+                throw std::runtime_error("Failed to open " + config.json_report);
+            }
+            out << run.GetStats().ToJson(config, elapsed);
+        }
+    } catch(const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
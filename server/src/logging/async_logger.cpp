@@ -0,0 +1,286 @@
+#include "async_logger.h"
+
+//std
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <ctime>
+
+//boost
+#include <boost/asio/ip/address.hpp>
+
+namespace async_log {
+
+namespace {
+
+using namespace std::literals;
+
+// Запись в stdout целиком, без буферизации stdio
+void WriteAll(std::string_view data) {
+    while(!data.empty()) {
+        const size_t written = std::fwrite(data.data(), 1, data.size(), stdout);
+        if(written == 0) {
+            break;
+        }
+        data.remove_prefix(written);
+    }
+    std::fflush(stdout);
+}
+
+void AppendIp(std::string& out, const LogRecord& record) {
+    namespace net = boost::asio::ip;
+    if(record.is_ipv6) {
+        net::address_v6::bytes_type bytes;
+        std::copy(record.ip.begin(), record.ip.end(), bytes.begin());
+        out += net::address_v6(bytes).to_string();
+    } else {
+        net::address_v4::bytes_type bytes;
+        std::copy_n(record.ip.begin(), bytes.size(), bytes.begin());
+        out += net::address_v4(bytes).to_string();
+    }
+}
+
+}  // namespace
+
+void LogRecord::SetShortText(std::string_view str) noexcept {
+    short_text_size = static_cast<uint8_t>(std::min(str.size(), short_text_capacity));
+    std::copy_n(str.data(), short_text_size, short_text);
+}
+
+void LogRecord::SetText(std::string_view str) noexcept {
+    is_text_truncated = str.size() > text_capacity;
+    text_size = static_cast<uint16_t>(std::min(str.size(), text_capacity));
+    std::copy_n(str.data(), text_size, text);
+}
+
+RecordRing::RecordRing(size_t capacity)
+    : records_(std::make_unique<LogRecord[]>(std::bit_ceil(std::max<size_t>(capacity, 2))))
+    , mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1) {
+}
+
+AsyncLogger& AsyncLogger::Instance() {
+    static AsyncLogger* logger = new AsyncLogger(Config{});
+    return *logger;
+}
+
+AsyncLogger::AsyncLogger(Config config)
+    : config_(config) {
+    std::thread([this] {
+        Run();
+    }).detach();
+}
+
+RecordRing& AsyncLogger::GetThreadRing() {
+    // Буфер переживает свой поток: оставшиеся записи дописывает фоновый поток
+    struct RingHolder {
+        std::shared_ptr<RecordRing> ring;
+        ~RingHolder() {
+            if(ring) {
+                ring->MarkOrphaned();
+            }
+        }
+    };
+    thread_local RingHolder holder;
+    if(!holder.ring) {
+        holder.ring = std::make_shared<RecordRing>(config_.ring_capacity);
+        std::lock_guard lock(rings_mutex_);
+        rings_.push_back(holder.ring);
+    }
+    return *holder.ring;
+}
+
+void AsyncLogger::PushLine(int64_t timestamp_us, std::string line) {
+    std::lock_guard lock(lines_mutex_);
+    pending_lines_.push_back({timestamp_us, std::move(line)});
+}
+
+bool AsyncLogger::Shutdown(std::chrono::milliseconds timeout) {
+    std::unique_lock lock(state_mutex_);
+    is_stop_requested_ = true;
+    cond_var_.notify_one();
+    return stopped_cond_var_.wait_for(lock, timeout, [this] {
+        return is_stopped_;
+    });
+}
+
+uint64_t AsyncLogger::GetDroppedCount() const {
+    std::lock_guard lock(rings_mutex_);
+    uint64_t dropped = dropped_in_removed_rings_;
+    for(const auto& ring : rings_) {
+        dropped += ring->GetDroppedCount();
+    }
+    return dropped;
+}
+
+int64_t AsyncLogger::NowUs() noexcept {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void AsyncLogger::AppendLinePrefix(std::string& out, int64_t timestamp_us) {
+    // Формат как у boost::posix_time::to_iso_extended_string в местном времени
+    const std::time_t seconds = static_cast<std::time_t>(timestamp_us / 1000000);
+    std::tm local{};
+    localtime_r(&seconds, &local);
+    char buffer[64];
+    const int size = std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02dT%02d:%02d:%02d.%06lld",
+                                   local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                                   local.tm_hour, local.tm_min, local.tm_sec,
+                                   static_cast<long long>(timestamp_us % 1000000));
+    out += R"({"timestamp":")"sv;
+    out.append(buffer, static_cast<size_t>(std::max(size, 0)));
+    out += "\","sv;
+}
+
+void AsyncLogger::AppendJsonString(std::string& out, std::string_view str) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out += '"';
+    for(const char c : str) {
+        switch(c) {
+        case '"':  out += "\\\""sv; break;
+        case '\\': out += "\\\\"sv; break;
+        case '\n': out += "\\n"sv; break;
+        case '\r': out += "\\r"sv; break;
+        case '\t': out += "\\t"sv; break;
+        default:
+            if(static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00"sv;
+                out += hex[(c >> 4) & 0xF];
+                out += hex[c & 0xF];
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+void AsyncLogger::FormatRecord(const LogRecord& record) {
+    const size_t begin = formatted_.size();
+    AppendLinePrefix(formatted_, record.timestamp_us);
+    switch(record.type) {
+    case LogRecord::Type::kRequest: {
+        formatted_ += R"("data":{"ip":")"sv;
+        AppendIp(formatted_, record);
+        formatted_ += R"(","URI":)"sv;
+        std::string uri(record.text, record.text_size);
+        if(record.is_text_truncated) {
+            uri += "..."sv;
+        }
+        AppendJsonString(formatted_, uri);
+        formatted_ += R"(,"method":)"sv;
+        AppendJsonString(formatted_, {record.short_text, record.short_text_size});
+        formatted_ += R"(},"message":"request received"})"sv;
+        break;
+    }
+    case LogRecord::Type::kResponse:
+        formatted_ += R"("data":{"response_time":)"sv;
+        formatted_ += std::to_string(record.value);
+        formatted_ += R"(,"code":)"sv;
+        formatted_ += std::to_string(record.code);
+        formatted_ += R"(,"content_type":)"sv;
+        AppendJsonString(formatted_, record.short_text_size != 0
+                                     ? std::string_view{record.short_text, record.short_text_size}
+                                     : "null"sv);
+        formatted_ += R"(},"message":"response sent"})"sv;
+        break;
+    }
+    formatted_ += '\n';
+    lines_.push_back({record.timestamp_us, begin, formatted_.size()});
+}
+
+bool AsyncLogger::WriteBatch() {
+    formatted_.clear();
+    lines_.clear();
+
+    {
+        std::lock_guard lock(lines_mutex_);
+        taken_lines_.swap(pending_lines_);
+    }
+    for(const auto& pending : taken_lines_) {
+        const size_t begin = formatted_.size();
+        formatted_ += pending.line;
+        formatted_ += '\n';
+        lines_.push_back({pending.timestamp_us, begin, formatted_.size()});
+    }
+    taken_lines_.clear();
+
+    uint64_t dropped = 0;
+    {
+        std::lock_guard lock(rings_mutex_);
+        for(auto it = rings_.begin(); it != rings_.end();) {
+            auto& ring = **it;
+            // Признак проверяется до опустошения, чтобы не потерять последние записи потока
+            const bool is_orphaned = ring.IsOrphaned();
+            ring.Drain([this](const LogRecord& record) {
+                FormatRecord(record);
+            });
+            if(is_orphaned && ring.IsEmpty()) {
+                dropped_in_removed_rings_ += ring.GetDroppedCount();
+                it = rings_.erase(it);
+            } else {
+                dropped += ring.GetDroppedCount();
+                ++it;
+            }
+        }
+        dropped += dropped_in_removed_rings_;
+    }
+
+    if(dropped != reported_dropped_) {
+        const size_t begin = formatted_.size();
+        const int64_t timestamp_us = NowUs();
+        AppendLinePrefix(formatted_, timestamp_us);
+        formatted_ += R"("data":{"dropped":)"sv;
+        formatted_ += std::to_string(dropped - reported_dropped_);
+        formatted_ += R"(,"total_dropped":)"sv;
+        formatted_ += std::to_string(dropped);
+        formatted_ += R"(},"message":"log records dropped"})"sv;
+        formatted_ += '\n';
+        lines_.push_back({timestamp_us, begin, formatted_.size()});
+        reported_dropped_ = dropped;
+    }
+
+    if(lines_.empty()) {
+        return false;
+    }
+
+    const auto by_time = [](const FormattedLine& lhs, const FormattedLine& rhs) {
+        return lhs.timestamp_us < rhs.timestamp_us;
+    };
+    if(std::is_sorted(lines_.begin(), lines_.end(), by_time)) {
+        WriteAll(formatted_);
+    } else {
+        // Записи разных потоков чередуются: выводим их в порядке времени
+        std::stable_sort(lines_.begin(), lines_.end(), by_time);
+        output_.clear();
+        output_.reserve(formatted_.size());
+        for(const auto& line : lines_) {
+            output_.append(formatted_, line.begin, line.end - line.begin);
+        }
+        WriteAll(output_);
+    }
+    written_.fetch_add(lines_.size(), std::memory_order_relaxed);
+    return true;
+}
+
+void AsyncLogger::Run() {
+    while(true) {
+        bool is_stop_requested = false;
+        {
+            std::unique_lock lock(state_mutex_);
+            cond_var_.wait_for(lock, config_.flush_interval, [this] {
+                return is_stop_requested_;
+            });
+            is_stop_requested = is_stop_requested_;
+        }
+        WriteBatch();
+        if(is_stop_requested) {
+            std::lock_guard lock(state_mutex_);
+            is_stopped_ = true;
+            stopped_cond_var_.notify_all();
+            return;
+        }
+    }
+}
+
+}  // namespace async_log
@@ -0,0 +1,195 @@
+#pragma once
+//std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace async_log {
+
+// Запись о запросе или ответе фиксированного размера: поток-производитель только копирует поля,
+// JSON формирует фоновый поток
+struct LogRecord {
+    static constexpr size_t short_text_capacity = 64;
+    static constexpr size_t text_capacity = 384;
+
+    enum class Type : uint8_t {
+        kRequest,   // ip, method (short_text), URI (text)
+        kResponse   // response_time (value), code, content_type (short_text)
+    };
+
+    Type type = Type::kRequest;
+    bool is_ipv6 = false;
+    bool is_text_truncated = false;
+    uint8_t short_text_size = 0;
+    uint16_t text_size = 0;
+    int32_t code = 0;
+    int64_t timestamp_us = 0;
+    int64_t value = 0;
+    std::array<unsigned char, 16> ip{};
+    char short_text[short_text_capacity];
+    char text[text_capacity];
+
+    void SetShortText(std::string_view str) noexcept;
+    void SetText(std::string_view str) noexcept;
+};
+
+static_assert(sizeof(LogRecord) <= 512);
+
+// Кольцевой буфер с одним производителем (поток, которому он принадлежит) и одним потребителем
+class RecordRing {
+public:
+    explicit RecordRing(size_t capacity);
+
+    // fill заполняет запись на месте; при переполнении запись отбрасывается
+    template <typename Fill>
+    bool TryPush(Fill&& fill) noexcept {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if(tail - cached_head_ > mask_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        fill(records_[tail & mask_]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Вызывается только потоком записи
+    template <typename Handler>
+    size_t Drain(Handler&& handler) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for(size_t i = head; i != tail; ++i) {
+            handler(records_[i & mask_]);
+        }
+        head_.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    bool IsEmpty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    uint64_t GetDroppedCount() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    // Поток-владелец завершился: после опустошения буфер можно удалить
+    void MarkOrphaned() noexcept {
+        is_orphaned_.store(true, std::memory_order_release);
+    }
+
+    bool IsOrphaned() const noexcept {
+        return is_orphaned_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::unique_ptr<LogRecord[]> records_;
+    size_t mask_;
+
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;            // используется только производителем
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> is_orphaned_{false};
+};
+
+// Асинхронный вывод журнала в stdout.
+// Запросы и ответы попадают в кольцевые буферы потоков без блокировок; редкие события
+// (запуск, ошибки) форматируются сразу и передаются через очередь под мьютексом.
+// Фоновый поток раз в flush_interval собирает записи, упорядочивает их по времени
+// и записывает одним блоком.
+class AsyncLogger {
+public:
+    struct Config {
+        size_t ring_capacity = 4096;    // записей на поток (по 512 байт), округляется до степени двойки
+        std::chrono::milliseconds flush_interval{5};
+    };
+
+    // Единственный экземпляр живёт до завершения процесса, чтобы логирование
+    // было доступно и из деструкторов статических объектов
+    static AsyncLogger& Instance();
+
+    template <typename Fill>
+    void Push(Fill&& fill) noexcept {
+        GetThreadRing().TryPush([&fill](LogRecord& record) {
+            record.timestamp_us = NowUs();
+            fill(record);
+        });
+    }
+
+    // Готовая строка журнала (без перевода строки)
+    void PushLine(int64_t timestamp_us, std::string line);
+
+    // Дожидается записи всего накопленного не дольше timeout и останавливает фоновый поток.
+    // Возвращает false, если за timeout записать всё не удалось
+    bool Shutdown(std::chrono::milliseconds timeout);
+
+    // Отброшено из-за переполнения буферов
+    uint64_t GetDroppedCount() const;
+    uint64_t GetWrittenCount() const noexcept {
+        return written_.load(std::memory_order_relaxed);
+    }
+
+    static int64_t NowUs() noexcept;
+    // {"timestamp":"...", - общее начало всех строк журнала
+    static void AppendLinePrefix(std::string& out, int64_t timestamp_us);
+    static void AppendJsonString(std::string& out, std::string_view str);
+
+private:
+    explicit AsyncLogger(Config config);
+
+    struct PendingLine {
+        int64_t timestamp_us;
+        std::string line;
+    };
+
+    struct FormattedLine {
+        int64_t timestamp_us;
+        size_t begin;
+        size_t end;
+    };
+
+    RecordRing& GetThreadRing();
+    void Run();
+    // Собирает всё накопленное и пишет в stdout; возвращает false, если писать было нечего
+    bool WriteBatch();
+    void FormatRecord(const LogRecord& record);
+
+    const Config config_;
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<RecordRing>> rings_;
+    uint64_t dropped_in_removed_rings_ = 0;
+
+    std::mutex lines_mutex_;
+    std::vector<PendingLine> pending_lines_;
+
+    std::mutex state_mutex_;
+    std::condition_variable cond_var_;
+    std::condition_variable stopped_cond_var_;
+    bool is_stop_requested_ = false;
+    bool is_stopped_ = false;
+
+    // Используются только фоновым потоком
+    std::string formatted_;
+    std::string output_;
+    std::vector<FormattedLine> lines_;
+    std::vector<PendingLine> taken_lines_;
+    uint64_t reported_dropped_ = 0;
+
+    std::atomic<uint64_t> written_{0};
+};
+
+}  // namespace async_log
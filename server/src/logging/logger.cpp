@@ -1,51 +1,139 @@
 #include "logger.h"
-#include <chrono>
+#include "async_logger.h"
 
-void MyFormatter(logging::record_view const& rec,  logging::formatting_ostream& strm)
+#include <atomic>
+
+using async_log::AsyncLogger;
+using async_log::LogRecord;
+
+namespace {
+
+std::atomic<LogLevel> current_level{LogLevel::kInfo};
+
+}  // namespace
+
+std::optional<LogLevel> ParseLogLevel(std::string_view level) noexcept
 {
-    if(!rec[timestamp].empty())
-    {
-        auto ts = *rec[timestamp];
-        strm << R"({"timestamp":")" << to_iso_extended_string(ts) << "\"";
+    using namespace std::literals;
+    if(level == "debug"sv) {
+        return LogLevel::kDebug;
+    }
+    if(level == "info"sv) {
+        return LogLevel::kInfo;
+    }
+    if(level == "warning"sv) {
+        return LogLevel::kWarning;
+    }
+    if(level == "error"sv) {
+        return LogLevel::kError;
     }
-    if(!rec[data].empty())
-    {
-        strm << ",\"data\":" << boost::json::serialize(rec[data].get());
+    return std::nullopt;
+}
+
+std::string_view LogLevelToString(LogLevel level) noexcept
+{
+    using namespace std::literals;
+    switch(level) {
+    case LogLevel::kDebug:
+        return "debug"sv;
+    case LogLevel::kInfo:
+        return "info"sv;
+    case LogLevel::kWarning:
+        return "warning"sv;
+    case LogLevel::kError:
+        return "error"sv;
     }
-    
-    strm << R"(,"message":")"<< rec[logging::expressions::smessage] << "\"}";
+    return "info"sv;
+}
+
+void SetLogLevel(LogLevel level) noexcept
+{
+    current_level.store(level, std::memory_order_relaxed);
+}
+
+LogLevel GetLogLevel() noexcept
+{
+    return current_level.load(std::memory_order_relaxed);
+}
+
+bool IsLogLevelEnabled(LogLevel level) noexcept
+{
+    return level >= GetLogLevel();
 }
 
 void InitLogger()
 {
-    logging::add_common_attributes(); 
+    // Запускает фоновый поток записи
+    AsyncLogger::Instance();
+}
 
-    logging::add_console_log(
-        std::cout,
-        keywords::auto_flush = true,
-        keywords::format = &MyFormatter
-    );
+bool ShutdownLogger(std::chrono::milliseconds timeout)
+{
+    return AsyncLogger::Instance().Shutdown(timeout);
 }
 
-void LogJson(const boost::json::value &data, std::string_view message)
+uint64_t GetLoggerDroppedCount()
 {
-    BOOST_LOG_SCOPED_THREAD_TAG("data", data);
-    BOOST_LOG_TRIVIAL(info) << message;
+    return AsyncLogger::Instance().GetDroppedCount();
 }
 
-void LogJsonThreadSafe(const boost::json::value& data, const std::string &message)
+uint64_t GetLoggerWrittenCount()
 {
-    BOOST_LOG_SCOPED_THREAD_TAG("data", data);
-    BOOST_LOG_TRIVIAL(info) << message;
+    return AsyncLogger::Instance().GetWrittenCount();
 }
 
-void LogResponse(const std::pair<std::string, int> &content_type_result, std::chrono::nanoseconds dur)
+void LogJson(const boost::json::value &data, std::string_view message, LogLevel level)
 {
     using namespace std::literals;
-    boost::json::value data = {
-        {"response_time", std::chrono::duration_cast<std::chrono::milliseconds>(dur).count()},
-        {"code", content_type_result.second},
-        {"content_type", (!content_type_result.first.empty()) ? content_type_result.first : "null"}
-    };
-    LogJson(data, "response sent"sv);
-}
\ No newline at end of file
+    if(!IsLogLevelEnabled(level)) {
+        return;
+    }
+    // Редкие события: строка форматируется сразу
+    const int64_t timestamp_us = AsyncLogger::NowUs();
+    std::string line;
+    AsyncLogger::AppendLinePrefix(line, timestamp_us);
+    line += "\"data\":"sv;
+    line += boost::json::serialize(data);
+    line += ",\"message\":"sv;
+    AsyncLogger::AppendJsonString(line, message);
+    line += '}';
+    AsyncLogger::Instance().PushLine(timestamp_us, std::move(line));
+}
+
+void LogJsonThreadSafe(const boost::json::value& data, const std::string &message, LogLevel level)
+{
+    LogJson(data, message, level);
+}
+
+void LogRequestReceived(const boost::asio::ip::address& ip, std::string_view uri, std::string_view method,
+                        std::optional<std::chrono::system_clock::time_point> received_at)
+{
+    AsyncLogger::Instance().Push([&](LogRecord& record) {
+        record.type = LogRecord::Type::kRequest;
+        if(received_at) {
+            record.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                received_at->time_since_epoch()).count();
+        }
+        record.is_ipv6 = ip.is_v6();
+        if(record.is_ipv6) {
+            const auto bytes = ip.to_v6().to_bytes();
+            std::copy(bytes.begin(), bytes.end(), record.ip.begin());
+        } else {
+            const auto bytes = ip.to_v4().to_bytes();
+            std::copy(bytes.begin(), bytes.end(), record.ip.begin());
+        }
+        record.SetText(uri);
+        record.SetShortText(method);
+    });
+}
+
+void LogResponse(std::string_view content_type, int code, std::chrono::nanoseconds dur)
+{
+    AsyncLogger::Instance().Push([&](LogRecord& record) {
+        record.type = LogRecord::Type::kResponse;
+        record.value = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
+        record.code = code;
+        // Пустой тип содержимого выводится как "null"
+        record.SetShortText(content_type);
+    });
+}
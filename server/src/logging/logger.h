@@ -1,37 +1,50 @@
 #pragma once
 //std
 #include <string>
+#include <string_view>
 #include <utility>
 #include <chrono>
+#include <optional>
 
 //boost
-#include <boost/log/trivial.hpp>
-#include <boost/log/core.hpp>
-#include <boost/log/expressions.hpp>
-#include <boost/log/utility/setup/file.hpp>
-#include <boost/log/utility/setup/console.hpp>
-#include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/json.hpp>
 
-#include <boost/log/attributes/scoped_attribute.hpp>
-#include <boost/log/attributes/constant.hpp>
+// Журнал пишется в stdout асинхронно (см. async_logger.h), формат строки:
+// {"timestamp":"<iso extended>","data":<json>,"message":"<message>"}
 
-#include <boost/date_time.hpp>
+// Уровни важности; записи ниже текущего уровня отбрасываются до форматирования
+enum class LogLevel : uint8_t {
+    kDebug,     // всё, выборочное логирование запросов отключено
+    kInfo,
+    kWarning,
+    kError
+};
 
-#include <boost/json.hpp>
+std::optional<LogLevel> ParseLogLevel(std::string_view level) noexcept;
+std::string_view LogLevelToString(LogLevel level) noexcept;
 
-namespace keywords = boost::log::keywords;
-namespace sinks = boost::log::sinks;
-namespace logging = boost::log;
+// Меняется во время работы через административный порт
+void SetLogLevel(LogLevel level) noexcept;
+LogLevel GetLogLevel() noexcept;
+bool IsLogLevelEnabled(LogLevel level) noexcept;
 
-BOOST_LOG_ATTRIBUTE_KEYWORD(data, "data", boost::json::value);
-BOOST_LOG_ATTRIBUTE_KEYWORD(timestamp, "TimeStamp", boost::posix_time::ptime)
+void InitLogger();
 
-void MyFormatter(logging::record_view const& rec,  logging::formatting_ostream& strm);
+// Дописывает накопленные записи не дольше timeout; false - если не успели
+bool ShutdownLogger(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
 
-void InitLogger();
+// Количество записей, отброшенных из-за переполнения буферов
+uint64_t GetLoggerDroppedCount();
+uint64_t GetLoggerWrittenCount();
+
+void LogJson(const boost::json::value &data, std::string_view message, LogLevel level = LogLevel::kInfo);
 
-void LogJson(const boost::json::value &data, std::string_view message);
+void LogJsonThreadSafe(const boost::json::value& data, const std::string &message, LogLevel level = LogLevel::kInfo);
 
-void LogJsonThreadSafe(const boost::json::value& data, const std::string &message);
+// Уровень для записей о запросах и ответах проверяет вызывающий код.
+// received_at задаётся, если запрос логируется уже после ответа
+void LogRequestReceived(const boost::asio::ip::address& ip, std::string_view uri, std::string_view method,
+                        std::optional<std::chrono::system_clock::time_point> received_at = std::nullopt);
 
-void LogResponse(const std::pair<std::string, int> &content_type_result, std::chrono::nanoseconds dur);
\ No newline at end of file
+void LogResponse(std::string_view content_type, int code, std::chrono::nanoseconds dur);
@@ -1,4 +1,5 @@
 //std
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <filesystem>
@@ -14,12 +15,16 @@
 //user
 #include "./json_handler/json_loader.h"
 #include "./request_handler/request_handler.h"
+#include "./request_handler/admin_handler.h"
 #include "./application/application.h"
 #include "./logging/logger.h"
 #include "command_line_parser.h"
 #include "./game/game.h"
 #include "./infrastructure/listener.h"
+#include "./infrastructure/thread_topology.h"
 #include "./database/database.h"
+#include "./metrics/registry.h"
+#include "./tracing/span_recorder.h"
 
 
 using namespace std::literals;
@@ -28,17 +33,75 @@ namespace sys = boost::system;
 
 namespace {
 
-// Запускает функцию fn на n потоках, включая текущий
-template <typename Fn>
-void RunWorkers(unsigned n, const Fn& fn) {
-    n = std::max(1u, n);
-    std::vector<std::jthread> workers;
-    workers.reserve(n - 1);
-    // Запускаем n-1 рабочих потоков, выполняющих функцию fn
-    while (--n) {
-        workers.emplace_back(fn);
+void CollectDatabaseMetrics(const database::ConnectionPool& pool, metrics::PrometheusWriter& writer) {
+    using Type = metrics::PrometheusWriter::Type;
+    writer.WriteHeader("db_pool_connections"sv, Type::kGauge, "Open database connections"sv);
+    writer.WriteSample("db_pool_connections"sv, {}, static_cast<uint64_t>(pool.GetSize()));
+    writer.WriteHeader("db_pool_waiters"sv, Type::kGauge, "Threads waiting for a database connection"sv);
+    writer.WriteSample("db_pool_waiters"sv, {}, static_cast<uint64_t>(pool.GetWaitersCount()));
+    writer.WriteHeader("db_pool_wait_seconds"sv, Type::kHistogram, "Time to acquire a database connection"sv);
+    writer.WriteHistogram("db_pool_wait_seconds"sv, {}, pool.GetWaitTimeHistogram().GetSnapshot(), 1e-6, metrics::kDurationBounds);
+}
+
+void CollectLoggerMetrics(metrics::PrometheusWriter& writer) {
+    using Type = metrics::PrometheusWriter::Type;
+    writer.WriteHeader("log_records_written_total"sv, Type::kCounter, "Log lines written to stdout"sv);
+    writer.WriteSample("log_records_written_total"sv, {}, GetLoggerWrittenCount());
+    writer.WriteHeader("log_records_dropped_total"sv, Type::kCounter, "Log records dropped because a buffer was full"sv);
+    writer.WriteSample("log_records_dropped_total"sv, {}, GetLoggerDroppedCount());
+}
+
+// Статистика акцепторов одного адреса из --listen
+struct ListenerAcceptStats {
+    std::string name;
+    std::shared_ptr<http_server::AcceptStats> stats;
+};
+
+void CollectAcceptMetrics(const std::vector<ListenerAcceptStats>& listeners, metrics::PrometheusWriter& writer) {
+    using Type = metrics::PrometheusWriter::Type;
+    writer.WriteHeader("http_connections_accepted_total"sv, Type::kCounter, "Accepted connections by listener and acceptor"sv);
+    for(const auto& [name, stats] : listeners) {
+        for(size_t i = 0; i < stats->GetAcceptorsCount(); ++i) {
+            const std::string acceptor = std::to_string(i);
+            writer.WriteSample("http_connections_accepted_total"sv, {{"listener"sv, name}, {"acceptor"sv, acceptor}}, stats->GetAccepted(i));
+        }
+    }
+    writer.WriteHeader("http_accept_errors_total"sv, Type::kCounter, "Failed accepts by listener and acceptor"sv);
+    for(const auto& [name, stats] : listeners) {
+        for(size_t i = 0; i < stats->GetAcceptorsCount(); ++i) {
+            const std::string acceptor = std::to_string(i);
+            writer.WriteSample("http_accept_errors_total"sv, {{"listener"sv, name}, {"acceptor"sv, acceptor}}, stats->GetErrors(i));
+        }
     }
-    fn();
+}
+
+void CollectConnectionMetrics(const http_server::ConnectionStats& stats, metrics::PrometheusWriter& writer) {
+    using Type = metrics::PrometheusWriter::Type;
+    const int64_t idle = stats.GetIdleConnections();
+    writer.WriteHeader("http_connections"sv, Type::kGauge, "Open connections; idle ones wait for a request and hold no buffers"sv);
+    writer.WriteSample("http_connections"sv, {{"state"sv, "active"sv}}, static_cast<uint64_t>(stats.GetConnections() - idle));
+    writer.WriteSample("http_connections"sv, {{"state"sv, "idle"sv}}, static_cast<uint64_t>(idle));
+    writer.WriteHeader("http_connection_memory_bytes"sv, Type::kGauge, "Memory held by connections"sv);
+    writer.WriteSample("http_connection_memory_bytes"sv, {{"kind"sv, "session"sv}}, static_cast<uint64_t>(stats.GetObjectBytes()));
+    writer.WriteSample("http_connection_memory_bytes"sv, {{"kind"sv, "buffers"sv}}, static_cast<uint64_t>(stats.GetBufferBytes()));
+    writer.WriteHeader("http_idle_timeouts_total"sv, Type::kCounter, "Connections closed by idle timeout"sv);
+    writer.WriteSample("http_idle_timeouts_total"sv, {}, stats.GetTimeouts());
+}
+
+// По SIGUSR1 записывает участки trace в файл и снова ждёт сигнала
+void WaitForTraceDumpSignal(net::signal_set& signals, const std::string& path) {
+    signals.async_wait([&signals, &path](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        if(ec) {
+            return;
+        }
+        try {
+            tracing::SpanRecorder::Instance().DumpChromeTraceToFile(path);
+            LogJson(boost::json::object{{"file", path}}, "trace written"sv);
+        } catch(const std::exception& ex) {
+            LogJson(boost::json::object{{"file", path}, {"exception", ex.what()}}, "trace write failed"sv, LogLevel::kError);
+        }
+        WaitForTraceDumpSignal(signals, path);
+    });
 }
 
 }  // namespace
@@ -53,34 +116,92 @@ int main(int argc, const char* argv[]) {
     try {
         if(auto args = cl_pars::ParseCommandLine(argc, argv))
         {
-            // 0. Инициализируем логер
-            // 1. Загружаем карту из файла и строим модель игры
+            if(!args->compile_config_.empty())
+            {
+                // Режим подготовки набора карт: сервер не запускается
+                json_loader::CompileGame(args->config_file_, args->compile_config_);
+                boost::json::value data = {
+                    {"config", args->config_file_},
+                    {"bundle", args->compile_config_}
+                };
+                LogJson(data, "map bundle compiled"sv);
+                ShutdownLogger();
+                return EXIT_SUCCESS;
+            }
+            // 0. Настраиваем логер
+            const auto log_level = ParseLogLevel(args->log_level_);
+            if(!log_level) {
+                throw std::runtime_error("Unknown log level " + args->log_level_);
+            }
+            SetLogLevel(*log_level);
+            http_handler::RequestLogSampler::Config sampler_config;
+            sampler_config.slow_threshold = std::chrono::milliseconds(args->log_slow_threshold_ms_);
+            for(const auto& rate : args->log_sample_rates_) {
+                sampler_config.sample_rates.push_back(http_handler::RequestLogSampler::ParseSampleRate(rate));
+            }
+            auto log_sampler = std::make_shared<http_handler::RequestLogSampler>(sampler_config);
+
+            // 1. Загружаем карту из файла (JSON или набор карт после --compile-config) и строим модель игры
             model::Game game = json_loader::LoadGame(args->config_file_);
 
             //Add path to static files in game     
             game.SetPathToStaticFiles(args->www_root_);
+            if(args->is_tick_profiler_enabled_ && !game.GetTickProfiler().SetEnabled(true))
+            {
+                throw std::runtime_error("Server is built without GAME_TICK_PROFILER");
+            }
+            tracing::SpanRecorder::Instance().SetEnabled(args->is_trace_enabled_);
 
-            // 2. Инициализируем io_context
-            const unsigned num_threads = std::thread::hardware_concurrency();
-            net::io_context ioc(num_threads);
+            // 2. Распределяем потоки по ролям: сеть, симуляция, обращения к БД
+            const unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+            infrastructure::ThreadTopology::Config topology_config;
+            if(args->thread_topology_ == "per-core")
+            {
+                // Один процессор остаётся потоку симуляции
+                topology_config.mode = infrastructure::ThreadTopology::Mode::kPerCore;
+                topology_config.net_threads = (args->net_threads_ != 0) ? args->net_threads_ : std::max(1u, num_threads - 1);
+            }
+            else
+            {
+                topology_config.net_threads = (args->net_threads_ != 0) ? args->net_threads_ : num_threads;
+            }
+            topology_config.io_threads = args->io_threads_;
+            topology_config.net_cpus = infrastructure::ParseCpuList(args->net_cpus_);
+            topology_config.sim_cpus = infrastructure::ParseCpuList(args->sim_cpus_);
+            topology_config.io_cpus = infrastructure::ParseCpuList(args->io_cpus_);
+            infrastructure::ThreadTopology topology(topology_config);
+            net::io_context& ioc = *topology.GetNetContexts().front();
 
             // 2.1 Инициализируем подключение к БД
             const char* db_url = std::getenv(database::DB_ENV_NAME);
             if(!db_url) {
                 throw std::runtime_error("GAME_DB_URL is not specified");
             }
-            database::Database database(db_url, num_threads);
+            database::ConnectionPool::Config pool_config;
+            pool_config.min_size = args->db_pool_min_size_;
+            pool_config.max_size = (args->db_pool_max_size_ != 0) ? args->db_pool_max_size_ : num_threads;
+            pool_config.acquire_timeout = std::chrono::milliseconds(args->db_acquire_timeout_ms_);
+            pool_config.idle_timeout = std::chrono::milliseconds(args->db_idle_timeout_ms_);
+            database::Database database(db_url, pool_config);
 
             // 2.2 Инициализируем приложение
-            // strand, используемый для доступа к API
-            auto api_strand = net::make_strand(ioc);
+            // strand, используемый для доступа к API и тактов; в per-core его выполняет поток симуляции
+            auto api_strand = net::make_strand(topology.GetSimContext());
 
-            app::Application application(game, args->is_randomize_spawn_points_, api_strand, database);
+            app::Application application(game, args->is_randomize_spawn_points_, api_strand, database.GetUnitOfWorkImpl(), topology.GetIoContext().get_executor());
 
             // 2.3 Восстановление состояния
             if(args->state_file_ != "")
             {
-                application.RecoverFromFile(args->state_file_);
+                std::optional<app::ActionJournal::Config> journal_config;
+                if(args->is_journal_enabled_)
+                {
+                    journal_config = app::ActionJournal::Config{
+                        .commit_window = std::chrono::milliseconds(args->journal_commit_window_ms_),
+                        .checkpoint_records = args->journal_checkpoint_records_
+                    };
+                }
+                application.RecoverFromFile(args->state_file_, journal_config);
             }
 
             // 2.4 Включение автоматического тактирования
@@ -95,43 +216,153 @@ int main(int argc, const char* argv[]) {
             }
             // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
             net::signal_set signals(ioc, SIGTERM, SIGINT);
-            signals.async_wait([&ioc, &application](const sys::error_code& ec, [[maybe_unused]]int signal_number) {
-                boost::json::object data;
+            signals.async_wait([&topology, &application, &api_strand](const sys::error_code& ec, [[maybe_unused]]int signal_number) {
                 if(!ec)
                 {
-                    ioc.stop();
-                    data["code"] = EXIT_FAILURE;
-                    
+                    // Состояние снимается на strand игры, чтобы не пересечься с тактом
+                    net::dispatch(api_strand, [&topology, &application] {
+                        application.SaveState();
+                        topology.Stop();
+                    });
                 }
-                application.SaveState();
             });
+            net::signal_set trace_signals(ioc, SIGUSR1);
+            WaitForTraceDumpSignal(trace_signals, args->trace_file_);
             // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-            auto handler = std::make_shared<http_handler::RequestHandler>(game, application, api_strand);
-            auto logging_handler = std::make_shared<http_handler::RequestHandlerWithLogger<http_handler::RequestHandler>>(handler);
+            auto api_queue = std::make_shared<http_handler::ApiQueue>(http_handler::ApiQueue::Config{
+                .max_depth = args->api_queue_max_depth_,
+                .max_wait = std::chrono::milliseconds(args->api_queue_max_wait_ms_),
+                .retry_after = std::chrono::seconds(args->retry_after_s_)
+            });
+            std::shared_ptr<http_handler::StaticCache> static_cache;
+            if(args->static_cache_max_file_size_ != 0)
+            {
+                static_cache = std::make_shared<http_handler::StaticCache>(game.GetPathToStaticFiles(), http_handler::StaticCache::Config{
+                    .max_file_size = args->static_cache_max_file_size_
+                });
+                if(args->is_static_watch_enabled_)
+                {
+                    static_cache->StartWatching();
+                }
+            }
+            // Запросы состояния с sinceTick ждут следующего такта, не занимая strand
+            std::shared_ptr<http_handler::StateLongPoll> state_long_poll;
+            if(args->state_long_poll_timeout_ms_ != 0)
+            {
+                const std::chrono::milliseconds max_timeout(args->state_long_poll_timeout_ms_);
+                state_long_poll = std::make_shared<http_handler::StateLongPoll>(application, api_strand, http_handler::StateLongPoll::Config{
+                    .default_timeout = std::min(max_timeout, http_handler::StateLongPoll::Config{}.default_timeout),
+                    .max_timeout = max_timeout
+                });
+            }
+            auto handler = std::make_shared<http_handler::RequestHandler>(game, application, api_strand, topology.GetIoContext().get_executor(), api_queue, static_cache, state_long_poll);
+            handler->SetServerTimingEnabled(args->is_server_timing_enabled_);
+            auto request_metrics = std::make_shared<http_handler::RequestMetrics>();
+            auto logging_handler = std::make_shared<http_handler::RequestHandlerWithLogger<http_handler::RequestHandler>>(handler, log_sampler, request_metrics);
 
-            // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
+            // 4.1 Источники метрик для /metrics
+            // В per-core у каждого сетевого потока свой io_context и свой SO_REUSEPORT-акцептор.
+            // В shared все акцепторы оказались бы в одном io_context и ядро распределяло бы
+            // соединения между ними без пользы, поэтому там reuse-port не применяется.
+            // Путь AF_UNIX всегда слушает один акцептор
+            const auto& net_contexts = topology.GetNetContexts();
+            const size_t tcp_acceptors = net_contexts.size();
+            if(args->is_reuse_port_enabled_ && net_contexts.size() == 1)
+            {
+                LogJson(boost::json::object{{"thread_topology", args->thread_topology_}}, "reuse-port ignored: it needs the per-core thread topology"sv, LogLevel::kWarning);
+            }
+            const auto connection_stats = std::make_shared<http_server::ConnectionStats>();
+            std::vector<http_server::ListenAddress> listen_addresses;
+            std::vector<ListenerAcceptStats> accept_stats;
+            for(const std::string& listen : args->listen_)
+            {
+                auto& address = listen_addresses.emplace_back(http_server::ParseListenAddress(listen));
+                const size_t acceptors = address.IsUnix() ? 1u : tcp_acceptors;
+                accept_stats.push_back({address.name, std::make_shared<http_server::AcceptStats>(acceptors)});
+            }
+            auto metrics_registry = std::make_shared<metrics::Registry>();
+            metrics_registry->AddCollector([accept_stats](metrics::PrometheusWriter& writer) {
+                CollectAcceptMetrics(accept_stats, writer);
+            });
+            metrics_registry->AddCollector([connection_stats](metrics::PrometheusWriter& writer) {
+                CollectConnectionMetrics(*connection_stats, writer);
+            });
+            metrics_registry->AddCollector([request_metrics](metrics::PrometheusWriter& writer) {
+                request_metrics->Collect(writer);
+            });
+            metrics_registry->AddCollector([api_queue](metrics::PrometheusWriter& writer) {
+                api_queue->Collect(writer);
+            });
+            if(state_long_poll)
+            {
+                metrics_registry->AddCollector([state_long_poll](metrics::PrometheusWriter& writer) {
+                    state_long_poll->Collect(writer);
+                });
+            }
+            if(static_cache)
+            {
+                metrics_registry->AddCollector([static_cache](metrics::PrometheusWriter& writer) {
+                    static_cache->Collect(writer);
+                });
+            }
+            metrics_registry->AddCollector([&application](metrics::PrometheusWriter& writer) {
+                application.CollectMetrics(writer);
+            });
+            metrics_registry->AddCollector([&database](metrics::PrometheusWriter& writer) {
+                CollectDatabaseMetrics(database.GetConnectionPool(), writer);
+            });
+            metrics_registry->AddCollector(CollectLoggerMetrics);
 
-            const auto address = net::ip::make_address("0.0.0.0");
-            constexpr net::ip::port_type port = 8080;
+            // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
 
-            http_server::ServeHttp(ioc, {address, port}, [&logging_handler](auto remote_endpoint, auto&& req, auto&& send) {
+            // Все адреса обслуживает один обработчик; счётчики соединений общие
+            boost::json::array listen_names;
+            for(size_t i = 0; i < listen_addresses.size(); ++i)
+            {
+                const http_server::ListenOptions listen_options{
+                    .acceptors = accept_stats[i].stats->GetAcceptorsCount(),
+                    .pending_accepts = args->pending_accepts_,
+                    .stats = accept_stats[i].stats,
+                    .idle_timeout = std::chrono::seconds(args->idle_timeout_s_),
+                    .connection_stats = connection_stats
+                };
+                http_server::ServeHttp(net_contexts, listen_addresses[i].endpoint, listen_options, [&logging_handler](auto remote_endpoint, auto&& req, auto&& send) {
                                 (*logging_handler)(remote_endpoint, std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
-            });
+                });
+                listen_names.emplace_back(listen_addresses[i].name);
+            }
+
+            // 5.1 Административный порт доступен только локально
+            http_handler::AdminHandler admin_handler(log_sampler, metrics_registry, game.GetTickProfiler());
+            if(args->admin_port_ != 0)
+            {
+                http_server::ServeHttp(ioc, net::ip::tcp::endpoint{net::ip::make_address("127.0.0.1"), args->admin_port_}, [&admin_handler](auto remote_endpoint, auto&& req, auto&& send) {
+                                admin_handler(remote_endpoint, std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
+                });
+            }
 
             // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
             //std::cout << "Server has started..."sv << std::endl;
 
-            boost::json::value data = {
-                {"port", port},
-                {"address", address.to_string()}
+            boost::json::object data = {
+                {"listen", std::move(listen_names)},
+                {"io_backend", http_server::GetIoBackendName()}
             };
+            // Адрес и порт первого TCP-слушателя - для тех, кто ждёт их в этой записи
+            const auto first_tcp = std::find_if(listen_addresses.begin(), listen_addresses.end(), [](const auto& address) {
+                return !address.IsUnix();
+            });
+            if(first_tcp != listen_addresses.end())
+            {
+                const net::ip::tcp::endpoint endpoint = http_server::ToTcpEndpoint(first_tcp->endpoint);
+                data["port"] = endpoint.port();
+                data["address"] = endpoint.address().to_string();
+            }
             LogJson(data, "server started"sv);
 
 
             // 6. Запускаем обработку асинхронных операций
-            RunWorkers(std::max(1u, num_threads), [&ioc] {
-                ioc.run();
-            });
+            topology.Run();
         }
     } catch (const std::exception& ex) {
         //std::cerr << ex.what() << std::endl;
@@ -140,10 +371,12 @@ int main(int argc, const char* argv[]) {
             {"exception", ex.what()}
         };
         LogJson(data, "server exited"sv);
+        ShutdownLogger();
         return EXIT_FAILURE;
     }
     boost::json::value data = {
         {"code", 0}
     };
     LogJson(data, "server exited"sv);
+    ShutdownLogger();
 }
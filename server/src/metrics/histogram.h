@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace metrics {
+
+// Лог-линейная гистограмма в стиле HDR: значения до 2*kSubBuckets хранятся точно,
+// дальше каждая степень двойки делится на kSubBuckets корзин (погрешность ~6%).
+// Запись - одна атомарная операция без блокировок.
+class Histogram {
+public:
+    static constexpr uint64_t kSubBuckets = 16;
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr size_t kBucketCount = 2 * kSubBuckets + (64 - kSubBucketBits - 1) * kSubBuckets;
+
+    class Snapshot {
+    public:
+        uint64_t Count() const noexcept {
+            return count_;
+        }
+
+        uint64_t Sum() const noexcept {
+            return sum_;
+        }
+
+        uint64_t Max() const noexcept {
+            return max_;
+        }
+
+        uint64_t BucketCount(size_t index) const noexcept {
+            return buckets_[index];
+        }
+
+        // Верхняя граница значения для квантиля q (0..1)
+        uint64_t Quantile(double q) const noexcept {
+            if(count_ == 0) {
+                return 0;
+            }
+            const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+            uint64_t seen = 0;
+            for(size_t i = 0; i < kBucketCount; ++i) {
+                seen += buckets_[i];
+                if(seen >= rank) {
+                    return std::min(BucketUpperBound(i), max_);
+                }
+            }
+            return max_;
+        }
+
+        Snapshot& Merge(const Snapshot& other) noexcept {
+            for(size_t i = 0; i < kBucketCount; ++i) {
+                buckets_[i] += other.buckets_[i];
+            }
+            count_ += other.count_;
+            sum_ += other.sum_;
+            max_ = std::max(max_, other.max_);
+            return *this;
+        }
+
+    private:
+        friend class Histogram;
+
+        std::array<uint64_t, kBucketCount> buckets_{};
+        uint64_t count_ = 0;
+        uint64_t sum_ = 0;
+        uint64_t max_ = 0;
+    };
+
+    void Record(uint64_t value) noexcept {
+        buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t prev_max = max_.load(std::memory_order_relaxed);
+        while(prev_max < value && !max_.compare_exchange_weak(prev_max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot GetSnapshot() const noexcept {
+        Snapshot snapshot;
+        for(size_t i = 0; i < kBucketCount; ++i) {
+            snapshot.buckets_[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count_ = count_.load(std::memory_order_relaxed);
+        snapshot.sum_ = sum_.load(std::memory_order_relaxed);
+        snapshot.max_ = max_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    static size_t BucketIndex(uint64_t value) noexcept {
+        if(value < 2 * kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - kSubBucketBits;
+        return 2 * kSubBuckets + (shift - 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+    }
+
+    static uint64_t BucketUpperBound(size_t index) noexcept {
+        if(index < 2 * kSubBuckets) {
+            return index;
+        }
+        const size_t k = index - 2 * kSubBuckets;
+        const unsigned shift = static_cast<unsigned>(k / kSubBuckets) + 1;
+        const uint64_t mantissa = k % kSubBuckets + kSubBuckets;
+        if(shift + kSubBucketBits + 1 >= 64 && mantissa + 1 == 2 * kSubBuckets) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+}  // namespace metrics
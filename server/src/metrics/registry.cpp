@@ -0,0 +1,136 @@
+#include "registry.h"
+
+#include <charconv>
+
+namespace metrics {
+
+namespace {
+
+using namespace std::literals;
+
+void AppendDouble(std::string& out, double value) {
+    char buffer[32];
+    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, ec == std::errc{} ? end : buffer);
+}
+
+void AppendLabelValue(std::string& out, std::string_view value) {
+    for(const char c : value) {
+        switch(c) {
+        case '\\': out += "\\\\"sv; break;
+        case '"':  out += "\\\""sv; break;
+        case '\n': out += "\\n"sv; break;
+        default:   out += c;
+        }
+    }
+}
+
+}  // namespace
+
+void PrometheusWriter::WriteHeader(std::string_view name, Type type, std::string_view help) {
+    out_ += "# HELP "sv;
+    out_ += name;
+    out_ += ' ';
+    out_ += help;
+    out_ += "\n# TYPE "sv;
+    out_ += name;
+    switch(type) {
+    case Type::kCounter:    out_ += " counter\n"sv; break;
+    case Type::kGauge:      out_ += " gauge\n"sv; break;
+    case Type::kHistogram:  out_ += " histogram\n"sv; break;
+    }
+}
+
+void PrometheusWriter::WriteName(std::string_view name, std::string_view suffix, Labels labels, std::string_view le) {
+    out_ += name;
+    out_ += suffix;
+    if(labels.size() == 0 && le.empty()) {
+        return;
+    }
+    out_ += '{';
+    bool is_first = true;
+    for(const auto& [label, value] : labels) {
+        if(!is_first) {
+            out_ += ',';
+        }
+        is_first = false;
+        out_ += label;
+        out_ += "=\""sv;
+        AppendLabelValue(out_, value);
+        out_ += '"';
+    }
+    if(!le.empty()) {
+        if(!is_first) {
+            out_ += ',';
+        }
+        out_ += "le=\""sv;
+        out_ += le;
+        out_ += '"';
+    }
+    out_ += '}';
+}
+
+void PrometheusWriter::WriteSample(std::string_view name, Labels labels, double value) {
+    WriteName(name, {}, labels);
+    out_ += ' ';
+    AppendDouble(out_, value);
+    out_ += '\n';
+}
+
+void PrometheusWriter::WriteSample(std::string_view name, Labels labels, uint64_t value) {
+    WriteName(name, {}, labels);
+    out_ += ' ';
+    out_ += std::to_string(value);
+    out_ += '\n';
+}
+
+void PrometheusWriter::WriteHistogram(std::string_view name, Labels labels, const Histogram::Snapshot& snapshot,
+                                      double scale, std::span<const double> bounds) {
+    // Корзины HDR-гистограммы сводятся к фиксированным границам: корзина попадает под границу,
+    // если её верхняя граница не больше границы вывода
+    size_t index = 0;
+    uint64_t cumulative = 0;
+    for(const double bound : bounds) {
+        const double raw_bound = bound / scale;
+        while(index < Histogram::kBucketCount && static_cast<double>(Histogram::BucketUpperBound(index)) <= raw_bound) {
+            cumulative += snapshot.BucketCount(index);
+            ++index;
+        }
+        std::string le;
+        AppendDouble(le, bound);
+        WriteName(name, "_bucket"sv, labels, le);
+        out_ += ' ';
+        out_ += std::to_string(cumulative);
+        out_ += '\n';
+    }
+    WriteName(name, "_bucket"sv, labels, "+Inf"sv);
+    out_ += ' ';
+    out_ += std::to_string(snapshot.Count());
+    out_ += '\n';
+
+    WriteName(name, "_sum"sv, labels);
+    out_ += ' ';
+    AppendDouble(out_, static_cast<double>(snapshot.Sum()) * scale);
+    out_ += '\n';
+
+    WriteName(name, "_count"sv, labels);
+    out_ += ' ';
+    out_ += std::to_string(snapshot.Count());
+    out_ += '\n';
+}
+
+void Registry::AddCollector(Collector collector) {
+    std::lock_guard lock(mutex_);
+    collectors_.push_back(std::move(collector));
+}
+
+std::string Registry::Render() const {
+    PrometheusWriter writer;
+    std::lock_guard lock(mutex_);
+    for(const auto& collector : collectors_) {
+        collector(writer);
+    }
+    return writer.Release();
+}
+
+}  // namespace metrics
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "histogram.h"
+
+namespace metrics {
+
+using Labels = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+// Границы корзин для вывода гистограмм, в единицах вывода
+inline constexpr double kDurationBounds[] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+inline constexpr double kSizeBounds[] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000
+};
+
+// Формирует текст в формате Prometheus (text exposition format 0.0.4)
+class PrometheusWriter {
+public:
+    enum class Type {
+        kCounter,
+        kGauge,
+        kHistogram
+    };
+
+    // Заголовок семейства; значения семейства пишутся сразу после него
+    void WriteHeader(std::string_view name, Type type, std::string_view help);
+
+    void WriteSample(std::string_view name, Labels labels, double value);
+    void WriteSample(std::string_view name, Labels labels, uint64_t value);
+
+    // Значения гистограммы хранятся в единицах, в 1/scale раз меньших единицы вывода
+    // (например, мкс при выводе в секундах: scale = 1e-6)
+    void WriteHistogram(std::string_view name, Labels labels, const Histogram::Snapshot& snapshot,
+                        double scale, std::span<const double> bounds);
+
+    std::string Release() {
+        return std::move(out_);
+    }
+
+private:
+    void WriteName(std::string_view name, std::string_view suffix, Labels labels, std::string_view le = {});
+
+    std::string out_;
+};
+
+// Реестр источников метрик. Источник пишет свои значения при каждом запросе /metrics,
+// поэтому сами метрики остаются полями тех объектов, которые их измеряют.
+class Registry {
+public:
+    using Collector = std::function<void(PrometheusWriter& writer)>;
+
+    void AddCollector(Collector collector);
+
+    std::string Render() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Collector> collectors_;
+};
+
+}  // namespace metrics
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "histogram.h"
+
+namespace metrics {
+
+// Число шардов: потоки распределяются по ним по кругу, поэтому соседние потоки
+// не делят одну кэш-линию при записи
+inline constexpr size_t kShardCount = 16;
+
+inline size_t CurrentShard() noexcept {
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+    return shard;
+}
+
+class ShardedCounter {
+public:
+    void Add(uint64_t value = 1) noexcept {
+        shards_[CurrentShard()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t Get() const noexcept {
+        uint64_t sum = 0;
+        for(const auto& shard : shards_) {
+            sum += shard.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Shard, kShardCount> shards_;
+};
+
+// Гистограмма из нескольких Histogram; каждый поток пишет в свою,
+// при чтении снимки объединяются
+class ShardedHistogram {
+public:
+    ShardedHistogram()
+        : shards_(std::make_unique<Shard[]>(kShardCount)) {
+    }
+
+    void Record(uint64_t value) noexcept {
+        shards_[CurrentShard()].histogram.Record(value);
+    }
+
+    Histogram::Snapshot GetSnapshot() const noexcept {
+        Histogram::Snapshot snapshot = shards_[0].histogram.GetSnapshot();
+        for(size_t i = 1; i < kShardCount; ++i) {
+            snapshot.Merge(shards_[i].histogram.GetSnapshot());
+        }
+        return snapshot;
+    }
+
+private:
+    struct alignas(64) Shard {
+        Histogram histogram;
+    };
+
+    // Около 8 КБ на шард, поэтому в куче
+    std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace metrics
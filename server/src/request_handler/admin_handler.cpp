@@ -0,0 +1,218 @@
+#include "admin_handler.h"
+#include "../logging/logger.h"
+#include "../tracing/span_recorder.h"
+
+namespace http_handler {
+
+namespace {
+
+StringResponse MakeJsonResponse(const StringRequest& req, const boost::json::value& body) {
+    return MakeStringResponse(http::status::ok, boost::json::serialize(body), req.version(), req.keep_alive(),
+                              ContentType::APPLICATION_JSON, "no-cache"sv);
+}
+
+std::optional<boost::json::object> ParseJsonObject(const StringRequest& req) {
+    boost::system::error_code ec;
+    auto value = boost::json::parse(req.body(), ec);
+    if(ec || !value.is_object()) {
+        return std::nullopt;
+    }
+    return std::move(value.as_object());
+}
+
+boost::json::object PhaseStatsToJson(const model::TickProfiler::PhaseStats& stats) {
+    const double total_us = static_cast<double>(stats.total_ns) / 1000.0;
+    return boost::json::object{
+        {"calls", stats.calls},
+        {"totalUs", total_us},
+        {"avgUs", stats.calls != 0 ? total_us / static_cast<double>(stats.calls) : 0.0},
+        {"maxUs", static_cast<double>(stats.max_ns) / 1000.0}
+    };
+}
+
+boost::json::object PhasesToJson(const model::TickProfiler::PhaseStatsArray& phases) {
+    boost::json::object result;
+    for(size_t i = 0; i < model::tick_phases_count; ++i) {
+        if(phases[i].calls == 0) {
+            continue;
+        }
+        const std::string_view name = model::GetTickPhaseName(static_cast<model::TickPhase>(i));
+        result[{name.data(), name.size()}] = PhaseStatsToJson(phases[i]);
+    }
+    return result;
+}
+
+boost::json::object TickReportToJson(const model::TickProfiler::Report& report) {
+    boost::json::object sessions;
+    for(const auto& [id, phases] : report.sessions) {
+        sessions[id] = PhasesToJson(phases);
+    }
+    return boost::json::object{
+        {"compiled", model::is_tick_profiler_compiled},
+        {"enabled", report.is_enabled},
+        {"ticks", PhaseStatsToJson(report.ticks)},
+        {"phases", PhasesToJson(report.phases)},
+        {"sessions", std::move(sessions)}
+    };
+}
+
+}  // namespace
+
+StringResponse AdminHandler::HandleAdminRequest(StringRequest&& req) {
+    if(req.target() == AdminEndpoints::log_level) {
+        return HandleLogLevel(req);
+    }
+    if(req.target() == AdminEndpoints::log_sampling) {
+        return HandleLogSampling(req);
+    }
+    if(req.target() == AdminEndpoints::tick_profile) {
+        return HandleTickProfile(req);
+    }
+    if(req.target() == AdminEndpoints::trace) {
+        return HandleTrace(req);
+    }
+    if(req.target() == AdminEndpoints::metrics) {
+        return HandleMetrics(req);
+    }
+    return FormErrorJsonResponse(req, http::status::not_found, "notFound"sv, "Unknown admin endpoint"sv, "no-cache"sv);
+}
+
+StringResponse AdminHandler::HandleLogLevel(const StringRequest& req) {
+    if(req.method() == http::verb::get) {
+        return MakeJsonResponse(req, boost::json::object{{"level", LogLevelToString(GetLogLevel())}});
+    }
+    if(req.method() != http::verb::put && req.method() != http::verb::post) {
+        return FormErrorJsonResponse(req, http::status::method_not_allowed, "invalidMethod"sv, "Only GET and PUT methods are expected"sv, "no-cache"sv, "GET, PUT, POST"sv);
+    }
+    const auto body = ParseJsonObject(req);
+    const auto* level_value = body ? body->if_contains("level") : nullptr;
+    std::optional<LogLevel> level;
+    if(level_value && level_value->is_string()) {
+        const auto& level_str = level_value->as_string();
+        level = ParseLogLevel({level_str.data(), level_str.size()});
+    }
+    if(!level) {
+        return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "Expected {\"level\":\"debug|info|warning|error\"}"sv, "no-cache"sv);
+    }
+    const LogLevel previous = GetLogLevel();
+    SetLogLevel(*level);
+    // Смена уровня записывается всегда, иначе при уровне error её не будет видно
+    LogJson(boost::json::object{{"from", LogLevelToString(previous)}, {"to", LogLevelToString(*level)}},
+            "log level changed"sv, LogLevel::kError);
+    return MakeJsonResponse(req, boost::json::object{{"level", LogLevelToString(*level)}});
+}
+
+boost::json::object AdminHandler::GetLogSampling() const {
+    boost::json::object rates;
+    for(size_t i = 0; i < static_cast<size_t>(Route::kCount); ++i) {
+        const auto route = static_cast<Route>(i);
+        const std::string_view name = GetRouteName(route);
+        rates[{name.data(), name.size()}] = sampler_->GetSampleRate(route);
+    }
+    return boost::json::object{
+        {"slowThresholdMs", sampler_->GetSlowThreshold().count()},
+        {"rates", std::move(rates)}
+    };
+}
+
+StringResponse AdminHandler::HandleLogSampling(const StringRequest& req) {
+    if(req.method() == http::verb::get) {
+        return MakeJsonResponse(req, GetLogSampling());
+    }
+    if(req.method() != http::verb::put && req.method() != http::verb::post) {
+        return FormErrorJsonResponse(req, http::status::method_not_allowed, "invalidMethod"sv, "Only GET and PUT methods are expected"sv, "no-cache"sv, "GET, PUT, POST"sv);
+    }
+    const auto body = ParseJsonObject(req);
+    if(!body) {
+        return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "Request body must be a JSON object"sv, "no-cache"sv);
+    }
+    // Сначала проверяем всё, затем применяем, чтобы ошибка не оставляла настройки изменёнными наполовину
+    std::optional<int64_t> slow_threshold;
+    if(const auto* value = body->if_contains("slowThresholdMs")) {
+        if(!value->is_int64() || value->as_int64() < 0) {
+            return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "slowThresholdMs must be a non-negative integer"sv, "no-cache"sv);
+        }
+        slow_threshold = value->as_int64();
+    }
+    std::vector<RequestLogSampler::SampleRate> rates;
+    if(const auto* value = body->if_contains("rates")) {
+        if(!value->is_object()) {
+            return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "rates must be an object"sv, "no-cache"sv);
+        }
+        for(const auto& [name, rate] : value->as_object()) {
+            const auto route = FindRouteByName({name.data(), name.size()});
+            if(!route || !rate.is_int64() || rate.as_int64() < 0 || rate.as_int64() > UINT32_MAX) {
+                return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "rates must map route names to non-negative integers"sv, "no-cache"sv);
+            }
+            rates.emplace_back(*route, static_cast<uint32_t>(rate.as_int64()));
+        }
+    }
+    if(slow_threshold) {
+        sampler_->SetSlowThreshold(std::chrono::milliseconds(*slow_threshold));
+    }
+    for(const auto& [route, rate] : rates) {
+        sampler_->SetSampleRate(route, rate);
+    }
+    auto sampling = GetLogSampling();
+    LogJson(sampling, "log sampling changed"sv, LogLevel::kError);
+    return MakeJsonResponse(req, sampling);
+}
+
+StringResponse AdminHandler::HandleTickProfile(const StringRequest& req) {
+    if(req.method() == http::verb::get) {
+        return MakeJsonResponse(req, TickReportToJson(tick_profiler_.GetReport()));
+    }
+    if(req.method() != http::verb::put && req.method() != http::verb::post) {
+        return FormErrorJsonResponse(req, http::status::method_not_allowed, "invalidMethod"sv, "Only GET and PUT methods are expected"sv, "no-cache"sv, "GET, PUT, POST"sv);
+    }
+    const auto body = ParseJsonObject(req);
+    const auto* enabled = body ? body->if_contains("enabled") : nullptr;
+    const auto* reset = body ? body->if_contains("reset") : nullptr;
+    if(!body || (enabled && !enabled->is_bool()) || (reset && !reset->is_bool())) {
+        return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "Expected {\"enabled\":bool,\"reset\":bool}"sv, "no-cache"sv);
+    }
+    if(enabled && enabled->as_bool() && !model::is_tick_profiler_compiled) {
+        return FormErrorJsonResponse(req, http::status::conflict, "notCompiled"sv, "Server is built without GAME_TICK_PROFILER"sv, "no-cache"sv);
+    }
+    if(reset && reset->as_bool()) {
+        tick_profiler_.Reset();
+    }
+    if(enabled) {
+        tick_profiler_.SetEnabled(enabled->as_bool());
+    }
+    return MakeJsonResponse(req, TickReportToJson(tick_profiler_.GetReport()));
+}
+
+StringResponse AdminHandler::HandleTrace(const StringRequest& req) {
+    auto& recorder = tracing::SpanRecorder::Instance();
+    if(req.method() == http::verb::get) {
+        return MakeStringResponse(http::status::ok, recorder.DumpChromeTrace(), req.version(), req.keep_alive(),
+                                  ContentType::APPLICATION_JSON, "no-cache"sv);
+    }
+    if(req.method() != http::verb::put && req.method() != http::verb::post) {
+        return FormErrorJsonResponse(req, http::status::method_not_allowed, "invalidMethod"sv, "Only GET and PUT methods are expected"sv, "no-cache"sv, "GET, PUT, POST"sv);
+    }
+    const auto body = ParseJsonObject(req);
+    const auto* enabled = body ? body->if_contains("enabled") : nullptr;
+    const auto* clear = body ? body->if_contains("clear") : nullptr;
+    if(!body || (enabled && !enabled->is_bool()) || (clear && !clear->is_bool())) {
+        return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "Expected {\"enabled\":bool,\"clear\":bool}"sv, "no-cache"sv);
+    }
+    if(clear && clear->as_bool()) {
+        recorder.Clear();
+    }
+    if(enabled) {
+        recorder.SetEnabled(enabled->as_bool());
+    }
+    return MakeJsonResponse(req, boost::json::object{{"enabled", recorder.IsEnabled()}});
+}
+
+StringResponse AdminHandler::HandleMetrics(const StringRequest& req) {
+    if(req.method() != http::verb::get) {
+        return FormErrorJsonResponse(req, http::status::method_not_allowed, "invalidMethod"sv, "Only GET method is expected"sv, "no-cache"sv, "GET"sv);
+    }
+    return MakeStringResponse(http::status::ok, registry_->Render(), req.version(), req.keep_alive(),
+                              "text/plain; version=0.0.4"sv, "no-cache"sv);
+}
+
+}  // namespace http_handler
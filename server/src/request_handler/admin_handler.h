@@ -0,0 +1,64 @@
+#pragma once
+
+#include <boost/asio/ip/tcp.hpp>
+
+#include <memory>
+
+#include "request_utils.h"
+#include "request_log_sampler.h"
+#include "../metrics/registry.h"
+#include "../game/tick_profiler.h"
+
+namespace http_handler {
+
+struct AdminEndpoints {
+    AdminEndpoints() = delete;
+    constexpr static std::string_view log_level     = "/admin/log-level"sv;
+    constexpr static std::string_view log_sampling  = "/admin/log-sampling"sv;
+    constexpr static std::string_view tick_profile  = "/admin/tick-profile"sv;
+    constexpr static std::string_view trace         = "/admin/trace"sv;
+    constexpr static std::string_view metrics       = "/metrics"sv;
+};
+
+// Обработчик запросов административного порта. Порт слушается только на 127.0.0.1,
+// поэтому авторизации нет.
+//
+// GET /admin/log-level                 {"level":"info"}
+// PUT /admin/log-level                 {"level":"warning"}
+// GET /admin/log-sampling              {"slowThresholdMs":100,"rates":{"state":1000,...}}
+// PUT /admin/log-sampling              {"slowThresholdMs":50,"rates":{"state":100}} - любые из полей
+// GET /admin/tick-profile              время этапов такта: всего и по сессиям, мкс
+// PUT /admin/tick-profile              {"enabled":true,"reset":true} - любые из полей
+// GET /admin/trace                     записанные участки в формате Chrome Trace (для Perfetto)
+// PUT /admin/trace                     {"enabled":true,"clear":true} - любые из полей
+// GET /metrics                         метрики в текстовом формате Prometheus
+class AdminHandler {
+public:
+    AdminHandler(std::shared_ptr<RequestLogSampler> sampler, std::shared_ptr<const metrics::Registry> registry,
+                 model::TickProfiler& tick_profiler)
+        : sampler_(std::move(sampler))
+        , registry_(std::move(registry))
+        , tick_profiler_(tick_profiler) {
+    }
+
+    template <typename Body, typename Allocator, typename Send>
+    void operator()([[maybe_unused]] boost::asio::ip::tcp::endpoint endpoint, http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
+        send(HandleAdminRequest(std::move(req)));
+    }
+
+    StringResponse HandleAdminRequest(StringRequest&& req);
+
+private:
+    StringResponse HandleLogLevel(const StringRequest& req);
+    StringResponse HandleLogSampling(const StringRequest& req);
+    StringResponse HandleTickProfile(const StringRequest& req);
+    StringResponse HandleTrace(const StringRequest& req);
+    StringResponse HandleMetrics(const StringRequest& req);
+    boost::json::object GetLogSampling() const;
+
+    std::shared_ptr<RequestLogSampler> sampler_;
+    std::shared_ptr<const metrics::Registry> registry_;
+    model::TickProfiler& tick_profiler_;
+};
+
+}  // namespace http_handler
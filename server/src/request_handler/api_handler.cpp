@@ -1,9 +1,12 @@
 #include "api_handler.h"
+#include "state_long_poll.h"
 #include "../json_handler/json_loader.h"
+#include "../json_handler/state_json.h"
 #include "../application/players.h"
 #include "../logging/logger.h"
 #include "../game/game_items.h"
 #include "../database/domain.h"
+#include "../database/connection_pool.h"
 
 #include <utility>
 #include <chrono>
@@ -17,9 +20,18 @@ std::string GetAllMapsInJSON(const model::Game& game);
 std::optional<std::string> GetMapConfigurationJSON(const model::Game& game, const std::string& map_id);
 
 
-StringResponse ApiHandler::HandleApiRequest(StringRequest&& req) {
+thread_local ServerTiming* ApiHandler::timing_ = nullptr;
+
+StringResponse ApiHandler::HandleApiRequest(StringRequest&& req, ServerTiming* timing) {
+    timing_ = timing;
+    struct TimingReset {
+        ServerTiming*& timing;
+        ~TimingReset() {
+            timing = nullptr;
+        }
+    } timing_reset{timing_};
+    auto handler_timer = MeasureTime(ServerTiming::Metric::kHandler);
     StringResponse response;
-    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
     if(req.target().find(Endpoints::join_endpoint) != std::string_view::npos)
     {
         response = HandlePostJoinEndpoint(std::move(req));
@@ -56,11 +68,6 @@ StringResponse ApiHandler::HandleApiRequest(StringRequest&& req) {
     {
         response = FormErrorJsonResponse(req, http::status::bad_request, "badRequest"sv, "Bad request"sv, "no-cache"sv);
     }
-    std::string content_type = std::string{response[http::field::content_type]};
-    int response_code = response.result_int();
-    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
-    std::chrono::nanoseconds dur = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
-    LogResponse({content_type, response_code}, dur);
     return response;
 }
 
@@ -69,6 +76,7 @@ StringResponse ApiHandler::HandleGetMapsEndpoint(StringRequest&& req) {
     {
         return FormErrorJsonResponse(req, http::status::method_not_allowed, "invalidMethod"sv, "Only GET method is expected"sv, "no-cache"sv, "GET, HEAD"sv);
     }
+    auto serialize_timer = MeasureTime(ServerTiming::Metric::kSerialize);
     std::string map_id = std::string{req.target().substr(Endpoints::maps_endpoint.size())};
     if(map_id.size() == 0 || (map_id.size() == 1 && map_id.back() == '/'))
     {
@@ -119,6 +127,7 @@ StringResponse ApiHandler::HandlePostJoinEndpoint(StringRequest&& req) {
         return FormErrorJsonResponse(req, http::status::not_found, "mapNotFound"sv, "Map not found"sv, "no-cache"sv);
     }
     auto [token, player_id] = application_.JoinGame(model::Map::Id{json_body.as_object()["mapId"].as_string().c_str()}, json_body.as_object()["userName"].as_string().c_str());
+    auto serialize_timer = MeasureTime(ServerTiming::Metric::kSerialize);
     boost::json::object answer_obj {
         {"authToken", *token},
         {"playerId", player_id}
@@ -156,6 +165,7 @@ std::optional<std::string> ParseAuthorization(const StringRequest& req) {
 
 std::optional<StringResponse> ApiHandler::CheckAuthorizationAndFormErrorResponse(const StringRequest& req, std::optional<std::string> token)
 {
+    auto auth_timer = MeasureTime(ServerTiming::Metric::kAuth);
     if(!token.has_value() || (token.has_value() && token.value().size() != 32))
     {
         return FormErrorJsonResponse(req, http::status::unauthorized, "invalidToken"sv, "Authorization header is missing"sv, "no-cache"sv);
@@ -191,6 +201,7 @@ StringResponse ApiHandler::HandleGetPlayersInSession(StringRequest&& req) {
         return resp.value();
     }
     auto players_deque = application_.GetAllPlayersInSessionWithCurrentPlayer(app::Token(token.value()));
+    auto serialize_timer = MeasureTime(ServerTiming::Metric::kSerialize);
     boost::json::object players_json;
     for(auto player : players_deque)
     {
@@ -213,51 +224,18 @@ StringResponse ApiHandler::HandleGetState(StringRequest&& req) {
         return resp.value();
     }
     auto players_deque = application_.GetAllPlayersInSessionWithCurrentPlayer(app::Token(token.value()));
-    boost::json::object players_json;
-    for (auto player : players_deque)
-    {
-        auto pos = player->GetDog()->GetDogCoordinates();
-        auto speed = player->GetDog()->GetDogSpeed();
-        auto dir = player->GetDog()->GetDogDirectionString();
-        boost::json::array loots_json_bag;
-        auto loots = player->GetSession()->GetAllLoots();
-        for(auto id : player->GetDog()->GetDogsBag().GetAllIds())
-        {
-            boost::json::object loot{
-                {"id", id},
-                {"type", loots.at(id)->GetType()}
-            };
-            loots_json_bag.push_back(loot);
-        }
-
-        players_json[std::to_string(player->GetDog()->GetId())] = boost::json::object{
-            {"pos", { pos.x_, pos.y_}},
-            {"speed", { speed.dx_, speed.dy_}},
-            {"dir", dir},
-            {"bag", loots_json_bag},
-            {"score", player->GetDog()->GetScore()}
-        };
-    }
-    auto session = application_.GetGameSessionByPlayer(app::Token(token.value()));
-    auto loots = session->GetLoots();
-    boost::json::object loots_json;
-    for(int i = 0; i < loots.size(); ++i)
+    std::vector<const model::Dog*> dogs;
+    dogs.reserve(players_deque.size());
+    for(const auto& player : players_deque)
     {
-        if(!session->IsBusyLoot(i))
-        {
-            const auto& loot = loots.at(i);
-            boost::json::object loot_json;
-            loot_json[json_loader::literals::loot_type_type] = loot->GetType();
-            boost::json::array pos = {static_cast<double>(loot->GetPosition().x), static_cast<double>(loot->GetPosition().y)};
-            loot_json[json_loader::literals::loot_pos] = pos;
-            loots_json[std::to_string(i)] = loot_json;
-        }
+        dogs.push_back(player->GetDog().get());
     }
-    boost::json::object result_json{
-        {"players",     players_json},
-        {"lostObjects", loots_json}
-    };
-    return MakeStringResponse(http::status::ok, boost::json::serialize(result_json), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, "no-cache"sv);
+    auto session = application_.GetGameSessionByPlayer(app::Token(token.value()));
+    auto serialize_timer = MeasureTime(ServerTiming::Metric::kSerialize);
+    auto response = MakeStringResponse(http::status::ok, json_loader::SerializeState(dogs, session->GetLootsInSession()), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, "no-cache"sv);
+    // Номер такта клиент передаёт в sinceTick, чтобы дождаться следующего (см. StateLongPoll)
+    response.set(StateLongPoll::tick_header, std::to_string(application_.GetTickNumber()));
+    return response;
 }
 
 bool IsDirectionCorrect(const std::string& direction)
@@ -286,8 +264,7 @@ StringResponse ApiHandler::HandleAction(StringRequest&& req) {
     {
         return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "Failed to parse action"sv, "no-cache"sv);    
     }
-    auto player = application_.FindPlayerByToken(app::Token(token.value()));
-    player->MoveAction(json_body.as_object().at("move").as_string().c_str(), player->GetSession()->GetMap()->GetDogSpeed());
+    application_.MoveAction(app::Token(token.value()), json_body.as_object().at("move").as_string().c_str());
 
     return MakeStringResponse(http::status::ok, "{}", req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, "no-cache"sv);
 
@@ -369,8 +346,18 @@ StringResponse ApiHandler::HandleGetRecords(StringRequest&& req)
     {
         return FormErrorJsonResponse(req, http::status::bad_request, "invalidArgument"sv, "Limit can't be more than 100"sv, "no-cache"sv);   
     }
-    std::vector<database::domain::Player> players_stat = application_.GetPlayersStats(offset, (limit == 0) ? application_.max_limit_records : limit);
-    
+    std::vector<database::domain::Player> players_stat;
+    try {
+        auto db_timer = MeasureTime(ServerTiming::Metric::kDb);
+        players_stat = application_.GetPlayersStats(offset, (limit == 0) ? application_.max_limit_records : limit);
+    } catch (const database::ConnectionPool::AcquireTimeoutError&) {
+        // Все соединения заняты дольше acquire_timeout - перегрузка, а не ошибка сервера
+        auto response = FormErrorJsonResponse(req, http::status::service_unavailable, "overloaded"sv, "Database is busy, retry later"sv, "no-cache"sv);
+        response.set(http::field::retry_after, "1"sv);
+        return response;
+    }
+
+    auto serialize_timer = MeasureTime(ServerTiming::Metric::kSerialize);
     boost::json::array stat_json;
     for(const auto& player : players_stat){
         boost::json::object json_obj;
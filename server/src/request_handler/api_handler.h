@@ -1,13 +1,19 @@
 #pragma once
 #include <boost/json.hpp>
 
+#include <optional>
 #include <string>
 
 #include "request_utils.h"
+#include "server_timing.h"
 #include "../game/game.h"
 #include "../application/application.h"
 
 namespace http_handler{
+
+// Токен из заголовка "Authorization: Bearer <token>"
+std::optional<std::string> ParseAuthorization(const StringRequest& req);
+
 class ApiHandler{
 public:
     explicit ApiHandler(model::Game& game, app::Application& application) : game_{game}, application_(application) {};
@@ -26,10 +32,19 @@ public:
         }
         return false;
     }
-    StringResponse HandleApiRequest(StringRequest&& request);
+    // timing (если задан) получает разбивку времени обработки для заголовка Server-Timing
+    StringResponse HandleApiRequest(StringRequest&& request, ServerTiming* timing = nullptr);
 private:
     model::Game& game_;
     app::Application& application_;
+    // Действует только во время HandleApiRequest в этом потоке: records обрабатываются
+    // пулом БД одновременно с остальными запросами на strand
+    static thread_local ServerTiming* timing_;
+
+    ServerTiming::Scope MeasureTime(ServerTiming::Metric metric) noexcept {
+        return {timing_, metric};
+    }
+
     StringResponse HandleGetMapsEndpoint(StringRequest&& request);
     StringResponse HandlePostJoinEndpoint(StringRequest&& request);
     StringResponse HandleGetPlayersInSession(StringRequest&& request);
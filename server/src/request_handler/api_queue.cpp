@@ -0,0 +1,60 @@
+#include "api_queue.h"
+
+namespace http_handler {
+
+namespace {
+
+std::string_view GetLaneName(ApiQueue::Lane lane) noexcept {
+    return lane == ApiQueue::Lane::kDatabase ? "db"sv : "strand"sv;
+}
+
+}  // namespace
+
+bool ApiQueue::TryAdmit(Route route) noexcept {
+    if(!IsLowPriority(route) || GetLane(route) != Lane::kStrand) {
+        return true;
+    }
+    const LaneStats& strand = lanes_[static_cast<size_t>(Lane::kStrand)];
+    const size_t depth = strand.depth.load(std::memory_order_relaxed);
+    const bool is_too_deep = config_.max_depth != 0 && depth >= config_.max_depth;
+    // Ожидание учитывается, только пока очередь не пуста: иначе после перегрузки
+    // оценка осталась бы большой до следующего запущенного обработчика
+    const bool is_too_slow = config_.max_wait.count() != 0 && depth != 0
+        && strand.last_wait_us.load(std::memory_order_relaxed) >= std::chrono::duration_cast<std::chrono::microseconds>(config_.max_wait).count();
+    if(is_too_deep || is_too_slow) {
+        rejected_[static_cast<size_t>(route)].Add();
+        return false;
+    }
+    return true;
+}
+
+void ApiQueue::OnStart(LaneStats& stats, std::chrono::steady_clock::time_point enqueued_at) noexcept {
+    stats.depth.fetch_sub(1, std::memory_order_relaxed);
+    const int64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - enqueued_at).count();
+    stats.last_wait_us.store(wait_us, std::memory_order_relaxed);
+    stats.wait_us.Record(static_cast<uint64_t>(wait_us));
+}
+
+void ApiQueue::Collect(metrics::PrometheusWriter& writer) const {
+    using Type = metrics::PrometheusWriter::Type;
+    writer.WriteHeader("api_queue_depth"sv, Type::kGauge, "API handlers waiting for their executor"sv);
+    for(size_t lane = 0; lane < lanes_.size(); ++lane) {
+        writer.WriteSample("api_queue_depth"sv, {{"executor"sv, GetLaneName(static_cast<Lane>(lane))}},
+                           static_cast<uint64_t>(GetDepth(static_cast<Lane>(lane))));
+    }
+    writer.WriteHeader("api_queue_wait_seconds"sv, Type::kHistogram, "Time from enqueue to start of an API handler"sv);
+    for(size_t lane = 0; lane < lanes_.size(); ++lane) {
+        writer.WriteHistogram("api_queue_wait_seconds"sv, {{"executor"sv, GetLaneName(static_cast<Lane>(lane))}},
+                              lanes_[lane].wait_us.GetSnapshot(), 1e-6, metrics::kDurationBounds);
+    }
+    writer.WriteHeader("api_requests_rejected_total"sv, Type::kCounter, "API requests rejected with 503 because of strand overload"sv);
+    for(size_t route = 0; route < rejected_.size(); ++route) {
+        if(IsLowPriority(static_cast<Route>(route))) {
+            writer.WriteSample("api_requests_rejected_total"sv, {{"route"sv, GetRouteName(static_cast<Route>(route))}},
+                               rejected_[route].Get());
+        }
+    }
+}
+
+}  // namespace http_handler
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <boost/asio/dispatch.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "../metrics/histogram.h"
+#include "../metrics/registry.h"
+#include "../metrics/sharded.h"
+#include "request_utils.h"
+
+namespace http_handler {
+
+// Учёт обработчиков API, ожидающих своего исполнителя (strand игры или пула БД):
+// глубина очереди и время от постановки до запуска, отдельно для каждого исполнителя.
+// При перегрузке strand отказывает запросам с низким приоритетом (players), действия
+// игроков и такты принимаются всегда
+class ApiQueue {
+public:
+    enum class Lane {
+        kStrand,    // api_strand
+        kDatabase,  // пул БД (records)
+        kCount
+    };
+
+    struct Config {
+        size_t max_depth = 0;                       // 0 - без ограничения
+        std::chrono::milliseconds max_wait{0};      // 0 - без ограничения
+        std::chrono::seconds retry_after{1};
+    };
+
+    explicit ApiQueue(Config config) noexcept
+        : config_(config) {
+    }
+
+    // records читает только базу и strand не занимает
+    static Lane GetLane(Route route) noexcept {
+        return route == Route::kRecords ? Lane::kDatabase : Lane::kStrand;
+    }
+
+    static bool IsLowPriority(Route route) noexcept {
+        return route == Route::kPlayers;
+    }
+
+    // false - запрос нужно отклонить с 503. Ограничения относятся только к очереди strand;
+    // время ожидания оценивается по последнему запущенному на нём обработчику
+    bool TryAdmit(Route route) noexcept;
+
+    // Выполняет handler через executor очереди lane, учитывая его в глубине этой очереди
+    template <typename Executor, typename Handler>
+    void Dispatch(Lane lane, const Executor& executor, Handler&& handler) {
+        LaneStats& stats = lanes_[static_cast<size_t>(lane)];
+        stats.depth.fetch_add(1, std::memory_order_relaxed);
+        // ApiQueue живёт дольше обработчиков: им владеет RequestHandler, удерживаемый самим handler
+        boost::asio::dispatch(executor, [&stats, enqueued_at = std::chrono::steady_clock::now(),
+                                       handler = std::forward<Handler>(handler)]() mutable {
+            OnStart(stats, enqueued_at);
+            handler();
+        });
+    }
+
+    std::chrono::seconds GetRetryAfter() const noexcept {
+        return config_.retry_after;
+    }
+
+    size_t GetDepth(Lane lane) const noexcept {
+        return lanes_[static_cast<size_t>(lane)].depth.load(std::memory_order_relaxed);
+    }
+
+    void Collect(metrics::PrometheusWriter& writer) const;
+
+private:
+    struct LaneStats {
+        std::atomic<size_t> depth{0};
+        std::atomic<int64_t> last_wait_us{0};
+        // В пуле БД пишется из нескольких потоков, запись в гистограмму атомарна
+        metrics::Histogram wait_us;
+    };
+
+    static void OnStart(LaneStats& stats, std::chrono::steady_clock::time_point enqueued_at) noexcept;
+
+    const Config config_;
+    std::array<LaneStats, static_cast<size_t>(Lane::kCount)> lanes_;
+    std::array<metrics::ShardedCounter, static_cast<size_t>(Route::kCount)> rejected_;
+};
+
+}  // namespace http_handler
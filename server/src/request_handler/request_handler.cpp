@@ -1,61 +1,117 @@
 #include "request_handler.h"
 #include "../json_handler/json_loader.h"
+#include "../utils/url_path.h"
 
+#include <sys/stat.h>
+
+#include <charconv>
 #include <deque>
 
 namespace http_handler {
 
-Response RequestHandler::PrepareStaticFileResponse(StringRequest&& req)
-{
-    namespace sys = boost::system;
-    utils::URLDecoder decoded_URL(req.target());
-    std::string full_target_path_str(static_file_path_);
-    full_target_path_str += decoded_URL.GetDecodedURLAsString();
-    std::filesystem::path full_target_path(full_target_path_str);
-    if(!utils::IsSubPath(full_target_path, static_file_path_))
-    {
-        return FormErrorJsonResponse(req, http::status::bad_request, "badRequest"sv, "Bad request"sv);
-    }    
-    http::response<http::file_body> response;
-    response.version(req.version());
-    response.result(http::status::ok);
+namespace {
 
-    if(std::filesystem::is_directory(full_target_path) || decoded_URL.GetDecodedURLAsStringView() == "/"sv || decoded_URL.GetDecodedURLAsStringView() == "/index.html")
-    {
-        response.insert(http::field::content_type, ContentType::TEXT_HTML);
-        http::file_body::value_type file;
-        full_target_path_str = static_file_path_;
-        full_target_path_str += "/index.html";
-        if (sys::error_code ec; file.open(full_target_path_str.data(), beast::file_mode::read, ec), ec) {
-        return MakeStringResponse(http::status::not_found, "file not found"s, req.version(), req.keep_alive(), ContentType::TEXT_PLAIN);
-        }
-        else
-        {
-            response.body() = std::move(file);
+namespace sys = boost::system;
+
+struct ByteRange {
+    bool is_satisfiable = true;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+std::optional<uint64_t> ParseUnsigned(std::string_view str) {
+    uint64_t value = 0;
+    const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if(ec != std::errc{} || end != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Range: bytes=first-last | bytes=first- | bytes=-suffix_length.
+// nullopt - заголовок не разобран или в нём несколько диапазонов: тогда файл отдаётся
+// целиком, как разрешает RFC 7233
+std::optional<ByteRange> ParseRange(std::string_view header, uint64_t file_size) {
+    constexpr std::string_view unit = "bytes="sv;
+    if(!header.starts_with(unit) || header.find(',') != std::string_view::npos) {
+        return std::nullopt;
+    }
+    const std::string_view spec = header.substr(unit.size());
+    const size_t dash = spec.find('-');
+    if(dash == std::string_view::npos) {
+        return std::nullopt;
+    }
+    if(dash == 0) {
+        const auto suffix_length = ParseUnsigned(spec.substr(1));
+        if(!suffix_length) {
+            return std::nullopt;
         }
-        response.prepare_payload();
-        return response;
-    }
-    else
-    {
-        if(utils::ContentTypeByFileExtension(full_target_path.extension().string()).has_value())
-        {
-            response.insert(http::field::content_type, utils::ContentTypeByFileExtension(full_target_path.extension().string()).value());
+        if(*suffix_length == 0 || file_size == 0) {
+            return ByteRange{.is_satisfiable = false};
         }
-        else
-        {
-            response.insert(http::field::content_type, ContentType::UNKNOWN);
+        const uint64_t size = std::min(*suffix_length, file_size);
+        return ByteRange{.offset = file_size - size, .size = size};
+    }
+    const auto first = ParseUnsigned(spec.substr(0, dash));
+    if(!first) {
+        return std::nullopt;
+    }
+    uint64_t last = file_size == 0 ? 0 : file_size - 1;
+    if(dash + 1 != spec.size()) {
+        const auto parsed_last = ParseUnsigned(spec.substr(dash + 1));
+        if(!parsed_last || *parsed_last < *first) {
+            return std::nullopt;
         }
+        last = std::min(last, *parsed_last);
+    }
+    if(*first >= file_size) {
+        return ByteRange{.is_satisfiable = false};
     }
+    return ByteRange{.offset = *first, .size = last - *first + 1};
+}
+
+std::string GetLastModified(const FileResponse::body_type::value_type& file) {
+    struct stat st{};
+    if(fstat(file.GetNativeHandle(), &st) != 0) {
+        return {};
+    }
+    return utils::FormatHttpDate(std::chrono::system_clock::from_time_t(st.st_mtim.tv_sec));
+}
 
-    http::file_body::value_type file;
-    
-    if (sys::error_code ec; file.open(full_target_path_str.data(), beast::file_mode::read, ec), ec) {
+// Открывает файл и, если запрошен диапазон, ограничивает ответ им (206).
+// Файлы, не попавшие в кэш, отправляются через sendfile
+Response MakeFileResponse(const StringRequest& req, const std::string& path, std::string_view content_type) {
+    FileResponse response;
+    response.version(req.version());
+    response.result(http::status::ok);
+    response.set(http::field::content_type, content_type);
+
+    auto& file = response.body();
+    if (sys::error_code ec; file.Open(path.data(), ec), ec) {
         return MakeStringResponse(http::status::not_found, "file not found"s, req.version(), req.keep_alive(), ContentType::TEXT_PLAIN);
     }
-    else
-    {
-        response.body() = std::move(file);
+    const std::string last_modified = GetLastModified(file);
+    if(!last_modified.empty()) {
+        response.set(http::field::last_modified, last_modified);
+    }
+    response.set(http::field::accept_ranges, "bytes"sv);
+
+    const auto range_header = req.find(http::field::range);
+    const auto if_range = req.find(http::field::if_range);
+    // If-Range с другой датой - файл изменился, частичный ответ клиенту не подходит
+    const bool is_range_valid = if_range == req.end() || (!last_modified.empty() && if_range->value() == last_modified);
+    if(range_header != req.end() && is_range_valid && req.method() == http::verb::get) {
+        if(const auto range = ParseRange(range_header->value(), file.GetFileSize())) {
+            if(!range->is_satisfiable) {
+                auto error = MakeStringResponse(http::status::range_not_satisfiable, ""sv, req.version(), req.keep_alive(), ContentType::TEXT_PLAIN);
+                error.set(http::field::content_range, "bytes */"s + std::to_string(file.GetFileSize()));
+                return error;
+            }
+            file.SetRange(range->offset, range->size);
+            response.result(http::status::partial_content);
+            response.set(http::field::content_range, "bytes "s + std::to_string(range->offset) + "-"s
+                         + std::to_string(range->offset + range->size - 1) + "/"s + std::to_string(file.GetFileSize()));
+        }
     }
 
     // Метод prepare_payload заполняет заголовки Content-Length и Transfer-Encoding
@@ -64,19 +120,63 @@ Response RequestHandler::PrepareStaticFileResponse(StringRequest&& req)
     return response;
 }
 
+}  // namespace
+
+std::shared_ptr<const RequestHandler::ResolvedStaticPath> RequestHandler::ResolveStaticPath(std::string_view target) const
+{
+    // Поколение читается до поиска в кэше: если кэш перезагрузится между ними,
+    // результат будет считаться устаревшим и при следующем запросе разберётся заново
+    const uint64_t generation = static_cache_ ? static_cache_->GetGeneration() : 0;
+    if(auto resolved = resolved_paths_->Get(target); resolved && (*resolved)->generation == generation) {
+        return std::move(*resolved);
+    }
+
+    utils::URLPathBuffer buffer;
+    const auto path = utils::NormalizeURLPath(target, buffer);
+    if(!path) {
+        return nullptr;
+    }
+    auto resolved = std::make_shared<ResolvedStaticPath>();
+    resolved->generation = generation;
+    if(static_cache_) {
+        resolved->cached = static_cache_->Find(*path);
+    }
+    if(!resolved->cached) {
+        resolved->file_path.reserve(static_file_path_.size() + path->size());
+        resolved->file_path = static_file_path_;
+        resolved->file_path += *path;
+        // Путь уже нормализован лексически, проверка нужна для символических ссылок за пределы www-root
+        std::filesystem::path full_target_path(resolved->file_path);
+        if(!utils::IsSubPath(full_target_path, static_file_path_)) {
+            return nullptr;
+        }
+        if(*path == "/"sv || *path == "/index.html"sv || std::filesystem::is_directory(full_target_path)) {
+            resolved->file_path = static_file_path_;
+            resolved->file_path += "/index.html";
+            resolved->content_type = ContentType::TEXT_HTML;
+        } else {
+            resolved->content_type = utils::ContentTypeByFileExtension(full_target_path.extension().string()).value_or(ContentType::UNKNOWN);
+        }
+    }
+    resolved_paths_->Put(std::string(target), resolved);
+    return resolved;
+}
+
+Response RequestHandler::PrepareStaticFileResponse(StringRequest&& req)
+{
+    const auto resolved = ResolveStaticPath(req.target());
+    if(!resolved) {
+        return FormErrorJsonResponse(req, http::status::bad_request, "badRequest"sv, "Bad request"sv);
+    }
+    if(resolved->cached) {
+        return StaticCache::MakeResponse(req, *resolved->cached);
+    }
+    return MakeFileResponse(req, resolved->file_path, resolved->content_type);
+}
+
 Response RequestHandler::HandleStaticFileRequest(StringRequest&& req) {
-    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
-    Response response = PrepareStaticFileResponse(std::move(req));
-    std::string content_type;
-    int response_code;
-    std::visit([&content_type, &response_code](auto& response){
-        content_type = response[http::field::content_type];
-        response_code = response.result_int(); 
-    }, response);
-    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
-    std::chrono::nanoseconds dur = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
-    LogResponse({content_type, response_code}, dur);
-    return response;
+    // Время ответа и его запись в журнал - в RequestHandlerWithLogger
+    return PrepareStaticFileResponse(std::move(req));
 }
 
 }  // namespace http_handler
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <boost/json.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/static_string.hpp>
 
 #include <optional>
 #include <any>
@@ -11,48 +12,109 @@
 #include "../game/game.h"
 #include "request_utils.h"
 #include "api_handler.h"
+#include "request_log_sampler.h"
+#include "request_metrics.h"
+#include "api_queue.h"
+#include "static_cache.h"
+#include "state_long_poll.h"
+#include "../tracing/span_recorder.h"
+#include "../utils/lru_cache.h"
 
 
 namespace http_handler {
 
+// Логирует запросы и ответы (с выборкой RequestLogSampler) и учитывает их в RequestMetrics
 template<class SomeRequestHandler>
 class RequestHandlerWithLogger
 {
 public:
-    explicit RequestHandlerWithLogger(std::shared_ptr<SomeRequestHandler> handler)
-        : decorated_handler{handler} {
-    }
-
-    static void LogRequest(const http_handler::StringRequest& request, boost::asio::ip::tcp::endpoint endpoint)
-    {
-        boost::json::value data = {
-            {"ip", endpoint.address().to_string()},
-            {"URI", request.target()},
-            {"method", request.method_string()}
-        };
-        LogJson(data, "request received"sv);
+    explicit RequestHandlerWithLogger(std::shared_ptr<SomeRequestHandler> handler, std::shared_ptr<RequestLogSampler> sampler,
+                                      std::shared_ptr<RequestMetrics> metrics)
+        : decorated_handler{handler}
+        , sampler_{std::move(sampler)}
+        , metrics_{std::move(metrics)} {
     }
 
     template <typename Body, typename Allocator, typename Send>
     void operator () (boost::asio::ip::tcp::endpoint endpoint, http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
-        std::string content_type = "";
-        int return_code = 0;
-        LogRequest(req, endpoint);
-        (*decorated_handler)(endpoint, std::move(req), std::move(send));
+        const Route route = GetRoute(req.target());
+        const bool is_sampled = sampler_->SampleRequest(route);
+        if(is_sampled) {
+            LogRequestReceived(endpoint.address(), req.target(), req.method_string());
+        }
+        // Запрос вне выборки запоминается, чтобы записать его вместе с ошибкой или медленным ответом
+        LoggedRequest request{
+            .address = endpoint.address(),
+            .target = is_sampled ? LoggedTarget{} : Truncate<LoggedTarget>(req.target()),
+            .method = is_sampled ? LoggedMethod{} : Truncate<LoggedMethod>(req.method_string()),
+            .received_at = std::chrono::system_clock::now(),
+            .start_time = std::chrono::steady_clock::now(),
+            .route = route,
+            .is_sampled = is_sampled
+        };
+        auto logged_send = [sampler = sampler_, metrics = metrics_, request = std::move(request), send = std::forward<Send>(send)](auto&& response) {
+            const auto dur = std::chrono::steady_clock::now() - request.start_time;
+            const int code = response.result_int();
+            metrics->Record(request.route, code, response.payload_size().value_or(0), dur);
+            if(sampler->GetResponseLogLevel(request.is_sampled, code, dur)) {
+                if(!request.is_sampled) {
+                    LogRequestReceived(request.address, {request.target.data(), request.target.size()},
+                                       {request.method.data(), request.method.size()}, request.received_at);
+                }
+                LogResponse(response[http::field::content_type], code, dur);
+            }
+            send(std::forward<decltype(response)>(response));
+        };
+        (*decorated_handler)(endpoint, std::move(req), std::move(logged_send));
     }
 
 private:
+    // Хранятся без выделения памяти; URI длиннее обрезается, как и в асинхронном журнале
+    using LoggedTarget = boost::static_string<256>;
+    using LoggedMethod = boost::static_string<16>;
+
+    template <typename StaticString>
+    static StaticString Truncate(std::string_view str) {
+        StaticString result;
+        result.assign(str.data(), std::min(str.size(), StaticString::static_capacity));
+        return result;
+    }
+
+    struct LoggedRequest {
+        boost::asio::ip::address address;
+        LoggedTarget target;
+        LoggedMethod method;
+        std::chrono::system_clock::time_point received_at;
+        std::chrono::steady_clock::time_point start_time;
+        Route route;
+        bool is_sampled;
+    };
+
     std::shared_ptr<SomeRequestHandler> decorated_handler;
+    std::shared_ptr<RequestLogSampler> sampler_;
+    std::shared_ptr<RequestMetrics> metrics_;
 };
 
 class RequestHandler : public std::enable_shared_from_this<RequestHandler>{
 public:
     using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
-    explicit RequestHandler(model::Game& game, app::Application& application, Strand& api_strand)
+    using Executor = boost::asio::io_context::executor_type;
+    // static_cache может быть nullptr: тогда статические файлы всегда читаются с диска.
+    // db_executor выполняет запросы records: они не трогают состояние игры и не должны
+    // занимать strand на время обращения к БД. state_long_poll равен nullptr - запросы
+    // состояния с sinceTick обслуживаются сразу, как обычные
+    explicit RequestHandler(model::Game& game, app::Application& application, Strand& api_strand, Executor db_executor,
+                            std::shared_ptr<ApiQueue> api_queue, std::shared_ptr<const StaticCache> static_cache,
+                            std::shared_ptr<StateLongPoll> state_long_poll = nullptr)
         : game_{game} 
         , api_handler_(game, application)
+        , static_file_path_(game_.GetPathToStaticFiles())
         , api_strand_(api_strand)
-        , static_file_path_(game_.GetPathToStaticFiles()) {
+        , db_executor_(db_executor)
+        , api_queue_(std::move(api_queue))
+        , state_long_poll_(std::move(state_long_poll))
+        , static_cache_(std::move(static_cache))
+        , resolved_paths_(std::make_unique<ResolvedPathCache>(resolved_paths_capacity)) {
     }
 
     RequestHandler(const RequestHandler&) = delete;
@@ -64,22 +126,62 @@ public:
     template <typename Body, typename Allocator, typename Send>
     void operator()(boost::asio::ip::tcp::endpoint endpoint, http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
         if (api_handler_.IsApiRequest(req)) {
-            auto handle = [self = shared_from_this(), send,
-                            req = std::forward<decltype(req)>(req)] {
+            const Route route = GetRoute(req.target());
+            if(!api_queue_->TryAdmit(route)) {
+                auto response = FormErrorJsonResponse(req, http::status::service_unavailable, "overloaded"sv, "Server is overloaded, retry later"sv, "no-cache"sv);
+                response.set(http::field::retry_after, std::to_string(api_queue_->GetRetryAfter().count()));
+                return send(std::move(response));
+            }
+            // Время в очереди strand: от передачи запроса до начала обработки
+            const uint64_t queued_ns = tracing::IsEnabled() ? tracing::SpanRecorder::NowNs() : 0;
+            std::optional<std::chrono::steady_clock::time_point> timed_since;
+            if(is_server_timing_enabled_ || req.find(ServerTiming::request_header) != req.end()) {
+                timed_since = std::chrono::steady_clock::now();
+            }
+            // Запрос перемещается в обработчик, а ответ об ошибке формируется уже без него
+            const unsigned version = req.version();
+            const bool keep_alive = req.keep_alive();
+            auto handle = [self = shared_from_this(), send = std::forward<Send>(send),
+                            req = std::forward<decltype(req)>(req), route, queued_ns, timed_since, version, keep_alive]() mutable {
+                if(queued_ns != 0) {
+                    tracing::SpanRecorder::Instance().RecordAsync("api", "strand_wait", queued_ns, tracing::SpanRecorder::NowNs());
+                }
+                tracing::ScopedSpan span("api", "handle_request", GetRouteName(route).data());
+                std::optional<ServerTiming> timing;
+                if(timed_since) {
+                    timing.emplace();
+                    timing->Add(ServerTiming::Metric::kQueue, std::chrono::steady_clock::now() - *timed_since);
+                }
                 try {
                     // Этот assert не выстрелит, так как лямбда-функция будет выполняться внутри strand
-                    assert(self->api_strand_.running_in_this_thread());
-                    http::request<Body, http::basic_fields<Allocator>>& req_to_move = const_cast<http::request<Body, http::basic_fields<Allocator>>&>(req);
-                    auto response = self->api_handler_.HandleApiRequest(std::move(req_to_move));
+                    assert(route == Route::kRecords || self->api_strand_.running_in_this_thread());
+                    StringResponse response;
+                    {
+                        // Запрос размещён в арене соединения и должен быть разрушен до отправки ответа:
+                        // после записи ответа сессия в своём потоке начинает использовать арену заново
+                        auto request = std::move(req);
+                        // Отложенный запрос освобождает strand до следующего такта
+                        if(route == Route::kState && self->state_long_poll_ && self->state_long_poll_->TryPark(request, send)) {
+                            return;
+                        }
+                        response = self->api_handler_.HandleApiRequest(std::move(request), timing ? &*timing : nullptr);
+                    }
+                    if(timing) {
+                        response.set(ServerTiming::response_header, timing->ToHeaderValue());
+                    }
                     return send(std::move(response));
                 } catch (std::exception& ex) {
-                    auto response = FormErrorJsonResponse(req, http::status::internal_server_error, /*"internalError"sv*/ ex.what(), "internalServerError"sv);
+                    auto response = FormErrorJsonResponse(version, keep_alive, http::status::internal_server_error, /*"internalError"sv*/ ex.what(), "internalServerError"sv);
                     return send(std::move(response));
                 }
             };
-            return boost::asio::dispatch(api_strand_, handle);
+            if(ApiQueue::GetLane(route) == ApiQueue::Lane::kDatabase) {
+                return api_queue_->Dispatch(ApiQueue::Lane::kDatabase, db_executor_, std::move(handle));
+            }
+            return api_queue_->Dispatch(ApiQueue::Lane::kStrand, api_strand_, std::move(handle));
         }
         // Возвращаем результат обработки запроса к файлу
+        tracing::ScopedSpan span("static", "handle_static");
         auto file_response = HandleStaticFileRequest(std::move(req));
 
         return std::visit([&send](auto&& resp) {
@@ -87,14 +189,39 @@ public:
                 }, std::move(file_response));
     }
 
+    // Заголовок Server-Timing во всех ответах API, а не только на запросы с X-Debug-Timing
+    void SetServerTimingEnabled(bool is_enabled) noexcept {
+        is_server_timing_enabled_ = is_enabled;
+    }
+
 private:
+    // Результат разбора target запроса к статическому файлу. Кэшируется по исходной
+    // строке target, чтобы повторные запросы не декодировали путь и не обращались
+    // к файловой системе для канонизации
+    struct ResolvedStaticPath {
+        uint64_t generation = 0;                        // StaticCache::GetGeneration() при разборе
+        std::shared_ptr<const StaticCache::Entry> cached;   // nullptr - файл читается с диска
+        std::string file_path;
+        std::string_view content_type;
+    };
+    using ResolvedPathCache = utils::LruCache<std::shared_ptr<const ResolvedStaticPath>>;
+    static constexpr size_t resolved_paths_capacity = 4096;
+
     Response HandleStaticFileRequest(StringRequest&& req);
     Response PrepareStaticFileResponse(StringRequest&& req);
+    // nullptr - путь некорректен или выходит за пределы www-root
+    std::shared_ptr<const ResolvedStaticPath> ResolveStaticPath(std::string_view target) const;
 
     model::Game& game_;
     ApiHandler api_handler_;
     std::string static_file_path_;
     Strand& api_strand_;
+    Executor db_executor_;
+    std::shared_ptr<ApiQueue> api_queue_;
+    std::shared_ptr<StateLongPoll> state_long_poll_;
+    std::shared_ptr<const StaticCache> static_cache_;
+    std::unique_ptr<ResolvedPathCache> resolved_paths_;
+    bool is_server_timing_enabled_ = false;
 };
 
 std::string GetAllMapsInJSON(const model::Game& game);
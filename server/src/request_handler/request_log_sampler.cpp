@@ -0,0 +1,87 @@
+#include "request_log_sampler.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+namespace http_handler {
+
+RequestLogSampler::RequestLogSampler(const Config& config)
+    : slow_threshold_ms_(config.slow_threshold.count()) {
+    for(auto& rate : sample_rates_) {
+        rate.store(1, std::memory_order_relaxed);
+    }
+    for(const auto& [route, rate] : config.sample_rates) {
+        SetSampleRate(route, rate);
+    }
+}
+
+RequestLogSampler::SampleRate RequestLogSampler::ParseSampleRate(std::string_view str) {
+    const size_t separator = str.find('=');
+    if(separator == std::string_view::npos) {
+        throw std::invalid_argument("Log sample rate must look like <route>=<N>: " + std::string(str));
+    }
+    const auto route = FindRouteByName(str.substr(0, separator));
+    if(!route) {
+        throw std::invalid_argument("Unknown route in log sample rate: " + std::string(str));
+    }
+    const std::string_view rate_str = str.substr(separator + 1);
+    uint32_t rate = 0;
+    const auto [end, ec] = std::from_chars(rate_str.data(), rate_str.data() + rate_str.size(), rate);
+    if(ec != std::errc{} || end != rate_str.data() + rate_str.size()) {
+        throw std::invalid_argument("Invalid log sample rate: " + std::string(str));
+    }
+    return {*route, rate};
+}
+
+bool RequestLogSampler::SampleRequest(Route route) const noexcept {
+    const LogLevel level = GetLogLevel();
+    if(level > LogLevel::kInfo) {
+        return false;
+    }
+    if(level == LogLevel::kDebug) {
+        return true;
+    }
+    const uint32_t rate = GetSampleRate(route);
+    if(rate <= 1) {
+        return rate == 1;
+    }
+    // Счётчики свои у каждого потока: в сумме по потокам сохраняется доля 1/N без общей атомарной переменной
+    thread_local std::array<uint32_t, routes_count> counters{};
+    uint32_t& counter = counters[static_cast<size_t>(route)];
+    const bool is_sampled = (counter % rate) == 0;
+    ++counter;
+    return is_sampled;
+}
+
+std::optional<LogLevel> RequestLogSampler::GetResponseLogLevel(bool is_sampled, int status_code,
+                                                               std::chrono::nanoseconds duration) const noexcept {
+    LogLevel level = LogLevel::kInfo;
+    if(status_code >= 500) {
+        level = LogLevel::kError;
+    } else if(status_code >= 400 || duration >= GetSlowThreshold()) {
+        level = LogLevel::kWarning;
+    }
+    if(!IsLogLevelEnabled(level) || (!is_sampled && level == LogLevel::kInfo)) {
+        return std::nullopt;
+    }
+    return level;
+}
+
+void RequestLogSampler::SetSampleRate(Route route, uint32_t rate) noexcept {
+    sample_rates_[static_cast<size_t>(route)].store(rate, std::memory_order_relaxed);
+}
+
+uint32_t RequestLogSampler::GetSampleRate(Route route) const noexcept {
+    return sample_rates_[static_cast<size_t>(route)].load(std::memory_order_relaxed);
+}
+
+void RequestLogSampler::SetSlowThreshold(std::chrono::milliseconds threshold) noexcept {
+    slow_threshold_ms_.store(threshold.count(), std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds RequestLogSampler::GetSlowThreshold() const noexcept {
+    return std::chrono::milliseconds(slow_threshold_ms_.load(std::memory_order_relaxed));
+}
+
+}  // namespace http_handler
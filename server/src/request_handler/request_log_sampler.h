@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../logging/logger.h"
+#include "request_utils.h"
+
+namespace http_handler {
+
+// Решает, какие запросы попадают в журнал.
+// Для каждого маршрута задаётся частота: 1 - каждый запрос, N - один из N, 0 - ни одного.
+// Ошибки и медленные ответы логируются всегда, если это позволяет текущий уровень журнала.
+class RequestLogSampler {
+public:
+    using SampleRate = std::pair<Route, uint32_t>;
+
+    struct Config {
+        std::chrono::milliseconds slow_threshold{100};
+        std::vector<SampleRate> sample_rates;
+    };
+
+    explicit RequestLogSampler(const Config& config);
+
+    // "state=1000"; бросает std::invalid_argument
+    static SampleRate ParseSampleRate(std::string_view str);
+
+    // Решение принимается при получении запроса
+    bool SampleRequest(Route route) const noexcept;
+
+    // Уровень записи об ответе или nullopt, если ответ не логируется
+    std::optional<LogLevel> GetResponseLogLevel(bool is_sampled, int status_code,
+                                                std::chrono::nanoseconds duration) const noexcept;
+
+    void SetSampleRate(Route route, uint32_t rate) noexcept;
+    uint32_t GetSampleRate(Route route) const noexcept;
+
+    void SetSlowThreshold(std::chrono::milliseconds threshold) noexcept;
+    std::chrono::milliseconds GetSlowThreshold() const noexcept;
+
+private:
+    static constexpr size_t routes_count = static_cast<size_t>(Route::kCount);
+
+    std::array<std::atomic<uint32_t>, routes_count> sample_rates_;
+    std::atomic<int64_t> slow_threshold_ms_;
+};
+
+}  // namespace http_handler
@@ -0,0 +1,51 @@
+#include "request_metrics.h"
+
+#include <algorithm>
+#include <string>
+
+namespace http_handler {
+
+size_t RequestMetrics::CodeIndex(int status_code) noexcept {
+    const auto it = std::find(known_codes.begin(), known_codes.end(), status_code);
+    return static_cast<size_t>(it - known_codes.begin());
+}
+
+void RequestMetrics::Record(Route route, int status_code, uint64_t bytes, std::chrono::nanoseconds duration) noexcept {
+    auto& metrics = routes_[static_cast<size_t>(route)];
+    metrics.requests[CodeIndex(status_code)].Add();
+    metrics.bytes_out.Add(bytes);
+    metrics.duration_us.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+}
+
+void RequestMetrics::Collect(metrics::PrometheusWriter& writer) const {
+    using Type = metrics::PrometheusWriter::Type;
+
+    writer.WriteHeader("http_requests_total"sv, Type::kCounter, "HTTP requests by route and status code"sv);
+    for(size_t route = 0; route < routes_count; ++route) {
+        const std::string_view route_name = GetRouteName(static_cast<Route>(route));
+        for(size_t code = 0; code <= known_codes.size(); ++code) {
+            const uint64_t count = routes_[route].requests[code].Get();
+            if(count == 0) {
+                continue;
+            }
+            const std::string code_str = code < known_codes.size() ? std::to_string(known_codes[code]) : "other"s;
+            writer.WriteSample("http_requests_total"sv, {{"route"sv, route_name}, {"code"sv, code_str}}, count);
+        }
+    }
+
+    writer.WriteHeader("http_response_bytes_total"sv, Type::kCounter, "HTTP response body bytes by route"sv);
+    for(size_t route = 0; route < routes_count; ++route) {
+        writer.WriteSample("http_response_bytes_total"sv, {{"route"sv, GetRouteName(static_cast<Route>(route))}},
+                           routes_[route].bytes_out.Get());
+    }
+
+    writer.WriteHeader("http_response_duration_seconds"sv, Type::kHistogram,
+                       "Time from request arrival to response by route"sv);
+    for(size_t route = 0; route < routes_count; ++route) {
+        writer.WriteHistogram("http_response_duration_seconds"sv, {{"route"sv, GetRouteName(static_cast<Route>(route))}},
+                              routes_[route].duration_us.GetSnapshot(), 1e-6, metrics::kDurationBounds);
+    }
+}
+
+}  // namespace http_handler
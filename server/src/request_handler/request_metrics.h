@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "../metrics/registry.h"
+#include "../metrics/sharded.h"
+#include "request_utils.h"
+
+namespace http_handler {
+
+// Счётчики запросов по маршрутам и кодам ответа, отданные байты и время ответа
+class RequestMetrics {
+public:
+    void Record(Route route, int status_code, uint64_t bytes, std::chrono::nanoseconds duration) noexcept;
+
+    void Collect(metrics::PrometheusWriter& writer) const;
+
+private:
+    // Коды, которые отдаёт сервер; остальные учитываются как "other"
+    static constexpr std::array<int, 14> known_codes = {
+        200, 204, 206, 304, 400, 401, 403, 404, 405, 408, 413, 429, 500, 503
+    };
+    static constexpr size_t routes_count = static_cast<size_t>(Route::kCount);
+
+    struct RouteMetrics {
+        std::array<metrics::ShardedCounter, known_codes.size() + 1> requests;
+        metrics::ShardedCounter bytes_out;
+        metrics::ShardedHistogram duration_us;
+    };
+
+    static size_t CodeIndex(int status_code) noexcept;
+
+    std::array<RouteMetrics, routes_count> routes_;
+};
+
+}  // namespace http_handler
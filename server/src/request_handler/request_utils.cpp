@@ -1,5 +1,7 @@
 #include "request_utils.h"
 
+#include <ctime>
+
 namespace http_handler{
 StringResponse MakeStringResponse(http::status status, std::string_view body, unsigned http_version,
                                 bool keep_alive, std::string_view content_type, 
@@ -20,68 +22,82 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
     return response;
 }
 
-StringResponse FormErrorJsonResponse(const StringRequest& req, http::status status, 
-                                            std::string_view code, std::string_view message, 
-                                            std::string_view cache_control, std::string_view allow) {
-    boost::json::object error_json{
-        {"code", code},
-        {"message", message}};
-    return MakeStringResponse(status, boost::json::serialize(error_json), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, cache_control, allow);
-}
-
+Route GetRoute(std::string_view target) noexcept {
+    const auto contains = [target](std::string_view endpoint) {
+        return target.find(endpoint) != std::string_view::npos;
+    };
+    if(!contains(Endpoints::api_endpoint)) {
+        return Route::kStatic;
+    }
+    if(contains(Endpoints::join_endpoint)) {
+        return Route::kJoin;
+    }
+    if(contains(Endpoints::get_players_in_session)) {
+        return Route::kPlayers;
+    }
+    if(contains(Endpoints::get_state)) {
+        return Route::kState;
+    }
+    if(contains(Endpoints::action)) {
+        return Route::kAction;
+    }
+    if(contains(Endpoints::tick)) {
+        return Route::kTick;
+    }
+    if(contains(Endpoints::maps_endpoint)) {
+        return Route::kMaps;
+    }
+    if(contains(Endpoints::records)) {
+        return Route::kRecords;
+    }
+    return Route::kApiOther;
 }
 
-namespace utils
-{
-URLDecoder::URLDecoder(std::string_view URL_string)
-{
-    decoded_str_ = ChangeURLCodedWordsToSymbols(URL_string);
+std::string_view GetRouteName(Route route) noexcept {
+    switch(route) {
+    case Route::kJoin:      return "join"sv;
+    case Route::kPlayers:   return "players"sv;
+    case Route::kState:     return "state"sv;
+    case Route::kAction:    return "action"sv;
+    case Route::kTick:      return "tick"sv;
+    case Route::kMaps:      return "maps"sv;
+    case Route::kRecords:   return "records"sv;
+    case Route::kApiOther:  return "api"sv;
+    case Route::kStatic:    return "static"sv;
+    case Route::kCount:     break;
+    }
+    return "unknown"sv;
 }
 
-std::string URLDecoder::ChangeURLCodedWordsToSymbols(const std::string_view str)
-{
-    using namespace std::literals;
-    if(str.size() == 0) 
-    {
-        return ""s;
-    }
-    std::string decoded_str = ""s;
-    for(size_t i = 0; i < str.size(); ++i)
-    {
-        if(str[i] == '%' && (i+2) < str.size())
-        {
-            int first_number = static_cast<int>(str[i+1]);
-            int second_number = static_cast<int>(str[i+2]);
-            int decoded_number = 0;
-            if(((first_number <= '9' && first_number >= '0') || (first_number <= 'F' && first_number >= 'A')) &&
-                ((second_number <= '9' && second_number >= '0') || (second_number <= 'F' && second_number >= 'A')))
-            {
-                char ch = static_cast<char>(std::stoi(std::string(str.begin() + (i + 1), str.begin() + i + 3), nullptr, 16));
-                decoded_str.push_back(ch);
-            }
-        }
-        else {
-            decoded_str.push_back(str[i]);
+std::optional<Route> FindRouteByName(std::string_view name) noexcept {
+    for(size_t i = 0; i < static_cast<size_t>(Route::kCount); ++i) {
+        const auto route = static_cast<Route>(i);
+        if(GetRouteName(route) == name) {
+            return route;
         }
     }
-    return decoded_str;
+    return std::nullopt;
 }
 
-std::string_view URLDecoder::GetDecodedURLAsStringView() const noexcept
-{
-    return decoded_str_;
+StringResponse FormErrorJsonResponse(const StringRequest& req, http::status status, 
+                                            std::string_view code, std::string_view message, 
+                                            std::string_view cache_control, std::string_view allow) {
+    return FormErrorJsonResponse(req.version(), req.keep_alive(), status, code, message, cache_control, allow);
 }
 
-std::string URLDecoder::GetDecodedURLAsString() const noexcept
-{
-    return decoded_str_;
+StringResponse FormErrorJsonResponse(unsigned http_version, bool keep_alive, http::status status,
+                                            std::string_view code, std::string_view message,
+                                            std::string_view cache_control, std::string_view allow) {
+    boost::json::object error_json{
+        {"code", code},
+        {"message", message}};
+    return MakeStringResponse(status, boost::json::serialize(error_json), http_version, keep_alive, ContentType::APPLICATION_JSON, cache_control, allow);
 }
 
-std::filesystem::path URLDecoder::GetDecodedURLAsPath()
-{
-    return std::filesystem::path(decoded_str_);
 }
 
+namespace utils
+{
 bool IsSubPath(std::filesystem::path path, std::filesystem::path base) {
     path = std::filesystem::weakly_canonical(path);
     base = std::filesystem::weakly_canonical(base);
@@ -124,4 +140,31 @@ std::optional<std::string_view>ContentTypeByFileExtension(std::string_view file_
     }
     return std::nullopt;
 }
-}
\ No newline at end of file
+
+std::string FormatHttpDate(std::chrono::system_clock::time_point time)
+{
+    const std::time_t t = std::chrono::system_clock::to_time_t(time);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buffer[64];
+    const size_t size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return {buffer, size};
+}
+
+std::optional<std::chrono::system_clock::time_point> ParseHttpDate(std::string_view date)
+{
+    char buffer[64];
+    if(date.size() >= sizeof(buffer))
+    {
+        return std::nullopt;
+    }
+    date.copy(buffer, date.size());
+    buffer[date.size()] = '\0';
+    std::tm tm{};
+    if(strptime(buffer, "%a, %d %b %Y %H:%M:%S GMT", &tm) == nullptr)
+    {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+}
+}
@@ -6,11 +6,16 @@
 #include <boost/beast/http.hpp>
 #include <boost/utility/string_view.hpp>
 
+#include <chrono>
 #include <string>
 #include <filesystem>
 #include <optional>
 #include <variant>
 
+#include "../server/request_arena.h"
+#include "../server/sendfile_body.h"
+#include "../server/shared_buffer_body.h"
+
 namespace http_handler{
 
 using namespace std::literals;
@@ -18,11 +23,15 @@ using namespace std::literals;
 namespace beast = boost::beast;
 namespace http = beast::http;
 
-using StringRequest = http::request<http::string_body>;
+// Заголовки и тело запроса размещаются в арене соединения (см. http_server::RequestArena).
+// Вне strand соединения запрос можно читать и разрушать, но не изменять: пока обрабатывается
+// этот запрос, сессия уже разбирает в арене следующие
+using StringRequest = http_server::ArenaRequest;
 using StringResponse = http::response<http::string_body>;
-using FileResponse = http::response<http::file_body>;
+using FileResponse = http::response<http_server::SendfileBody>;
+using CachedFileResponse = http::response<http_server::SharedBufferBody>;
 
-using Response = std::variant<StringResponse, FileResponse>;
+using Response = std::variant<StringResponse, FileResponse, CachedFileResponse>;
 
 struct Endpoints {
     Endpoints() = delete;
@@ -38,6 +47,26 @@ struct Endpoints {
     
 };
 
+// Маршруты, по которым настраивается выборочное логирование
+enum class Route : uint8_t {
+    kJoin,
+    kPlayers,
+    kState,
+    kAction,
+    kTick,
+    kMaps,
+    kRecords,
+    kApiOther,
+    kStatic,
+    kCount
+};
+
+// Определяет маршрут в том же порядке, что и ApiHandler::HandleApiRequest
+Route GetRoute(std::string_view target) noexcept;
+// Имя маршрута - строковый литерал, data() заканчивается нулём
+std::string_view GetRouteName(Route route) noexcept;
+std::optional<Route> FindRouteByName(std::string_view name) noexcept;
+
 struct ContentType {
     ContentType() = delete;
     // Text / HTML
@@ -70,6 +99,11 @@ StringResponse FormErrorJsonResponse(const StringRequest& req, http::status stat
                                             std::string_view code, std::string_view message, 
                                             std::string_view cache_control = ""sv, std::string_view allow = ""sv);
 
+// Для случаев, когда запроса уже нет (например, он перемещён в обработчик)
+StringResponse FormErrorJsonResponse(unsigned http_version, bool keep_alive, http::status status,
+                                            std::string_view code, std::string_view message,
+                                            std::string_view cache_control = ""sv, std::string_view allow = ""sv);
+
 StringResponse MakeStringResponse(http::status status, std::string_view body, unsigned http_version,
                                 bool keep_alive, std::string_view content_type, 
                                 std::string_view cache_control = ""sv, std::string_view allow = ""sv) ;
@@ -77,20 +111,10 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
 
 namespace utils
 {
-class URLDecoder {
-public:
-    URLDecoder() = delete;
-    explicit URLDecoder(std::string_view URL_string);
-
-    std::string ChangeURLCodedWordsToSymbols(const std::string_view str);
-
-    std::string_view GetDecodedURLAsStringView() const noexcept;
-    std::string GetDecodedURLAsString() const noexcept;
-    std::filesystem::path GetDecodedURLAsPath();
-private:
-    std::string decoded_str_;
-};
-
 bool IsSubPath(std::filesystem::path path, std::filesystem::path base);
 std::optional<std::string_view>ContentTypeByFileExtension(std::string_view file_extension);
+
+// Дата в формате HTTP (RFC 7231, IMF-fixdate): "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string FormatHttpDate(std::chrono::system_clock::time_point time);
+std::optional<std::chrono::system_clock::time_point> ParseHttpDate(std::string_view date);
 }
\ No newline at end of file
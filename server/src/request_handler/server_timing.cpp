@@ -0,0 +1,40 @@
+#include "server_timing.h"
+
+#include <cstdio>
+
+namespace http_handler {
+
+namespace {
+
+std::string_view GetMetricName(ServerTiming::Metric metric) noexcept {
+    switch(metric) {
+    case ServerTiming::Metric::kQueue:      return "queue"sv;
+    case ServerTiming::Metric::kAuth:       return "auth"sv;
+    case ServerTiming::Metric::kHandler:    return "handler"sv;
+    case ServerTiming::Metric::kSerialize:  return "serialize"sv;
+    case ServerTiming::Metric::kDb:         return "db"sv;
+    case ServerTiming::Metric::kCount:      break;
+    }
+    return "unknown"sv;
+}
+
+}  // namespace
+
+std::string ServerTiming::ToHeaderValue() const {
+    std::string value;
+    char buffer[32];
+    for(size_t i = 0; i < durations_.size(); ++i) {
+        if(!durations_[i].is_measured) {
+            continue;
+        }
+        if(!value.empty()) {
+            value += ", "sv;
+        }
+        value += GetMetricName(static_cast<Metric>(i));
+        std::snprintf(buffer, sizeof(buffer), ";dur=%.3f", static_cast<double>(durations_[i].ns) / 1e6);
+        value += buffer;
+    }
+    return value;
+}
+
+}  // namespace http_handler
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace http_handler {
+
+using namespace std::literals;
+
+// Разбивка времени обработки API-запроса для заголовка Server-Timing.
+// Заполняется на api_strand одним потоком, поэтому без синхронизации
+class ServerTiming {
+public:
+    // Запрос с этим заголовком получает Server-Timing, даже если он не включён флагом
+    constexpr static std::string_view request_header = "X-Debug-Timing"sv;
+    constexpr static std::string_view response_header = "Server-Timing"sv;
+
+    enum class Metric : uint8_t {
+        kQueue,         // ожидание в очереди api_strand
+        kAuth,          // проверка токена
+        kHandler,       // вся обработка запроса, включая auth, serialize и db
+        kSerialize,     // построение JSON ответа
+        kDb,            // запросы к базе данных
+        kCount
+    };
+
+    // Замер участка; ничего не делает, если timing не задан
+    class Scope {
+    public:
+        Scope(ServerTiming* timing, Metric metric) noexcept
+            : timing_(timing)
+            , metric_(metric) {
+            if(timing_ != nullptr) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope() {
+            if(timing_ != nullptr) {
+                timing_->Add(metric_, std::chrono::steady_clock::now() - start_);
+            }
+        }
+
+    private:
+        ServerTiming* timing_;
+        Metric metric_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    void Add(Metric metric, std::chrono::steady_clock::duration duration) noexcept {
+        auto& value = durations_[static_cast<size_t>(metric)];
+        value.ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        value.is_measured = true;
+    }
+
+    // "queue;dur=0.012, auth;dur=0.003, handler;dur=0.245" - только измеренные участки, мс
+    std::string ToHeaderValue() const;
+
+private:
+    struct Duration {
+        uint64_t ns = 0;
+        bool is_measured = false;
+    };
+
+    std::array<Duration, static_cast<size_t>(Metric::kCount)> durations_{};
+};
+
+}  // namespace http_handler
@@ -0,0 +1,165 @@
+#include "state_long_poll.h"
+#include "api_handler.h"
+#include "state_query.h"
+#include "../json_handler/state_json.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace http_handler {
+
+namespace {
+
+std::shared_ptr<const std::string> MakeErrorBody(std::string_view code, std::string_view message) {
+    return std::make_shared<const std::string>(boost::json::serialize(boost::json::object{{"code", code}, {"message", message}}));
+}
+
+}  // namespace
+
+StateLongPoll::StateLongPoll(app::Application& application, Strand strand, Config config)
+    : application_(application)
+    , strand_(strand)
+    , config_(config)
+    , timer_(strand_) {
+    // Сигнал вызывается на strand в конце такта; соединение разрывается вместе с объектом
+    tick_connection_ = application_.DoOnTick([this](std::chrono::milliseconds) {
+        OnTick();
+    });
+}
+
+std::optional<StateLongPoll::Waiter> StateLongPoll::PrepareWaiter(const StringRequest& req) const {
+    if(req.method() != http::verb::get) {
+        return std::nullopt;
+    }
+    const auto query = ParseStateQuery(req.target());
+    // Клиент отстал или помнит такт прошлого запуска сервера - отвечаем сразу
+    if(!query || query->since_tick != application_.GetTickNumber()) {
+        return std::nullopt;
+    }
+    const auto timeout = std::min(query->timeout.value_or(config_.default_timeout), config_.max_timeout);
+    if(timeout.count() <= 0) {
+        return std::nullopt;
+    }
+    // Ошибки авторизации возвращает обычный обработчик
+    auto token = ParseAuthorization(req);
+    if(!token || token->size() != 32) {
+        return std::nullopt;
+    }
+    app::Token player_token(std::move(*token));
+    if(application_.FindPlayerByToken(player_token) == nullptr) {
+        return std::nullopt;
+    }
+    return Waiter{
+        .token = std::move(player_token),
+        .version = req.version(),
+        .keep_alive = req.keep_alive(),
+        .deadline = Clock::now() + timeout,
+        .send = nullptr
+    };
+}
+
+void StateLongPoll::Park(Waiter&& waiter) {
+    const Clock::time_point deadline = waiter.deadline;
+    waiters_.push_back(std::move(waiter));
+    waiting_.store(waiters_.size(), std::memory_order_relaxed);
+    if(deadline < timer_deadline_) {
+        ArmTimer(deadline);
+    }
+}
+
+void StateLongPoll::ArmTimer(Clock::time_point deadline) {
+    timer_deadline_ = deadline;
+    timer_.expires_at(deadline);
+    timer_.async_wait([weak_self = weak_from_this()](boost::system::error_code ec) {
+        if(auto self = weak_self.lock()) {
+            self->OnTimer(ec);
+        }
+    });
+}
+
+void StateLongPoll::OnTimer(boost::system::error_code ec) {
+    // Таймер переставлен на более ранний срок или все запросы завершены тактом
+    if(ec == boost::asio::error::operation_aborted) {
+        return;
+    }
+    timer_deadline_ = Clock::time_point::max();
+    const Clock::time_point now = Clock::now();
+    const auto expired_begin = std::partition(waiters_.begin(), waiters_.end(), [now](const Waiter& waiter) {
+        return waiter.deadline > now;
+    });
+    std::vector<Waiter> expired(std::make_move_iterator(expired_begin), std::make_move_iterator(waiters_.end()));
+    waiters_.erase(expired_begin, waiters_.end());
+    waiting_.store(waiters_.size(), std::memory_order_relaxed);
+    if(!waiters_.empty()) {
+        const auto next = std::min_element(waiters_.begin(), waiters_.end(), [](const Waiter& lhs, const Waiter& rhs) {
+            return lhs.deadline < rhs.deadline;
+        });
+        ArmTimer(next->deadline);
+    }
+    completed_by_timeout_.fetch_add(expired.size(), std::memory_order_relaxed);
+    Complete(expired);
+}
+
+void StateLongPoll::OnTick() {
+    if(waiters_.empty()) {
+        return;
+    }
+    std::vector<Waiter> waiters;
+    waiters.swap(waiters_);
+    waiting_.store(0, std::memory_order_relaxed);
+    timer_deadline_ = Clock::time_point::max();
+    timer_.cancel();
+    completed_by_tick_.fetch_add(waiters.size(), std::memory_order_relaxed);
+    Complete(waiters);
+}
+
+void StateLongPoll::Complete(std::vector<Waiter>& waiters) {
+    static const auto unknown_token_body = MakeErrorBody("unknownToken"sv, "Player token has not been found"sv);
+    static const auto internal_error_body = MakeErrorBody("internalServerError"sv, "Failed to serialize state"sv);
+    const std::string tick = std::to_string(application_.GetTickNumber());
+    // Состояние одинаково для всех игроков сессии
+    std::unordered_map<const model::GameSession*, std::shared_ptr<const std::string>> states;
+    for(Waiter& waiter : waiters) {
+        StateResponse response(http::status::ok, waiter.version);
+        try {
+            // Игрок мог выбыть, пока запрос ждал такта
+            const auto player = application_.FindPlayerByToken(waiter.token);
+            if(player == nullptr) {
+                response.result(http::status::unauthorized);
+                response.body() = unknown_token_body;
+            } else {
+                auto& state = states[player->GetSession()];
+                if(!state) {
+                    const auto players = application_.GetAllPlayersInSessionWithCurrentPlayer(waiter.token);
+                    std::vector<const model::Dog*> dogs;
+                    dogs.reserve(players.size());
+                    for(const auto& session_player : players) {
+                        dogs.push_back(session_player->GetDog().get());
+                    }
+                    state = std::make_shared<const std::string>(json_loader::SerializeState(dogs, player->GetSession()->GetLootsInSession()));
+                }
+                response.body() = state;
+            }
+        } catch(const std::exception&) {
+            response.result(http::status::internal_server_error);
+            response.body() = internal_error_body;
+        }
+        response.set(http::field::content_type, ContentType::APPLICATION_JSON);
+        response.set(http::field::cache_control, "no-cache"sv);
+        response.set(tick_header, tick);
+        response.keep_alive(waiter.keep_alive);
+        response.prepare_payload();
+        waiter.send(std::move(response));
+    }
+}
+
+void StateLongPoll::Collect(metrics::PrometheusWriter& writer) const {
+    using Type = metrics::PrometheusWriter::Type;
+    writer.WriteHeader("state_long_poll_waiting"sv, Type::kGauge, "State requests waiting for the next tick"sv);
+    writer.WriteSample("state_long_poll_waiting"sv, {}, waiting_.load(std::memory_order_relaxed));
+    writer.WriteHeader("state_long_poll_completed_total"sv, Type::kCounter, "Waiting state requests completed by tick or timeout"sv);
+    writer.WriteSample("state_long_poll_completed_total"sv, {{"reason"sv, "tick"sv}}, completed_by_tick_.load(std::memory_order_relaxed));
+    writer.WriteSample("state_long_poll_completed_total"sv, {{"reason"sv, "timeout"sv}}, completed_by_timeout_.load(std::memory_order_relaxed));
+}
+
+}  // namespace http_handler
@@ -0,0 +1,96 @@
+#pragma once
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/signals2.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "request_utils.h"
+#include "../application/application.h"
+#include "../metrics/registry.h"
+
+namespace http_handler {
+
+// Долгий опрос состояния: GET /api/v1/game/state?sinceTick=N[&timeout=MS].
+// Если номер такта (заголовок X-Game-Tick прошлого ответа) совпадает с текущим, запрос
+// не занимает strand, а ждёт следующего такта или таймаута. Отложенные запросы
+// завершаются все сразу из Application::DoOnTick; состояние сериализуется один раз
+// на игровую сессию и разделяется между ответами её игроков
+class StateLongPoll : public std::enable_shared_from_this<StateLongPoll> {
+public:
+    using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+    using StateResponse = http::response<http_server::SharedBufferBody>;
+    using Send = std::function<void(StateResponse&&)>;
+
+    struct Config {
+        std::chrono::milliseconds default_timeout{20000};   // если в запросе нет timeout
+        std::chrono::milliseconds max_timeout{25000};       // меньше таймаута простоя соединения
+    };
+
+    constexpr static std::string_view tick_header = "X-Game-Tick"sv;
+
+    // Подписывается на такты application; strand - тот же, на котором идут такты
+    StateLongPoll(app::Application& application, Strand strand, Config config);
+
+    StateLongPoll(const StateLongPoll&) = delete;
+    StateLongPoll& operator=(const StateLongPoll&) = delete;
+
+    // Вызывается на strand. true - запрос отложен и копия send сохранена; false - ответить
+    // нужно сразу: нет sinceTick, такт уже новее или запрос всё равно завершится ошибкой
+    template <typename SendHandler>
+    bool TryPark(const StringRequest& req, SendHandler& send) {
+        auto waiter = PrepareWaiter(req);
+        if(!waiter) {
+            return false;
+        }
+        // Копия, а не перемещение: если Park бросит исключение, вызывающий ответит
+        // ошибкой через исходный send
+        waiter->send = Send(send);
+        Park(std::move(*waiter));
+        return true;
+    }
+
+    void Collect(metrics::PrometheusWriter& writer) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Waiter {
+        app::Token token;
+        unsigned version;
+        bool keep_alive;
+        Clock::time_point deadline;
+        Send send;
+    };
+
+    std::optional<Waiter> PrepareWaiter(const StringRequest& req) const;
+    void Park(Waiter&& waiter);
+    void ArmTimer(Clock::time_point deadline);
+    void OnTimer(boost::system::error_code ec);
+    void OnTick();
+    // Отвечает текущим состоянием
+    void Complete(std::vector<Waiter>& waiters);
+
+    app::Application& application_;
+    Strand strand_;
+    const Config config_;
+    boost::signals2::scoped_connection tick_connection_;
+    boost::asio::steady_timer timer_;
+    Clock::time_point timer_deadline_ = Clock::time_point::max();
+    std::vector<Waiter> waiters_;
+
+    // Читаются при сборе метрик из любого потока
+    std::atomic<uint64_t> waiting_{0};
+    std::atomic<uint64_t> completed_by_tick_{0};
+    std::atomic<uint64_t> completed_by_timeout_{0};
+};
+
+}  // namespace http_handler
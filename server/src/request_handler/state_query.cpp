@@ -0,0 +1,53 @@
+#include "state_query.h"
+
+#include <charconv>
+
+namespace http_handler {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::string_view since_tick_param = "sinceTick="sv;
+constexpr std::string_view timeout_param = "timeout="sv;
+
+}  // namespace
+
+std::optional<StateQuery> ParseStateQuery(std::string_view target) noexcept {
+    const size_t question = target.find('?');
+    if(question == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const std::string_view query = target.substr(question + 1, target.find('#', question) - question - 1);
+    const auto since_tick = FindUintParam(query, since_tick_param);
+    if(!since_tick) {
+        return std::nullopt;
+    }
+    StateQuery result{.since_tick = *since_tick, .timeout = std::nullopt};
+    if(const auto timeout = FindUintParam(query, timeout_param)) {
+        result.timeout = std::chrono::milliseconds(*timeout);
+    }
+    return result;
+}
+
+std::optional<uint64_t> FindUintParam(std::string_view query, std::string_view name) noexcept {
+    size_t pos = 0;
+    while((pos = query.find(name, pos)) != std::string_view::npos) {
+        if(pos == 0 || query[pos - 1] == '&') {
+            break;
+        }
+        pos += name.size();
+    }
+    if(pos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const std::string_view value = query.substr(pos + name.size(), query.find('&', pos) - pos - name.size());
+    uint64_t result = 0;
+    const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if(ec != std::errc{} || end != value.data() + value.size()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+}  // namespace http_handler
@@ -0,0 +1,22 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace http_handler {
+
+// Параметры долгого опроса состояния: ?sinceTick=N[&timeout=MS]
+struct StateQuery {
+    uint64_t since_tick = 0;
+    std::optional<std::chrono::milliseconds> timeout;
+};
+
+// nullopt - в target нет sinceTick, обычный запрос состояния. Fragment (#...) отбрасывается
+std::optional<StateQuery> ParseStateQuery(std::string_view target) noexcept;
+
+// Значение параметра name ("sinceTick=") в query без '?'; имя должно стоять в начале
+// query или после '&'. nullopt - параметра нет или значение не целое неотрицательное число
+std::optional<uint64_t> FindUintParam(std::string_view query, std::string_view name) noexcept;
+
+}  // namespace http_handler
@@ -0,0 +1,355 @@
+#include "static_cache.h"
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include "../logging/logger.h"
+
+namespace http_handler {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::string_view encoding_names[StaticCache::encodings_count] = {""sv, "gzip"sv, "br"sv};
+constexpr std::string_view etag_suffixes[StaticCache::encodings_count] = {""sv, "-gz"sv, "-br"sv};
+constexpr std::string_view brotli_extension = ".br"sv;
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if(!in) {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+    std::stringstream content;
+    content << in.rdbuf();
+    return std::move(content).str();
+}
+
+std::string Gzip(const std::string& data) {
+    namespace io = boost::iostreams;
+    std::string compressed;
+    {
+        io::filtering_ostream out;
+        out.push(io::gzip_compressor(io::gzip_params(io::gzip::best_compression)));
+        out.push(io::back_inserter(compressed));
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    return compressed;
+}
+
+// FNV-1a: ETag меняется вместе с содержимым
+uint64_t HashContent(const std::string& data) {
+    uint64_t hash = 14695981039346656037ull;
+    for(const unsigned char ch : data) {
+        hash = (hash ^ ch) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string MakeETag(uint64_t hash, std::string_view suffix) {
+    char buffer[40];
+    const int size = std::snprintf(buffer, sizeof(buffer), "\"%016llx%.*s\"", static_cast<unsigned long long>(hash),
+                                   static_cast<int>(suffix.size()), suffix.data());
+    return {buffer, static_cast<size_t>(size)};
+}
+
+std::string_view Trim(std::string_view str) {
+    while(!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while(!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+// Вызывает f для каждого элемента списка через запятую
+template <typename F>
+void ForEachListItem(std::string_view list, F&& f) {
+    while(!list.empty()) {
+        const size_t comma = list.find(',');
+        f(Trim(list.substr(0, comma)));
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+    }
+}
+
+bool MatchesETag(std::string_view if_none_match, const StaticCache::Entry& entry) {
+    bool is_matched = false;
+    ForEachListItem(if_none_match, [&](std::string_view tag) {
+        if(tag == "*"sv) {
+            is_matched = true;
+            return;
+        }
+        if(tag.starts_with("W/"sv)) {
+            tag.remove_prefix(2);
+        }
+        for(const auto& variant : entry.variants) {
+            if(variant.data && variant.etag == tag) {
+                is_matched = true;
+            }
+        }
+    });
+    return is_matched;
+}
+
+bool IsNotModified(const StringRequest& req, const StaticCache::Entry& entry) {
+    // If-Modified-Since учитывается только без If-None-Match (RFC 7232, 3.3)
+    if(const auto it = req.find(http::field::if_none_match); it != req.end()) {
+        return MatchesETag(it->value(), entry);
+    }
+    if(const auto it = req.find(http::field::if_modified_since); it != req.end()) {
+        const auto since = utils::ParseHttpDate(it->value());
+        return since && entry.modified_at <= *since;
+    }
+    return false;
+}
+
+// Вариант с наибольшим q из Accept-Encoding; при равенстве - brotli
+StaticCache::Encoding ChooseEncoding(std::string_view accept_encoding, const StaticCache::Entry& entry) {
+    using Encoding = StaticCache::Encoding;
+    double q_brotli = -1;
+    double q_gzip = -1;
+    double q_any = -1;
+    ForEachListItem(accept_encoding, [&](std::string_view item) {
+        const size_t semicolon = item.find(';');
+        const std::string_view name = Trim(item.substr(0, semicolon));
+        double q = 1;
+        if(semicolon != std::string_view::npos) {
+            const std::string_view params = item.substr(semicolon + 1);
+            if(const size_t pos = params.find("q="sv); pos != std::string_view::npos) {
+                std::from_chars(params.data() + pos + 2, params.data() + params.size(), q);
+            }
+        }
+        if(beast::iequals(name, "br"sv)) {
+            q_brotli = q;
+        } else if(beast::iequals(name, "gzip"sv)) {
+            q_gzip = q;
+        } else if(name == "*"sv) {
+            q_any = q;
+        }
+    });
+    if(q_brotli < 0) {
+        q_brotli = q_any;
+    }
+    if(q_gzip < 0) {
+        q_gzip = q_any;
+    }
+
+    Encoding result = Encoding::kIdentity;
+    double best_q = 0;
+    if(entry.Get(Encoding::kBrotli).data && q_brotli > best_q) {
+        result = Encoding::kBrotli;
+        best_q = q_brotli;
+    }
+    if(entry.Get(Encoding::kGzip).data && q_gzip > best_q) {
+        result = Encoding::kGzip;
+    }
+    return result;
+}
+
+template <typename ResponseType>
+void SetValidators(ResponseType& response, const StaticCache::Entry& entry, StaticCache::Encoding encoding) {
+    response.set(http::field::etag, entry.Get(encoding).etag);
+    response.set(http::field::last_modified, entry.last_modified);
+    if(entry.Get(StaticCache::Encoding::kGzip).data || entry.Get(StaticCache::Encoding::kBrotli).data) {
+        response.set(http::field::vary, "Accept-Encoding"sv);
+    }
+}
+
+std::shared_ptr<const StaticCache::Entry> LoadEntry(const fs::path& path, const StaticCache::Config& config) {
+    using Encoding = StaticCache::Encoding;
+    auto entry = std::make_shared<StaticCache::Entry>();
+    entry->content_type = utils::ContentTypeByFileExtension(path.extension().string()).value_or(ContentType::UNKNOWN);
+    const auto modified_at = fs::last_write_time(path);
+    entry->modified_at = std::chrono::time_point_cast<std::chrono::seconds>(
+        std::chrono::file_clock::to_sys(modified_at));
+    entry->last_modified = utils::FormatHttpDate(entry->modified_at);
+
+    auto identity = std::make_shared<const std::string>(ReadFile(path));
+    const uint64_t hash = HashContent(*identity);
+    auto set_variant = [&](Encoding encoding, std::shared_ptr<const std::string> data) {
+        auto& variant = entry->variants[static_cast<size_t>(encoding)];
+        variant.etag = MakeETag(hash, etag_suffixes[static_cast<size_t>(encoding)]);
+        variant.data = std::move(data);
+    };
+    if(identity->size() >= config.min_compress_size) {
+        // Сжатый вариант хранится, только если он заметно меньше исходного
+        auto is_worth = [&](const std::string& compressed) {
+            return compressed.size() < identity->size() - identity->size() / 10;
+        };
+        if(auto gzip = Gzip(*identity); is_worth(gzip)) {
+            set_variant(Encoding::kGzip, std::make_shared<const std::string>(std::move(gzip)));
+        }
+        fs::path brotli_path = path;
+        brotli_path += brotli_extension;
+        std::error_code ec;
+        if(fs::is_regular_file(brotli_path, ec) && fs::last_write_time(brotli_path, ec) >= modified_at && !ec) {
+            if(auto brotli = ReadFile(brotli_path); is_worth(brotli)) {
+                set_variant(Encoding::kBrotli, std::make_shared<const std::string>(std::move(brotli)));
+            }
+        }
+    }
+    set_variant(Encoding::kIdentity, std::move(identity));
+    return entry;
+}
+
+}  // namespace
+
+StaticCache::StaticCache(fs::path root, Config config)
+    : root_(std::move(root))
+    , config_(config) {
+    Reload();
+}
+
+StaticCache::~StaticCache() = default;
+
+std::shared_ptr<const StaticCache::Entry> StaticCache::Find(std::string_view decoded_path) const {
+    if(decoded_path.size() > 1 && decoded_path.back() == '/') {
+        decoded_path.remove_suffix(1);
+    }
+    const auto snapshot = snapshot_.load(std::memory_order_acquire);
+    const auto it = snapshot->files.find(decoded_path);
+    return it == snapshot->files.end() ? nullptr : it->second;
+}
+
+Response StaticCache::MakeResponse(const StringRequest& req, const Entry& entry) {
+    const Encoding encoding = ChooseEncoding(req[http::field::accept_encoding], entry);
+    if(IsNotModified(req, entry)) {
+        StringResponse response(http::status::not_modified, req.version());
+        SetValidators(response, entry, encoding);
+        response.keep_alive(req.keep_alive());
+        return response;
+    }
+
+    CachedFileResponse response(http::status::ok, req.version());
+    response.set(http::field::content_type, entry.content_type);
+    if(encoding != Encoding::kIdentity) {
+        response.set(http::field::content_encoding, encoding_names[static_cast<size_t>(encoding)]);
+    }
+    SetValidators(response, entry, encoding);
+    response.body() = entry.Get(encoding).data;
+    response.keep_alive(req.keep_alive());
+    response.prepare_payload();
+    return response;
+}
+
+std::shared_ptr<const StaticCache::Snapshot> StaticCache::Load() const {
+    auto snapshot = std::make_shared<Snapshot>();
+    std::vector<std::string> directories;
+    for(const auto& item : fs::recursive_directory_iterator(root_, fs::directory_options::skip_permission_denied)) {
+        std::string path = "/" + fs::relative(item.path(), root_).generic_string();
+        if(item.is_directory()) {
+            directories.push_back(std::move(path));
+            continue;
+        }
+        if(!item.is_regular_file() || item.file_size() > config_.max_file_size
+           || item.path().extension() == brotli_extension) {
+            continue;
+        }
+        auto entry = LoadEntry(item.path(), config_);
+        for(const auto& variant : entry->variants) {
+            snapshot->bytes += variant.data ? variant.data->size() : 0;
+        }
+        ++snapshot->file_count;
+        snapshot->files.emplace(std::move(path), std::move(entry));
+    }
+    // Как и при чтении с диска, путь к каталогу отдаёт корневой index.html
+    if(const auto it = snapshot->files.find("/index.html"sv); it != snapshot->files.end()) {
+        const auto index = it->second;
+        snapshot->files.emplace("/", index);
+        for(auto& directory : directories) {
+            snapshot->files.emplace(std::move(directory), index);
+        }
+    }
+    return snapshot;
+}
+
+void StaticCache::Reload() {
+    auto snapshot = Load();
+    boost::json::value data = {
+        {"files", snapshot->file_count},
+        {"bytes", snapshot->bytes}
+    };
+    snapshot_.store(std::move(snapshot), std::memory_order_release);
+    reloads_.fetch_add(1, std::memory_order_release);
+    LogJson(data, "static cache loaded"sv);
+}
+
+void StaticCache::AddWatches(int inotify_fd) const {
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF;
+    // Повторное добавление каталога возвращает прежний дескриптор, удалённые каталоги
+    // снимаются с наблюдения ядром
+    inotify_add_watch(inotify_fd, root_.c_str(), mask);
+    for(const auto& item : fs::recursive_directory_iterator(root_, fs::directory_options::skip_permission_denied)) {
+        if(item.is_directory()) {
+            inotify_add_watch(inotify_fd, item.path().c_str(), mask);
+        }
+    }
+}
+
+void StaticCache::StartWatching() {
+    const int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify_fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "inotify_init1");
+    }
+    AddWatches(inotify_fd);
+    watcher_ = std::jthread([this, inotify_fd](std::stop_token stop_token) {
+        Watch(stop_token, inotify_fd);
+    });
+}
+
+void StaticCache::Watch(std::stop_token stop_token, int inotify_fd) {
+    using Clock = std::chrono::steady_clock;
+    // Изменения обычно идут пачкой (копирование каталога), перезагрузка - после паузы
+    constexpr auto quiet_period = 200ms;
+    bool has_changes = false;
+    Clock::time_point last_change;
+    alignas(inotify_event) char buffer[4096];
+    while(!stop_token.stop_requested()) {
+        pollfd fd{.fd = inotify_fd, .events = POLLIN, .revents = 0};
+        if(poll(&fd, 1, static_cast<int>(quiet_period.count())) > 0) {
+            while(read(inotify_fd, buffer, sizeof(buffer)) > 0) {
+            }
+            has_changes = true;
+            last_change = Clock::now();
+            continue;
+        }
+        if(has_changes && Clock::now() - last_change >= quiet_period) {
+            has_changes = false;
+            try {
+                Reload();
+                AddWatches(inotify_fd);
+            } catch(const std::exception& ex) {
+                boost::json::value data = {
+                    {"exception", ex.what()}
+                };
+                LogJson(data, "static cache reload failed"sv, LogLevel::kError);
+            }
+        }
+    }
+    close(inotify_fd);
+}
+
+void StaticCache::Collect(metrics::PrometheusWriter& writer) const {
+    using Type = metrics::PrometheusWriter::Type;
+    const auto snapshot = snapshot_.load(std::memory_order_acquire);
+    writer.WriteHeader("static_cache_files"sv, Type::kGauge, "Static files held in memory"sv);
+    writer.WriteSample("static_cache_files"sv, {}, static_cast<uint64_t>(snapshot->file_count));
+    writer.WriteHeader("static_cache_bytes"sv, Type::kGauge, "Memory used by cached static files, all encodings"sv);
+    writer.WriteSample("static_cache_bytes"sv, {}, static_cast<uint64_t>(snapshot->bytes));
+    writer.WriteHeader("static_cache_reloads_total"sv, Type::kCounter, "Loads of the static file cache"sv);
+    writer.WriteSample("static_cache_reloads_total"sv, {}, reloads_.load(std::memory_order_relaxed));
+}
+
+}  // namespace http_handler
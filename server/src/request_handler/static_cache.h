@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "request_utils.h"
+#include "../metrics/registry.h"
+
+namespace http_handler {
+
+// Неизменяемый кэш статических файлов www-root. Загружается при старте целиком,
+// вместе со сжатыми вариантами: gzip считается при загрузке, brotli берётся из
+// заранее подготовленного файла рядом с исходным (file.js.br), если он не старше файла.
+// Запросы к файлам вне кэша (слишком большим или появившимся после загрузки)
+// обслуживаются с диска. С StartWatching кэш перезагружается при изменениях в www-root
+class StaticCache {
+public:
+    struct Config {
+        size_t max_file_size = 8 * 1024 * 1024;     // файлы больше не кэшируются
+        size_t min_compress_size = 1024;            // меньшие файлы не сжимаются
+    };
+
+    enum class Encoding {
+        kIdentity,
+        kGzip,
+        kBrotli
+    };
+    static constexpr size_t encodings_count = 3;
+
+    struct Variant {
+        std::shared_ptr<const std::string> data;    // nullptr - варианта нет
+        std::string etag;
+    };
+
+    struct Entry {
+        std::string_view content_type;
+        std::string last_modified;      // дата в формате HTTP
+        std::chrono::system_clock::time_point modified_at;
+        std::array<Variant, encodings_count> variants;
+
+        const Variant& Get(Encoding encoding) const noexcept {
+            return variants[static_cast<size_t>(encoding)];
+        }
+    };
+
+    StaticCache(std::filesystem::path root, Config config);
+    explicit StaticCache(std::filesystem::path root)
+        : StaticCache(std::move(root), Config{}) {
+    }
+    ~StaticCache();
+
+    StaticCache(const StaticCache&) = delete;
+    StaticCache& operator=(const StaticCache&) = delete;
+
+    // decoded_path - путь из URL после декодирования, начинается с '/'.
+    // Путь к каталогу отдаёт корневой index.html. nullptr - файла нет в кэше
+    std::shared_ptr<const Entry> Find(std::string_view decoded_path) const;
+
+    // Ответ с нужным вариантом сжатия или 304, если у клиента актуальная копия
+    static Response MakeResponse(const StringRequest& req, const Entry& entry);
+
+    // Перечитывает www-root; запросы до окончания обслуживаются из прежнего содержимого
+    void Reload();
+
+    // Следит за www-root через inotify в отдельном потоке
+    void StartWatching();
+
+    // Меняется при каждой перезагрузке: по нему сбрасываются результаты, полученные из кэша
+    uint64_t GetGeneration() const noexcept {
+        return reloads_.load(std::memory_order_acquire);
+    }
+
+    void Collect(metrics::PrometheusWriter& writer) const;
+
+private:
+    // Поиск по std::string_view без создания строки
+    struct PathHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view path) const noexcept {
+            return std::hash<std::string_view>{}(path);
+        }
+    };
+
+    struct Snapshot {
+        std::unordered_map<std::string, std::shared_ptr<const Entry>, PathHash, std::equal_to<>> files;
+        size_t file_count = 0;
+        size_t bytes = 0;           // все варианты всех файлов
+    };
+
+    std::shared_ptr<const Snapshot> Load() const;
+    void AddWatches(int inotify_fd) const;
+    void Watch(std::stop_token stop_token, int inotify_fd);
+
+    std::filesystem::path root_;
+    Config config_;
+    std::atomic<std::shared_ptr<const Snapshot>> snapshot_;
+    std::atomic<uint64_t> reloads_{0};
+    std::jthread watcher_;
+};
+
+}  // namespace http_handler
@@ -0,0 +1,213 @@
+#include "journal.h"
+
+namespace serialization
+{
+    namespace
+    {
+        using namespace std::literals;
+
+        constexpr std::string_view journal_magic = "GSJRNL\r\n"sv;
+        constexpr size_t frame_header_size = 2 * sizeof(uint32_t);
+        // Минимальный размер трофея в записи такта: тип и две координаты
+        constexpr size_t min_spawn_size = 3 * sizeof(uint64_t);
+
+        struct RecordEncoder {
+            BinaryWriter& writer;
+
+            void operator()(const JoinRecord& record) const
+            {
+                writer.WriteU8(static_cast<uint8_t>(JournalRecordType::kJoin));
+                writer.WriteString(record.map_id);
+                writer.WriteString(record.user_name);
+                writer.WriteString(record.token);
+                writer.WriteU64(record.dog_id);
+                writer.WriteDouble(record.x);
+                writer.WriteDouble(record.y);
+            }
+
+            void operator()(const MoveRecord& record) const
+            {
+                writer.WriteU8(static_cast<uint8_t>(JournalRecordType::kMove));
+                writer.WriteString(record.token);
+                writer.WriteString(record.move);
+            }
+
+            void operator()(const TickRecord& record) const
+            {
+                writer.WriteU8(static_cast<uint8_t>(JournalRecordType::kTick));
+                writer.WriteU64(record.delta_ms);
+                writer.WriteU64(record.spawned.size());
+                for(const auto& [map_id, spawns] : record.spawned)
+                {
+                    writer.WriteString(*map_id);
+                    writer.WriteU64(spawns.size());
+                    for(const auto& spawn : spawns)
+                    {
+                        writer.WriteU64(spawn.type);
+                        writer.WriteDouble(spawn.position.x);
+                        writer.WriteDouble(spawn.position.y);
+                    }
+                }
+                writer.WriteU64(record.retired.size());
+                for(const auto& result : record.retired)
+                {
+                    EncodeRetiredPlayer(writer, result);
+                }
+            }
+
+            void operator()(const ResultsSavedRecord& record) const
+            {
+                writer.WriteU8(static_cast<uint8_t>(JournalRecordType::kResultsSaved));
+                writer.WriteU64(record.ids.size());
+                for(const auto& id : record.ids)
+                {
+                    writer.WriteString(id);
+                }
+            }
+        };
+
+        JournalRecord DecodeRecord(BinaryReader& reader, uint32_t version)
+        {
+            const auto type = static_cast<JournalRecordType>(reader.ReadU8());
+            switch(type)
+            {
+            case JournalRecordType::kJoin:
+            {
+                JoinRecord record;
+                record.map_id = reader.ReadString();
+                record.user_name = reader.ReadString();
+                record.token = reader.ReadString();
+                record.dog_id = reader.ReadU64();
+                record.x = reader.ReadDouble();
+                record.y = reader.ReadDouble();
+                return record;
+            }
+            case JournalRecordType::kMove:
+            {
+                MoveRecord record;
+                record.token = reader.ReadString();
+                record.move = reader.ReadString();
+                return record;
+            }
+            case JournalRecordType::kTick:
+            {
+                TickRecord record;
+                record.delta_ms = reader.ReadU64();
+                const uint64_t sessions_count = reader.ReadCount(2 * sizeof(uint64_t));
+                record.spawned.reserve(sessions_count);
+                for(uint64_t i = 0; i < sessions_count; ++i)
+                {
+                    model::Map::Id map_id{reader.ReadString()};
+                    std::vector<model::LootSpawn> spawns(reader.ReadCount(min_spawn_size));
+                    for(auto& spawn : spawns)
+                    {
+                        spawn.type = reader.ReadU64();
+                        spawn.position.x = reader.ReadDouble();
+                        spawn.position.y = reader.ReadDouble();
+                    }
+                    record.spawned.emplace_back(std::move(map_id), std::move(spawns));
+                }
+                // В версии 1 результаты выбывших в журнал не попадали
+                if(version >= 2)
+                {
+                    record.retired.resize(reader.ReadCount(min_retired_player_size));
+                    for(auto& result : record.retired)
+                    {
+                        result = DecodeRetiredPlayer(reader);
+                    }
+                }
+                return record;
+            }
+            case JournalRecordType::kResultsSaved:
+            {
+                ResultsSavedRecord record;
+                record.ids.resize(reader.ReadCount(sizeof(uint64_t)));
+                for(auto& id : record.ids)
+                {
+                    id = reader.ReadString();
+                }
+                return record;
+            }
+            }
+            throw SnapshotError("Unknown journal record type " + std::to_string(static_cast<int>(type)));
+        }
+    } // namespace
+
+    std::string EncodeJournalHeader(uint64_t first_lsn)
+    {
+        BinaryWriter writer;
+        writer.WriteBytes(journal_magic);
+        writer.WriteU32(journal_version);
+        writer.WriteU64(first_lsn);
+        return writer.Release();
+    }
+
+    void EncodeJournalEntry(BinaryWriter& writer, uint64_t lsn, const JournalRecord& record)
+    {
+        // Длина и контрольная сумма известны только после кодирования записи
+        const size_t frame_start = writer.Size();
+        writer.WriteU32(0);
+        writer.WriteU32(0);
+        writer.WriteU64(lsn);
+        std::visit(RecordEncoder{writer}, record);
+        std::string_view payload = std::string_view(writer.Data()).substr(frame_start + frame_header_size);
+        writer.PatchU32(frame_start, static_cast<uint32_t>(payload.size()));
+        writer.PatchU32(frame_start + sizeof(uint32_t), Crc32(payload));
+    }
+
+    JournalReader::JournalReader(std::string_view data)
+        : data_(data)
+    {
+        if(!data_.starts_with(journal_magic) || data_.size() < journal_header_size)
+        {
+            throw SnapshotError("Not a journal segment");
+        }
+        BinaryReader reader(data_.substr(journal_magic.size()));
+        version_ = reader.ReadU32();
+        if(version_ == 0 || version_ > journal_version)
+        {
+            throw SnapshotError("Unsupported journal version " + std::to_string(version_));
+        }
+        first_lsn_ = reader.ReadU64();
+        pos_ = journal_header_size;
+    }
+
+    std::optional<JournalEntry> JournalReader::Next()
+    {
+        if(is_torn_tail_ || pos_ == data_.size())
+        {
+            return std::nullopt;
+        }
+        BinaryReader frame_reader(data_.substr(pos_));
+        std::string_view payload;
+        try
+        {
+            const uint32_t length = frame_reader.ReadU32();
+            const uint32_t crc = frame_reader.ReadU32();
+            payload = frame_reader.ReadBytes(length);
+            if(Crc32(payload) != crc)
+            {
+                is_torn_tail_ = true;
+                return std::nullopt;
+            }
+        }
+        catch(const SnapshotError&)
+        {
+            is_torn_tail_ = true;
+            return std::nullopt;
+        }
+        pos_ += frame_header_size + payload.size();
+
+        // Запись с верной контрольной суммой обязана разбираться целиком
+        BinaryReader reader(payload);
+        JournalEntry entry;
+        entry.lsn = reader.ReadU64();
+        entry.record = DecodeRecord(reader, version_);
+        if(!reader.AtEnd())
+        {
+            throw SnapshotError("Unexpected data at the end of journal record");
+        }
+        return entry;
+    }
+
+} // namespace serialization
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "../game/game.h"
+#include "snapshot.h"
+
+namespace serialization {
+
+// Формат сегмента журнала действий.
+//
+// Заголовок:  magic[8] | version:u32 | first_lsn:u64
+// Запись:     length:u32 | crc32:u32 | payload[length]
+// payload:    lsn:u64 | type:u8 | поля записи
+//
+// Записи идут с возрастающими lsn. Недописанная или повреждённая запись в конце
+// сегмента означает, что сервер остановился во время записи: всё после неё отбрасывается.
+//
+// Версия 2: запись такта дополнена результатами выбывших в нём игроков,
+// добавлена запись kResultsSaved. Сегменты версии 1 читаются.
+
+enum class JournalRecordType : uint8_t {
+    kJoin = 1,
+    kMove = 2,
+    kTick = 3,
+    kResultsSaved = 4
+};
+
+// Вход в игру: сохраняются выданные токен, id собаки и точка появления,
+// чтобы повтор не зависел от генераторов случайных чисел
+struct JoinRecord {
+    std::string map_id;
+    std::string user_name;
+    std::string token;
+    uint64_t dog_id = 0;
+    double x = 0.0;
+    double y = 0.0;
+};
+
+struct MoveRecord {
+    std::string token;
+    std::string move;
+};
+
+// Такт игры вместе с трофеями, появившимися за него, и результатами выбывших игроков.
+// Результаты считаются неподтверждёнными, пока в журнале не появится ResultsSavedRecord с их id
+struct TickRecord {
+    uint64_t delta_ms = 0;
+    model::Game::SpawnedLoots spawned;
+    std::vector<RetiredPlayerResult> retired;
+};
+
+// База подтвердила запись результатов с этими id
+struct ResultsSavedRecord {
+    std::vector<std::string> ids;
+};
+
+using JournalRecord = std::variant<JoinRecord, MoveRecord, TickRecord, ResultsSavedRecord>;
+
+struct JournalEntry {
+    uint64_t lsn = 0;
+    JournalRecord record;
+};
+
+static constexpr uint32_t journal_version = 2;
+static constexpr size_t journal_header_size = 8 + sizeof(uint32_t) + sizeof(uint64_t);
+
+std::string EncodeJournalHeader(uint64_t first_lsn);
+
+// Дописывает запись в writer вместе с длиной и контрольной суммой
+void EncodeJournalEntry(BinaryWriter& writer, uint64_t lsn, const JournalRecord& record);
+
+// Последовательно читает записи одного сегмента
+class JournalReader {
+public:
+    // Бросает SnapshotError, если заголовок сегмента не распознан
+    explicit JournalReader(std::string_view data);
+
+    uint64_t GetFirstLsn() const noexcept {
+        return first_lsn_;
+    }
+
+    // Следующая запись или nullopt в конце сегмента
+    std::optional<JournalEntry> Next();
+
+    // Сегмент закончился недописанной или повреждённой записью
+    bool IsTornTail() const noexcept {
+        return is_torn_tail_;
+    }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+    uint64_t first_lsn_ = 0;
+    uint32_t version_ = journal_version;
+    bool is_torn_tail_ = false;
+};
+
+}  // namespace serialization
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <algorithm>
 #include <queue>
@@ -62,6 +63,57 @@ void serialize(Archive& ar, model::LootsWrappler& loots_wrappler, [[maybe_unused
     }
 }
 
+// Прямое двоичное кодирование для snapshot.h (Writer/Reader - BinaryWriter/BinaryReader)
+template <typename Writer>
+void EncodeBinary(Writer& writer, const model::LootsWrappler& loots_wrappler) {
+    writer.WriteU64(loots_wrappler.loots_.size());
+    for(const auto& loot : loots_wrappler.loots_) {
+        writer.WriteU64(loot.type_);
+        writer.WriteDouble(loot.position_.x);
+        writer.WriteDouble(loot.position_.y);
+        writer.WriteDouble(loot.width_);
+    }
+    std::queue<uint64_t> copy_of_freed_ids(loots_wrappler.freed_ids_);
+    writer.WriteU64(copy_of_freed_ids.size());
+    while(!copy_of_freed_ids.empty()) {
+        writer.WriteU64(copy_of_freed_ids.front());
+        copy_of_freed_ids.pop();
+    }
+    writer.WriteU64(loots_wrappler.busy_loots_id_.size());
+    for(uint64_t id : loots_wrappler.busy_loots_id_) {
+        writer.WriteU64(id);
+    }
+}
+
+template <typename Reader>
+void DecodeBinary(Reader& reader, model::LootsWrappler& loots_wrappler) {
+    static const size_t loot_size = 4 * sizeof(uint64_t);
+    loots_wrappler = model::LootsWrappler{};
+    const uint64_t loots_count = reader.ReadCount(loot_size);
+    for(uint64_t i = 0; i < loots_count; ++i) {
+        model::Loot& loot = loots_wrappler.loots_.emplace_back();
+        loot.type_ = reader.ReadU64();
+        loot.position_.x = reader.ReadDouble();
+        loot.position_.y = reader.ReadDouble();
+        loot.width_ = reader.ReadDouble();
+        loots_wrappler.loots_ptr_.push_back(&loot);
+    }
+    const uint64_t freed_count = reader.ReadCount(sizeof(uint64_t));
+    for(uint64_t i = 0; i < freed_count; ++i) {
+        const uint64_t id = reader.ReadU64();
+        if(id >= loots_count) {
+            throw std::out_of_range("Invalid id of freed loot in snapshot");
+        }
+        loots_wrappler.freed_ids_.push(id);
+        loots_wrappler.loots_ptr_.at(id) = nullptr;
+    }
+    const uint64_t busy_count = reader.ReadCount(sizeof(uint64_t));
+    loots_wrappler.busy_loots_id_.reserve(busy_count);
+    for(uint64_t i = 0; i < busy_count; ++i) {
+        loots_wrappler.busy_loots_id_.insert(reader.ReadU64());
+    }
+}
+
 }  // namespace model
 
 namespace serialization {
@@ -91,6 +143,82 @@ public:
         ar& token_;
     }
 
+    // Прямое двоичное кодирование для snapshot.h. В отличие от serialize
+    // сохраняет и время в игре, и признак ухода на пенсию
+    template <typename Writer>
+    void EncodeBinary(Writer& writer) const {
+        writer.WriteU64(id_);
+        writer.WriteString(name_);
+        writer.WriteDouble(pos_.x_);
+        writer.WriteDouble(pos_.y_);
+        writer.WriteU64(bag_capacity_);
+        writer.WriteDouble(speed_.dx_);
+        writer.WriteDouble(speed_.dy_);
+        writer.WriteU8(static_cast<uint8_t>(direction_));
+        writer.WriteU64(score_);
+        writer.WriteU64(bag_content_.size());
+        for(uint64_t item_id : bag_content_) {
+            writer.WriteU64(item_id);
+        }
+        writer.WriteString(map_id_);
+        writer.WriteString(token_);
+        writer.WriteU64(game_time_ms_);
+        writer.WriteU64(standing_time_ms_);
+        writer.WriteBool(is_retirement_);
+    }
+
+    // Тот же формат, что и у EncodeBinary выше, но прямо из модели, без промежуточной
+    // копии собаки. Используется при снятии снимка на strand игры
+    template <typename Writer>
+    static void EncodeBinary(Writer& writer, const model::Dog& dog, std::string_view token, std::string_view map_id) {
+        writer.WriteU64(dog.GetId());
+        writer.WriteString(dog.GetName());
+        writer.WriteDouble(dog.GetDogCoordinates().x_);
+        writer.WriteDouble(dog.GetDogCoordinates().y_);
+        writer.WriteU64(dog.GetBagCapacity());
+        writer.WriteDouble(dog.GetDogSpeed().dx_);
+        writer.WriteDouble(dog.GetDogSpeed().dy_);
+        writer.WriteU8(static_cast<uint8_t>(dog.GetDogDirection()));
+        writer.WriteU64(dog.GetScore());
+        const auto& bag_content = dog.GetDogsBag().GetAllIds();
+        writer.WriteU64(bag_content.size());
+        for(uint64_t item_id : bag_content) {
+            writer.WriteU64(item_id);
+        }
+        writer.WriteString(map_id);
+        writer.WriteString(token);
+        writer.WriteU64(dog.GetGameTime_ms());
+        writer.WriteU64(dog.GetStandingTime());
+        writer.WriteBool(dog.IsOnRetirement());
+    }
+
+    template <typename Reader>
+    void DecodeBinary(Reader& reader) {
+        id_ = reader.ReadU64();
+        name_ = reader.ReadString();
+        pos_.x_ = reader.ReadDouble();
+        pos_.y_ = reader.ReadDouble();
+        bag_capacity_ = reader.ReadU64();
+        speed_.dx_ = reader.ReadDouble();
+        speed_.dy_ = reader.ReadDouble();
+        const uint8_t direction = reader.ReadU8();
+        if(direction > static_cast<uint8_t>(model::Direction::EAST)) {
+            throw std::out_of_range("Invalid dog direction in snapshot");
+        }
+        direction_ = static_cast<model::Direction>(direction);
+        score_ = reader.ReadU64();
+        bag_content_.clear();
+        const uint64_t bag_size = reader.ReadCount(sizeof(uint64_t));
+        for(uint64_t i = 0; i < bag_size; ++i) {
+            bag_content_.push_back(reader.ReadU64());
+        }
+        map_id_ = reader.ReadString();
+        token_ = reader.ReadString();
+        game_time_ms_ = reader.ReadU64();
+        standing_time_ms_ = reader.ReadU64();
+        is_retirement_ = reader.ReadBool();
+    }
+
 private:
     uint64_t id_ = 0;
     std::string name_;
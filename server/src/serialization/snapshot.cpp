@@ -0,0 +1,252 @@
+#include "snapshot.h"
+
+#include <sstream>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/crc.hpp>
+#include <boost/json.hpp>
+
+namespace serialization
+{
+    namespace
+    {
+        using namespace std::literals;
+
+        constexpr std::string_view snapshot_magic = "GSSNAP\r\n"sv;
+        constexpr size_t header_size = snapshot_magic.size() + 2 * sizeof(uint32_t);
+        // Минимальный размер закодированной собаки: числовые поля и длины трёх строк
+        constexpr size_t min_dog_size = 13 * sizeof(uint64_t) + 2;
+
+        SessionSnapshot DecodeSession(std::string_view payload)
+        {
+            BinaryReader reader(payload);
+            SessionSnapshot session;
+            session.map_id = reader.ReadString();
+            const uint64_t dogs_count = reader.ReadCount(min_dog_size);
+            session.dogs.resize(dogs_count);
+            for(auto& dog : session.dogs)
+            {
+                dog.DecodeBinary(reader);
+            }
+            model::DecodeBinary(reader, session.loots);
+            if(!reader.AtEnd())
+            {
+                throw SnapshotError("Unexpected data at the end of session section");
+            }
+            return session;
+        }
+
+        std::vector<RetiredPlayerResult> DecodePendingResults(std::string_view payload)
+        {
+            BinaryReader reader(payload);
+            std::vector<RetiredPlayerResult> results(reader.ReadCount(min_retired_player_size));
+            for(auto& result : results)
+            {
+                result = DecodeRetiredPlayer(reader);
+            }
+            if(!reader.AtEnd())
+            {
+                throw SnapshotError("Unexpected data at the end of pending results section");
+            }
+            return results;
+        }
+    } // namespace
+
+    bool IsBinarySnapshot(std::string_view data) noexcept
+    {
+        return data.starts_with(snapshot_magic);
+    }
+
+    uint32_t Crc32(std::string_view data) noexcept
+    {
+        boost::crc_32_type crc;
+        crc.process_bytes(data.data(), data.size());
+        return crc.checksum();
+    }
+
+    std::string EncodeSession(std::string_view map_id, const std::vector<DogRepr>& dogs, const model::LootsWrappler& loots)
+    {
+        BinaryWriter writer;
+        writer.Reserve(map_id.size() + dogs.size() * (min_dog_size + 64) + loots.GetAllLoots().size() * 4 * sizeof(uint64_t) + 64);
+        writer.WriteString(map_id);
+        writer.WriteU64(dogs.size());
+        for(const auto& dog : dogs)
+        {
+            dog.EncodeBinary(writer);
+        }
+        model::EncodeBinary(writer, loots);
+        return writer.Release();
+    }
+
+    std::string EncodeSession(std::string_view map_id, const std::vector<SessionDog>& dogs, const model::LootsWrappler& loots)
+    {
+        BinaryWriter writer;
+        writer.Reserve(map_id.size() + dogs.size() * (min_dog_size + 64) + loots.GetAllLoots().size() * 4 * sizeof(uint64_t) + 64);
+        writer.WriteString(map_id);
+        writer.WriteU64(dogs.size());
+        for(const auto& dog : dogs)
+        {
+            DogRepr::EncodeBinary(writer, *dog.dog, dog.token, map_id);
+        }
+        model::EncodeBinary(writer, loots);
+        return writer.Release();
+    }
+
+    std::string BuildSnapshot(const EncodedStateSnapshot& snapshot)
+    {
+        SnapshotBuilder builder;
+        for(const auto& session : snapshot.sessions)
+        {
+            builder.AddSection(SectionType::kSession, session);
+        }
+        if(snapshot.journal_lsn != 0)
+        {
+            builder.AddSection(SectionType::kJournalPosition, EncodeJournalPosition(snapshot.journal_lsn));
+        }
+        if(!snapshot.pending_results.empty())
+        {
+            builder.AddSection(SectionType::kPendingResults, EncodePendingResults(snapshot.pending_results));
+        }
+        return builder.Finish();
+    }
+
+    std::string EncodeJournalPosition(uint64_t journal_lsn)
+    {
+        BinaryWriter writer;
+        writer.WriteU64(journal_lsn);
+        return writer.Release();
+    }
+
+    void EncodeRetiredPlayer(BinaryWriter& writer, const RetiredPlayerResult& result)
+    {
+        writer.WriteString(result.id);
+        writer.WriteString(result.name);
+        writer.WriteU64(result.score);
+        writer.WriteDouble(result.play_time_ms);
+    }
+
+    RetiredPlayerResult DecodeRetiredPlayer(BinaryReader& reader)
+    {
+        RetiredPlayerResult result;
+        result.id = reader.ReadString();
+        result.name = reader.ReadString();
+        result.score = reader.ReadU64();
+        result.play_time_ms = reader.ReadDouble();
+        return result;
+    }
+
+    std::string EncodePendingResults(const std::vector<RetiredPlayerResult>& results)
+    {
+        BinaryWriter writer;
+        writer.WriteU64(results.size());
+        for(const auto& result : results)
+        {
+            EncodeRetiredPlayer(writer, result);
+        }
+        return writer.Release();
+    }
+
+    SnapshotBuilder::SnapshotBuilder()
+    {
+        writer_.WriteBytes(snapshot_magic);
+        writer_.WriteU32(snapshot_version);
+        writer_.WriteU32(0);
+    }
+
+    void SnapshotBuilder::AddSection(SectionType type, std::string_view payload)
+    {
+        writer_.WriteU32(static_cast<uint32_t>(type));
+        writer_.WriteU64(payload.size());
+        writer_.WriteU32(Crc32(payload));
+        writer_.WriteBytes(payload);
+        ++section_count_;
+    }
+
+    std::string SnapshotBuilder::Finish()
+    {
+        writer_.PatchU32(snapshot_magic.size() + sizeof(uint32_t), section_count_);
+        return writer_.Release();
+    }
+
+    StateSnapshot DecodeSnapshot(std::string_view data)
+    {
+        if(!IsBinarySnapshot(data) || data.size() < header_size)
+        {
+            throw SnapshotError("Not a binary snapshot");
+        }
+        BinaryReader reader(data.substr(snapshot_magic.size()));
+        const uint32_t version = reader.ReadU32();
+        if(version == 0 || version > snapshot_version)
+        {
+            throw SnapshotError("Unsupported snapshot version " + std::to_string(version));
+        }
+        const uint32_t section_count = reader.ReadU32();
+
+        StateSnapshot snapshot;
+        for(uint32_t i = 0; i < section_count; ++i)
+        {
+            const uint32_t type = reader.ReadU32();
+            const uint64_t length = reader.ReadU64();
+            const uint32_t crc = reader.ReadU32();
+            std::string_view payload = reader.ReadBytes(length);
+            if(Crc32(payload) != crc)
+            {
+                throw SnapshotError("Snapshot section checksum mismatch");
+            }
+            if(type == static_cast<uint32_t>(SectionType::kSession))
+            {
+                snapshot.sessions.push_back(DecodeSession(payload));
+            }
+            else if(type == static_cast<uint32_t>(SectionType::kJournalPosition))
+            {
+                BinaryReader position_reader(payload);
+                snapshot.journal_lsn = position_reader.ReadU64();
+            }
+            else if(type == static_cast<uint32_t>(SectionType::kPendingResults))
+            {
+                snapshot.pending_results = DecodePendingResults(payload);
+            }
+            // Секции неизвестных типов пропускаются
+        }
+        return snapshot;
+    }
+
+    StateSnapshot DecodeLegacyJsonState(std::string_view data)
+    {
+        StateSnapshot snapshot;
+        const boost::json::value parsed_json = boost::json::parse(data);
+        if(!parsed_json.is_object())
+        {
+            return snapshot;
+        }
+        // Сессии идут в порядке первого упоминания карты
+        auto get_session = [&snapshot](const std::string& map_id) -> SessionSnapshot& {
+            auto it = std::find_if(snapshot.sessions.begin(), snapshot.sessions.end(), [&map_id](const SessionSnapshot& session) {
+                return session.map_id == map_id;
+            });
+            if(it != snapshot.sessions.end())
+            {
+                return *it;
+            }
+            snapshot.sessions.push_back(SessionSnapshot{.map_id = map_id, .dogs = {}, .loots = {}});
+            return snapshot.sessions.back();
+        };
+        for(const auto& json_player : parsed_json.as_object().at("Players").as_array())
+        {
+            std::istringstream string_stream(json_player.as_string().c_str());
+            boost::archive::text_iarchive ia{string_stream};
+            DogRepr ser_dog;
+            ia >> ser_dog;
+            const std::string map_id = std::get<2>(ser_dog.Restore());
+            get_session(map_id).dogs.push_back(std::move(ser_dog));
+        }
+        for(const auto& json_obj : parsed_json.as_object().at("Items").as_array())
+        {
+            std::istringstream string_stream(json_obj.as_object().at("loots_in_map").as_string().c_str());
+            boost::archive::text_iarchive ia{string_stream};
+            ia >> get_session(json_obj.as_object().at("map_id").as_string().c_str()).loots;
+        }
+        return snapshot;
+    }
+
+} // namespace serialization
@@ -0,0 +1,276 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "serialization.h"
+
+namespace serialization {
+
+// Двоичный формат снимка состояния игры.
+//
+// Заголовок:  magic[8] | version:u32 | section_count:u32
+// Секция:     type:u32 | length:u64 | crc32:u32 | payload[length]
+//
+// Все числа записываются в little-endian, double - как биты IEEE 754.
+// Одна секция kSession на каждую игровую сессию: map_id, собаки, предметы на карте.
+// Секция kJournalPosition хранит номер последней записи журнала действий, вошедшей в снимок.
+// Секция kPendingResults - результаты выбывших игроков, которые ещё не подтверждены базой.
+
+class SnapshotError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class BinaryWriter {
+public:
+    void WriteU8(uint8_t value) {
+        buffer_.push_back(static_cast<char>(value));
+    }
+
+    void WriteU32(uint32_t value) {
+        WriteLittleEndian(value);
+    }
+
+    void WriteU64(uint64_t value) {
+        WriteLittleEndian(value);
+    }
+
+    void WriteDouble(double value) {
+        WriteLittleEndian(std::bit_cast<uint64_t>(value));
+    }
+
+    void WriteBool(bool value) {
+        WriteU8(value ? 1 : 0);
+    }
+
+    void WriteString(std::string_view value) {
+        WriteU64(value.size());
+        buffer_.append(value);
+    }
+
+    void WriteBytes(std::string_view bytes) {
+        buffer_.append(bytes);
+    }
+
+    // Перезаписывает ранее записанное значение (например, счётчик в заголовке)
+    void PatchU32(size_t offset, uint32_t value) {
+        BinaryWriter patch;
+        patch.WriteU32(value);
+        buffer_.replace(offset, sizeof(value), patch.Data());
+    }
+
+    void Reserve(size_t size) {
+        buffer_.reserve(size);
+    }
+
+    size_t Size() const noexcept {
+        return buffer_.size();
+    }
+
+    const std::string& Data() const noexcept {
+        return buffer_;
+    }
+
+    std::string Release() noexcept {
+        return std::move(buffer_);
+    }
+
+private:
+    template <typename T>
+    void WriteLittleEndian(T value) {
+        char bytes[sizeof(T)];
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(bytes, &value, sizeof(T));
+        } else {
+            for(size_t i = 0; i < sizeof(T); ++i) {
+                bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+            }
+        }
+        buffer_.append(bytes, sizeof(T));
+    }
+
+    std::string buffer_;
+};
+
+class BinaryReader {
+public:
+    explicit BinaryReader(std::string_view data)
+        : data_(data) {
+    }
+
+    uint8_t ReadU8() {
+        return static_cast<uint8_t>(ReadBytes(1)[0]);
+    }
+
+    uint32_t ReadU32() {
+        return ReadLittleEndian<uint32_t>();
+    }
+
+    uint64_t ReadU64() {
+        return ReadLittleEndian<uint64_t>();
+    }
+
+    double ReadDouble() {
+        return std::bit_cast<double>(ReadLittleEndian<uint64_t>());
+    }
+
+    bool ReadBool() {
+        return ReadU8() != 0;
+    }
+
+    std::string ReadString() {
+        const uint64_t size = ReadU64();
+        return std::string{ReadBytes(size)};
+    }
+
+    std::string_view ReadBytes(uint64_t size) {
+        if(size > data_.size() - pos_) {
+            throw SnapshotError("Snapshot is truncated");
+        }
+        std::string_view bytes = data_.substr(pos_, size);
+        pos_ += size;
+        return bytes;
+    }
+
+    // Количество элементов контейнера; каждый элемент занимает не меньше min_element_size байт,
+    // поэтому испорченный счётчик не приводит к огромному резервированию памяти
+    uint64_t ReadCount(size_t min_element_size = 1) {
+        const uint64_t count = ReadU64();
+        if(count > (data_.size() - pos_) / std::max<size_t>(1, min_element_size)) {
+            throw SnapshotError("Snapshot is truncated");
+        }
+        return count;
+    }
+
+    bool AtEnd() const noexcept {
+        return pos_ == data_.size();
+    }
+
+private:
+    template <typename T>
+    T ReadLittleEndian() {
+        std::string_view bytes = ReadBytes(sizeof(T));
+        T value = 0;
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(&value, bytes.data(), sizeof(T));
+        } else {
+            for(size_t i = 0; i < sizeof(T); ++i) {
+                value |= static_cast<T>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+            }
+        }
+        return value;
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+enum class SectionType : uint32_t {
+    kSession = 1,
+    kJournalPosition = 2,
+    kPendingResults = 3
+};
+
+// Результат выбывшего игрока для записи в базу. id (UUID) выдаётся при выбывании
+// и не меняется при повторах, поэтому повторная запись не создаёт дубликат
+struct RetiredPlayerResult {
+    std::string id;
+    std::string name;
+    uint64_t score = 0;
+    double play_time_ms = 0.0;
+};
+
+// Состояние одной игровой сессии, восстановленное из снимка
+struct SessionSnapshot {
+    std::string map_id;
+    std::vector<DogRepr> dogs;
+    model::LootsWrappler loots;
+};
+
+// Состояние всех сессий, восстановленное из снимка
+struct StateSnapshot {
+    std::vector<SessionSnapshot> sessions;
+    std::chrono::steady_clock::time_point captured_at;
+    // Номер последней записи журнала, учтённой в снимке (0 - журнал не вёлся)
+    uint64_t journal_lsn = 0;
+    std::vector<RetiredPlayerResult> pending_results;
+};
+
+// Неизменяемое состояние всех сессий, снятое на strand игры для сохранения.
+// Сессии сразу кодируются в содержимое секций kSession: один проход с записью
+// в непрерывный буфер дешевле, чем глубокая копия собак и предметов
+struct EncodedStateSnapshot {
+    std::vector<std::string> sessions;
+    std::chrono::steady_clock::time_point captured_at;
+    // Номер последней записи журнала, учтённой в снимке (0 - журнал не вёлся)
+    uint64_t journal_lsn = 0;
+    std::vector<RetiredPlayerResult> pending_results;
+};
+
+// Собака сессии и токен её игрока - для кодирования прямо из состояния игры
+struct SessionDog {
+    const model::Dog* dog = nullptr;
+    std::string_view token;
+};
+
+static constexpr uint32_t snapshot_version = 1;
+
+bool IsBinarySnapshot(std::string_view data) noexcept;
+
+uint32_t Crc32(std::string_view data) noexcept;
+
+// Кодирует содержимое секции kSession
+std::string EncodeSession(std::string_view map_id, const std::vector<DogRepr>& dogs, const model::LootsWrappler& loots);
+
+inline std::string EncodeSession(const SessionSnapshot& session) {
+    return EncodeSession(session.map_id, session.dogs, session.loots);
+}
+
+// То же содержимое секции kSession, но без промежуточных DogRepr
+std::string EncodeSession(std::string_view map_id, const std::vector<SessionDog>& dogs, const model::LootsWrappler& loots);
+
+// Собирает файл снимка: секции kSession, kJournalPosition (если журнал ведётся)
+// и kPendingResults (если есть неподтверждённые результаты)
+std::string BuildSnapshot(const EncodedStateSnapshot& snapshot);
+
+// Собирает файл снимка из закодированных секций
+class SnapshotBuilder {
+public:
+    SnapshotBuilder();
+
+    void AddSection(SectionType type, std::string_view payload);
+
+    std::string Finish();
+
+private:
+    BinaryWriter writer_;
+    uint32_t section_count_ = 0;
+};
+
+// Кодирует содержимое секции kJournalPosition
+std::string EncodeJournalPosition(uint64_t journal_lsn);
+
+// Минимальный размер закодированного результата: длины двух строк, очки и время
+static constexpr size_t min_retired_player_size = 4 * sizeof(uint64_t);
+
+void EncodeRetiredPlayer(BinaryWriter& writer, const RetiredPlayerResult& result);
+RetiredPlayerResult DecodeRetiredPlayer(BinaryReader& reader);
+
+// Кодирует содержимое секции kPendingResults
+std::string EncodePendingResults(const std::vector<RetiredPlayerResult>& results);
+
+// Разбирает файл снимка, проверяя версию и контрольные суммы секций
+StateSnapshot DecodeSnapshot(std::string_view data);
+
+// Разбирает файл состояния в формате JSON, сохранённый до перехода на двоичные снимки:
+// {"Players": [DogRepr в text_oarchive], "Items": [{"map_id", "loots_in_map"}]}
+StateSnapshot DecodeLegacyJsonState(std::string_view data);
+
+}  // namespace serialization
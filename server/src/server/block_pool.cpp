@@ -0,0 +1,73 @@
+#include "block_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <new>
+
+namespace http_server {
+
+namespace {
+
+constexpr std::size_t classes_count = std::bit_width(BlockPool::max_block_size) - std::bit_width(BlockPool::min_block_size) + 1;
+
+std::size_t GetClass(std::size_t size) noexcept {
+    return std::bit_width(std::bit_ceil(std::max(size, BlockPool::min_block_size))) - std::bit_width(BlockPool::min_block_size);
+}
+
+std::size_t GetClassSize(std::size_t size_class) noexcept {
+    return BlockPool::min_block_size << size_class;
+}
+
+class ThreadCache {
+public:
+    ThreadCache() = default;
+    ThreadCache(const ThreadCache&) = delete;
+    ThreadCache& operator=(const ThreadCache&) = delete;
+
+    ~ThreadCache() {
+        for(std::size_t size_class = 0; size_class < classes_count; ++size_class) {
+            for(std::size_t i = 0; i < counts_[size_class]; ++i) {
+                ::operator delete(blocks_[size_class][i], GetClassSize(size_class));
+            }
+        }
+    }
+
+    void* Take(std::size_t size_class) {
+        if(counts_[size_class] == 0) {
+            return ::operator new(GetClassSize(size_class));
+        }
+        return blocks_[size_class][--counts_[size_class]];
+    }
+
+    void Put(void* block, std::size_t size_class) noexcept {
+        if(counts_[size_class] == BlockPool::max_cached_blocks) {
+            return ::operator delete(block, GetClassSize(size_class));
+        }
+        blocks_[size_class][counts_[size_class]++] = block;
+    }
+
+private:
+    std::array<std::array<void*, BlockPool::max_cached_blocks>, classes_count> blocks_{};
+    std::array<std::size_t, classes_count> counts_{};
+};
+
+thread_local ThreadCache cache;
+
+}  // namespace
+
+void* BlockPool::Allocate(std::size_t size) {
+    if(size > max_block_size) {
+        return ::operator new(size);
+    }
+    return cache.Take(GetClass(size));
+}
+
+void BlockPool::Deallocate(void* block, std::size_t size) noexcept {
+    if(size > max_block_size) {
+        return ::operator delete(block, size);
+    }
+    cache.Put(block, GetClass(size));
+}
+
+}  // namespace http_server
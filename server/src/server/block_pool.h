@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+
+namespace http_server {
+
+// Кэш блоков памяти в каждом потоке для буферов соединений. Простаивающее соединение
+// возвращает сюда буфер чтения и блок арены, а следующий запрос на этом потоке берёт
+// их обратно без обращения к куче. Блоки округляются до степени двойки; больше
+// max_block_size - напрямую из кучи
+class BlockPool {
+public:
+    static constexpr std::size_t min_block_size = 512;
+    static constexpr std::size_t max_block_size = 64 * 1024;
+    // Сколько свободных блоков каждого размера хранит один поток
+    static constexpr std::size_t max_cached_blocks = 32;
+
+    static void* Allocate(std::size_t size);
+    // size - тот же, что был передан в Allocate
+    static void Deallocate(void* block, std::size_t size) noexcept;
+};
+
+// Аллокатор поверх BlockPool для контейнеров, память которых освобождается целиком
+// (например, beast::basic_flat_buffer)
+template <typename T>
+class PooledAllocator {
+public:
+    using value_type = T;
+
+    PooledAllocator() noexcept = default;
+
+    template <typename U>
+    PooledAllocator(const PooledAllocator<U>&) noexcept {
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(BlockPool::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        BlockPool::Deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PooledAllocator<U>&) const noexcept {
+        return true;
+    }
+};
+
+}  // namespace http_server
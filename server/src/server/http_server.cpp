@@ -1,6 +1,9 @@
 #include "http_server.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <sys/sendfile.h>
+
+#include <cerrno>
 #include <iostream>
 #include "../logging/logger.h"
 
@@ -13,45 +16,318 @@ namespace http_server {
             {"text", ec.message()},
             {"where", what}
         };
-        LogJson(data, "error"sv);
+        LogJson(data, "error"sv, LogLevel::kError);
+    }
+
+    SessionBase::SessionBase(SessionSocket&& socket, std::shared_ptr<const SessionContext> context, size_t object_size)
+        : object_size_(object_size)
+        , context_(std::move(context))
+        , socket_(std::move(socket)) {
+        beast::error_code ec;
+        remote_endpoint_ = ToTcpEndpoint(socket_.remote_endpoint(ec));
+        if(context_->stats) {
+            context_->stats->AddConnection(object_size_);
+        }
+    }
+
+    SessionBase::~SessionBase() {
+        if(context_->stats) {
+            context_->stats->RemoveConnection(object_size_);
+            context_->stats->AddBufferBytes(-static_cast<int64_t>(buffer_bytes_));
+            if(is_idle_) {
+                context_->stats->AddIdle(-1);
+            }
+        }
     }
 
     void SessionBase::Run() {
-        net::dispatch(stream_.get_executor(), beast::bind_front_handler(&SessionBase::Read, GetSharedThis()));
+        TimerWheel::Attach(GetSharedThis());
+        net::dispatch(socket_.get_executor(), beast::bind_front_handler(&SessionBase::Read, GetSharedThis()));
     }
 
     void SessionBase::Read() {
-        request_ = {};
-        stream_.expires_after(30s);
-        http::async_read(stream_, buffer_, request_, beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+        // Для keep-alive соединения участок включает ожидание следующего запроса клиента
+        read_start_ns_ = tracing::IsEnabled() ? tracing::SpanRecorder::NowNs() : 0;
+        is_reading_ = true;
+        ArmIdleTimeout();
+        if(buffer_.size() != 0) {
+            return ReadRequest();
+        }
+        // Данных нет: до их прихода сессия не держит состояние разбора
+        is_waiting_ = true;
+        if(next_write_id_ == next_request_id_) {
+            EnterIdle();
+        }
+        socket_.async_wait(tcp::socket::wait_read, beast::bind_front_handler(&SessionBase::OnReadable, GetSharedThis()));
+    }
+
+    void SessionBase::OnReadable(beast::error_code ec) {
+        is_waiting_ = false;
+        if(is_idle_) {
+            is_idle_ = false;
+            if(context_->stats) {
+                context_->stats->AddIdle(-1);
+            }
+        }
+        if(is_closed_) {
+            is_reading_ = false;
+            return;
+        }
+        if(ec) {
+            is_reading_ = false;
+            is_read_closed_ = true;
+            return ReportError(ec, "read"sv);
+        }
+        ReadRequest();
+    }
+
+    void SessionBase::EnterIdle() {
+        request_.reset();
+        arena_.Release();
+        buffer_.shrink_to_fit();
+        UpdateBufferStats();
+        is_idle_ = true;
+        if(context_->stats) {
+            context_->stats->AddIdle(1);
+        }
+    }
+
+    void SessionBase::ReadRequest() {
+        request_.reset();
+        if(next_write_id_ == next_request_id_) {
+            // Конвейер пуст: прошлые запросы и ответы разрушены, память арены используется заново
+            arena_.Reset();
+            requests_since_reset_ = 0;
+        }
+        request_.emplace(std::piecewise_construct, std::make_tuple(arena_.GetAllocator()), std::make_tuple(arena_.GetAllocator()));
+        http::async_read(socket_, buffer_, *request_, beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
     }
 
     void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+        is_reading_ = false;
+        if(read_start_ns_ != 0) {
+            tracing::SpanRecorder::Instance().RecordAsync("http", "read_request", read_start_ns_, tracing::SpanRecorder::NowNs());
+        }
+        UpdateBufferStats();
+        if(is_closed_) {
+            return;
+        }
         if(ec == http::error::end_of_stream) {
-            return Close();
+            // Ответы на уже прочитанные запросы дописываются, затем соединение закрывается
+            is_read_closed_ = true;
+            if(next_write_id_ == next_request_id_) {
+                Close();
+            }
+            return;
         }
 
         if(ec) {
+            is_read_closed_ = true;
             return ReportError(ec, "read"sv);
         }
 
-        HandleRequest(std::move(request_));
+        // Ответ на запрос без keep-alive закроет соединение: следующие запросы не читаются
+        is_read_closed_ = !request_->keep_alive();
+        ++requests_since_reset_;
+        HandleRequest(next_request_id_++, std::move(*request_));
+        ReadNext();
     }
 
-    void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]]std::size_t bytes_written) {
-        if(ec) {
-            return ReportError(ec, "write"sv);
+    void SessionBase::ReadNext() {
+        if(is_reading_ || is_read_closed_) {
+            return;
         }
-        if(close) {
-            return Close();
+        const uint64_t pending = next_request_id_ - next_write_id_;
+        if(pending >= max_pipeline_depth || (pending != 0 && requests_since_reset_ >= max_requests_per_arena)) {
+            return;
         }
         Read();
     }
 
+    void SessionBase::Write(uint64_t id, http::response<SendfileBody>&& response) {
+        net::dispatch(socket_.get_executor(), [self = GetSharedThis(), id, response = std::move(response)]() mutable {
+            self->Enqueue(id, std::allocate_shared<FileWrite>(self->arena_.GetAllocator<FileWrite>(), std::move(response)));
+        });
+    }
+
+    void SessionBase::Enqueue(uint64_t id, std::shared_ptr<QueuedResponse> response) {
+        GetSlot(id) = std::move(response);
+        WriteQueued();
+    }
+
+    void SessionBase::WriteQueued() {
+        if(is_writing_ || is_closed_ || next_write_id_ == next_request_id_ || !GetSlot(next_write_id_)) {
+            return;
+        }
+        is_writing_ = true;
+        write_start_ns_ = tracing::IsEnabled() ? tracing::SpanRecorder::NowNs() : 0;
+        if(GetSlot(next_write_id_)->is_file) {
+            return WriteFile(static_cast<FileWrite&>(*GetSlot(next_write_id_)));
+        }
+        // Готовые подряд ответы собираются в одну запись; файл и ответ, не готовый
+        // или не умещающийся в одну порцию, её завершают
+        write_buffers_.clear();
+        batch_size_ = 0;
+        for(uint64_t id = next_write_id_; id != next_request_id_; ++id) {
+            QueuedResponse* response = GetSlot(id).get();
+            if(!response || response->is_file) {
+                break;
+            }
+            auto& buffered = static_cast<BufferedResponse&>(*response);
+            beast::error_code ec;
+            batch_bytes_[batch_size_++] = buffered.Prepare(write_buffers_, ec);
+            if(ec) {
+                return FailWrite(ec);
+            }
+            if(!buffered.single_piece || buffered.need_eof) {
+                break;
+            }
+        }
+        ArmIdleTimeout();
+        net::async_write(socket_, write_buffers_, beast::bind_front_handler(&SessionBase::OnWriteQueued, GetSharedThis()));
+    }
+
+    void SessionBase::OnWriteQueued(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+        if(write_start_ns_ != 0) {
+            tracing::SpanRecorder::Instance().RecordAsync("http", "write_response", write_start_ns_, tracing::SpanRecorder::NowNs(),
+                                                          batch_size_ > 1 ? "coalesced" : nullptr);
+        }
+        if(ec) {
+            return FailWrite(ec);
+        }
+        is_writing_ = false;
+        for(size_t i = 0; i < batch_size_; ++i) {
+            if(!static_cast<BufferedResponse&>(*GetSlot(next_write_id_)).Consume(batch_bytes_[i])) {
+                // Остаток тела уйдёт следующей записью
+                break;
+            }
+            if(!PopWrittenResponse()) {
+                return;
+            }
+        }
+        ContinueAfterWrite();
+    }
+
+    void SessionBase::ContinueAfterWrite() {
+        WriteQueued();
+        if(is_waiting_ && !is_idle_ && next_write_id_ == next_request_id_) {
+            // Все ответы записаны, пока сессия ждёт данных от клиента
+            EnterIdle();
+        }
+        ReadNext();
+    }
+
+    bool SessionBase::PopWrittenResponse() {
+        std::shared_ptr<QueuedResponse>& slot = GetSlot(next_write_id_);
+        const bool need_eof = slot->need_eof;
+        slot.reset();
+        ++next_write_id_;
+        if(need_eof || (is_read_closed_ && next_write_id_ == next_request_id_)) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void SessionBase::FailWrite(beast::error_code ec) {
+        if(is_closed_) {
+            // Запись прервана закрытием соединения по таймауту
+            return;
+        }
+        // Остальные ответы не отправляются, ожидающее чтение отменяется
+        is_closed_ = true;
+        is_read_closed_ = true;
+        beast::error_code cancel_ec;
+        socket_.cancel(cancel_ec);
+        ReportError(ec, "write"sv);
+    }
+
+    void SessionBase::WriteFile(FileWrite& write) {
+        write.serializer.split(true);
+        ArmIdleTimeout();
+        http::async_write_header(socket_, write.serializer,
+                            [self = GetSharedThis(), &write](beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+                                self->OnWriteFileHeader(write, ec);
+                            });
+    }
+
+    void SessionBase::OnWriteFileHeader(FileWrite& write, beast::error_code ec) {
+        if(ec || write.remaining == 0) {
+            return FinishFileWrite(ec);
+        }
+        // sendfile пишет в сокет напрямую и должен получать EAGAIN, а не блокироваться
+        socket_.native_non_blocking(true, ec);
+        if(ec) {
+            return FinishFileWrite(ec);
+        }
+        SendFile(write);
+    }
+
+    void SessionBase::SendFile(FileWrite& write) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(write.remaining, max_sendfile_chunk));
+        off_t offset = static_cast<off_t>(write.offset);
+        const ssize_t sent = ::sendfile(socket_.native_handle(), write.response.body().GetNativeHandle(), &offset, chunk);
+        if(sent < 0 && errno != EAGAIN && errno != EINTR) {
+            const int error = errno;
+            if((error == EINVAL || error == ENOSYS) && write.offset == write.response.body().GetOffset()) {
+                // Файловая система не поддерживает sendfile: тело пишется через writer с чтением файла
+                return http::async_write(socket_, write.serializer,
+                            [self = GetSharedThis()](beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+                                self->FinishFileWrite(ec);
+                            });
+            }
+            return FinishFileWrite(beast::error_code(error, sys::system_category()));
+        }
+        if(sent == 0 && chunk != 0) {
+            // Файл стал короче, чем было объявлено в Content-Length
+            return FinishFileWrite(http::error::short_read);
+        }
+        if(sent > 0) {
+            write.offset += static_cast<uint64_t>(sent);
+            write.remaining -= static_cast<uint64_t>(sent);
+        }
+        if(write.remaining == 0) {
+            return FinishFileWrite({});
+        }
+        // Следующая порция - когда в буфере сокета появится место. Между порциями
+        // поток выполняет другие обработчики
+        socket_.async_wait(tcp::socket::wait_write,
+                            [self = GetSharedThis(), &write](beast::error_code ec) {
+                                if(ec) {
+                                    return self->FinishFileWrite(ec);
+                                }
+                                self->ArmIdleTimeout();
+                                self->SendFile(write);
+                            });
+    }
+
+    void SessionBase::FinishFileWrite(beast::error_code ec) {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+        // Для сокета в неблокирующем режиме io_uring-бэкенд Asio выполняет каждое чтение
+        // как poll и отдельный системный вызов. Режим возвращается, чтобы следующие запросы
+        // соединения снова читались одной операцией io_uring
+        beast::error_code mode_ec;
+        socket_.native_non_blocking(false, mode_ec);
+#endif
+        if(write_start_ns_ != 0) {
+            tracing::SpanRecorder::Instance().RecordAsync("http", "write_response", write_start_ns_, tracing::SpanRecorder::NowNs(), "sendfile");
+        }
+        if(ec) {
+            return FailWrite(ec);
+        }
+        is_writing_ = false;
+        if(!PopWrittenResponse()) {
+            return;
+        }
+        ContinueAfterWrite();
+    }
+
     void SessionBase::Close() {
+        is_closed_ = true;
+        is_read_closed_ = true;
         beast::error_code ec;
-        if(stream_.socket().is_open()){
-            stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+        if(socket_.is_open()){
+            socket_.shutdown(tcp::socket::shutdown_send, ec);
             if(ec) {
                 return ReportError(ec, "Socket Shutdown"sv);
             }
@@ -59,4 +335,39 @@ namespace http_server {
 
     }
 
+    void SessionBase::OnExpired() {
+        net::dispatch(socket_.get_executor(), beast::bind_front_handler(&SessionBase::OnIdleTimeout, GetSharedThis()));
+    }
+
+    void SessionBase::OnIdleTimeout() {
+        if(IsArmed() || !socket_.is_open()) {
+            // Срок продлён, пока уведомление шло в strand
+            return;
+        }
+        if(!is_writing_ && next_write_id_ != next_request_id_) {
+            // Ответ ещё готовит обработчик: соединение не простаивает
+            return ArmIdleTimeout();
+        }
+        // Клиент не присылает запрос или не читает ответ. Ожидающие операции завершатся
+        // с operation_aborted; это не ошибка и в журнал не пишется
+        is_closed_ = true;
+        is_read_closed_ = true;
+        if(context_->stats) {
+            context_->stats->AddTimeout();
+        }
+        beast::error_code ec;
+        socket_.close(ec);
+    }
+
+    void SessionBase::UpdateBufferStats() {
+        const size_t buffer_bytes = arena_.GetHeldBytes() + buffer_.capacity();
+        if(buffer_bytes == buffer_bytes_) {
+            return;
+        }
+        if(context_->stats) {
+            context_->stats->AddBufferBytes(static_cast<int64_t>(buffer_bytes) - static_cast<int64_t>(buffer_bytes_));
+        }
+        buffer_bytes_ = buffer_bytes;
+    }
+
 }  // namespace http_server
@@ -3,11 +3,31 @@
 // boost.beast будет использовать std::string_view вместо boost::string_view
 //#define BOOST_BEAST_USE_STD_STRING_VIEW
 
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "block_pool.h"
+#include "listen_address.h"
+#include "request_arena.h"
+#include "sendfile_body.h"
+#include "shared_buffer_body.h"
+#include "timer_wheel.h"
+#include "../tracing/span_recorder.h"
+
 namespace http_server {
 
 namespace net = boost::asio;
@@ -19,53 +39,275 @@ namespace sys = boost::system;
 
 void ReportError(beast::error_code ec, std::string_view what);
 
-class SessionBase {
+// Механизм асинхронного ввода-вывода, с которым собран сервер (CMake-опция GAME_IO_URING)
+constexpr std::string_view GetIoBackendName() noexcept {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+    return "io_uring"sv;
+#else
+    return "epoll"sv;
+#endif
+}
+
+// Конкретный тип исполнителя вместо any_io_executor: копирование стирающей тип обёртки
+// со strand внутри выделяет память в каждой асинхронной операции
+using SessionExecutor = net::strand<net::io_context::executor_type>;
+// Таймауты соединений ведёт TimerWheel, поэтому вместо beast::basic_stream с двумя
+// таймерами на соединение - обычный сокет. Протокол обобщённый: TCP или AF_UNIX
+using SessionSocket = net::basic_stream_socket<net::generic::stream_protocol, SessionExecutor>;
+
+// Соединения и память, которую они держат, для /metrics
+class ConnectionStats {
+public:
+    void AddConnection(size_t object_bytes) noexcept {
+        connections_.fetch_add(1, std::memory_order_relaxed);
+        object_bytes_.fetch_add(static_cast<int64_t>(object_bytes), std::memory_order_relaxed);
+    }
+
+    void RemoveConnection(size_t object_bytes) noexcept {
+        connections_.fetch_sub(1, std::memory_order_relaxed);
+        object_bytes_.fetch_sub(static_cast<int64_t>(object_bytes), std::memory_order_relaxed);
+    }
+
+    // Соединение ждёт следующего запроса и не держит буферов
+    void AddIdle(int64_t delta) noexcept {
+        idle_connections_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // Буферы чтения и блоки арен соединений
+    void AddBufferBytes(int64_t delta) noexcept {
+        buffer_bytes_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    void AddTimeout() noexcept {
+        timeouts_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int64_t GetConnections() const noexcept {
+        return connections_.load(std::memory_order_relaxed);
+    }
+
+    int64_t GetIdleConnections() const noexcept {
+        return idle_connections_.load(std::memory_order_relaxed);
+    }
+
+    int64_t GetObjectBytes() const noexcept {
+        return object_bytes_.load(std::memory_order_relaxed);
+    }
+
+    int64_t GetBufferBytes() const noexcept {
+        return buffer_bytes_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetTimeouts() const noexcept {
+        return timeouts_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> connections_{0};
+    std::atomic<int64_t> idle_connections_{0};
+    std::atomic<int64_t> object_bytes_{0};
+    std::atomic<int64_t> buffer_bytes_{0};
+    std::atomic<uint64_t> timeouts_{0};
+};
+
+// Общее для соединений одного Listener
+struct SessionContext {
+    std::shared_ptr<TimerWheel> timeouts;
+    TimerWheel::Clock::duration idle_timeout;
+    std::shared_ptr<ConnectionStats> stats;     // может быть nullptr
+};
+
+// Соединение HTTP/1.1 с конвейерной обработкой: следующие запросы разбираются, пока
+// ответы на предыдущие ещё готовятся или пишутся. Ответы отправляются строго в порядке
+// запросов; готовые подряд ответы с телом в памяти уходят в сокет одной записью
+class SessionBase : public TimerWheel::Timer {
 public:
     SessionBase(const SessionBase&) = delete;
     SessionBase& operator=(const SessionBase&) = delete;
 
     void Run();
 protected:
-    explicit SessionBase(tcp::socket&& socket)
-        : stream_(std::move(socket)) {
+    // object_size - размер объекта сессии для ConnectionStats
+    SessionBase(SessionSocket&& socket, std::shared_ptr<const SessionContext> context, size_t object_size);
 
-        }
-    using HttpRequest = http::request<http::string_body>;
-    ~SessionBase() = default;
+    using HttpRequest = ArenaRequest;
+    ~SessionBase();
 
+    // Ответ на запрос с номером id из HandleRequest. Может вызываться вне strand соединения:
+    // ответ передаётся в strand и размещается в арене уже там
     template <typename Body, typename Fields>
-    void Write(http::response<Body, Fields>&& response){
-        auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
-        auto self = GetSharedThis();
-        http::async_write(stream_, *safe_response,
-                            [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                                self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                            });
+    void Write(uint64_t id, http::response<Body, Fields>&& response) {
+        net::dispatch(socket_.get_executor(), [self = GetSharedThis(), id, response = std::move(response)]() mutable {
+            using Queued = SerializedResponse<Body, Fields>;
+            self->Enqueue(id, std::allocate_shared<Queued>(self->arena_.GetAllocator<Queued>(), std::move(response)));
+        });
+    }
+
+    // Тело-файл отправляется через sendfile: заголовок пишется как обычно, затем файл
+    // уходит в сокет порциями между ожиданиями готовности сокета к записи
+    void Write(uint64_t id, http::response<SendfileBody>&& response);
+
+    // Адрес клиента запоминается при подключении; у соединений через AF_UNIX он пустой
+    const tcp::endpoint& GetRemoteEndpoint() const noexcept {
+        return remote_endpoint_;
     }
 
 private:
+    // Без непрочитанных данных сессия сначала ждёт готовности сокета к чтению. Если при
+    // этом все ответы записаны, соединение простаивает: буфер чтения и арена
+    // возвращаются в BlockPool
     void Read();
+    void OnReadable(beast::error_code ec);
+    void EnterIdle();
+    void ReadRequest();
     void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
-    void OnWrite(bool close, beast::error_code ec, [[maybe_unused]]std::size_t bytes_written);
+    // Читает следующий запрос, если конвейер не заполнен
+    void ReadNext();
     void Close();
 
-    virtual void HandleRequest(HttpRequest&& request) = 0;
+    // Срок простоя отсчитывается заново при каждом чтении и записи
+    void ArmIdleTimeout() {
+        context_->timeouts->Arm(*this, context_->idle_timeout);
+    }
+    void OnExpired() override;
+    void OnIdleTimeout();
+    // Сообщает ConnectionStats, сколько памяти буферов держит соединение
+    void UpdateBufferStats();
+
+    // На каждый запрос обработчик вызывает Write с тем же id ровно один раз
+    virtual void HandleRequest(uint64_t id, HttpRequest&& request) = 0;
+
+    // Сколько запросов соединения может ждать ответа одновременно
+    static constexpr size_t max_pipeline_depth = 8;
+    // Арена сбрасывается, только когда конвейер пуст. Если клиент не даёт ему опустеть,
+    // после стольких запросов чтение приостанавливается до записи всех ответов
+    static constexpr size_t max_requests_per_arena = 64;
+    // Порция sendfile за один вызов: большой файл не занимает поток надолго
+    static constexpr size_t max_sendfile_chunk = 1024 * 1024;
+
+    struct QueuedResponse {
+        virtual ~QueuedResponse() = default;
+
+        bool need_eof = false;
+        // FileWrite: пишется отдельно от остальных ответов
+        bool is_file = false;
+    };
+
+    struct BufferedResponse : QueuedResponse {
+        // Добавляет в buffers очередную порцию ответа и возвращает её размер
+        virtual size_t Prepare(std::vector<net::const_buffer>& buffers, beast::error_code& ec) = 0;
+        // true - ответ записан целиком
+        virtual bool Consume(size_t bytes) = 0;
+
+        // Заголовок и тело отдаются одной порцией: следом в той же записи
+        // может идти следующий ответ
+        bool single_piece = false;
+    };
+
+    template <typename Body, typename Fields>
+    struct SerializedResponse final : BufferedResponse {
+        explicit SerializedResponse(http::response<Body, Fields>&& response_to_write)
+            : response(std::move(response_to_write))
+            , serializer(response) {
+            need_eof = response.need_eof();
+            single_piece = std::is_same_v<Body, http::string_body> || std::is_same_v<Body, SharedBufferBody>;
+        }
+
+        size_t Prepare(std::vector<net::const_buffer>& buffers, beast::error_code& ec) override {
+            size_t size = 0;
+            serializer.next(ec, [&buffers, &size](beast::error_code&, const auto& sequence) {
+                for(const net::const_buffer buffer : beast::buffers_range_ref(sequence)) {
+                    buffers.push_back(buffer);
+                    size += buffer.size();
+                }
+            });
+            return size;
+        }
+
+        bool Consume(size_t bytes) override {
+            serializer.consume(bytes);
+            return serializer.is_done();
+        }
+
+        http::response<Body, Fields> response;
+        http::response_serializer<Body, Fields> serializer;
+    };
+
+    struct FileWrite final : QueuedResponse {
+        explicit FileWrite(http::response<SendfileBody>&& response_to_write)
+            : response(std::move(response_to_write))
+            , serializer(response)
+            , offset(response.body().GetOffset())
+            , remaining(response.body().GetSize()) {
+            need_eof = response.need_eof();
+            is_file = true;
+        }
+
+        http::response<SendfileBody> response;
+        http::response_serializer<SendfileBody> serializer;
+        uint64_t offset = 0;
+        uint64_t remaining = 0;
+    };
+
+    // Ответ на запрос id готов; пишется, когда записаны ответы на все предыдущие
+    void Enqueue(uint64_t id, std::shared_ptr<QueuedResponse> response);
+    // Начинает запись готовых ответов с самого раннего
+    void WriteQueued();
+    void OnWriteQueued(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+    void ContinueAfterWrite();
+    // Ответ на самый ранний запрос записан. false - соединение закрывается
+    bool PopWrittenResponse();
+    void FailWrite(beast::error_code ec);
+
+    void WriteFile(FileWrite& write);
+    void OnWriteFileHeader(FileWrite& write, beast::error_code ec);
+    void SendFile(FileWrite& write);
+    void FinishFileWrite(beast::error_code ec);
+
+    std::shared_ptr<QueuedResponse>& GetSlot(uint64_t id) noexcept {
+        return pipeline_[id % max_pipeline_depth];
+    }
 
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
 
-    
-    beast::flat_buffer buffer_;
-    HttpRequest request_;
+    // Арена объявлена первой: размещённые в ней объекты разрушаются раньше неё.
+    // Состояния асинхронных операций в ней не размещаются: чтение и запись идут
+    // одновременно, и завершение одной ставится в strand из другого потока, пока
+    // strand выделяет память для другой. Их память берётся из кэша потока Asio
+    RequestArena arena_;
+    beast::basic_flat_buffer<PooledAllocator<char>> buffer_;
+    std::optional<HttpRequest> request_;
+    // Ответы по номерам запросов; nullptr - ответ ещё не готов
+    std::array<std::shared_ptr<QueuedResponse>, max_pipeline_depth> pipeline_;
+    uint64_t next_request_id_ = 0;      // номер следующего прочитанного запроса
+    uint64_t next_write_id_ = 0;        // самый ранний запрос без записанного ответа
+    size_t requests_since_reset_ = 0;
+    // Порции ответов текущей записи
+    std::vector<net::const_buffer> write_buffers_;
+    std::array<size_t, max_pipeline_depth> batch_bytes_{};
+    size_t batch_size_ = 0;
+    bool is_reading_ = false;           // ожидание данных или чтение запроса
+    bool is_waiting_ = false;           // ожидание готовности сокета к чтению
+    bool is_writing_ = false;
+    bool is_read_closed_ = false;       // следующие запросы не читаются
+    bool is_closed_ = false;            // ответы больше не пишутся
+    bool is_idle_ = false;
+    uint64_t read_start_ns_ = 0;
+    uint64_t write_start_ns_ = 0;
+    size_t buffer_bytes_ = 0;           // учтено в ConnectionStats
+    const size_t object_size_;
+    std::shared_ptr<const SessionContext> context_;
+    tcp::endpoint remote_endpoint_;
 protected:
-    beast::tcp_stream stream_;
+    SessionSocket socket_;
 };
 
 template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
 public:
     template<typename Handler>
-    Session(tcp::socket&& socket, Handler&& request_handler)
-        : SessionBase(std::move(socket))
+    Session(SessionSocket&& socket, std::shared_ptr<const SessionContext> context, Handler&& request_handler)
+        : SessionBase(std::move(socket), std::move(context), sizeof(Session))
         , request_handler_(std::forward<Handler>(request_handler)) {
             
         }
@@ -75,59 +317,182 @@ private:
         return this->shared_from_this();
     }
 
-    void HandleRequest(HttpRequest&& request) override {
-        request_handler_(stream_.socket().remote_endpoint(), std::move(request), [self = this->shared_from_this()] (auto&& response) {
-            self->Write(std::move(response));
+    void HandleRequest(uint64_t id, HttpRequest&& request) override {
+        request_handler_(GetRemoteEndpoint(), std::move(request), [self = this->shared_from_this(), id] (auto&& response) {
+            self->Write(id, std::move(response));
         });
     }
 
     RequestHandler request_handler_;
 };
 
+// Счётчики принятых соединений по акцепторам Listener, для /metrics
+class AcceptStats {
+public:
+    explicit AcceptStats(size_t acceptors)
+        : accepted_(std::max<size_t>(1, acceptors))
+        , errors_(std::max<size_t>(1, acceptors)) {
+    }
+
+    void AddAccepted(size_t acceptor) noexcept {
+        accepted_[acceptor].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AddError(size_t acceptor) noexcept {
+        errors_[acceptor].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t GetAcceptorsCount() const noexcept {
+        return accepted_.size();
+    }
+
+    uint64_t GetAccepted(size_t acceptor) const noexcept {
+        return accepted_[acceptor].load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetErrors(size_t acceptor) const noexcept {
+        return errors_[acceptor].load(std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<std::atomic<uint64_t>> accepted_;
+    std::vector<std::atomic<uint64_t>> errors_;
+};
+
+struct ListenOptions {
+    // Больше одного - каждый акцептор открывается с SO_REUSEPORT на тот же адрес,
+    // и ядро само распределяет между ними новые соединения
+    size_t acceptors = 1;
+    // Сколько async_accept одновременно ожидает на каждом акцепторе
+    size_t pending_accepts = 1;
+    // Может быть nullptr; иначе рассчитана не меньше чем на acceptors акцепторов
+    std::shared_ptr<AcceptStats> stats;
+    // Соединение закрывается, если столько времени клиент не присылает запрос
+    // или не читает ответ
+    std::chrono::seconds idle_timeout = 30s;
+    // Может быть nullptr
+    std::shared_ptr<ConnectionStats> connection_stats;
+};
+
+// Акцепторы одного io_context. Принятые соединения по кругу распределяются по
+// session_contexts, а их таймауты ведёт общее для них TimerWheel. Все объекты
+// Listener привязаны к io_context и разрушаются вместе с ним
 template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
 public:
+    // Открывает acceptors_count акцепторов; в AcceptStats они учитываются под номерами
+    // начиная с first_acceptor
     template <typename Handler>
-    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+    Listener(net::io_context& ioc, std::vector<net::io_context*> session_contexts, const ListenEndpoint& endpoint,
+             const ListenOptions& options, size_t first_acceptor, size_t acceptors_count, Handler&& request_handler)
         : ioc_(ioc)
-        , acceptor_(net::make_strand(ioc))
+        , session_contexts_(std::move(session_contexts))
+        , first_acceptor_(first_acceptor)
+        , pending_accepts_(std::max<size_t>(1, options.pending_accepts))
+        , stats_(options.stats)
+        , timeouts_(std::make_shared<TimerWheel>(ioc, timeout_tick, timeout_slots))
+        , session_context_(std::make_shared<const SessionContext>(SessionContext{timeouts_, options.idle_timeout, options.connection_stats}))
         , request_handler_(std::forward<Handler>(request_handler)) {
-            acceptor_.open(endpoint.protocol());
-            acceptor_.set_option(net::socket_base::reuse_address(true));
-            acceptor_.bind(endpoint);
-            acceptor_.listen(net::socket_base::max_listen_connections);
+            RemoveStaleUnixSocket(endpoint);
+            acceptors_.reserve(acceptors_count);
+            for(size_t i = 0; i < acceptors_count; ++i) {
+                // Каждый акцептор в своём strand: ожидающие accept разных акцепторов
+                // завершаются параллельно на разных потоках
+                Acceptor& acceptor = acceptors_.emplace_back(net::make_strand(ioc));
+                acceptor.open(endpoint.protocol());
+                acceptor.set_option(net::socket_base::reuse_address(true));
+                if(options.acceptors > 1) {
+                    acceptor.set_option(ReusePort(true));
+                }
+                acceptor.bind(endpoint);
+                acceptor.listen(net::socket_base::max_listen_connections);
+            }
         }
     
     void Run() {
-        DoAccept();
+        timeouts_->Start();
+        for(size_t index = 0; index < acceptors_.size(); ++index) {
+            for(size_t i = 0; i < pending_accepts_; ++i) {
+                DoAccept(index);
+            }
+        }
     }
     
 private:
+    using Acceptor = net::basic_socket_acceptor<net::generic::stream_protocol>;
+    using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
 
-    void DoAccept() {
-        acceptor_.async_accept(net::make_strand(ioc_), beast::bind_front_handler(&Listener::OnAccept, this->shared_from_this()));
+    // Таймауты соединений отмеряются с точностью до секунды
+    static constexpr auto timeout_tick = 1s;
+    static constexpr size_t timeout_slots = 64;
+
+    void DoAccept(size_t index) {
+        net::io_context& session_context = session_contexts_.size() == 1
+            ? *session_contexts_.front()
+            : *session_contexts_[next_session_context_.fetch_add(1, std::memory_order_relaxed) % session_contexts_.size()];
+        acceptors_[index].async_accept(net::make_strand(session_context), beast::bind_front_handler(&Listener::OnAccept, this->shared_from_this(), index));
     }
 
-    void OnAccept(sys::error_code ec, tcp::socket socket) {
+    void OnAccept(size_t index, sys::error_code ec, SessionSocket socket) {
         if(ec) {
+            if(stats_) {
+                stats_->AddError(first_acceptor_ + index);
+            }
             return ReportError(ec, "accept"sv);
         }
+        if(stats_) {
+            stats_->AddAccepted(first_acceptor_ + index);
+        }
         AsyncRunSession(std::move(socket));
-        DoAccept();
+        DoAccept(index);
     }
 
-    void AsyncRunSession(tcp::socket&& socket) {
-        std::make_shared<Session<RequestHandler>>(std::move(socket), std::move(request_handler_))->Run();
+    void AsyncRunSession(SessionSocket&& socket) {
+        // Обработчик копируется: сессии создаются из разных strand одновременно
+        std::make_shared<Session<RequestHandler>>(std::move(socket), session_context_, request_handler_)->Run();
     }
     net::io_context& ioc_;
-    tcp::acceptor acceptor_;
-    RequestHandler request_handler_;
+    const std::vector<net::io_context*> session_contexts_;
+    std::atomic<size_t> next_session_context_{0};
+    std::vector<Acceptor> acceptors_;
+    const size_t first_acceptor_;
+    const size_t pending_accepts_;
+    std::shared_ptr<AcceptStats> stats_;
+    std::shared_ptr<TimerWheel> timeouts_;
+    std::shared_ptr<const SessionContext> session_context_;
+    const RequestHandler request_handler_;
 };
 
+// TCP: акцепторы распределяются по contexts по кругу, у каждого io_context свой Listener.
+// AF_UNIX: путь нельзя открыть несколькими акцепторами, поэтому единственный акцептор
+// в contexts.front() раздаёт соединения по всем contexts; contexts.front() должен
+// разрушаться раньше остальных - его ожидающие accept держат их strand
 template <typename RequestHandler>
-void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
+void ServeHttp(const std::vector<net::io_context*>& contexts, const ListenEndpoint& endpoint, const ListenOptions& options, RequestHandler&& handler) {
     using MyListener = Listener<std::decay_t<RequestHandler>>;
-    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+    if(endpoint.protocol().family() == AF_UNIX) {
+        ListenOptions unix_options = options;
+        unix_options.acceptors = 1;
+        std::make_shared<MyListener>(*contexts.front(), contexts, endpoint, unix_options, 0, 1, handler)->Run();
+        return;
+    }
+    const size_t acceptors = std::max<size_t>(1, options.acceptors);
+    size_t first_acceptor = 0;
+    for(size_t i = 0; i < contexts.size() && first_acceptor < acceptors; ++i) {
+        const size_t count = acceptors / contexts.size() + (i < acceptors % contexts.size() ? 1 : 0);
+        std::make_shared<MyListener>(*contexts[i], std::vector<net::io_context*>{contexts[i]}, endpoint, options, first_acceptor, count, handler)->Run();
+        first_acceptor += count;
+    }
+}
+
+template <typename RequestHandler>
+void ServeHttp(net::io_context& ioc, const ListenEndpoint& endpoint, const ListenOptions& options, RequestHandler&& handler) {
+    ServeHttp(std::vector<net::io_context*>{&ioc}, endpoint, options, std::forward<RequestHandler>(handler));
+}
+
+template <typename RequestHandler>
+void ServeHttp(net::io_context& ioc, const ListenEndpoint& endpoint, RequestHandler&& handler) {
+    ServeHttp(ioc, endpoint, ListenOptions{}, std::forward<RequestHandler>(handler));
 }
 
 }  // namespace http_server
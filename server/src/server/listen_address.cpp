@@ -0,0 +1,101 @@
+#include "listen_address.h"
+
+#include <boost/asio/local/stream_protocol.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::string_view tcp_scheme = "tcp://"sv;
+constexpr std::string_view unix_scheme = "unix://"sv;
+
+ListenEndpoint ParseTcpEndpoint(std::string_view address, std::string_view host_port) {
+    const size_t colon = host_port.rfind(':');
+    if(colon == std::string_view::npos) {
+        throw std::invalid_argument("Listen address without port: "s + std::string(address));
+    }
+    std::string_view host = host_port.substr(0, colon);
+    const std::string_view port_text = host_port.substr(colon + 1);
+    if(host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);
+    } else if(host.find(':') != std::string_view::npos) {
+        throw std::invalid_argument("IPv6 address must be in brackets: "s + std::string(address));
+    }
+
+    unsigned port = 0;
+    const auto [end, ec] = std::from_chars(port_text.data(), port_text.data() + port_text.size(), port);
+    if(ec != std::errc{} || end != port_text.data() + port_text.size() || port > 65535) {
+        throw std::invalid_argument("Invalid port in listen address: "s + std::string(address));
+    }
+
+    boost::system::error_code address_ec;
+    const auto ip = net::ip::make_address(std::string(host), address_ec);
+    if(address_ec) {
+        throw std::invalid_argument("Invalid IP address in listen address: "s + std::string(address));
+    }
+    return tcp::endpoint(ip, static_cast<unsigned short>(port));
+}
+
+ListenEndpoint ParseUnixEndpoint(std::string_view address, std::string_view path) {
+    if(path.empty()) {
+        throw std::invalid_argument("Empty socket path in listen address: "s + std::string(address));
+    }
+    if(path.size() >= sizeof(sockaddr_un::sun_path)) {
+        throw std::invalid_argument("Socket path is too long: "s + std::string(address));
+    }
+    return net::local::stream_protocol::endpoint(path);
+}
+
+}  // namespace
+
+bool ListenAddress::IsUnix() const noexcept {
+    return endpoint.protocol().family() == AF_UNIX;
+}
+
+ListenAddress ParseListenAddress(std::string_view address) {
+    if(address.starts_with(tcp_scheme)) {
+        return {ParseTcpEndpoint(address, address.substr(tcp_scheme.size())), std::string(address)};
+    }
+    if(address.starts_with(unix_scheme)) {
+        return {ParseUnixEndpoint(address, address.substr(unix_scheme.size())), std::string(address)};
+    }
+    throw std::invalid_argument("Listen address must start with tcp:// or unix://: "s + std::string(address));
+}
+
+tcp::endpoint ToTcpEndpoint(const ListenEndpoint& endpoint) noexcept {
+    tcp::endpoint result;
+    const int family = endpoint.protocol().family();
+    if((family == AF_INET || family == AF_INET6) && endpoint.size() <= result.capacity()) {
+        std::memcpy(result.data(), endpoint.data(), endpoint.size());
+        result.resize(endpoint.size());
+    }
+    return result;
+}
+
+void RemoveStaleUnixSocket(const ListenEndpoint& endpoint) {
+    if(endpoint.protocol().family() != AF_UNIX) {
+        return;
+    }
+    const auto* address = reinterpret_cast<const sockaddr_un*>(endpoint.data());
+    const size_t max_length = endpoint.size() - offsetof(sockaddr_un, sun_path);
+    const std::string path(address->sun_path, strnlen(address->sun_path, max_length));
+    // Пустой путь - абстрактный сокет без файла
+    if(path.empty()) {
+        return;
+    }
+    std::error_code ec;
+    if(std::filesystem::is_socket(path, ec)) {
+        std::filesystem::remove(path, ec);
+    }
+}
+
+}  // namespace http_server
@@ -0,0 +1,35 @@
+#pragma once
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace http_server {
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+// Адрес любого потокового сокета: TCP или AF_UNIX
+using ListenEndpoint = net::generic::stream_protocol::endpoint;
+
+// Адрес, на котором сервер принимает соединения:
+//   tcp://HOST:PORT - HOST задаётся IPv4-адресом или IPv6-адресом в квадратных скобках
+//   unix://PATH     - сокет AF_UNIX; файл от прошлого запуска удаляется перед bind
+struct ListenAddress {
+    ListenEndpoint endpoint;
+    std::string name;           // запись в исходном виде, для журнала и метрик
+
+    bool IsUnix() const noexcept;
+};
+
+// Бросает std::invalid_argument, если адрес записан неверно
+ListenAddress ParseListenAddress(std::string_view address);
+
+// Адрес клиента TCP-соединения; для AF_UNIX - пустой tcp::endpoint
+tcp::endpoint ToTcpEndpoint(const ListenEndpoint& endpoint) noexcept;
+
+// Удаляет оставшийся от прошлого запуска файл сокета AF_UNIX; остальные адреса не трогает
+void RemoveStaleUnixSocket(const ListenEndpoint& endpoint);
+
+}  // namespace http_server
@@ -0,0 +1,46 @@
+#include "request_arena.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "block_pool.h"
+
+namespace http_server {
+
+RequestArena::~RequestArena() {
+    if(block_ != nullptr) {
+        FreeBlock();
+    }
+}
+
+void RequestArena::Reset() {
+    if(block_ != nullptr) {
+        resource_->release();
+        if(overflow_.GetAllocated() == 0 || block_size_ >= max_block_size) {
+            overflow_.TakeAllocated();
+            return;
+        }
+        FreeBlock();
+    }
+    block_ = BlockPool::Allocate(block_size_);
+    resource_.emplace(block_, block_size_, &overflow_);
+}
+
+void RequestArena::Release() {
+    if(block_ != nullptr) {
+        FreeBlock();
+    }
+}
+
+void RequestArena::FreeBlock() {
+    resource_.reset();
+    BlockPool::Deallocate(block_, block_size_);
+    block_ = nullptr;
+    // Следующий такой же запрос должен поместиться в основной блок
+    const std::size_t overflow = overflow_.TakeAllocated();
+    if(overflow != 0 && block_size_ < max_block_size) {
+        block_size_ = std::min(std::bit_ceil(block_size_ + overflow), max_block_size);
+    }
+}
+
+}  // namespace http_server
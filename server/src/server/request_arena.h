@@ -0,0 +1,138 @@
+#pragma once
+#include <boost/beast/http.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace http_server {
+
+namespace http = boost::beast::http;
+
+// Аллокатор поверх memory_resource. std::pmr::polymorphic_allocator не подходит:
+// basic_fields требует присваиваемый аллокатор. По умолчанию - обычная куча
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() noexcept = default;
+
+    explicit ArenaAllocator(std::pmr::memory_resource* resource) noexcept
+        : resource_(resource) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : resource_(other.GetResource()) {
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    std::pmr::memory_resource* GetResource() const noexcept {
+        return resource_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return resource_ == other.GetResource() || resource_->is_equal(*other.GetResource());
+    }
+
+private:
+    std::pmr::memory_resource* resource_ = std::pmr::new_delete_resource();
+};
+
+using ArenaStringBody = http::basic_string_body<char, std::char_traits<char>, ArenaAllocator<char>>;
+using ArenaFields = http::basic_fields<ArenaAllocator<char>>;
+// Запрос, заголовки и тело которого размещаются в арене соединения
+using ArenaRequest = http::request<ArenaStringBody, ArenaFields>;
+
+// Арена одного соединения: память запросов и ответов берётся из одного блока
+// и освобождается целиком, когда ответы на все прочитанные запросы записаны.
+// Если запрос не поместился, блок при сбросе увеличивается (до max_block_size), так что
+// на установившемся keep-alive потоке запросов куча не используется.
+// Пока соединение простаивает, блок возвращается в BlockPool.
+// Не потокобезопасна: память выделяется только в strand соединения
+class RequestArena {
+public:
+    static constexpr std::size_t initial_block_size = 4 * 1024;
+    static constexpr std::size_t max_block_size = 64 * 1024;
+
+    // Блок берётся при первом Reset
+    RequestArena() = default;
+    ~RequestArena();
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    // Только между Reset и Release
+    template <typename T = char>
+    ArenaAllocator<T> GetAllocator() noexcept {
+        return ArenaAllocator<T>(&*resource_);
+    }
+
+    // Все объекты, размещённые в арене, должны быть уже разрушены
+    void Reset();
+
+    // Возвращает блок в BlockPool; размер следующего блока сохраняется.
+    // Все объекты, размещённые в арене, должны быть уже разрушены
+    void Release();
+
+    std::size_t GetBlockSize() const noexcept {
+        return block_size_;
+    }
+
+    // Память, которую арена держит сейчас
+    std::size_t GetHeldBytes() const noexcept {
+        return block_ != nullptr ? block_size_ : 0;
+    }
+
+private:
+    // Считает память, выделенную сверх основного блока
+    class OverflowResource : public std::pmr::memory_resource {
+    public:
+        std::size_t GetAllocated() const noexcept {
+            return allocated_;
+        }
+
+        std::size_t TakeAllocated() noexcept {
+            return std::exchange(allocated_, 0);
+        }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            allocated_ += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::size_t allocated_ = 0;
+    };
+
+    // Освобождает блок и запоминает, каким он должен быть в следующий раз
+    void FreeBlock();
+
+    std::size_t block_size_ = initial_block_size;
+    void* block_ = nullptr;
+    OverflowResource overflow_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+}  // namespace http_server
@@ -0,0 +1,108 @@
+#pragma once
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace http_server {
+
+// Тело ответа - участок файла. SessionBase::Write отправляет его через sendfile, минуя
+// пространство пользователя; writer нужен для остальных случаев (например, если
+// sendfile не поддерживается файловой системой) и читает файл порциями
+struct SendfileBody {
+    class value_type {
+    public:
+        void Open(const char* path, boost::beast::error_code& ec) {
+            file_.open(path, boost::beast::file_mode::read, ec);
+            if(ec) {
+                return;
+            }
+            file_size_ = file_.size(ec);
+            offset_ = 0;
+            size_ = file_size_;
+        }
+
+        // Отправляется только [offset, offset + size), для ответа 206
+        void SetRange(std::uint64_t offset, std::uint64_t size) noexcept {
+            offset_ = std::min(offset, file_size_);
+            size_ = std::min(size, file_size_ - offset_);
+        }
+
+        bool IsOpen() const noexcept {
+            return file_.is_open();
+        }
+
+        int GetNativeHandle() const noexcept {
+            return file_.native_handle();
+        }
+
+        std::uint64_t GetFileSize() const noexcept {
+            return file_size_;
+        }
+
+        std::uint64_t GetOffset() const noexcept {
+            return offset_;
+        }
+
+        std::uint64_t GetSize() const noexcept {
+            return size_;
+        }
+
+        boost::beast::file& GetFile() noexcept {
+            return file_;
+        }
+
+    private:
+        boost::beast::file file_;
+        std::uint64_t file_size_ = 0;
+        std::uint64_t offset_ = 0;
+        std::uint64_t size_ = 0;
+    };
+
+    static std::uint64_t size(const value_type& body) noexcept {
+        return body.GetSize();
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, typename Fields>
+        writer(boost::beast::http::header<isRequest, Fields>&, value_type& body)
+            : body_(body) {
+        }
+
+        void init(boost::beast::error_code& ec) {
+            remaining_ = body_.GetSize();
+            body_.GetFile().seek(body_.GetOffset(), ec);
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& ec) {
+            const size_t amount = static_cast<size_t>(std::min<std::uint64_t>(remaining_, sizeof(buffer_)));
+            if(amount == 0) {
+                ec = {};
+                return boost::none;
+            }
+            const size_t read = body_.GetFile().read(buffer_, amount, ec);
+            if(ec) {
+                return boost::none;
+            }
+            if(read == 0) {
+                // Файл стал короче, чем было объявлено в Content-Length
+                ec = boost::beast::http::error::short_read;
+                return boost::none;
+            }
+            remaining_ -= read;
+            return {{const_buffers_type{buffer_, read}, remaining_ > 0}};
+        }
+
+    private:
+        value_type& body_;
+        std::uint64_t remaining_ = 0;
+        char buffer_[4096];
+    };
+};
+
+}  // namespace http_server
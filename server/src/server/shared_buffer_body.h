@@ -0,0 +1,47 @@
+#pragma once
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace http_server {
+
+// Тело ответа, разделяющее неизменяемый буфер между ответами (например, файл из кэша
+// статических ресурсов): буфер не копируется и пишется в сокет одним фрагментом
+struct SharedBufferBody {
+    using value_type = std::shared_ptr<const std::string>;
+
+    static std::uint64_t size(const value_type& body) noexcept {
+        return body ? body->size() : 0;
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, typename Fields>
+        writer(const boost::beast::http::header<isRequest, Fields>&, const value_type& body)
+            : body_(body) {
+        }
+
+        void init(boost::beast::error_code& ec) {
+            ec = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& ec) {
+            ec = {};
+            if(!body_ || body_->empty()) {
+                return boost::none;
+            }
+            return {{const_buffers_type{body_->data(), body_->size()}, false}};
+        }
+
+    private:
+        const value_type& body_;
+    };
+};
+
+}  // namespace http_server
@@ -0,0 +1,99 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+namespace http_server {
+
+TimerWheel::TimerWheel(boost::asio::io_context& ioc, Clock::duration tick, size_t slots)
+    : timer_(ioc)
+    , tick_(tick)
+    , slots_(std::max<size_t>(1, slots)) {
+}
+
+void TimerWheel::Start() {
+    Schedule();
+}
+
+void TimerWheel::Arm(Timer& timer, Clock::duration timeout) {
+    const uint64_t ticks = std::max<uint64_t>(1, (timeout + tick_ - Clock::duration{1}) / tick_);
+    const uint64_t deadline = current_tick_.load(std::memory_order_acquire) + ticks;
+    timer.deadline_.store(deadline);
+    // Таймер уже в колесе: новый срок заметит OnTick
+    if(!timer.is_scheduled_.exchange(true)) {
+        std::lock_guard lock(mutex_);
+        Insert(timer, deadline);
+    }
+}
+
+size_t TimerWheel::GetSize() const {
+    std::lock_guard lock(mutex_);
+    return size_;
+}
+
+void TimerWheel::Schedule() {
+    timer_.expires_after(tick_);
+    timer_.async_wait([self = shared_from_this()](const boost::system::error_code& ec) {
+        if(ec) {
+            return;
+        }
+        self->OnTick();
+        self->Schedule();
+    });
+}
+
+void TimerWheel::OnTick() {
+    const uint64_t now = current_tick_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    {
+        std::lock_guard lock(mutex_);
+        std::vector<std::weak_ptr<Timer>>& slot = slots_[now % slots_.size()];
+        size_t kept = 0;
+        for(std::weak_ptr<Timer>& entry : slot) {
+            std::shared_ptr<Timer> timer = entry.lock();
+            if(!timer) {
+                --size_;
+                continue;
+            }
+            uint64_t deadline = timer->deadline_.load();
+            if(deadline <= now && timer->deadline_.compare_exchange_strong(deadline, 0)) {
+                // Таймер покидает колесо. Если Arm успел взвести его заново, но застал
+                // is_scheduled_ ещё установленным, таймер возвращается в колесо здесь
+                timer->is_scheduled_.store(false);
+                deadline = timer->deadline_.load();
+                if(deadline != 0 && !timer->is_scheduled_.exchange(true)) {
+                    moved_.push_back(std::move(entry));
+                } else {
+                    --size_;
+                }
+                expired_.push_back(std::move(timer));
+                continue;
+            }
+            if(deadline % slots_.size() == now % slots_.size()) {
+                // Срок через целое число оборотов
+                slot[kept++] = std::move(entry);
+            } else {
+                moved_.push_back(std::move(entry));
+            }
+        }
+        slot.resize(kept);
+        for(std::weak_ptr<Timer>& entry : moved_) {
+            if(std::shared_ptr<Timer> timer = entry.lock()) {
+                slots_[timer->deadline_.load() % slots_.size()].push_back(std::move(entry));
+            } else {
+                --size_;
+            }
+        }
+        moved_.clear();
+    }
+    // Вне блокировки: обработчики могут снова взводить таймеры
+    for(const std::shared_ptr<Timer>& timer : expired_) {
+        timer->OnExpired();
+    }
+    expired_.clear();
+}
+
+void TimerWheel::Insert(Timer& timer, uint64_t deadline) {
+    slots_[deadline % slots_.size()].push_back(timer.self_);
+    ++size_;
+}
+
+}  // namespace http_server
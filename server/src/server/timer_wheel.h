@@ -0,0 +1,80 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace http_server {
+
+// Хешированное колесо таймеров с грубым шагом для таймаутов соединений. Вместо
+// steady_timer на каждое соединение и операции с кучей таймеров на каждый запрос
+// продление срока - одна запись в атомарную переменную. Колесо проверяет таймер, только
+// когда доходит до ячейки его прежнего срока, и переносит его, если срок продлён
+class TimerWheel : public std::enable_shared_from_this<TimerWheel> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    class Timer {
+    public:
+        virtual ~Timer() = default;
+
+        // Срок истёк; вызывается из потока io_context колеса. Таймер покидает колесо,
+        // и его можно взвести снова
+        virtual void OnExpired() = 0;
+
+    protected:
+        // false - срок истёк и таймер не взведён заново
+        bool IsArmed() const noexcept {
+            return deadline_.load() != 0;
+        }
+
+    private:
+        friend class TimerWheel;
+
+        std::weak_ptr<Timer> self_;
+        std::atomic<uint64_t> deadline_{0};     // номер шага колеса
+        std::atomic<bool> is_scheduled_{false};
+    };
+
+    // slots * tick - оборот колеса; срок длиннее оборота проверяется несколько раз
+    TimerWheel(boost::asio::io_context& ioc, Clock::duration tick, size_t slots);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    void Start();
+
+    // Колесо хранит на таймер слабую ссылку: таймер разрушается вместе с владельцем
+    static void Attach(const std::shared_ptr<Timer>& timer) {
+        timer->self_ = timer;
+    }
+
+    // Срок - через timeout, с точностью до шага. Можно вызывать из любого потока;
+    // повторный вызов переносит срок. Таймер должен быть прикреплён через Attach
+    void Arm(Timer& timer, Clock::duration timeout);
+
+    // Таймеров в колесе
+    size_t GetSize() const;
+
+private:
+    void Schedule();
+    void OnTick();
+    void Insert(Timer& timer, uint64_t deadline);
+
+    boost::asio::steady_timer timer_;
+    const Clock::duration tick_;
+    std::atomic<uint64_t> current_tick_{0};
+    mutable std::mutex mutex_;
+    std::vector<std::vector<std::weak_ptr<Timer>>> slots_;
+    size_t size_ = 0;
+    // Промежуточные списки OnTick; хранятся, чтобы не выделять память на каждом шаге
+    std::vector<std::shared_ptr<Timer>> expired_;
+    std::vector<std::weak_ptr<Timer>> moved_;
+};
+
+}  // namespace http_server
@@ -0,0 +1,224 @@
+#include "span_recorder.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace tracing {
+
+namespace {
+
+struct Span {
+    const char* category = nullptr;
+    const char* name = nullptr;
+    const char* detail = nullptr;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    uint64_t async_id = 0;  // 0 - участок внутри потока
+};
+
+void AppendEvent(std::string& out, const Span& span, char phase, uint64_t ts_ns, long pid, uint32_t tid) {
+    char buffer[128];
+    out += "{\"name\":\"";
+    out += span.name;
+    out += "\",\"cat\":\"";
+    out += span.category;
+    std::snprintf(buffer, sizeof(buffer), "\",\"ph\":\"%c\",\"ts\":%llu.%03llu,\"pid\":%ld,\"tid\":%u",
+                  phase, static_cast<unsigned long long>(ts_ns / 1000), static_cast<unsigned long long>(ts_ns % 1000), pid, tid);
+    out += buffer;
+    if(phase == 'X') {
+        const uint64_t dur_ns = span.end_ns - span.start_ns;
+        std::snprintf(buffer, sizeof(buffer), ",\"dur\":%llu.%03llu",
+                      static_cast<unsigned long long>(dur_ns / 1000), static_cast<unsigned long long>(dur_ns % 1000));
+        out += buffer;
+    } else {
+        std::snprintf(buffer, sizeof(buffer), ",\"id\":\"0x%llx\"", static_cast<unsigned long long>(span.async_id));
+        out += buffer;
+    }
+    if(span.detail != nullptr && phase != 'e') {
+        out += ",\"args\":{\"detail\":\"";
+        out += span.detail;
+        out += "\"}";
+    }
+    out += "},\n";
+}
+
+}  // namespace
+
+class SpanRecorder::ThreadBuffer {
+public:
+    explicit ThreadBuffer(uint32_t tid)
+        : tid_(tid)
+        , slots_(std::make_unique<Slot[]>(spans_per_thread)) {
+    }
+
+    uint32_t GetTid() const noexcept {
+        return tid_;
+    }
+
+    // Вызывается только потоком-владельцем
+    void Push(const Span& span) noexcept {
+        const uint64_t index = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[index % spans_per_thread];
+        // seqlock: нечётное значение - запись в процессе
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.category.store(span.category, std::memory_order_relaxed);
+        slot.name.store(span.name, std::memory_order_relaxed);
+        slot.detail.store(span.detail, std::memory_order_relaxed);
+        slot.start_ns.store(span.start_ns, std::memory_order_relaxed);
+        slot.end_ns.store(span.end_ns, std::memory_order_relaxed);
+        slot.async_id.store(span.async_id, std::memory_order_relaxed);
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    // Может вызываться из любого потока; записи, затёртые во время чтения, пропускаются
+    void Collect(std::vector<Span>& spans) const {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t first = head > spans_per_thread ? head - spans_per_thread : 0;
+        first = std::max(first, cleared_before_.load(std::memory_order_relaxed));
+        for(uint64_t index = first; index < head; ++index) {
+            const Slot& slot = slots_[index % spans_per_thread];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if(seq != 2 * index + 2) {
+                continue;
+            }
+            Span span;
+            span.category = slot.category.load(std::memory_order_relaxed);
+            span.name = slot.name.load(std::memory_order_relaxed);
+            span.detail = slot.detail.load(std::memory_order_relaxed);
+            span.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+            span.end_ns = slot.end_ns.load(std::memory_order_relaxed);
+            span.async_id = slot.async_id.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.seq.load(std::memory_order_relaxed) == seq) {
+                spans.push_back(span);
+            }
+        }
+    }
+
+    void Clear() noexcept {
+        cleared_before_.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char*> category{nullptr};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<const char*> detail{nullptr};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> end_ns{0};
+        std::atomic<uint64_t> async_id{0};
+    };
+
+    const uint32_t tid_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> cleared_before_{0};
+};
+
+SpanRecorder::ThreadBuffer& SpanRecorder::GetThreadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if(buffer == nullptr) {
+        std::lock_guard lock(mutex_);
+        buffers_.push_back(std::make_shared<ThreadBuffer>(static_cast<uint32_t>(buffers_.size() + 1)));
+        buffer = buffers_.back().get();
+    }
+    return *buffer;
+}
+
+void SpanRecorder::Push(bool is_async, const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+                        const char* detail) noexcept {
+    if(!IsEnabled()) {
+        return;
+    }
+    Span span{
+        .category = category,
+        .name = name,
+        .detail = detail,
+        .start_ns = start_ns,
+        .end_ns = std::max(start_ns, end_ns),
+        .async_id = is_async ? next_async_id_.fetch_add(1, std::memory_order_relaxed) : 0
+    };
+    try {
+        GetThreadBuffer().Push(span);
+    } catch(const std::exception&) {
+        // Не удалось выделить буфер потока - участок теряется
+    }
+}
+
+void SpanRecorder::Record(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+                          const char* detail) noexcept {
+    Push(false, category, name, start_ns, end_ns, detail);
+}
+
+void SpanRecorder::RecordAsync(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+                               const char* detail) noexcept {
+    Push(true, category, name, start_ns, end_ns, detail);
+}
+
+std::string SpanRecorder::DumpChromeTrace() const {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard lock(mutex_);
+        buffers = buffers_;
+    }
+    const long pid = static_cast<long>(::getpid());
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":0,\"args\":{\"name\":\"game_server\"}},\n", pid);
+    out += buffer;
+
+    std::vector<Span> spans;
+    for(const auto& thread_buffer : buffers) {
+        spans.clear();
+        thread_buffer->Collect(spans);
+        if(spans.empty()) {
+            continue;
+        }
+        const uint32_t tid = thread_buffer->GetTid();
+        std::snprintf(buffer, sizeof(buffer),
+                      "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%u,\"args\":{\"name\":\"thread-%u\"}},\n",
+                      pid, tid, tid);
+        out += buffer;
+        for(const Span& span : spans) {
+            if(span.async_id == 0) {
+                AppendEvent(out, span, 'X', span.start_ns, pid, tid);
+            } else {
+                AppendEvent(out, span, 'b', span.start_ns, pid, tid);
+                AppendEvent(out, span, 'e', span.end_ns, pid, tid);
+            }
+        }
+    }
+    // Убираем запятую после последнего события
+    out.resize(out.size() - 2);
+    out += "\n]}\n";
+    return out;
+}
+
+void SpanRecorder::DumpChromeTraceToFile(const std::string& path) const {
+    const std::string trace = DumpChromeTrace();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if(file == nullptr) {
+        throw std::runtime_error("Failed to open trace file " + path);
+    }
+    const size_t written = std::fwrite(trace.data(), 1, trace.size(), file);
+    const bool is_closed = std::fclose(file) == 0;
+    if(written != trace.size() || !is_closed) {
+        throw std::runtime_error("Failed to write trace file " + path);
+    }
+}
+
+void SpanRecorder::Clear() {
+    std::lock_guard lock(mutex_);
+    for(const auto& buffer : buffers_) {
+        buffer->Clear();
+    }
+}
+
+}  // namespace tracing
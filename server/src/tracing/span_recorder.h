@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tracing {
+
+// Запись участков выполнения (spans) для просмотра в Perfetto / chrome://tracing.
+// Каждый поток пишет в свой кольцевой буфер без блокировок; при переполнении
+// затираются самые старые записи. Имена и категории - строковые литералы:
+// сохраняется только указатель.
+class SpanRecorder {
+public:
+    static constexpr size_t spans_per_thread = 1 << 15;
+
+    static SpanRecorder& Instance() {
+        // Не разрушается при выходе: потоки могут писать до последнего момента
+        static SpanRecorder* const instance = new SpanRecorder;
+        return *instance;
+    }
+
+    static uint64_t NowNs() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool IsEnabled() const noexcept {
+        return is_enabled_.load(std::memory_order_relaxed);
+    }
+
+    void SetEnabled(bool is_enabled) noexcept {
+        is_enabled_.store(is_enabled, std::memory_order_relaxed);
+    }
+
+    // Участок, начавшийся и закончившийся в текущем потоке (вложенные события)
+    void Record(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+                const char* detail = nullptr) noexcept;
+
+    // Участок, начало и конец которого могут быть в разных потоках: ожидание
+    // в очереди strand, чтение и запись сокета. Показывается отдельной дорожкой
+    void RecordAsync(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+                     const char* detail = nullptr) noexcept;
+
+    // Содержимое всех буферов в формате Chrome Trace Event (JSON)
+    std::string DumpChromeTrace() const;
+    void DumpChromeTraceToFile(const std::string& path) const;
+
+    void Clear();
+
+private:
+    class ThreadBuffer;
+
+    SpanRecorder() = default;
+
+    ThreadBuffer& GetThreadBuffer();
+    void Push(bool is_async, const char* category, const char* name, uint64_t start_ns, uint64_t end_ns,
+              const char* detail) noexcept;
+
+    std::atomic<bool> is_enabled_{false};
+    std::atomic<uint64_t> next_async_id_{1};
+
+    mutable std::mutex mutex_;
+    // Буферы не удаляются при завершении потоков, чтобы их записи попали в выгрузку
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+inline bool IsEnabled() noexcept {
+    return SpanRecorder::Instance().IsEnabled();
+}
+
+// Записывает участок от создания до разрушения, если запись включена
+class ScopedSpan {
+public:
+    ScopedSpan(const char* category, const char* name, const char* detail = nullptr) noexcept
+        : category_(category)
+        , name_(name)
+        , detail_(detail)
+        , start_ns_(IsEnabled() ? SpanRecorder::NowNs() : 0) {
+    }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    ~ScopedSpan() {
+        if(start_ns_ != 0) {
+            SpanRecorder::Instance().Record(category_, name_, start_ns_, SpanRecorder::NowNs(), detail_);
+        }
+    }
+
+private:
+    const char* category_;
+    const char* name_;
+    const char* detail_;
+    uint64_t start_ns_;
+};
+
+}  // namespace tracing
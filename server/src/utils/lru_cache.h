@@ -0,0 +1,64 @@
+#pragma once
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace utils {
+
+// Потокобезопасный LRU-кэш со строковыми ключами. Поиск по std::string_view не создаёт
+// строку; при переполнении вытесняется давно не использованное значение
+template <typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity)
+        : capacity_(capacity) {
+    }
+
+    std::optional<Value> Get(std::string_view key) {
+        std::lock_guard lock(mutex_);
+        const auto it = index_.find(key);
+        if(it == index_.end()) {
+            return std::nullopt;
+        }
+        items_.splice(items_.begin(), items_, it->second);
+        return it->second->second;
+    }
+
+    void Put(std::string key, Value value) {
+        std::lock_guard lock(mutex_);
+        if(const auto it = index_.find(key); it != index_.end()) {
+            it->second->second = std::move(value);
+            items_.splice(items_.begin(), items_, it->second);
+            return;
+        }
+        if(capacity_ == 0) {
+            return;
+        }
+        if(items_.size() == capacity_) {
+            index_.erase(items_.back().first);
+            items_.pop_back();
+        }
+        items_.emplace_front(std::move(key), std::move(value));
+        // Ключ индекса ссылается на строку в узле списка: узлы не перемещаются
+        index_.emplace(items_.front().first, items_.begin());
+    }
+
+    size_t GetSize() const {
+        std::lock_guard lock(mutex_);
+        return items_.size();
+    }
+
+private:
+    using Items = std::list<std::pair<std::string, Value>>;
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    Items items_;
+    std::unordered_map<std::string_view, typename Items::iterator> index_;
+};
+
+}  // namespace utils
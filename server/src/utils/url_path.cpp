@@ -0,0 +1,86 @@
+#include "url_path.h"
+
+namespace utils {
+
+namespace {
+
+int HexDigit(char ch) noexcept {
+    if(ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    if(ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+    if(ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
+
+}  // namespace
+
+std::optional<std::string_view> NormalizeURLPath(std::string_view target, URLPathBuffer& buffer) noexcept {
+    target = target.substr(0, target.find_first_of("?#"));
+    if(target.empty() || target.front() != '/') {
+        return std::nullopt;
+    }
+    size_t size = 0;
+    buffer[size++] = '/';
+    size_t segment_start = size;
+
+    // Сегмент [segment_start, size) закончен: "." удаляется, ".." удаляет и предыдущий
+    auto finish_segment = [&]() noexcept {
+        const std::string_view segment(buffer.data() + segment_start, size - segment_start);
+        if(segment == ".") {
+            size = segment_start;
+        } else if(segment == "..") {
+            if(segment_start == 1) {
+                return false;
+            }
+            size = segment_start - 1;
+            while(buffer[size - 1] != '/') {
+                --size;
+            }
+        }
+        return true;
+    };
+
+    for(size_t i = 1; i < target.size(); ++i) {
+        char ch = target[i];
+        if(ch == '%') {
+            if(i + 2 >= target.size()) {
+                return std::nullopt;
+            }
+            const int high = HexDigit(target[i + 1]);
+            const int low = HexDigit(target[i + 2]);
+            if(high < 0 || low < 0 || (high == 0 && low == 0)) {
+                return std::nullopt;
+            }
+            ch = static_cast<char>(high * 16 + low);
+            i += 2;
+        }
+        if(ch == '/') {
+            if(!finish_segment()) {
+                return std::nullopt;
+            }
+            if(buffer[size - 1] != '/') {
+                if(size == buffer.size()) {
+                    return std::nullopt;
+                }
+                buffer[size++] = '/';
+            }
+            segment_start = size;
+            continue;
+        }
+        if(size == buffer.size()) {
+            return std::nullopt;
+        }
+        buffer[size++] = ch;
+    }
+    if(!finish_segment()) {
+        return std::nullopt;
+    }
+    return std::string_view(buffer.data(), size);
+}
+
+}  // namespace utils
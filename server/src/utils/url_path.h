@@ -0,0 +1,20 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <string_view>
+
+namespace utils {
+
+// Наибольшая длина пути после декодирования
+constexpr size_t max_url_path_length = 1024;
+using URLPathBuffer = std::array<char, max_url_path_length>;
+
+// Путь из request-target за один проход и без выделения памяти: отбрасывает query и
+// fragment, декодирует %xx (шестнадцатеричные цифры в любом регистре), склеивает
+// повторные '/', убирает сегменты "." и применяет "..". Результат лежит в buffer,
+// начинается с '/' и не выходит выше корня.
+// nullopt - путь не с '/', неверная %-последовательность, %00, выход выше корня
+// или путь длиннее буфера
+std::optional<std::string_view> NormalizeURLPath(std::string_view target, URLPathBuffer& buffer) noexcept;
+
+}  // namespace utils
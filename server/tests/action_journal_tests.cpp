@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sys/resource.h>
+
+#include <csignal>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../src/application/action_journal.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Временный каталог для файла состояния и сегментов журнала
+struct TempDir {
+    TempDir()
+        : path(std::filesystem::temp_directory_path() / ("action_journal_test_" + std::to_string(::getpid()))) {
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+    std::filesystem::path path;
+};
+
+// Пока объект жив, файлы не могут вырасти больше limit байт: write завершается с EFBIG
+class FileSizeLimit {
+public:
+    explicit FileSizeLimit(rlim_t limit) {
+        ::getrlimit(RLIMIT_FSIZE, &saved_);
+        previous_handler_ = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit limited = saved_;
+        limited.rlim_cur = limit;
+        ::setrlimit(RLIMIT_FSIZE, &limited);
+    }
+    ~FileSizeLimit() {
+        Restore();
+    }
+    void Restore() {
+        if(is_active_) {
+            ::setrlimit(RLIMIT_FSIZE, &saved_);
+            std::signal(SIGXFSZ, previous_handler_);
+            is_active_ = false;
+        }
+    }
+
+private:
+    rlimit saved_{};
+    void (*previous_handler_)(int) = nullptr;
+    bool is_active_ = true;
+};
+
+serialization::MoveRecord Move(std::string move) {
+    return serialization::MoveRecord{.token = "token", .move = std::move(move)};
+}
+
+}  // namespace
+
+TEST_CASE("Action journal retries records that failed to reach the disk", "[ActionJournal]") {
+    TempDir dir;
+    const std::filesystem::path state_file = dir.path / "state";
+    {
+        app::ActionJournal journal(state_file, {.commit_window = 0ms, .checkpoint_records = 0}, 1);
+        journal.Append(Move("U"));
+        journal.Flush();
+        REQUIRE(journal.GetDurableLsn() == 1);
+
+        uintmax_t segment_size = 0;
+        for(const auto& entry : std::filesystem::directory_iterator(dir.path)) {
+            segment_size = std::max(segment_size, entry.file_size());
+        }
+        // Следующая запись поместится в сегмент лишь частично
+        FileSizeLimit limit(static_cast<rlim_t>(segment_size) + 1);
+        journal.Append(Move("D"));
+        journal.Append(Move("L"));
+        CHECK_THROWS_AS(journal.Flush(), std::runtime_error);
+        CHECK(journal.GetFailedWritesCount() >= 1);
+        CHECK(journal.GetDurableLsn() == 1);
+
+        limit.Restore();
+        journal.Append(Move("R"));
+        journal.Flush();
+        CHECK(journal.GetDurableLsn() == 4);
+    }
+
+    // Недописанный хвост неудачной попытки обрезан, записи не потеряны и не повторяются
+    std::vector<uint64_t> lsns;
+    const uint64_t last_lsn = app::ActionJournal::Replay(state_file, 0, [&lsns](serialization::JournalEntry&& entry) {
+        lsns.push_back(entry.lsn);
+    });
+    CHECK(last_lsn == 4);
+    CHECK(lsns == std::vector<uint64_t>{1, 2, 3, 4});
+}
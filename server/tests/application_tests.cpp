@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/application/application.h"
+#include "../src/json_handler/json_loader.h"
+
+using namespace std::literals;
+
+namespace {
+
+namespace net = boost::asio;
+
+// Одна длинная дорога: собака не упирается в её конец за время теста.
+// Собака, простоявшая секунду, выбывает
+constexpr std::string_view config_json = R"({
+    "defaultDogSpeed": 10.0,
+    "defaultBagCapacity": 3,
+    "dogRetirementTime": 1.0,
+    "lootGeneratorConfig": {"period": 5.0, "probability": 0.5},
+    "maps": [
+        {
+            "id": "map1",
+            "name": "Map 1",
+            "roads": [
+                {"x0": 0, "y0": 0, "x1": 100}
+            ],
+            "buildings": [],
+            "offices": [],
+            "lootTypes": [
+                {"name": "key", "file": "assets/key.obj", "type": "obj", "value": 10}
+            ]
+        }
+    ]
+})"sv;
+
+// Временный каталог с конфигурацией игры, файлом состояния и сегментами журнала
+struct TempDir {
+    TempDir()
+        : path(std::filesystem::temp_directory_path() / ("application_test_" + std::to_string(::getpid()))) {
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+        std::ofstream(GetConfigPath()) << config_json;
+    }
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+    std::filesystem::path GetConfigPath() const {
+        return path / "config.json";
+    }
+    std::string GetStatePath() const {
+        return (path / "state.bin").string();
+    }
+    std::filesystem::path path;
+};
+
+// Запоминает сохранённых игроков; первые failures сохранений завершаются ошибкой
+class FakePlayerRepository : public database::domain::PlayerRepository {
+public:
+    void Save(const database::domain::Player& player) override {
+        if(failures > 0) {
+            --failures;
+            throw std::runtime_error("database is unavailable");
+        }
+        saved.push_back(player);
+    }
+    void Delete(std::string_view) override {
+    }
+    std::optional<database::domain::Player> GetPlayerByName(std::string_view) override {
+        return std::nullopt;
+    }
+    std::vector<database::domain::Player> GetPlayersStat(uint64_t, uint64_t) override {
+        return saved;
+    }
+
+    int failures = 0;
+    std::vector<database::domain::Player> saved;
+};
+
+class FakeUnitOfWork : public database::app::UnitOfWork {
+public:
+    explicit FakeUnitOfWork(FakePlayerRepository& repository)
+        : repository_(repository) {
+    }
+    database::domain::PlayerRepository* Player() override {
+        return &repository_;
+    }
+    void Commit() override {
+    }
+
+private:
+    FakePlayerRepository& repository_;
+};
+
+class FakeDatabase : public database::app::UnitOfWorkFactory {
+public:
+    std::unique_ptr<database::app::UnitOfWork> CreateUnitOfWork() override {
+        return std::make_unique<FakeUnitOfWork>(repository);
+    }
+
+    FakePlayerRepository repository;
+};
+
+// Приложение с собственной игрой; strand и пул БД обслуживает один io_context,
+// который тест запускает сам
+struct TestServer {
+    TestServer(const TempDir& dir, FakeDatabase& database)
+        : game(json_loader::LoadGame(dir.GetConfigPath()))
+        , application(game, false, strand, database, ioc.get_executor()) {
+        application.RecoverFromFile(dir.GetStatePath(), app::ActionJournal::Config{.commit_window = 0ms, .checkpoint_records = 0});
+    }
+
+    net::io_context ioc;
+    app::Application::Strand strand{net::make_strand(ioc)};
+    model::Game game;
+    app::Application application;
+};
+
+}  // namespace
+
+SCENARIO("Application recovers from a snapshot taken by a tick listener") {
+    TempDir dir;
+    FakeDatabase database;
+    app::Token token{""};
+    model::DogCoordinates expected;
+    {
+        TestServer server(dir, database);
+        token = server.application.JoinGame(model::Map::Id{"map1"}, "Pluto").first;
+        server.application.MoveAction(token, "R");
+        // Снимок снимается в обработчике такта, как это делает Listener. Запись синхронная,
+        // чтобы на диске оказался именно он
+        bool is_saved = false;
+        auto connection = server.application.DoOnTick([&server, &is_saved](std::chrono::milliseconds) {
+            if(!is_saved) {
+                server.application.SaveState();
+                is_saved = true;
+            }
+        });
+        server.application.UpdateApplication(100);
+        server.application.UpdateApplication(100);
+        expected = server.application.FindPlayerByToken(token)->GetDog()->GetDogCoordinates();
+        server.ioc.run();
+    }
+
+    WHEN("the server restarts") {
+        TestServer server(dir, database);
+
+        THEN("the tick in the snapshot is not replayed from the journal again") {
+            const auto player = server.application.FindPlayerByToken(token);
+            REQUIRE(player != nullptr);
+            const auto restored = player->GetDog()->GetDogCoordinates();
+            CHECK(restored.x_ == expected.x_);
+            CHECK(restored.y_ == expected.y_);
+        }
+        server.ioc.run();
+    }
+}
+
+SCENARIO("Results of retired players reach the database after restart and failures") {
+    TempDir dir;
+    FakeDatabase database;
+    {
+        TestServer server(dir, database);
+        server.application.JoinGame(model::Map::Id{"map1"}, "Goofy");
+        server.application.UpdateApplication(1000);
+
+        // Такт не ждёт базу: результат передан пулу БД, но пул ещё не запускался
+        CHECK(server.application.GetPendingResultsCount() == 1);
+        CHECK(database.repository.saved.empty());
+        // Сервер останавливается, так и не записав результат
+    }
+
+    WHEN("the server restarts and the first attempt to save fails") {
+        database.repository.failures = 1;
+        {
+            TestServer server(dir, database);
+            CHECK(server.application.GetPendingResultsCount() == 1);
+            server.ioc.run();
+
+            THEN("the result restored from the journal is saved on retry") {
+                CHECK(database.repository.failures == 0);
+                REQUIRE(database.repository.saved.size() == 1);
+                CHECK(database.repository.saved[0].GetName() == "Goofy");
+                CHECK(server.application.GetPendingResultsCount() == 0);
+            }
+        }
+
+        AND_WHEN("the server restarts once more") {
+            TestServer server(dir, database);
+            server.ioc.run();
+
+            THEN("the confirmed result is not sent again") {
+                CHECK(server.application.GetPendingResultsCount() == 0);
+                CHECK(database.repository.saved.size() == 1);
+            }
+        }
+    }
+}
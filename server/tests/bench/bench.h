@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Не даёт компилятору выбросить вычисление value
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Options {
+    std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds{20};
+    size_t samples = 15;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;   // операций в одном замере
+    size_t samples = 0;
+    double median_ns = 0;      // время одной операции
+    double min_ns = 0;
+    double max_ns = 0;
+};
+
+// Передаётся в тело бенчмарка: подготовка выполняется до Measure и в замер не входит
+class State {
+public:
+    explicit State(const Options& options) noexcept
+        : options_(options) {
+    }
+
+    // Подбирает число повторов op так, чтобы замер длился не меньше min_sample_time,
+    // и делает options.samples замеров. Вызывается один раз
+    template <typename Op>
+    void Measure(Op&& op) {
+        uint64_t iterations = 1;
+        for(;;) {
+            const auto elapsed = Run(op, iterations);
+            if(elapsed >= options_.min_sample_time) {
+                break;
+            }
+            // Увеличиваем с запасом, но не больше чем в 10 раз за шаг
+            const double scale = elapsed.count() > 0
+                ? 1.2 * static_cast<double>(options_.min_sample_time.count()) / static_cast<double>(elapsed.count())
+                : 10.0;
+            iterations = static_cast<uint64_t>(static_cast<double>(iterations) * std::min(std::max(scale, 1.5), 10.0)) + 1;
+        }
+        std::vector<double> sample_ns;
+        sample_ns.reserve(options_.samples);
+        for(size_t i = 0; i < options_.samples; ++i) {
+            sample_ns.push_back(static_cast<double>(Run(op, iterations).count()) / static_cast<double>(iterations));
+        }
+        SetResult(iterations, std::move(sample_ns));
+    }
+
+    const Result& GetResult() const noexcept {
+        return result_;
+    }
+
+private:
+    template <typename Op>
+    static std::chrono::nanoseconds Run(Op& op, uint64_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        for(uint64_t i = 0; i < iterations; ++i) {
+            op();
+        }
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    void SetResult(uint64_t iterations, std::vector<double> sample_ns);
+
+    const Options& options_;
+    Result result_;
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(State&)> body;
+};
+
+class Suite {
+public:
+    void Add(std::string name, std::function<void(State&)> body) {
+        benchmarks_.push_back({std::move(name), std::move(body)});
+    }
+
+    const std::vector<Benchmark>& GetBenchmarks() const noexcept {
+        return benchmarks_;
+    }
+
+private:
+    std::vector<Benchmark> benchmarks_;
+};
+
+// Регистрация бенчмарков по файлам
+void AddCollisionDetectorBenchmarks(Suite& suite);
+void AddMotionBenchmarks(Suite& suite);
+void AddLootBenchmarks(Suite& suite);
+void AddSerializationBenchmarks(Suite& suite);
+
+}  // namespace bench
@@ -0,0 +1,194 @@
+// Микробенчмарки библиотеки модели игры. Результаты пишутся в JSON (--out) и могут
+// сравниваться с сохранённым ранее файлом (--baseline): замедление медианы больше
+// --threshold процентов считается регрессией, и программа завершается с кодом 1
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+
+#include <boost/json.hpp>
+#include <boost/program_options.hpp>
+
+#include "bench.h"
+
+using namespace std::literals;
+
+namespace bench {
+
+void State::SetResult(uint64_t iterations, std::vector<double> sample_ns) {
+    std::sort(sample_ns.begin(), sample_ns.end());
+    result_.iterations = iterations;
+    result_.samples = sample_ns.size();
+    if(!sample_ns.empty()) {
+        result_.median_ns = sample_ns[sample_ns.size() / 2];
+        result_.min_ns = sample_ns.front();
+        result_.max_ns = sample_ns.back();
+    }
+}
+
+}  // namespace bench
+
+namespace {
+
+struct Args {
+    std::string filter;
+    bool is_list = false;
+    std::string out_file;
+    std::string baseline_file;
+    double threshold_percent = 10.0;
+    size_t samples = 15;
+    uint64_t min_sample_time_ms = 20;
+};
+
+[[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
+    namespace po = boost::program_options;
+    Args args;
+    po::options_description desc{"All options"s};
+    desc.add_options()
+        ("help,h", "Show help")
+        ("filter",          po::value(&args.filter)->value_name("substring"s),                  "Run only benchmarks whose name contains substring")
+        ("list",            po::bool_switch(&args.is_list),                                     "List benchmarks and exit")
+        ("out",             po::value(&args.out_file)->value_name("file"s),                     "Write results as JSON")
+        ("baseline",        po::value(&args.baseline_file)->value_name("file"s),                "Compare with results written earlier by --out")
+        ("threshold",       po::value(&args.threshold_percent)->value_name("percent"s),         "Allowed slowdown against baseline")
+        ("samples",         po::value(&args.samples)->value_name("count"s),                     "Number of samples per benchmark")
+        ("min-time",        po::value(&args.min_sample_time_ms)->value_name("milliseconds"s),   "Minimal duration of one sample");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if(vm.contains("help")) {
+        std::cout << desc;
+        return std::nullopt;
+    }
+    if(args.samples == 0) {
+        throw std::invalid_argument("Number of samples must be positive");
+    }
+    return args;
+}
+
+std::string ToJson(const std::vector<bench::Result>& results) {
+    boost::json::array benchmarks;
+    benchmarks.reserve(results.size());
+    for(const auto& result : results) {
+        benchmarks.push_back(boost::json::object{
+            {"name", result.name},
+            {"iterations", result.iterations},
+            {"samples", result.samples},
+            {"medianNs", result.median_ns},
+            {"minNs", result.min_ns},
+            {"maxNs", result.max_ns}
+        });
+    }
+    return boost::json::serialize(boost::json::object{{"benchmarks", std::move(benchmarks)}}) + '\n';
+}
+
+// Медианы из файла, записанного ToJson
+std::unordered_map<std::string, double> LoadBaseline(const std::string& file) {
+    std::ifstream in(file);
+    if(!in) {
+        throw std::runtime_error("Failed to open baseline " + file);
+    }
+    std::stringstream content;
+    content << in.rdbuf();
+    const auto value = boost::json::parse(content.str());
+
+    std::unordered_map<std::string, double> medians;
+    for(const auto& item : value.as_object().at("benchmarks").as_array()) {
+        const auto& benchmark = item.as_object();
+        const auto& name = benchmark.at("name").as_string();
+        medians[std::string(name.data(), name.size())] = benchmark.at("medianNs").as_double();
+    }
+    return medians;
+}
+
+// Возвращает число регрессий
+size_t CompareWithBaseline(const std::vector<bench::Result>& results,
+                           const std::unordered_map<std::string, double>& baseline, double threshold_percent) {
+    size_t regressions = 0;
+    std::cout << "\nComparison with baseline (threshold " << threshold_percent << "%)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for(const auto& result : results) {
+        std::cout << std::left << std::setw(48) << result.name << std::right;
+        const auto it = baseline.find(result.name);
+        if(it == baseline.end() || it->second <= 0) {
+            std::cout << "  new\n";
+            continue;
+        }
+        const double change = (result.median_ns - it->second) / it->second * 100.0;
+        std::cout << std::setw(14) << it->second << " -> " << std::setw(12) << result.median_ns << " ns "
+                  << std::showpos << std::setw(8) << change << '%' << std::noshowpos;
+        if(change > threshold_percent) {
+            std::cout << "  REGRESSION";
+            ++regressions;
+        }
+        std::cout << '\n';
+    }
+    return regressions;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        const auto args = ParseCommandLine(argc, argv);
+        if(!args) {
+            return EXIT_SUCCESS;
+        }
+
+        bench::Suite suite;
+        bench::AddCollisionDetectorBenchmarks(suite);
+        bench::AddMotionBenchmarks(suite);
+        bench::AddLootBenchmarks(suite);
+        bench::AddSerializationBenchmarks(suite);
+
+        bench::Options options;
+        options.samples = args->samples;
+        options.min_sample_time = std::chrono::milliseconds(args->min_sample_time_ms);
+
+        std::vector<bench::Result> results;
+        if(!args->is_list) {
+            std::cout << std::left << std::setw(48) << "benchmark" << std::right << std::setw(14) << "median ns"
+                      << std::setw(14) << "min ns" << std::setw(14) << "max ns" << std::setw(14) << "iterations" << '\n';
+        }
+        for(const auto& benchmark : suite.GetBenchmarks()) {
+            if(!args->filter.empty() && benchmark.name.find(args->filter) == std::string::npos) {
+                continue;
+            }
+            if(args->is_list) {
+                std::cout << benchmark.name << '\n';
+                continue;
+            }
+            bench::State state(options);
+            benchmark.body(state);
+            auto result = state.GetResult();
+            result.name = benchmark.name;
+            std::cout << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(14) << result.median_ns << std::setw(14) << result.min_ns
+                      << std::setw(14) << result.max_ns << std::setw(14) << result.iterations << std::endl;
+            results.push_back(std::move(result));
+        }
+        if(args->is_list) {
+            return EXIT_SUCCESS;
+        }
+
+        if(!args->out_file.empty()) {
+            std::ofstream out(args->out_file);
+            if(!out) {
+                throw std::runtime_error("Failed to open " + args->out_file);
+            }
+            out << ToJson(results);
+        }
+        if(!args->baseline_file.empty()
+           && CompareWithBaseline(results, LoadBaseline(args->baseline_file), args->threshold_percent) > 0) {
+            return EXIT_FAILURE;
+        }
+    } catch(const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 2;
+    }
+    return EXIT_SUCCESS;
+}
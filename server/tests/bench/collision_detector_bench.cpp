@@ -0,0 +1,57 @@
+#include <random>
+
+#include "bench.h"
+#include "../../src/game/collision_detector.h"
+
+namespace bench {
+
+namespace {
+
+using collision_detector::Gatherer;
+using collision_detector::Item;
+using collision_detector::ItemGathererProviderWrappler;
+
+// Собаки и трофеи на поле side x side; за такт собака проходит не больше одной клетки
+ItemGathererProviderWrappler MakeProvider(size_t gatherers_count, size_t items_count, double side) {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> coord(0.0, side);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+
+    ItemGathererProviderWrappler::Items items;
+    items.reserve(items_count);
+    for(size_t i = 0; i < items_count; ++i) {
+        items.push_back(Item{{coord(random), coord(random)}, 0.0, i});
+    }
+    ItemGathererProviderWrappler::Gatherers gatherers;
+    gatherers.reserve(gatherers_count);
+    for(size_t i = 0; i < gatherers_count; ++i) {
+        const model::DoublePoint start{coord(random), coord(random)};
+        // Движение вдоль одной оси, как по дороге
+        const model::DoublePoint end = i % 2 == 0
+            ? model::DoublePoint{start.x + step(random), start.y}
+            : model::DoublePoint{start.x, start.y + step(random)};
+        gatherers.push_back(Gatherer{start, end, 0.6, i});
+    }
+    return {std::move(items), std::move(gatherers)};
+}
+
+}  // namespace
+
+void AddCollisionDetectorBenchmarks(Suite& suite) {
+    for(size_t gatherers : {10, 100, 1000}) {
+        for(size_t items : {10, 100, 1000, 10000}) {
+            const std::string name = "find_gather_events/gatherers=" + std::to_string(gatherers)
+                + "/items=" + std::to_string(items);
+            suite.Add(name, [gatherers, items](State& state) {
+                // Плотность как на большой карте: около одного трофея на 100 клеток
+                const double side = std::max(100.0, std::sqrt(static_cast<double>(gatherers + items) * 100.0));
+                const auto provider = MakeProvider(gatherers, items, side);
+                state.Measure([&provider] {
+                    DoNotOptimize(collision_detector::FindGatherEvents(provider));
+                });
+            });
+        }
+    }
+}
+
+}  // namespace bench
@@ -0,0 +1,107 @@
+#!/bin/bash
+# Сравнение сетевых бэкендов под одинаковой нагрузкой. Поочерёдно запускает две сборки
+# game_server - обычную (epoll) и собранную с -DGAME_IO_URING=ON, - нагружает каждую
+# game_load с одним и тем же профилем и печатает пропускную способность, задержки
+# и процессорное время сервера (user/sys) на запрос.
+#
+#   GAME_DB_URL=... tests/bench/io_backend_compare.sh build/game_server build-uring/game_server \
+#       --connections 2000 --rate 20000 --duration 60 --mix action=50,state=50
+#
+# Аргументы после путей к серверам передаются game_load. Переменные окружения:
+#   GAME_LOAD    - путь к game_load (по умолчанию рядом с первым сервером)
+#   CONFIG_FILE  - конфигурация игры (data/config.json)
+#   WWW_ROOT     - статические файлы (static)
+#   SERVER_ARGS  - дополнительные аргументы сервера, например "--tick-period 50"
+#   PORT         - порт сервера (8080)
+#   OUT_DIR      - каталог для отчётов и логов серверов
+set -euo pipefail
+
+if [[ $# -lt 2 ]]; then
+    echo "Usage: $0 EPOLL_SERVER URING_SERVER [game_load options...]" >&2
+    exit 1
+fi
+
+EPOLL_SERVER=$1
+URING_SERVER=$2
+shift 2
+
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+GAME_LOAD=${GAME_LOAD:-$(dirname "$EPOLL_SERVER")/game_load}
+CONFIG_FILE=${CONFIG_FILE:-$SCRIPT_DIR/../../data/config.json}
+WWW_ROOT=${WWW_ROOT:-$SCRIPT_DIR/../../static}
+SERVER_ARGS=${SERVER_ARGS:---tick-period 50}
+PORT=${PORT:-8080}
+OUT_DIR=${OUT_DIR:-$(mktemp -d)}
+CLK_TCK=$(getconf CLK_TCK)
+mkdir -p "$OUT_DIR"
+
+wait_for_port() {
+    for _ in $(seq 1 100); do
+        if (echo > "/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    echo "Server did not open port $PORT" >&2
+    return 1
+}
+
+# utime и stime процесса в тиках
+cpu_ticks() {
+    awk '{ print $14, $15 }' "/proc/$1/stat"
+}
+
+# run_backend NAME SERVER [game_load options...]
+run_backend() {
+    local name=$1 server=$2
+    shift 2
+    # shellcheck disable=SC2086
+    "$server" --config-file "$CONFIG_FILE" --www-root "$WWW_ROOT" $SERVER_ARGS > "$OUT_DIR/$name.log" 2>&1 &
+    local pid=$!
+    wait_for_port
+
+    local before after
+    before=$(cpu_ticks "$pid")
+    "$GAME_LOAD" --host 127.0.0.1 --port "$PORT" --json-report "$OUT_DIR/$name.json" "$@" > "$OUT_DIR/$name.txt"
+    after=$(cpu_ticks "$pid")
+    echo "$before $after" > "$OUT_DIR/$name.cpu"
+
+    kill -TERM "$pid"
+    wait "$pid" || true
+    # Следующий сервер займёт тот же порт
+    while (echo > "/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; do
+        sleep 0.1
+    done
+}
+
+# json_field FILE ENDPOINT FIELD - поле отчёта game_load для маршрута
+json_field() {
+    grep -o "\"$2\":{[^}]*}" "$1" | grep -o "\"$3\":[0-9.]*" | cut -d: -f2 || true
+}
+
+print_row() {
+    local name=$1
+    local report=$OUT_DIR/$name.json
+    local duration requests
+    duration=$(grep -o '"durationSeconds":[0-9.]*' "$report" | cut -d: -f2)
+    requests=$(grep -o '"requests":[0-9]*' "$report" | cut -d: -f2 | awk '{ sum += $1 } END { print sum + 0 }')
+    read -r user_before sys_before user_after sys_after < "$OUT_DIR/$name.cpu"
+    awk -v name="$name" -v duration="$duration" -v requests="$requests" -v tck="$CLK_TCK" \
+        -v user=$((user_after - user_before)) -v sys=$((sys_after - sys_before)) \
+        -v state_p50="$(json_field "$report" state p50Ms)" -v state_p99="$(json_field "$report" state p99Ms)" \
+        -v action_p50="$(json_field "$report" action p50Ms)" -v action_p99="$(json_field "$report" action p99Ms)" \
+        'BEGIN {
+            per_request = requests > 0 ? (user + sys) / tck * 1e6 / requests : 0
+            printf "%-9s %10.0f %9.2f %9.2f %12.1f %10s %10s %10s %10s\n", name, requests / duration,
+                   user / tck, sys / tck, per_request, state_p50, state_p99, action_p50, action_p99
+        }'
+}
+
+echo "Reports and server logs: $OUT_DIR"
+run_backend epoll "$EPOLL_SERVER" "$@"
+run_backend io_uring "$URING_SERVER" "$@"
+
+printf "%-9s %10s %9s %9s %12s %10s %10s %10s %10s\n" backend "req/s" "user, s" "sys, s" "cpu us/req" \
+       "state p50" "state p99" "action p50" "action p99"
+print_row epoll
+print_row io_uring
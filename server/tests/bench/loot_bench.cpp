@@ -0,0 +1,66 @@
+#include <random>
+
+#include "bench.h"
+#include "../../src/game/game_items.h"
+#include "../../src/game/loot_generator.h"
+
+using namespace std::literals;
+
+namespace bench {
+
+namespace {
+
+model::LootsWrappler MakeLoots(size_t count, std::mt19937_64& random) {
+    std::uniform_real_distribution<double> coord(0.0, 100.0);
+    model::LootsWrappler loots;
+    for(size_t i = 0; i < count; ++i) {
+        loots.AddLoot(random() % 4, {coord(random), coord(random)});
+    }
+    return loots;
+}
+
+}  // namespace
+
+void AddLootBenchmarks(Suite& suite) {
+    for(size_t count : {100, 10000}) {
+        // Подбор трофея, сдача на базу и появление нового на освободившемся номере
+        suite.Add("loots_churn/loots=" + std::to_string(count), [count](State& state) {
+            std::mt19937_64 random(42);
+            auto loots = MakeLoots(count, random);
+            state.Measure([&] {
+                const uint64_t id = random() % count;
+                loots.MarkBusy(id);
+                loots.PopLoot(id);
+                loots.AddLoot(id % 4, {1.0, 2.0});
+            });
+            DoNotOptimize(loots.GetSize());
+        });
+
+        // Список трофеев на карте, как при построении ответа /state; десятая часть в рюкзаках
+        suite.Add("loots_get_loots/loots=" + std::to_string(count), [count](State& state) {
+            std::mt19937_64 random(42);
+            auto loots = MakeLoots(count, random);
+            for(size_t id = 0; id < count; id += 10) {
+                loots.MarkBusy(id);
+            }
+            state.Measure([&loots] {
+                DoNotOptimize(loots.GetLoots());
+            });
+        });
+    }
+
+    suite.Add("loot_generator_generate", [](State& state) {
+        std::mt19937_64 random(42);
+        std::uniform_real_distribution<double> probability(0.0, 1.0);
+        loot_gen::LootGenerator generator{5s, 0.5, [&] {
+            return probability(random);
+        }};
+        unsigned loot_count = 0;
+        state.Measure([&] {
+            loot_count = (loot_count + generator.Generate(50ms, loot_count, 100)) % 100;
+            DoNotOptimize(loot_count);
+        });
+    });
+}
+
+}  // namespace bench
@@ -0,0 +1,78 @@
+#include <array>
+#include <memory>
+#include <random>
+
+#include "bench.h"
+#include "../../src/game/motion.h"
+
+using namespace std::literals;
+
+namespace bench {
+
+namespace {
+
+constexpr int block_size = 10;
+constexpr double dog_speed = 3.0;
+constexpr uint64_t tick_ms = 50;
+
+// Сетка из (blocks + 1) горизонтальных и (blocks + 1) вертикальных дорог
+model::Map MakeGridMap(int blocks) {
+    model::Map map{model::Map::Id{"grid"s}, "grid"s};
+    const int side = blocks * block_size;
+    for(int i = 0; i <= blocks; ++i) {
+        map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, i * block_size}, side});
+        map.AddRoad(model::Road{model::Road::VERTICAL, {i * block_size, 0}, side});
+    }
+    map.SetDogSpeed(dog_speed);
+    return map;
+}
+
+void SetRandomDirection(model::Dog& dog, std::mt19937_64& random) {
+    static constexpr std::array<model::Direction, 4> directions = {
+        model::Direction::NORTH, model::Direction::SOUTH, model::Direction::WEST, model::Direction::EAST};
+    const auto direction = directions[random() % directions.size()];
+    dog.SetDogDirection(direction);
+    switch(direction) {
+    case model::Direction::NORTH:   dog.SetDogSpeed({0.0, -dog_speed}); break;
+    case model::Direction::SOUTH:   dog.SetDogSpeed({0.0, dog_speed}); break;
+    case model::Direction::WEST:    dog.SetDogSpeed({-dog_speed, 0.0}); break;
+    case model::Direction::EAST:    dog.SetDogSpeed({dog_speed, 0.0}); break;
+    }
+}
+
+}  // namespace
+
+void AddMotionBenchmarks(Suite& suite) {
+    for(auto [blocks, dogs_count] : {std::pair{10, 100}, std::pair{100, 100}, std::pair{100, 1000}}) {
+        const std::string name = "motion_tick/grid=" + std::to_string(blocks) + "x" + std::to_string(blocks)
+            + "/dogs=" + std::to_string(dogs_count);
+        suite.Add(name, [blocks = blocks, dogs_count = dogs_count](State& state) {
+            const auto map = MakeGridMap(blocks);
+            model::Motion motion(&map);
+            std::mt19937_64 random(42);
+            std::uniform_int_distribution<int> crossing(0, blocks);
+
+            std::vector<std::shared_ptr<model::Dog>> dogs;
+            dogs.reserve(dogs_count);
+            for(size_t i = 0; i < static_cast<size_t>(dogs_count); ++i) {
+                auto dog = std::make_shared<model::Dog>("dog"s, 3);
+                dog->SetDogCoordinates({static_cast<double>(crossing(random) * block_size),
+                                        static_cast<double>(crossing(random) * block_size)});
+                SetRandomDirection(*dog, random);
+                dogs.push_back(std::move(dog));
+            }
+            // Один такт всех собак; упёршиеся в край дороги поворачивают
+            state.Measure([&] {
+                for(const auto& dog : dogs) {
+                    motion.UpdateStateOfDog(tick_ms, dog);
+                    const auto speed = dog->GetDogSpeed();
+                    if(speed.dx_ == 0.0 && speed.dy_ == 0.0) {
+                        SetRandomDirection(*dog, random);
+                    }
+                }
+            });
+        });
+    }
+}
+
+}  // namespace bench
@@ -0,0 +1,126 @@
+#include <boost/archive/text_oarchive.hpp>
+#include <random>
+#include <sstream>
+
+#include "bench.h"
+#include "../../src/json_handler/state_json.h"
+#include "../../src/serialization/serialization.h"
+#include "../../src/serialization/snapshot.h"
+
+using namespace std::literals;
+
+namespace bench {
+
+namespace {
+
+// Сессия: собаки с трофеями в рюкзаках и трофеи на карте
+struct Session {
+    std::vector<model::Dog> dogs;
+    model::LootsWrappler loots;
+};
+
+Session MakeSession(size_t dogs_count, size_t loots_count) {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> coord(0.0, 100.0);
+    Session session;
+    for(size_t i = 0; i < loots_count; ++i) {
+        session.loots.AddLoot(random() % 4, {coord(random), coord(random)});
+    }
+    session.dogs.reserve(dogs_count);
+    uint64_t next_loot = 0;
+    for(size_t i = 0; i < dogs_count; ++i) {
+        model::Dog dog("dog"s + std::to_string(i), 3);
+        dog.SetId(i);
+        dog.SetDogCoordinates({coord(random), coord(random)});
+        dog.SetDogSpeed({1.5, 0.0});
+        dog.SetDogDirection(model::Direction::EAST);
+        dog.SetScore(random() % 1000);
+        // У каждой второй собаки два трофея
+        for(int j = 0; j < 2 && i % 2 == 0 && next_loot < loots_count; ++j, ++next_loot) {
+            dog.GetDogsBag().AddIdOfTheLoot(next_loot);
+            session.loots.MarkBusy(next_loot);
+        }
+        session.dogs.push_back(std::move(dog));
+    }
+    return session;
+}
+
+std::vector<serialization::DogRepr> MakeReprs(const Session& session) {
+    std::vector<serialization::DogRepr> reprs;
+    reprs.reserve(session.dogs.size());
+    for(const auto& dog : session.dogs) {
+        reprs.emplace_back(dog, "0123456789abcdef0123456789abcdef", "map1");
+    }
+    return reprs;
+}
+
+}  // namespace
+
+void AddSerializationBenchmarks(Suite& suite) {
+    suite.Add("dog_repr/text_archive", [](State& state) {
+        const auto session = MakeSession(1, 2);
+        const serialization::DogRepr repr(session.dogs.front(), "0123456789abcdef0123456789abcdef", "map1");
+        state.Measure([&repr] {
+            std::stringstream strm;
+            boost::archive::text_oarchive archive{strm};
+            archive << repr;
+            DoNotOptimize(strm);
+        });
+    });
+
+    suite.Add("dog_repr/binary", [](State& state) {
+        const auto session = MakeSession(1, 2);
+        const serialization::DogRepr repr(session.dogs.front(), "0123456789abcdef0123456789abcdef", "map1");
+        state.Measure([&repr] {
+            serialization::BinaryWriter writer;
+            repr.EncodeBinary(writer);
+            DoNotOptimize(writer.Release());
+        });
+    });
+
+    for(auto [dogs_count, loots_count] : {std::pair{10, 20}, std::pair{100, 200}, std::pair{1000, 2000}}) {
+        const std::string suffix = "/dogs=" + std::to_string(dogs_count) + "/loots=" + std::to_string(loots_count);
+
+        suite.Add("snapshot_encode_session" + suffix, [dogs_count = dogs_count, loots_count = loots_count](State& state) {
+            const auto session = MakeSession(dogs_count, loots_count);
+            const auto reprs = MakeReprs(session);
+            state.Measure([&] {
+                DoNotOptimize(serialization::EncodeSession("map1"sv, reprs, session.loots));
+            });
+        });
+
+        // Работа strand при снятии снимка: прежняя глубокая копия собак и предметов
+        // против кодирования сессии прямо из состояния игры
+        suite.Add("snapshot_capture/copy" + suffix, [dogs_count = dogs_count, loots_count = loots_count](State& state) {
+            const auto session = MakeSession(dogs_count, loots_count);
+            state.Measure([&] {
+                DoNotOptimize(MakeReprs(session));
+                DoNotOptimize(model::LootsWrappler(session.loots));
+            });
+        });
+
+        suite.Add("snapshot_capture/encode" + suffix, [dogs_count = dogs_count, loots_count = loots_count](State& state) {
+            const auto session = MakeSession(dogs_count, loots_count);
+            std::vector<serialization::SessionDog> dogs;
+            for(const auto& dog : session.dogs) {
+                dogs.push_back(serialization::SessionDog{.dog = &dog, .token = "0123456789abcdef0123456789abcdef"sv});
+            }
+            state.Measure([&] {
+                DoNotOptimize(serialization::EncodeSession("map1"sv, dogs, session.loots));
+            });
+        });
+
+        suite.Add("state_json" + suffix, [dogs_count = dogs_count, loots_count = loots_count](State& state) {
+            const auto session = MakeSession(dogs_count, loots_count);
+            std::vector<const model::Dog*> dogs;
+            for(const auto& dog : session.dogs) {
+                dogs.push_back(&dog);
+            }
+            state.Measure([&] {
+                DoNotOptimize(json_loader::SerializeState(dogs, session.loots));
+            });
+        });
+    }
+}
+
+}  // namespace bench
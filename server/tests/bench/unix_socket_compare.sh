@@ -0,0 +1,108 @@
+#!/bin/bash
+# Сравнение TCP через loopback и сокета AF_UNIX под одинаковой нагрузкой - как для
+# обратного прокси на той же машине. Запускает game_server с двумя слушателями
+# (--listen tcp://127.0.0.1:PORT --listen unix://SOCKET), поочерёдно нагружает каждый
+# game_load с одним и тем же профилем и печатает пропускную способность, задержки
+# и процессорное время сервера (user/sys) на запрос.
+#
+#   GAME_DB_URL=... tests/bench/unix_socket_compare.sh build/game_server \
+#       --connections 2000 --rate 20000 --duration 60 --mix action=50,state=50
+#
+# Аргументы после пути к серверу передаются game_load. Переменные окружения:
+#   GAME_LOAD    - путь к game_load (по умолчанию рядом с сервером)
+#   CONFIG_FILE  - конфигурация игры (data/config.json)
+#   WWW_ROOT     - статические файлы (static)
+#   SERVER_ARGS  - дополнительные аргументы сервера, например "--tick-period 50"
+#   PORT         - TCP-порт сервера (8080)
+#   SOCKET       - путь к сокету AF_UNIX (OUT_DIR/game.sock)
+#   OUT_DIR      - каталог для отчётов и журнала сервера
+set -euo pipefail
+
+if [[ $# -lt 1 ]]; then
+    echo "Usage: $0 SERVER [game_load options...]" >&2
+    exit 1
+fi
+
+SERVER=$1
+shift
+
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+GAME_LOAD=${GAME_LOAD:-$(dirname "$SERVER")/game_load}
+CONFIG_FILE=${CONFIG_FILE:-$SCRIPT_DIR/../../data/config.json}
+WWW_ROOT=${WWW_ROOT:-$SCRIPT_DIR/../../static}
+SERVER_ARGS=${SERVER_ARGS:---tick-period 50}
+PORT=${PORT:-8080}
+OUT_DIR=${OUT_DIR:-$(mktemp -d)}
+SOCKET=${SOCKET:-$OUT_DIR/game.sock}
+CLK_TCK=$(getconf CLK_TCK)
+mkdir -p "$OUT_DIR"
+
+wait_for_server() {
+    for _ in $(seq 1 100); do
+        if (echo > "/dev/tcp/127.0.0.1/$PORT") 2>/dev/null && [[ -S "$SOCKET" ]]; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    echo "Server did not open port $PORT and socket $SOCKET" >&2
+    return 1
+}
+
+# utime и stime процесса в тиках
+cpu_ticks() {
+    awk '{ print $14, $15 }' "/proc/$1/stat"
+}
+
+# run_transport NAME [game_load options...] - оба прогона идут к одному процессу сервера
+run_transport() {
+    local name=$1
+    shift
+    local before after
+    before=$(cpu_ticks "$SERVER_PID")
+    "$GAME_LOAD" --json-report "$OUT_DIR/$name.json" "$@" > "$OUT_DIR/$name.txt"
+    after=$(cpu_ticks "$SERVER_PID")
+    echo "$before $after" > "$OUT_DIR/$name.cpu"
+}
+
+# json_field FILE ENDPOINT FIELD - поле отчёта game_load для маршрута
+json_field() {
+    grep -o "\"$2\":{[^}]*}" "$1" | grep -o "\"$3\":[0-9.]*" | cut -d: -f2 || true
+}
+
+print_row() {
+    local name=$1
+    local report=$OUT_DIR/$name.json
+    local duration requests
+    duration=$(grep -o '"durationSeconds":[0-9.]*' "$report" | cut -d: -f2)
+    requests=$(grep -o '"requests":[0-9]*' "$report" | cut -d: -f2 | awk '{ sum += $1 } END { print sum + 0 }')
+    read -r user_before sys_before user_after sys_after < "$OUT_DIR/$name.cpu"
+    awk -v name="$name" -v duration="$duration" -v requests="$requests" -v tck="$CLK_TCK" \
+        -v user=$((user_after - user_before)) -v sys=$((sys_after - sys_before)) \
+        -v state_p50="$(json_field "$report" state p50Ms)" -v state_p99="$(json_field "$report" state p99Ms)" \
+        -v action_p50="$(json_field "$report" action p50Ms)" -v action_p99="$(json_field "$report" action p99Ms)" \
+        'BEGIN {
+            per_request = requests > 0 ? (user + sys) / tck * 1e6 / requests : 0
+            printf "%-9s %10.0f %9.2f %9.2f %12.1f %10s %10s %10s %10s\n", name, requests / duration,
+                   user / tck, sys / tck, per_request, state_p50, state_p99, action_p50, action_p99
+        }'
+}
+
+echo "Reports and server log: $OUT_DIR"
+# shellcheck disable=SC2086
+"$SERVER" --config-file "$CONFIG_FILE" --www-root "$WWW_ROOT" \
+    --listen "tcp://127.0.0.1:$PORT" --listen "unix://$SOCKET" $SERVER_ARGS > "$OUT_DIR/server.log" 2>&1 &
+SERVER_PID=$!
+trap 'kill -TERM "$SERVER_PID" 2>/dev/null || true' EXIT
+wait_for_server
+
+run_transport tcp --host 127.0.0.1 --port "$PORT" "$@"
+run_transport unix --unix-socket "$SOCKET" "$@"
+
+kill -TERM "$SERVER_PID"
+wait "$SERVER_PID" || true
+trap - EXIT
+
+printf "%-9s %10s %9s %9s %12s %10s %10s %10s %10s\n" transport "req/s" "user, s" "sys, s" "cpu us/req" \
+       "state p50" "state p99" "action p50" "action p99"
+print_row tcp
+print_row unix
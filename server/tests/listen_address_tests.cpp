@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include "../src/server/listen_address.h"
+
+using namespace std::literals;
+using http_server::ParseListenAddress;
+
+TEST_CASE("TCP listen addresses are parsed", "[ListenAddress]") {
+    const auto ipv4 = ParseListenAddress("tcp://127.0.0.1:8080"sv);
+    CHECK_FALSE(ipv4.IsUnix());
+    CHECK(ipv4.name == "tcp://127.0.0.1:8080"s);
+    const auto ipv4_endpoint = http_server::ToTcpEndpoint(ipv4.endpoint);
+    CHECK(ipv4_endpoint.address().to_string() == "127.0.0.1"s);
+    CHECK(ipv4_endpoint.port() == 8080);
+
+    const auto ipv6_endpoint = http_server::ToTcpEndpoint(ParseListenAddress("tcp://[::1]:443"sv).endpoint);
+    CHECK(ipv6_endpoint.address().is_v6());
+    CHECK(ipv6_endpoint.address().to_string() == "::1"s);
+    CHECK(ipv6_endpoint.port() == 443);
+}
+
+TEST_CASE("Unix listen addresses are parsed", "[ListenAddress]") {
+    const auto address = ParseListenAddress("unix:///run/game/http.sock"sv);
+    CHECK(address.IsUnix());
+    CHECK(address.name == "unix:///run/game/http.sock"s);
+    // У соединений через AF_UNIX нет адреса клиента
+    CHECK(http_server::ToTcpEndpoint(address.endpoint) == http_server::tcp::endpoint{});
+}
+
+TEST_CASE("Malformed listen addresses are rejected", "[ListenAddress]") {
+    CHECK_THROWS_AS(ParseListenAddress("127.0.0.1:8080"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("udp://127.0.0.1:8080"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("tcp://127.0.0.1"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("tcp://127.0.0.1:"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("tcp://127.0.0.1:65536"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("tcp://localhost:8080"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("tcp://::1:8080"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("unix://"sv), std::invalid_argument);
+    CHECK_THROWS_AS(ParseListenAddress("unix://"s + std::string(200, 'a')), std::invalid_argument);
+}
@@ -0,0 +1,179 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/json_handler/json_loader.h"
+#include "../src/json_handler/map_bundle.h"
+#include "../src/serialization/snapshot.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Дороги нулевой длины в обоих направлениях, здания, офисы и несколько типов трофеев.
+// Типы трофеев содержат значения JSON всех видов: они хранятся в наборе деревом
+constexpr std::string_view config_json = R"({
+    "defaultDogSpeed": 3.0,
+    "defaultBagCapacity": 3,
+    "dogRetirementTime": 15.0,
+    "lootGeneratorConfig": {"period": 5.0, "probability": 0.5},
+    "maps": [
+        {
+            "id": "map1",
+            "name": "Map 1",
+            "dogSpeed": 4.5,
+            "bagCapacity": 5,
+            "roads": [
+                {"x0": 0, "y0": 0, "x1": 40},
+                {"x0": 40, "y0": 0, "y1": 30},
+                {"x0": 10, "y0": 20, "y1": 20},
+                {"x0": 25, "y0": 5, "x1": 25},
+                {"x0": 40, "y0": 30, "x1": 0}
+            ],
+            "buildings": [
+                {"x": 5, "y": 5, "w": 30, "h": 20}
+            ],
+            "offices": [
+                {"id": "o0", "x": 40, "y": 30, "offsetX": 5, "offsetY": 0}
+            ],
+            "lootTypes": [
+                {"name": "key", "file": "assets/key.obj", "type": "obj", "rotation": 90, "color": "#338844", "scale": 0.03, "value": 10},
+                {"name": "wallet", "file": "assets/wallet.obj", "type": "obj", "rotation": 0, "color": "#883344", "scale": 0.01, "value": 30}
+            ]
+        },
+        {
+            "id": "map2",
+            "name": "Map 2",
+            "roads": [
+                {"x0": 0, "y0": 0, "y1": 10}
+            ],
+            "buildings": [],
+            "offices": [],
+            "lootTypes": [
+                {"name": "coin", "file": "assets/coin.obj", "type": "obj", "value": 1,
+                 "tags": ["shiny", true, false, null], "meta": {"weight": -2, "nested": [[]], "size": 18446744073709551615}}
+            ]
+        }
+    ]
+})"sv;
+
+struct ConfigFile {
+    ConfigFile()
+        : path(std::filesystem::temp_directory_path() / ("map_bundle_test_" + std::to_string(::getpid()) + ".json")) {
+        std::ofstream(path) << config_json;
+    }
+    ~ConfigFile() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    std::filesystem::path path;
+};
+
+void CheckSameRoads(const model::Map& restored, const model::Map& original) {
+    REQUIRE(restored.GetRoads().size() == original.GetRoads().size());
+    for(size_t i = 0; i < original.GetRoads().size(); ++i) {
+        const auto& road = original.GetRoads()[i];
+        const auto& restored_road = restored.GetRoads()[i];
+        CHECK(restored_road.IsHorizontal() == road.IsHorizontal());
+        CHECK(restored_road.GetStart().x == road.GetStart().x);
+        CHECK(restored_road.GetStart().y == road.GetStart().y);
+        CHECK(restored_road.GetEnd().x == road.GetEnd().x);
+        CHECK(restored_road.GetEnd().y == road.GetEnd().y);
+    }
+    auto same_index = [](const model::Map::RoadIndex& lhs, const model::Map::RoadIndex& rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const auto& l, const auto& r) {
+            return l.coord == r.coord && l.road == r.road;
+        });
+    };
+    CHECK(same_index(restored.GetHorizontalRoadIndex(), original.GetHorizontalRoadIndex()));
+    CHECK(same_index(restored.GetVerticalRoadIndex(), original.GetVerticalRoadIndex()));
+}
+
+void CheckSameMap(const model::Map& restored, const model::Map& original) {
+    CHECK(*restored.GetId() == *original.GetId());
+    CHECK(restored.GetName() == original.GetName());
+    CHECK(restored.GetDogSpeed() == original.GetDogSpeed());
+    CHECK(restored.GetBagCapacity() == original.GetBagCapacity());
+    CheckSameRoads(restored, original);
+
+    REQUIRE(restored.GetBuildings().size() == original.GetBuildings().size());
+    for(size_t i = 0; i < original.GetBuildings().size(); ++i) {
+        const auto& bounds = original.GetBuildings()[i].GetBounds();
+        const auto& restored_bounds = restored.GetBuildings()[i].GetBounds();
+        CHECK(restored_bounds.position.x == bounds.position.x);
+        CHECK(restored_bounds.position.y == bounds.position.y);
+        CHECK(restored_bounds.size.width == bounds.size.width);
+        CHECK(restored_bounds.size.height == bounds.size.height);
+    }
+
+    REQUIRE(restored.GetOffices().size() == original.GetOffices().size());
+    for(size_t i = 0; i < original.GetOffices().size(); ++i) {
+        const auto& office = original.GetOffices()[i];
+        const auto& restored_office = restored.GetOffices()[i];
+        CHECK(*restored_office.GetId() == *office.GetId());
+        CHECK(restored_office.GetPosition().x == office.GetPosition().x);
+        CHECK(restored_office.GetPosition().y == office.GetPosition().y);
+        CHECK(restored_office.GetOffset().dx == office.GetOffset().dx);
+        CHECK(restored_office.GetOffset().dy == office.GetOffset().dy);
+    }
+
+    REQUIRE(restored.GetLootTypes().size() == original.GetLootTypes().size());
+    for(size_t i = 0; i < original.GetLootTypes().size(); ++i) {
+        CHECK(restored.GetLootTypes()[i].GetLootType() == original.GetLootTypes()[i].GetLootType());
+    }
+}
+
+}  // namespace
+
+TEST_CASE("Map bundle restores the game loaded from JSON", "[MapBundle]") {
+    ConfigFile config;
+    const model::Game original = json_loader::LoadGame(config.path);
+    const std::string bundle = json_loader::EncodeMapBundle(original);
+    REQUIRE(json_loader::IsMapBundle(bundle));
+
+    const model::Game restored = json_loader::DecodeMapBundle(bundle);
+    CHECK(restored.GetRetirementTime() == original.GetRetirementTime());
+    CHECK(restored.GetLootGeneratorConf()->GetPeriod() == original.GetLootGeneratorConf()->GetPeriod());
+    CHECK(restored.GetLootGeneratorConf()->GetPropability() == original.GetLootGeneratorConf()->GetPropability());
+    REQUIRE(restored.GetMaps().size() == original.GetMaps().size());
+    for(size_t i = 0; i < original.GetMaps().size(); ++i) {
+        CheckSameMap(restored.GetMaps()[i], original.GetMaps()[i]);
+    }
+
+    // Направление дорог нулевой длины берётся из конфигурации, а не из координат концов
+    const auto& roads = restored.GetMaps().front().GetRoads();
+    CHECK(roads[2].IsVertical());
+    CHECK(roads[3].IsHorizontal());
+}
+
+TEST_CASE("Damaged map bundles are rejected", "[MapBundle]") {
+    ConfigFile config;
+    const std::string bundle = json_loader::EncodeMapBundle(json_loader::LoadGame(config.path));
+
+    SECTION("corrupted payload") {
+        std::string corrupted = bundle;
+        corrupted[corrupted.size() / 2] ^= 0x01;
+        CHECK_THROWS_AS(json_loader::DecodeMapBundle(corrupted), serialization::SnapshotError);
+    }
+    SECTION("corrupted checksum") {
+        std::string corrupted = bundle;
+        // Контрольная сумма идёт сразу после magic[8] и version:u32
+        corrupted[8 + sizeof(uint32_t)] ^= 0x01;
+        CHECK_THROWS_AS(json_loader::DecodeMapBundle(corrupted), serialization::SnapshotError);
+    }
+    SECTION("truncated bundle") {
+        for(const size_t size : {bundle.size() - 1, bundle.size() / 2, size_t{10}}) {
+            CHECK_THROWS_AS(json_loader::DecodeMapBundle(std::string_view(bundle).substr(0, size)), serialization::SnapshotError);
+        }
+    }
+    SECTION("unknown version") {
+        std::string future = bundle;
+        future[8] = 99;
+        CHECK_THROWS_AS(json_loader::DecodeMapBundle(future), serialization::SnapshotError);
+    }
+}
@@ -0,0 +1,62 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+
+#include "../src/request_handler/state_query.h"
+
+using namespace std::literals;
+using http_handler::FindUintParam;
+using http_handler::ParseStateQuery;
+
+TEST_CASE("Query parameters are found only by whole name", "[StateQuery]") {
+    CHECK(FindUintParam("sinceTick=5"sv, "sinceTick="sv) == 5u);
+    CHECK(FindUintParam("a=1&sinceTick=7&b=2"sv, "sinceTick="sv) == 7u);
+    // sinceTick= внутри имени другого параметра или в значении
+    CHECK(FindUintParam("lastsinceTick=5"sv, "sinceTick="sv) == std::nullopt);
+    CHECK(FindUintParam("lastsinceTick=5&sinceTick=9"sv, "sinceTick="sv) == 9u);
+    CHECK(FindUintParam("a=sinceTick=5"sv, "sinceTick="sv) == std::nullopt);
+    CHECK(FindUintParam("sinceTicks=5"sv, "sinceTick="sv) == std::nullopt);
+}
+
+TEST_CASE("Query parameters without a numeric value are ignored", "[StateQuery]") {
+    CHECK(FindUintParam("sinceTick="sv, "sinceTick="sv) == std::nullopt);
+    CHECK(FindUintParam("sinceTick=&timeout=5"sv, "sinceTick="sv) == std::nullopt);
+    CHECK(FindUintParam("sinceTick"sv, "sinceTick="sv) == std::nullopt);
+    CHECK(FindUintParam("sinceTick=-1"sv, "sinceTick="sv) == std::nullopt);
+    CHECK(FindUintParam("sinceTick=12ab"sv, "sinceTick="sv) == std::nullopt);
+    CHECK(FindUintParam("sinceTick=99999999999999999999999"sv, "sinceTick="sv) == std::nullopt);
+}
+
+TEST_CASE("Long poll parameters are parsed from request target", "[StateQuery]") {
+    const auto query = ParseStateQuery("/api/v1/game/state?sinceTick=42&timeout=1500"sv);
+    REQUIRE(query);
+    CHECK(query->since_tick == 42);
+    CHECK(query->timeout == 1500ms);
+
+    const auto without_timeout = ParseStateQuery("/api/v1/game/state?sinceTick=3"sv);
+    REQUIRE(without_timeout);
+    CHECK_FALSE(without_timeout->timeout);
+
+    // Нулевой таймаут передаётся как есть: отвечать сразу решает StateLongPoll
+    const auto zero_timeout = ParseStateQuery("/api/v1/game/state?timeout=0&sinceTick=3"sv);
+    REQUIRE(zero_timeout);
+    CHECK(zero_timeout->timeout == 0ms);
+
+    CHECK_FALSE(ParseStateQuery("/api/v1/game/state"sv));
+    CHECK_FALSE(ParseStateQuery("/api/v1/game/state?timeout=100"sv));
+    CHECK_FALSE(ParseStateQuery("/api/v1/game/state?sinceTick="sv));
+}
+
+TEST_CASE("Fragment is not part of the query", "[StateQuery]") {
+    const auto query = ParseStateQuery("/api/v1/game/state?sinceTick=5#timeout=100"sv);
+    REQUIRE(query);
+    CHECK(query->since_tick == 5);
+    CHECK_FALSE(query->timeout);
+
+    const auto trailing_fragment = ParseStateQuery("/api/v1/game/state?sinceTick=5&timeout=10#frag"sv);
+    REQUIRE(trailing_fragment);
+    CHECK(trailing_fragment->timeout == 10ms);
+
+    CHECK_FALSE(ParseStateQuery("/api/v1/game/state?timeout=10#sinceTick=5"sv));
+    CHECK_FALSE(ParseStateQuery("/api/v1/game/state?sinceTick=#5"sv));
+}
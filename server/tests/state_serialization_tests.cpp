@@ -1,10 +1,13 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include <boost/json.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <sstream>
 
 #include "../src/game/game_items.h"
 #include "../src/serialization/serialization.h"
+#include "../src/serialization/snapshot.h"
+#include "../src/serialization/journal.h"
 
 using namespace model;
 using namespace std::literals;
@@ -71,3 +74,270 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
         }
     }
 }
+
+
+SCENARIO("Binary snapshot") {
+    GIVEN("a session with dogs and loot") {
+        Dog dog("Pluto"s, 3);
+        dog.SetId(42);
+        dog.SetDogCoordinates({42.2, 12.5});
+        dog.SetScore(42);
+        dog.GetDogsBag().AddIdOfTheLoot(1);
+        dog.SetDogDirection(Direction::WEST);
+        dog.SetDogSpeed({-2.3, 0.0});
+        dog.SetGameTime(1500);
+        dog.SetStandingTime(200);
+
+        LootsWrappler loots;
+        loots.AddLoot(0, {1.0, 2.0});
+        loots.AddLoot(1, {3.5, 4.5});
+        loots.AddLoot(2, {5.0, 6.0});
+        loots.MarkBusy(1);
+        loots.PopLoot(2);
+
+        serialization::SnapshotBuilder builder;
+        builder.AddSection(serialization::SectionType::kSession,
+                           serialization::EncodeSession("map1"sv, {serialization::DogRepr(dog, "token", "map1")}, loots));
+        std::string data = builder.Finish();
+
+        WHEN("snapshot is decoded") {
+            REQUIRE(serialization::IsBinarySnapshot(data));
+            auto sessions = serialization::DecodeSnapshot(data).sessions;
+
+            THEN("session state is restored") {
+                REQUIRE(sessions.size() == 1);
+                CHECK(sessions[0].map_id == "map1");
+                REQUIRE(sessions[0].dogs.size() == 1);
+                const auto [restored_dog, token, map_id] = sessions[0].dogs[0].Restore();
+                CHECK(token == "token");
+                CHECK(map_id == "map1");
+                CHECK(restored_dog.GetId() == dog.GetId());
+                CHECK(restored_dog.GetName() == dog.GetName());
+                CHECK(restored_dog.GetDogCoordinates() == dog.GetDogCoordinates());
+                CHECK(restored_dog.GetDogSpeed() == dog.GetDogSpeed());
+                CHECK(restored_dog.GetDogDirection() == dog.GetDogDirection());
+                CHECK(restored_dog.GetScore() == dog.GetScore());
+                CHECK(restored_dog.GetGameTime_ms() == dog.GetGameTime_ms());
+                CHECK(restored_dog.GetStandingTime() == dog.GetStandingTime());
+                CHECK(restored_dog.GetDogsBag().GetAllIds() == dog.GetDogsBag().GetAllIds());
+
+                const auto& restored_loots = sessions[0].loots;
+                CHECK(restored_loots.GetSize() == loots.GetSize());
+                CHECK(restored_loots.IsBusyLoot(1));
+                CHECK(restored_loots.GetAllLoots().at(2) == nullptr);
+                CHECK(restored_loots.GetLoot(0).GetPosition() == DoublePoint{1.0, 2.0});
+            }
+        }
+
+        WHEN("session is encoded straight from the game state") {
+            const std::string direct = serialization::EncodeSession("map1"sv, {serialization::SessionDog{.dog = &dog, .token = "token"sv}}, loots);
+
+            THEN("it matches the encoding of DogRepr copies") {
+                CHECK(direct == serialization::EncodeSession("map1"sv, {serialization::DogRepr(dog, "token", "map1")}, loots));
+            }
+
+            THEN("the assembled snapshot carries the session and the journal position") {
+                serialization::EncodedStateSnapshot captured;
+                captured.sessions.push_back(direct);
+                captured.journal_lsn = 11;
+                const auto decoded = serialization::DecodeSnapshot(serialization::BuildSnapshot(captured));
+                REQUIRE(decoded.sessions.size() == 1);
+                CHECK(decoded.sessions[0].map_id == "map1");
+                CHECK(decoded.sessions[0].dogs.size() == 1);
+                CHECK(decoded.journal_lsn == 11);
+                CHECK(decoded.pending_results.empty());
+            }
+
+            THEN("unconfirmed results of retired players are kept in the snapshot") {
+                serialization::EncodedStateSnapshot captured;
+                captured.sessions.push_back(direct);
+                captured.pending_results.push_back({.id = "6f1c2c4e-0d5a-4a4e-9f2b-7b1d3c9e8a10", .name = "Goofy", .score = 30, .play_time_ms = 15000.5});
+                const auto decoded = serialization::DecodeSnapshot(serialization::BuildSnapshot(captured));
+                REQUIRE(decoded.pending_results.size() == 1);
+                CHECK(decoded.pending_results[0].id == "6f1c2c4e-0d5a-4a4e-9f2b-7b1d3c9e8a10");
+                CHECK(decoded.pending_results[0].name == "Goofy");
+                CHECK(decoded.pending_results[0].score == 30);
+                CHECK(decoded.pending_results[0].play_time_ms == 15000.5);
+            }
+        }
+
+        WHEN("snapshot is corrupted") {
+            data[data.size() - 1] ^= 0x1;
+            THEN("checksum mismatch is detected") {
+                CHECK_THROWS_AS(serialization::DecodeSnapshot(data), serialization::SnapshotError);
+            }
+        }
+
+        WHEN("snapshot is truncated") {
+            data.resize(data.size() / 2);
+            THEN("decoding fails") {
+                CHECK_THROWS_AS(serialization::DecodeSnapshot(data), serialization::SnapshotError);
+            }
+        }
+    }
+}
+
+SCENARIO("Snapshot version check") {
+    GIVEN("a snapshot written by a newer server") {
+        serialization::SnapshotBuilder builder;
+        builder.AddSection(serialization::SectionType::kJournalPosition, serialization::EncodeJournalPosition(7));
+        std::string data = builder.Finish();
+        // Версия идёт сразу после magic[8]
+        serialization::BinaryWriter version;
+        version.WriteU32(serialization::snapshot_version + 1);
+        data.replace(8, sizeof(uint32_t), version.Data());
+
+        THEN("it is recognized but not decoded") {
+            CHECK(serialization::IsBinarySnapshot(data));
+            CHECK_THROWS_AS(serialization::DecodeSnapshot(data), serialization::SnapshotError);
+        }
+    }
+}
+
+SCENARIO("Legacy JSON state") {
+    GIVEN("a state file saved before the binary format") {
+        Dog dog("Pluto"s, 3);
+        dog.SetId(42);
+        dog.SetDogCoordinates({4.5, 1.0});
+        dog.SetScore(17);
+        dog.GetDogsBag().AddIdOfTheLoot(1);
+
+        LootsWrappler loots;
+        loots.AddLoot(0, {1.0, 2.0});
+        loots.AddLoot(1, {3.5, 4.5});
+        loots.MarkBusy(1);
+
+        std::stringstream dog_stream;
+        {
+            OutputArchive archive{dog_stream};
+            const serialization::DogRepr repr(dog, "token", "map1");
+            archive << repr;
+        }
+        std::stringstream loots_stream;
+        {
+            OutputArchive archive{loots_stream};
+            archive << loots;
+        }
+        const std::string data = boost::json::serialize(boost::json::object{
+            {"Players", boost::json::array{boost::json::string(dog_stream.str())}},
+            {"Items", boost::json::array{boost::json::object{{"map_id", "map1"}, {"loots_in_map", loots_stream.str()}},
+                                         boost::json::object{{"map_id", "map2"}, {"loots_in_map", loots_stream.str()}}}}
+        });
+
+        WHEN("state is decoded") {
+            REQUIRE_FALSE(serialization::IsBinarySnapshot(data));
+            const auto snapshot = serialization::DecodeLegacyJsonState(data);
+
+            THEN("dogs and loot are grouped into sessions by map") {
+                REQUIRE(snapshot.sessions.size() == 2);
+                CHECK(snapshot.journal_lsn == 0);
+                const auto& session = snapshot.sessions[0];
+                CHECK(session.map_id == "map1");
+                REQUIRE(session.dogs.size() == 1);
+                const auto [restored_dog, token, map_id] = session.dogs[0].Restore();
+                CHECK(token == "token");
+                CHECK(restored_dog.GetId() == dog.GetId());
+                CHECK(restored_dog.GetName() == dog.GetName());
+                CHECK(restored_dog.GetDogCoordinates() == dog.GetDogCoordinates());
+                CHECK(restored_dog.GetScore() == dog.GetScore());
+                CHECK(restored_dog.GetDogsBag().GetAllIds() == dog.GetDogsBag().GetAllIds());
+                CHECK(session.loots.GetSize() == loots.GetSize());
+                CHECK(session.loots.IsBusyLoot(1));
+
+                CHECK(snapshot.sessions[1].map_id == "map2");
+                CHECK(snapshot.sessions[1].dogs.empty());
+                CHECK(snapshot.sessions[1].loots.GetSize() == loots.GetSize());
+            }
+        }
+    }
+}
+
+SCENARIO("Action journal") {
+    GIVEN("a journal segment with join, move, tick and results saved records") {
+        serialization::BinaryWriter writer;
+        writer.WriteBytes(serialization::EncodeJournalHeader(5));
+        serialization::EncodeJournalEntry(writer, 5, serialization::JoinRecord{
+            .map_id = "map1", .user_name = "Pluto", .token = "token", .dog_id = 7, .x = 1.5, .y = 2.0});
+        serialization::EncodeJournalEntry(writer, 6, serialization::MoveRecord{.token = "token", .move = "U"});
+        serialization::TickRecord tick{.delta_ms = 50, .spawned = {}, .retired = {}};
+        tick.spawned.emplace_back(Map::Id{"map1"}, std::vector<LootSpawn>{{.type = 2, .position = {3.0, 4.5}}});
+        tick.retired.push_back({.id = "6f1c2c4e-0d5a-4a4e-9f2b-7b1d3c9e8a10", .name = "Goofy", .score = 30, .play_time_ms = 15000.0});
+        serialization::EncodeJournalEntry(writer, 7, tick);
+        serialization::EncodeJournalEntry(writer, 8, serialization::ResultsSavedRecord{.ids = {"6f1c2c4e-0d5a-4a4e-9f2b-7b1d3c9e8a10"}});
+        std::string data = writer.Release();
+
+        WHEN("segment is read") {
+            serialization::JournalReader reader(data);
+            std::vector<serialization::JournalEntry> entries;
+            while(auto entry = reader.Next()) {
+                entries.push_back(std::move(*entry));
+            }
+
+            THEN("records are restored in order") {
+                CHECK(reader.GetFirstLsn() == 5);
+                CHECK_FALSE(reader.IsTornTail());
+                REQUIRE(entries.size() == 4);
+                CHECK(entries[2].lsn == 7);
+                const auto& join = std::get<serialization::JoinRecord>(entries[0].record);
+                CHECK(join.user_name == "Pluto");
+                CHECK(join.dog_id == 7);
+                CHECK(join.x == 1.5);
+                CHECK(std::get<serialization::MoveRecord>(entries[1].record).move == "U");
+                const auto& restored_tick = std::get<serialization::TickRecord>(entries[2].record);
+                CHECK(restored_tick.delta_ms == 50);
+                REQUIRE(restored_tick.spawned.size() == 1);
+                CHECK(*restored_tick.spawned[0].first == "map1");
+                CHECK(restored_tick.spawned[0].second.at(0).type == 2);
+                CHECK(restored_tick.spawned[0].second.at(0).position == DoublePoint{3.0, 4.5});
+                REQUIRE(restored_tick.retired.size() == 1);
+                CHECK(restored_tick.retired[0].name == "Goofy");
+                CHECK(restored_tick.retired[0].score == 30);
+                CHECK(std::get<serialization::ResultsSavedRecord>(entries[3].record).ids == std::vector<std::string>{tick.retired[0].id});
+            }
+        }
+
+        WHEN("last record is written partially") {
+            data.resize(data.size() - 3);
+            serialization::JournalReader reader(data);
+            size_t count = 0;
+            while(reader.Next()) {
+                ++count;
+            }
+
+            THEN("records before it are read and the tail is reported") {
+                CHECK(count == 3);
+                CHECK(reader.IsTornTail());
+            }
+        }
+    }
+
+    GIVEN("a segment written in version 1, where ticks carry no results") {
+        serialization::BinaryWriter payload;
+        payload.WriteU64(3);
+        payload.WriteU8(static_cast<uint8_t>(serialization::JournalRecordType::kTick));
+        payload.WriteU64(50);
+        payload.WriteU64(0);
+
+        std::string data = serialization::EncodeJournalHeader(3);
+        serialization::BinaryWriter version;
+        version.WriteU32(1);
+        data.replace(8, sizeof(uint32_t), version.Data());
+        serialization::BinaryWriter frame;
+        frame.WriteU32(static_cast<uint32_t>(payload.Size()));
+        frame.WriteU32(serialization::Crc32(payload.Data()));
+        frame.WriteBytes(payload.Data());
+        data += frame.Data();
+
+        THEN("the tick is decoded without results") {
+            serialization::JournalReader reader(data);
+            const auto entry = reader.Next();
+            REQUIRE(entry.has_value());
+            const auto& tick = std::get<serialization::TickRecord>(entry->record);
+            CHECK(tick.delta_ms == 50);
+            CHECK(tick.spawned.empty());
+            CHECK(tick.retired.empty());
+            CHECK_FALSE(reader.Next().has_value());
+            CHECK_FALSE(reader.IsTornTail());
+        }
+    }
+}
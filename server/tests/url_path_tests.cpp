@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "../src/utils/lru_cache.h"
+#include "../src/utils/url_path.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::optional<std::string> Normalize(std::string_view target) {
+    utils::URLPathBuffer buffer;
+    const auto path = utils::NormalizeURLPath(target, buffer);
+    return path ? std::optional<std::string>(*path) : std::nullopt;
+}
+
+}  // namespace
+
+TEST_CASE("URL path is decoded", "[NormalizeURLPath]") {
+    CHECK(Normalize("/index.html"sv) == "/index.html"s);
+    CHECK(Normalize("/my%20file.txt"sv) == "/my file.txt"s);
+    CHECK(Normalize("/%D0%B0%d0%b1"sv) == "/\xD0\xB0\xD0\xB1"s);
+    CHECK(Normalize("/images/cube.png?v=2#top"sv) == "/images/cube.png"s);
+}
+
+TEST_CASE("URL path is normalized", "[NormalizeURLPath]") {
+    CHECK(Normalize("/"sv) == "/"s);
+    CHECK(Normalize("//images///cube.png"sv) == "/images/cube.png"s);
+    CHECK(Normalize("/./images/./cube.png"sv) == "/images/cube.png"s);
+    CHECK(Normalize("/js/../images/cube.png"sv) == "/images/cube.png"s);
+    CHECK(Normalize("/images/.."sv) == "/"s);
+    CHECK(Normalize("/images/%2e%2e/index.html"sv) == "/index.html"s);
+    CHECK(Normalize("/images/..%2fjs/app.js"sv) == "/js/app.js"s);
+    CHECK(Normalize("/images/"sv) == "/images/"s);
+}
+
+TEST_CASE("Malformed URL paths are rejected", "[NormalizeURLPath]") {
+    CHECK_FALSE(Normalize(""sv));
+    CHECK_FALSE(Normalize("index.html"sv));
+    CHECK_FALSE(Normalize("/.."sv));
+    CHECK_FALSE(Normalize("/images/../../etc/passwd"sv));
+    CHECK_FALSE(Normalize("/%2e%2e/etc/passwd"sv));
+    CHECK_FALSE(Normalize("/file%zz"sv));
+    CHECK_FALSE(Normalize("/file%2"sv));
+    CHECK_FALSE(Normalize("/file%"sv));
+    CHECK_FALSE(Normalize("/file%00.txt"sv));
+    CHECK_FALSE(Normalize("/" + std::string(utils::max_url_path_length, 'a')));
+}
+
+TEST_CASE("LRU cache evicts the least recently used value", "[LruCache]") {
+    utils::LruCache<int> cache(2);
+    cache.Put("a"s, 1);
+    cache.Put("b"s, 2);
+    CHECK(cache.Get("a"sv) == 1);
+
+    cache.Put("c"s, 3);
+    CHECK(cache.GetSize() == 2);
+    CHECK_FALSE(cache.Get("b"sv));
+    CHECK(cache.Get("a"sv) == 1);
+    CHECK(cache.Get("c"sv) == 3);
+
+    cache.Put("a"s, 10);
+    CHECK(cache.GetSize() == 2);
+    CHECK(cache.Get("a"sv) == 10);
+}